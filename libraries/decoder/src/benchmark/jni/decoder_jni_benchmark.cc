@@ -0,0 +1,423 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+// Microbenchmarks of the per-frame native code of the decoder modules: the
+// bit depth conversion and surface copies of the video decoders, and the PCM
+// copies of the FLAC decoder.
+//
+// Usage: decoder_jni_benchmark [--filter=<substring>] [--min_time_ms=<ms>]
+//
+// Only benchmarks whose name contains the filter are run, each for at least
+// the given time (200 ms by default). The results are written to stdout as
+// JSON, with the median, minimum and mean duration of an iteration.
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bit_depth_converter.h"  // NOLINT
+#include "cpu_info.h"             // NOLINT
+#include "decoder_stats.h"        // NOLINT
+#include "include/pcm_copy.h"     // NOLINT
+#include "pixel_kernels.h"        // NOLINT
+#include "plane_copy.h"           // NOLINT
+
+namespace decoder_jni {
+namespace {
+
+struct Options {
+  std::string filter;
+  int64_t min_time_ns = 200000000;
+};
+
+struct Resolution {
+  const char* name;
+  int width;
+  int height;
+};
+
+const Resolution kResolutions[] = {
+    {"720p", 1280, 720}, {"1080p", 1920, 1080}, {"2160p", 3840, 2160}};
+
+struct IsaName {
+  uint32_t isa;
+  const char* name;
+};
+
+const IsaName kIsaNames[] = {{kIsaNeon, "neon"},
+                             {kIsaSve, "sve"},
+                             {kIsaSse2, "sse2"},
+                             {kIsaSse41, "sse41"},
+                             {kIsaAvx2, "avx2"}};
+
+// Iterations are repeated until both the minimum time and this number of
+// iterations are reached.
+const int kMinIterations = 5;
+const int kMaxIterations = 100000;
+
+// The number of samples per channel of the FLAC blocks copied, the usual block
+// size of FLAC encoders.
+const int kFlacBlockSize = 4096;
+
+int AlignTo16(int value) { return (value + 15) & ~15; }
+
+std::string Join(const std::vector<std::string>& parts) {
+  std::string result;
+  for (const std::string& part : parts) {
+    if (!result.empty()) result += '/';
+    result += part;
+  }
+  return result;
+}
+
+// Returns the single instruction sets supported by the device, preceded by 0
+// for the portable kernels.
+std::vector<uint32_t> GetBenchmarkedIsas() {
+  std::vector<uint32_t> isas_list = {0};
+  for (const IsaName& isa_name : kIsaNames) {
+    if (GetSupportedIsas() & isa_name.isa) isas_list.push_back(isa_name.isa);
+  }
+  return isas_list;
+}
+
+const char* GetIsaName(uint32_t isa) {
+  for (const IsaName& isa_name : kIsaNames) {
+    if (isa_name.isa == isa) return isa_name.name;
+  }
+  return "portable";
+}
+
+// Fills |data| with pseudorandom samples of |bits| bits.
+void FillSamples(std::vector<uint16_t>* data, int bits) {
+  for (size_t i = 0; i < data->size(); i++) {
+    (*data)[i] = static_cast<uint16_t>(MixBits(static_cast<uint32_t>(i)) &
+                                       ((1u << bits) - 1));
+  }
+}
+
+// Runs the benchmarks passed to Run() and writes their results.
+class BenchmarkRunner {
+ public:
+  explicit BenchmarkRunner(const Options& options) : options_(options) {
+    std::printf("{\n  \"context\": {\n    \"supported_isas\": [");
+    bool first_isa = true;
+    for (const IsaName& isa_name : kIsaNames) {
+      if ((GetSupportedIsas() & isa_name.isa) == 0) continue;
+      std::printf("%s\"%s\"", first_isa ? "" : ", ", isa_name.name);
+      first_isa = false;
+    }
+    std::printf(
+        "],\n    \"num_cpus\": %u,\n    \"num_performance_cores\": %d\n"
+        "  },\n  \"benchmarks\": [",
+        std::thread::hardware_concurrency(),
+        GetNumberOfPerformanceCoresOnline());
+  }
+
+  ~BenchmarkRunner() { std::printf("\n  ]\n}\n"); }
+
+  // Not copyable or movable.
+  BenchmarkRunner(const BenchmarkRunner&) = delete;
+  BenchmarkRunner(BenchmarkRunner&&) = delete;
+  BenchmarkRunner& operator=(const BenchmarkRunner&) = delete;
+  BenchmarkRunner& operator=(BenchmarkRunner&&) = delete;
+
+  // Returns whether a benchmark named |name| is run, e.g. to skip allocating
+  // its data.
+  bool Matches(const std::string& name) const {
+    return name.find(options_.filter) != std::string::npos;
+  }
+
+  // Calls |function| repeatedly if |name| matches the filter and writes the
+  // durations of the calls. |bytes| is the amount of data processed by a call.
+  void Run(const std::string& name, int64_t bytes,
+           const std::function<void()>& function) {
+    if (!Matches(name)) return;
+    // Warm up caches and lazily created threads.
+    function();
+    std::vector<int64_t> durations_ns;
+    int64_t total_ns = 0;
+    while (static_cast<int>(durations_ns.size()) < kMaxIterations &&
+           (total_ns < options_.min_time_ns ||
+            static_cast<int>(durations_ns.size()) < kMinIterations)) {
+      const int64_t start_time_ns = GetMonotonicTimeNs();
+      function();
+      const int64_t duration_ns = GetMonotonicTimeNs() - start_time_ns;
+      durations_ns.push_back(duration_ns);
+      total_ns += duration_ns;
+    }
+    std::sort(durations_ns.begin(), durations_ns.end());
+    const int64_t iterations = static_cast<int64_t>(durations_ns.size());
+    const int64_t median_ns = durations_ns[durations_ns.size() / 2];
+    const double bytes_per_second =
+        median_ns > 0 ? bytes * 1e9 / median_ns : 0;
+    std::printf(
+        "%s\n    {\"name\": \"%s\", \"iterations\": %" PRId64
+        ", \"median_ns\": %" PRId64 ", \"min_ns\": %" PRId64
+        ", \"mean_ns\": %" PRId64 ", \"bytes_per_second\": %.0f}",
+        first_result_ ? "" : ",", name.c_str(), iterations, median_ns,
+        durations_ns[0], total_ns / iterations, bytes_per_second);
+    std::fflush(stdout);
+    first_result_ = false;
+  }
+
+ private:
+  const Options options_;
+  bool first_result_ = true;
+};
+
+// Converts 10-bit 4:2:0 frames to 8 bits, as for YUV output of high bit depth
+// video, on one thread and on the threads used by default.
+void RunBitDepthConversion(BenchmarkRunner* runner) {
+  for (const Resolution& resolution : kResolutions) {
+    const int width = resolution.width;
+    const int height = resolution.height;
+    const int uv_width = (width + 1) / 2;
+    const int uv_height = (height + 1) / 2;
+    std::vector<uint16_t> source(static_cast<size_t>(width) * height +
+                                 2 * static_cast<size_t>(uv_width) * uv_height);
+    std::vector<uint8_t> destination(source.size());
+    bool filled = false;
+    for (uint32_t isa : GetBenchmarkedIsas()) {
+      for (int max_threads : {1, 64}) {
+        BitDepthConverter converter(isa, max_threads);
+        const std::string name =
+            Join({"convert_10_to_8", resolution.name, GetIsaName(isa),
+                  "threads:" + std::to_string(converter.num_threads())});
+        if (!runner->Matches(name)) continue;
+        if (max_threads > 1 && converter.num_threads() == 1) continue;
+        if (!filled) {
+          FillSamples(&source, /*bits=*/10);
+          filled = true;
+        }
+        const uint16_t* const source_u = source.data() + width * height;
+        const uint16_t* const source_v = source_u + uv_width * uv_height;
+        uint8_t* const destination_u = destination.data() + width * height;
+        uint8_t* const destination_v = destination_u + uv_width * uv_height;
+        const BitDepthConverter::Plane planes[3] = {
+            {reinterpret_cast<const uint8_t*>(source.data()), width * 2,
+             destination.data(), width, width, height},
+            {reinterpret_cast<const uint8_t*>(source_u), uv_width * 2,
+             destination_u, uv_width, uv_width, uv_height},
+            {reinterpret_cast<const uint8_t*>(source_v), uv_width * 2,
+             destination_v, uv_width, uv_width, uv_height}};
+        runner->Run(name, static_cast<int64_t>(source.size()) * 2,
+                    [&converter, &planes]() {
+                      converter.Convert10BitTo8Bit(planes, 3);
+                    });
+      }
+    }
+  }
+}
+
+// Copies 8-bit frames to YV12 surface buffers, as when rendering VP9 and AV1
+// frames, and copies the luma plane alone.
+void RunSurfaceCopies(BenchmarkRunner* runner) {
+  for (const Resolution& resolution : kResolutions) {
+    const int width = resolution.width;
+    const int height = resolution.height;
+    const int uv_width = (width + 1) / 2;
+    const int uv_height = (height + 1) / 2;
+    // Decoders allocate frames with borders and aligned strides.
+    const int source_stride = AlignTo16(width + 64);
+    const int source_uv_stride = AlignTo16(uv_width + 32);
+    std::vector<uint8_t> source_y(static_cast<size_t>(source_stride) * height);
+    std::vector<uint8_t> source_u(static_cast<size_t>(source_uv_stride) *
+                                  uv_height);
+    std::vector<uint8_t> source_v(source_u.size());
+    // The YV12 layout of ANativeWindow buffers: Y, then V, then U.
+    const int destination_stride = AlignTo16(width);
+    const int destination_uv_stride = AlignTo16(destination_stride / 2);
+    const size_t y_size = static_cast<size_t>(destination_stride) * height;
+    const size_t uv_size = static_cast<size_t>(destination_uv_stride) *
+                           uv_height;
+    std::vector<uint8_t> destination(y_size + 2 * uv_size);
+    const int64_t frame_bytes =
+        static_cast<int64_t>(width) * height + 2 * uv_width * uv_height;
+    for (uint32_t isa : GetBenchmarkedIsas()) {
+      const PlaneCopier copier(isa);
+      runner->Run(Join({"copy_plane", resolution.name, GetIsaName(isa)}),
+                  static_cast<int64_t>(width) * height, [&]() {
+                    copier.CopyPlane(source_y.data(), source_stride,
+                                     destination.data(), destination_stride,
+                                     width, height);
+                  });
+      runner->Run(
+          Join({"render_yv12", resolution.name, GetIsaName(isa)}), frame_bytes,
+          [&]() {
+            copier.CopyPlane(source_y.data(), source_stride,
+                             destination.data(), destination_stride, width,
+                             height);
+            uint8_t* const destination_v = destination.data() + y_size;
+            copier.CopyChromaPlanes(source_u.data(), source_uv_stride,
+                                    source_v.data(), source_uv_stride,
+                                    destination_v + uv_size, destination_v,
+                                    destination_uv_stride, uv_width,
+                                    uv_height);
+          });
+    }
+  }
+}
+
+// Copies 10-bit frames to P010 surface buffers, as when rendering high bit
+// depth VP9 and AV1 frames.
+void RunP010Copies(BenchmarkRunner* runner) {
+  for (const Resolution& resolution : kResolutions) {
+    const int width = resolution.width;
+    const int height = resolution.height;
+    const int uv_width = (width + 1) / 2;
+    const int uv_height = (height + 1) / 2;
+    const std::string prefix = Join({"render_p010", resolution.name});
+    std::vector<uint32_t> isas_list;
+    for (uint32_t isa : GetBenchmarkedIsas()) {
+      if (runner->Matches(Join({prefix, GetIsaName(isa)}))) {
+        isas_list.push_back(isa);
+      }
+    }
+    if (isas_list.empty()) continue;
+    std::vector<uint16_t> source_y(static_cast<size_t>(width) * height);
+    std::vector<uint16_t> source_u(static_cast<size_t>(uv_width) * uv_height);
+    std::vector<uint16_t> source_v(source_u.size());
+    FillSamples(&source_y, /*bits=*/10);
+    FillSamples(&source_u, /*bits=*/10);
+    FillSamples(&source_v, /*bits=*/10);
+    // P010 has a full resolution Y plane and a half height interleaved UV
+    // plane, with the same stride.
+    const int destination_stride = AlignTo16(width) * 2;
+    std::vector<uint8_t> destination(static_cast<size_t>(destination_stride) *
+                                     (height + uv_height));
+    uint8_t* const destination_uv =
+        destination.data() + static_cast<size_t>(destination_stride) * height;
+    const int64_t frame_bytes =
+        2 * (static_cast<int64_t>(width) * height + 2 * uv_width * uv_height);
+    for (uint32_t isa : isas_list) {
+      const PlaneCopier copier(isa);
+      runner->Run(Join({prefix, GetIsaName(isa)}), frame_bytes, [&]() {
+        copier.ShiftPlane16(reinterpret_cast<const uint8_t*>(source_y.data()),
+                            width * 2, destination.data(), destination_stride,
+                            width, height, /*shift=*/6);
+        copier.InterleaveChromaPlanes16(
+            reinterpret_cast<const uint8_t*>(source_u.data()), uv_width * 2,
+            reinterpret_cast<const uint8_t*>(source_v.data()), uv_width * 2,
+            destination_uv, destination_stride, uv_width, uv_height,
+            /*shift=*/6);
+      });
+    }
+  }
+}
+
+const char* GetPcmEncodingName(PcmOutputEncoding encoding) {
+  switch (encoding) {
+    case kPcmOutputEncodingFloat:
+      return "float";
+    case kPcmOutputEncoding16Bit:
+      return "16bit";
+    default:
+      return "source";
+  }
+}
+
+// Interleaves decoded FLAC blocks into PCM output buffers.
+void RunFlacPcmCopies(BenchmarkRunner* runner) {
+  const PcmOutputEncoding kEncodings[] = {kPcmOutputEncodingSource,
+                                          kPcmOutputEncodingFloat,
+                                          kPcmOutputEncoding16Bit};
+  for (unsigned bits_per_sample : {16u, 24u}) {
+    const unsigned bytes_per_sample = bits_per_sample / 8;
+    for (unsigned channels : {1u, 2u, 6u, 8u}) {
+      std::vector<std::vector<int>> channel_data(
+          channels, std::vector<int>(kFlacBlockSize));
+      std::vector<const int*> source(channels);
+      for (unsigned channel = 0; channel < channels; channel++) {
+        for (int i = 0; i < kFlacBlockSize; i++) {
+          // Signed samples of |bits_per_sample| bits.
+          channel_data[channel][i] =
+              static_cast<int>(MixBits(channel * kFlacBlockSize + i)) >>
+              (32 - bits_per_sample);
+        }
+        source[channel] = channel_data[channel].data();
+      }
+      for (PcmOutputEncoding encoding : kEncodings) {
+        for (bool downmix : {false, true}) {
+          if (downmix && channels <= 2) continue;
+          const PcmCopyFunction copy = getLittleEndianPcmCopyFunction(
+              encoding, downmix, bytes_per_sample, channels);
+          if (copy == nullptr) continue;
+          std::vector<std::string> parts = {
+              "flac_pcm_copy", std::to_string(bits_per_sample) + "bit",
+              std::to_string(channels) + "ch", GetPcmEncodingName(encoding)};
+          if (downmix) parts.push_back("downmix");
+          const unsigned output_channels =
+              getPcmOutputChannels(downmix, channels);
+          const unsigned output_bytes_per_sample =
+              getPcmOutputBytesPerSample(encoding, bytes_per_sample);
+          std::vector<int8_t> destination(
+              static_cast<size_t>(kFlacBlockSize) * output_channels *
+              output_bytes_per_sample);
+          uint32_t dither_state = 1;
+          runner->Run(Join(parts),
+                      static_cast<int64_t>(kFlacBlockSize) * channels *
+                          bytes_per_sample,
+                      [&]() {
+                        copy(destination.data(), source.data(),
+                             bytes_per_sample, kFlacBlockSize, channels,
+                             &dither_state);
+                      });
+        }
+      }
+    }
+  }
+}
+
+bool ParseOptions(int argc, char** argv, Options* options) {
+  for (int i = 1; i < argc; i++) {
+    const char* const argument = argv[i];
+    if (std::strncmp(argument, "--filter=", 9) == 0) {
+      options->filter = argument + 9;
+    } else if (std::strncmp(argument, "--min_time_ms=", 14) == 0) {
+      options->min_time_ns =
+          static_cast<int64_t>(std::atoll(argument + 14)) * 1000000;
+    } else {
+      std::fprintf(stderr,
+                   "Usage: %s [--filter=<substring>] [--min_time_ms=<ms>]\n",
+                   argv[0]);
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace
+}  // namespace decoder_jni
+
+int main(int argc, char** argv) {
+  using namespace decoder_jni;  // NOLINT
+  Options options;
+  if (!ParseOptions(argc, argv, &options)) {
+    return 1;
+  }
+  BenchmarkRunner runner(options);
+  RunBitDepthConversion(&runner);
+  RunSurfaceCopies(&runner);
+  RunP010Copies(&runner);
+  RunFlacPcmCopies(&runner);
+  return 0;
+}
@@ -48,6 +48,9 @@ public abstract class SimpleDecoder<
   private boolean flushed;
   private boolean released;
   private int skippedOutputBufferCount;
+  // Whether the output buffer of the current decode call holds no output. Only accessed on the
+  // decode thread.
+  private boolean outputHeldBack;
 
   /**
    * @param inputBuffers An array of nulls that will be used to store references to input buffers.
@@ -229,8 +232,24 @@ public abstract class SimpleDecoder<
       flushed = false;
     }
 
+    // Whether the end of stream input buffer must be processed again to drain more output.
+    boolean draining = false;
     if (inputBuffer.isEndOfStream()) {
-      outputBuffer.addFlag(C.BUFFER_FLAG_END_OF_STREAM);
+      @Nullable E exception;
+      try {
+        exception = drain(outputBuffer, resetDecoder);
+      } catch (RuntimeException e) {
+        exception = createUnexpectedDecodeException(e);
+      } catch (OutOfMemoryError e) {
+        exception = createUnexpectedDecodeException(e);
+      }
+      if (exception != null) {
+        synchronized (lock) {
+          this.exception = exception;
+        }
+        return false;
+      }
+      draining = !outputBuffer.isEndOfStream();
     } else {
       if (inputBuffer.isDecodeOnly()) {
         outputBuffer.addFlag(C.BUFFER_FLAG_DECODE_ONLY);
@@ -239,6 +258,7 @@ public abstract class SimpleDecoder<
         outputBuffer.addFlag(C.BUFFER_FLAG_FIRST_SAMPLE);
       }
       @Nullable E exception;
+      outputHeldBack = false;
       try {
         exception = decode(inputBuffer, outputBuffer, resetDecoder);
       } catch (RuntimeException e) {
@@ -260,7 +280,10 @@ public abstract class SimpleDecoder<
     }
 
     synchronized (lock) {
-      if (flushed) {
+      if (outputHeldBack) {
+        // The buffer holds nothing that the subclass needs to release.
+        releaseOutputBufferInternal(outputBuffer);
+      } else if (flushed) {
         outputBuffer.release();
       } else if (outputBuffer.isDecodeOnly()) {
         skippedOutputBufferCount++;
@@ -270,8 +293,12 @@ public abstract class SimpleDecoder<
         skippedOutputBufferCount = 0;
         queuedOutputBuffers.addLast(outputBuffer);
       }
-      // Make the input buffer available again.
-      releaseInputBufferInternal(inputBuffer);
+      if (draining && !flushed) {
+        queuedInputBuffers.addFirst(inputBuffer);
+      } else {
+        // Make the input buffer available again.
+        releaseInputBufferInternal(inputBuffer);
+      }
     }
 
     return true;
@@ -312,11 +339,45 @@ public abstract class SimpleDecoder<
    * @param outputBuffer The output buffer to store decoded data. The flag {@link
    *     C#BUFFER_FLAG_DECODE_ONLY} will be set if the same flag is set on {@code inputBuffer}, but
    *     may be set/unset as required. If the flag is set when the call returns then the output
-   *     buffer will not be made available to dequeue. The output buffer may not have been populated
-   *     in this case.
+   *     buffer will not be made available to dequeue, and is counted as skipped. The output buffer
+   *     may not have been populated in this case. See also {@link #holdBackOutput()}.
    * @param reset Whether the decoder must be reset before decoding.
    * @return A decoder exception if an error occurred, or null if decoding was successful.
    */
   @Nullable
   protected abstract E decode(I inputBuffer, O outputBuffer, boolean reset);
+
+  /**
+   * Indicates that the output buffer of the current {@link #decode} call holds no output, because
+   * the output of the input buffer is held back to be output by a later call, for example when
+   * several input buffers are decoded in parallel. Unlike with {@link C#BUFFER_FLAG_DECODE_ONLY},
+   * the output buffer isn't counted as skipped, and it's reused without being released through
+   * {@link #releaseOutputBuffer}.
+   *
+   * <p>Must only be called from {@link #decode}.
+   */
+  protected final void holdBackOutput() {
+    outputHeldBack = true;
+  }
+
+  /**
+   * Called when the end of the input stream is reached, to output any data that the decoder has
+   * not output yet (for example because it decodes several buffers in parallel).
+   *
+   * <p>Implementations should store the next pending output in {@code outputBuffer}, or set {@link
+   * C#BUFFER_FLAG_END_OF_STREAM} on it if there is none. The method is called again with a new
+   * output buffer until the flag is set. The default implementation sets the flag immediately.
+   *
+   * @param outputBuffer The output buffer to store pending output. If the flag {@link
+   *     C#BUFFER_FLAG_DECODE_ONLY} is set when the call returns then the output buffer will not be
+   *     made available to dequeue.
+   * @param reset Whether the decoder must be reset before draining, because the end of stream
+   *     follows a flush directly. Output held back from before the flush must then be discarded.
+   * @return A decoder exception if an error occurred, or null if draining was successful.
+   */
+  @Nullable
+  protected E drain(O outputBuffer, boolean reset) {
+    outputBuffer.addFlag(C.BUFFER_FLAG_END_OF_STREAM);
+    return null;
+  }
 }
@@ -153,6 +153,38 @@ public class VideoDecoderOutputBuffer extends DecoderOutputBuffer {
     return true;
   }
 
+  /**
+   * Configures the buffer for a YUV frame whose planes are backed by memory owned by the decoder,
+   * rather than by {@link #data}. Called via JNI after decoding completes.
+   *
+   * <p>The planes are only valid until the buffer is released.
+   */
+  public void initForExternalYuvFrame(
+      int width,
+      int height,
+      int yStride,
+      int uvStride,
+      int colorspace,
+      ByteBuffer yPlane,
+      ByteBuffer uPlane,
+      ByteBuffer vPlane) {
+    this.width = width;
+    this.height = height;
+    this.colorspace = colorspace;
+    if (yuvPlanes == null) {
+      yuvPlanes = new ByteBuffer[3];
+    }
+    yuvPlanes[0] = yPlane;
+    yuvPlanes[1] = uPlane;
+    yuvPlanes[2] = vPlane;
+    if (yuvStrides == null) {
+      yuvStrides = new int[3];
+    }
+    yuvStrides[0] = yStride;
+    yuvStrides[1] = uvStride;
+    yuvStrides[2] = uvStride;
+  }
+
   /**
    * Configures the buffer for the given frame dimensions when passing actual frame data via {@link
    * #decoderPrivate}. Called via JNI after decoding completes.
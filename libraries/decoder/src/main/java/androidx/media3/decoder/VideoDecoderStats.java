@@ -0,0 +1,106 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package androidx.media3.decoder;
+
+import static androidx.media3.common.util.Assertions.checkArgument;
+
+import androidx.media3.common.util.UnstableApi;
+
+/**
+ * Performance counters of a native video decoder, which attribute the time spent per frame to
+ * decoding, conversion and rendering, e.g. to find the cause of dropped frames.
+ *
+ * <p>The counters cover the lifetime of the decoder. Durations are measured in native code with the
+ * monotonic clock.
+ */
+@UnstableApi
+public final class VideoDecoderStats {
+
+  /** The number of values written by native decoders. */
+  public static final int VALUE_COUNT = 15;
+
+  /** The number of frames decoded. */
+  public final long decodedFrameCount;
+
+  /** The total time spent decoding frames, in nanoseconds. */
+  public final long totalDecodeTimeNs;
+
+  /** The maximum time spent decoding a frame, in nanoseconds. */
+  public final long maxDecodeTimeNs;
+
+  /** The number of frames copied or converted to the data of YUV output buffers. */
+  public final long convertedFrameCount;
+
+  /** The total time spent copying or converting frames, in nanoseconds. */
+  public final long totalConversionTimeNs;
+
+  /** The maximum time spent copying or converting a frame, in nanoseconds. */
+  public final long maxConversionTimeNs;
+
+  /** The number of frames rendered to a surface. */
+  public final long renderedFrameCount;
+
+  /** The total time spent rendering frames, in nanoseconds. */
+  public final long totalRenderTimeNs;
+
+  /** The maximum time spent rendering a frame, in nanoseconds. */
+  public final long maxRenderTimeNs;
+
+  /** The number of frame buffers allocated by the decoder's buffer pool. */
+  public final int bufferCount;
+
+  /** The number of frame buffers in use by the decoder or by output buffers. */
+  public final int buffersInUse;
+
+  /** The maximum number of frame buffers that were in use at any one time. */
+  public final int maxBuffersInUse;
+
+  /** The number of allocations of frame buffer data, including reallocations. */
+  public final long bufferAllocationCount;
+
+  /** The number of threads used by the decoder library. */
+  public final int decoderThreadCount;
+
+  /**
+   * The number of threads used to convert high bit depth frames, or 0 if no frame has been
+   * converted.
+   */
+  public final int conversionThreadCount;
+
+  /**
+   * Creates an instance from values written by a native decoder.
+   *
+   * @param values At least {@link #VALUE_COUNT} values, in the order of the fields of this class.
+   */
+  public VideoDecoderStats(long[] values) {
+    checkArgument(values.length >= VALUE_COUNT);
+    decodedFrameCount = values[0];
+    totalDecodeTimeNs = values[1];
+    maxDecodeTimeNs = values[2];
+    convertedFrameCount = values[3];
+    totalConversionTimeNs = values[4];
+    maxConversionTimeNs = values[5];
+    renderedFrameCount = values[6];
+    totalRenderTimeNs = values[7];
+    maxRenderTimeNs = values[8];
+    bufferCount = (int) values[9];
+    buffersInUse = (int) values[10];
+    maxBuffersInUse = (int) values[11];
+    bufferAllocationCount = values[12];
+    decoderThreadCount = (int) values[13];
+    conversionThreadCount = (int) values[14];
+  }
+}
@@ -0,0 +1,84 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "bit_depth_converter.h"
+
+#include <algorithm>
+#include <cstddef>
+
+#include "cpu_info.h"  // NOLINT
+
+namespace decoder_jni {
+
+namespace {
+
+// The number of rows per band. Bands are small enough to balance the load
+// between threads, but large enough to amortize the cost of dispatching them.
+const int kBandHeight = 32;
+
+// The maximum number of planes of a frame.
+const int kMaxPlanes = 3;
+
+// The conversion is memory bound, so using more threads than this doesn't
+// help.
+const int kMaxThreads = 4;
+
+int GetNumThreads(int max_threads) {
+  const int num_cores = GetNumberOfPerformanceCoresOnline();
+  return std::max(std::min(num_cores, max_threads), 1);
+}
+
+}  // namespace
+
+BitDepthConverter::BitDepthConverter()
+    : BitDepthConverter(GetSupportedIsas(), kMaxThreads) {}
+
+BitDepthConverter::BitDepthConverter(uint32_t isas, int max_threads)
+    : kernels_(GetPixelKernels(isas)),
+      thread_pool_(GetNumThreads(max_threads)) {}
+
+void BitDepthConverter::Convert10BitTo8Bit(const Plane* planes,
+                                           int num_planes) {
+  num_planes = std::min(num_planes, kMaxPlanes);
+  // The index of the first band of each plane, and the total band count.
+  int first_band[kMaxPlanes + 1];
+  first_band[0] = 0;
+  for (int i = 0; i < num_planes; i++) {
+    const int num_bands = (planes[i].height + kBandHeight - 1) / kBandHeight;
+    first_band[i + 1] = first_band[i] + std::max(num_bands, 0);
+  }
+  const uint32_t frame_seed = MixBits(++frame_index_);
+  const PixelKernels& kernels = kernels_;
+  thread_pool_.ParallelFor(first_band[num_planes], [&](int band) {
+    int plane_index = 0;
+    while (band >= first_band[plane_index + 1]) plane_index++;
+    const Plane& plane = planes[plane_index];
+    const int row_begin = (band - first_band[plane_index]) * kBandHeight;
+    const int row_end = std::min(row_begin + kBandHeight, plane.height);
+    for (int y = row_begin; y < row_end; y++) {
+      const uint32_t row_seed = MixBits(
+          frame_seed + static_cast<uint32_t>(plane_index << 16) +
+          static_cast<uint32_t>(y));
+      kernels.convert_row_10_to_8(
+          reinterpret_cast<const uint16_t*>(
+              plane.source + static_cast<ptrdiff_t>(plane.source_stride) * y),
+          plane.destination +
+              static_cast<ptrdiff_t>(plane.destination_stride) * y,
+          plane.width, row_seed);
+    }
+  });
+}
+
+}  // namespace decoder_jni
@@ -0,0 +1,68 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef LIBRARIES_DECODER_SRC_MAIN_JNI_BIT_DEPTH_CONVERTER_H_
+#define LIBRARIES_DECODER_SRC_MAIN_JNI_BIT_DEPTH_CONVERTER_H_
+
+#include <cstdint>
+
+#include "pixel_kernels.h"  // NOLINT
+#include "thread_pool.h"  // NOLINT
+
+namespace decoder_jni {
+
+// Converts 10-bit frames to 8 bits per sample with a lightweight dither, for
+// decoders that output YUV frames to Java.
+//
+// Each plane is split into bands of rows, which are converted in parallel on a
+// persistent thread pool sized by the number of performance cores. The dither
+// of every row is seeded from the frame, plane and row index, so the output
+// doesn't depend on the number of threads, on scheduling or on the instruction
+// set used.
+class BitDepthConverter {
+ public:
+  // A plane to convert. Strides are in bytes, and |width| and |height| are in
+  // samples.
+  struct Plane {
+    const uint8_t* source;
+    int source_stride;
+    uint8_t* destination;
+    int destination_stride;
+    int width;
+    int height;
+  };
+
+  // Uses the kernels of all instruction sets supported by the device.
+  BitDepthConverter();
+  // Only uses the kernels of the instruction sets in |isas| (a bitmask of Isa
+  // values), and at most |max_threads| threads.
+  BitDepthConverter(uint32_t isas, int max_threads);
+
+  // Converts |num_planes| planes of 10-bit samples stored in 16-bit words to 8
+  // bits. Must not be called concurrently.
+  void Convert10BitTo8Bit(const Plane* planes, int num_planes);
+
+  // Returns the number of threads planes are converted on.
+  int num_threads() const { return thread_pool_.num_threads(); }
+
+ private:
+  const PixelKernels kernels_;
+  ThreadPool thread_pool_;
+  uint32_t frame_index_ = 0;
+};
+
+}  // namespace decoder_jni
+
+#endif  // LIBRARIES_DECODER_SRC_MAIN_JNI_BIT_DEPTH_CONVERTER_H_
@@ -0,0 +1,294 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "cpu_info.h"  // NOLINT
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>  // NOLINT
+#include <utility>
+
+namespace decoder_jni {
+namespace {
+
+// Note: The code in this file needs to use the 'long' type because it is the
+// return type of the Standard C Library function strtol(). The linter warnings
+// are suppressed with NOLINT comments since they are integers at runtime.
+
+// Returns the number of online processor cores.
+int GetNumberOfProcessorsOnline() {
+  // See https://developer.android.com/ndk/guides/cpu-features.
+  long num_cpus = sysconf(_SC_NPROCESSORS_ONLN);  // NOLINT
+  if (num_cpus < 0) {
+    return 0;
+  }
+  // It is safe to cast num_cpus to int. sysconf(_SC_NPROCESSORS_ONLN) returns
+  // the return value of get_nprocs(), which is an int.
+  return static_cast<int>(num_cpus);
+}
+
+// Reads the first line of the given file into buffer. Returns false on
+// failure.
+bool ReadLine(const char* path, char* buffer, int size) {
+  FILE* file = fopen(path, "r");
+  if (file == nullptr) {
+    return false;
+  }
+  char* const str = fgets(buffer, size, file);
+  fclose(file);
+  return str != nullptr;
+}
+
+#if defined(__arm__) || defined(__aarch64__)
+// Returns the positive integer value of the given attribute of the given CPU,
+// e.g. "cpufreq/cpuinfo_max_freq" or "cpu_capacity". Returns 0 on failure.
+long ReadCpuAttribute(int cpu_index, const char* attribute) {  // NOLINT
+  char buffer[128];
+  const int rv = snprintf(buffer, sizeof(buffer),
+                          "/sys/devices/system/cpu/cpu%d/%s", cpu_index,
+                          attribute);
+  if (rv < 0 || rv >= static_cast<int>(sizeof(buffer))) {
+    return 0;
+  }
+  if (!ReadLine(buffer, buffer, sizeof(buffer))) {
+    return 0;
+  }
+  const long value = strtol(buffer, nullptr, 10);  // NOLINT
+  if (value <= 0 || value == LONG_MAX) {
+    return 0;
+  }
+  return value;
+}
+#endif
+
+// Reads the indices of the online CPUs. Returns false on failure.
+bool ReadOnlineCpus(std::vector<int>* cpus) {
+  // Some examples of the online CPU list are:
+  //   "0-7"
+  //   "0"
+  //   "0-1,2,3,4-7"
+  char online[512];
+  if (!ReadLine("/sys/devices/system/cpu/online", online, sizeof(online))) {
+    return false;
+  }
+  const char* cp = online;
+  int range_begin = -1;
+  while (true) {
+    char* str_end;
+    const int cpu = static_cast<int>(strtol(cp, &str_end, 10));  // NOLINT
+    if (str_end == cp) {
+      break;
+    }
+    cp = str_end;
+    if (*cp == '-') {
+      range_begin = cpu;
+    } else {
+      if (range_begin == -1) {
+        range_begin = cpu;
+      }
+      for (int i = range_begin; i <= cpu; ++i) {
+        cpus->push_back(i);
+      }
+      range_begin = -1;
+    }
+    if (*cp == '\0') {
+      break;
+    }
+    ++cp;
+  }
+  return !cpus->empty();
+}
+
+// Groups the given CPUs into clusters of equal key (capacity or frequency),
+// fastest first.
+void GroupCpus(const std::vector<int>& cpus, const std::vector<long>& keys,
+               const std::vector<long>& freqs,  // NOLINT
+               std::vector<CpuCluster>* clusters) {
+  std::vector<long> cluster_keys;  // NOLINT
+  for (size_t i = 0; i < cpus.size(); ++i) {
+    size_t j = 0;
+    while (j < cluster_keys.size() && cluster_keys[j] != keys[i]) {
+      ++j;
+    }
+    if (j == cluster_keys.size()) {
+      cluster_keys.push_back(keys[i]);
+      clusters->push_back(CpuCluster());
+    }
+    CpuCluster& cluster = (*clusters)[j];
+    cluster.cpus.push_back(cpus[i]);
+    if (freqs[i] > cluster.max_frequency_khz) {
+      cluster.max_frequency_khz = freqs[i];
+    }
+  }
+  // Sort the clusters by decreasing key. There are only a few clusters.
+  for (size_t i = 1; i < clusters->size(); ++i) {
+    for (size_t j = i; j > 0 && cluster_keys[j - 1] < cluster_keys[j]; --j) {
+      std::swap(cluster_keys[j - 1], cluster_keys[j]);
+      std::swap((*clusters)[j - 1], (*clusters)[j]);
+    }
+  }
+  const long max_key = cluster_keys[0];  // NOLINT
+  for (size_t i = 0; i < clusters->size(); ++i) {
+    const long capacity = cluster_keys[i] * 1024 / max_key;  // NOLINT
+    (*clusters)[i].capacity = capacity > 0 ? static_cast<int>(capacity) : 1;
+  }
+}
+
+}  // namespace
+
+int CpuTopology::GetNumberOfCpus() const {
+  int num_cpus = 0;
+  for (const CpuCluster& cluster : clusters) {
+    num_cpus += static_cast<int>(cluster.cpus.size());
+  }
+  return num_cpus;
+}
+
+int CpuTopology::GetNumberOfPerformanceCores() const {
+  if (clusters.size() <= 1) {
+    return GetNumberOfCpus();
+  }
+  return GetNumberOfCpus() - static_cast<int>(clusters.back().cpus.size());
+}
+
+std::vector<int> CpuTopology::GetPerformanceCpus() const {
+  std::vector<int> cpus;
+  const size_t num_clusters =
+      clusters.size() <= 1 ? clusters.size() : clusters.size() - 1;
+  for (size_t i = 0; i < num_clusters; ++i) {
+    cpus.insert(cpus.end(), clusters[i].cpus.begin(), clusters[i].cpus.end());
+  }
+  std::sort(cpus.begin(), cpus.end());
+  return cpus;
+}
+
+// These CPUs support heterogeneous multiprocessing.
+#if defined(__arm__) || defined(__aarch64__)
+
+// Some SoCs such as Snapdragon 855 have performance cores with different max
+// frequencies, so each distinct capacity or frequency forms its own cluster and
+// only the slowest cluster is considered to be efficiency cores.
+bool ReadCpuTopology(CpuTopology* topology) {
+  std::vector<int> cpus;
+  if (!ReadOnlineCpus(&cpus)) {
+    return false;
+  }
+  std::vector<long> capacities;  // NOLINT
+  std::vector<long> freqs;       // NOLINT
+  bool has_capacities = true;
+  for (const int cpu : cpus) {
+    const long capacity = ReadCpuAttribute(cpu, "cpu_capacity");  // NOLINT
+    has_capacities = has_capacities && capacity > 0;
+    capacities.push_back(capacity);
+    freqs.push_back(ReadCpuAttribute(cpu, "cpufreq/cpuinfo_max_freq"));
+  }
+  if (!has_capacities) {
+    for (const long freq : freqs) {  // NOLINT
+      if (freq <= 0) {
+        return false;
+      }
+    }
+  }
+  topology->clusters.clear();
+  GroupCpus(cpus, has_capacities ? capacities : freqs, freqs,
+            &topology->clusters);
+  return true;
+}
+
+#else
+
+// Assume symmetric multiprocessing.
+bool ReadCpuTopology(CpuTopology* topology) {
+  std::vector<int> cpus;
+  if (!ReadOnlineCpus(&cpus)) {
+    cpus.clear();
+    const int num_cpus = GetNumberOfProcessorsOnline();
+    for (int i = 0; i < num_cpus; ++i) {
+      cpus.push_back(i);
+    }
+  }
+  if (cpus.empty()) {
+    return false;
+  }
+  topology->clusters.clear();
+  GroupCpus(cpus, std::vector<long>(cpus.size(), 1),  // NOLINT
+            std::vector<long>(cpus.size(), 0), &topology->clusters);  // NOLINT
+  return true;
+}
+
+#endif
+
+namespace {
+
+// The process-wide topology cache of GetCpuTopology().
+struct CpuTopologyCache {
+  std::mutex mutex;
+  // The following are guarded by |mutex|.
+  bool valid = false;
+  // The result of ReadCpuTopology().
+  bool available = false;
+  // The number of online CPUs when |topology| was read.
+  int num_cpus_online = 0;
+  CpuTopology topology;
+};
+
+CpuTopologyCache& GetCpuTopologyCache() {
+  // Intentionally leaked, so that it can be used during static destruction.
+  static CpuTopologyCache* const cache = new CpuTopologyCache();
+  return *cache;
+}
+
+}  // namespace
+
+bool GetCpuTopology(CpuTopology* topology) {
+  // Unlike the sysfs files of each CPU, the number of online CPUs is a single
+  // read (or cached by libc), so it's checked on every call to detect CPU
+  // hotplug.
+  const int num_cpus_online = GetNumberOfProcessorsOnline();
+  CpuTopologyCache& cache = GetCpuTopologyCache();
+  std::lock_guard<std::mutex> lock(cache.mutex);
+  if (!cache.valid || cache.num_cpus_online != num_cpus_online) {
+    cache.topology.clusters.clear();
+    cache.available = ReadCpuTopology(&cache.topology);
+    cache.num_cpus_online = num_cpus_online;
+    cache.valid = true;
+  }
+  if (cache.available) {
+    *topology = cache.topology;
+  }
+  return cache.available;
+}
+
+void InvalidateCpuTopology() {
+  CpuTopologyCache& cache = GetCpuTopologyCache();
+  std::lock_guard<std::mutex> lock(cache.mutex);
+  cache.valid = false;
+}
+
+int GetNumberOfPerformanceCoresOnline() {
+  CpuTopology topology;
+  if (!GetCpuTopology(&topology)) {
+    return 0;
+  }
+  return topology.GetNumberOfPerformanceCores();
+}
+
+}  // namespace decoder_jni
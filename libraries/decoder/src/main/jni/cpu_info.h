@@ -0,0 +1,80 @@
+/*
+ * Copyright 2021 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef LIBRARIES_DECODER_SRC_MAIN_JNI_CPU_INFO_H_
+#define LIBRARIES_DECODER_SRC_MAIN_JNI_CPU_INFO_H_
+
+#include <vector>
+
+namespace decoder_jni {
+
+// A group of online CPUs with the same performance, e.g. the big or LITTLE
+// cores of a big.LITTLE SoC.
+struct CpuCluster {
+  // The indices of the CPUs, in increasing order.
+  std::vector<int> cpus;
+  // The maximum frequency of the CPUs in kHz, or 0 if unknown.
+  long max_frequency_khz = 0;  // NOLINT
+  // The performance of the CPUs relative to the fastest CPUs of the device,
+  // from 1 to 1024 (the scale of the kernel's cpu_capacity).
+  int capacity = 0;
+};
+
+// The online CPUs, grouped by performance.
+struct CpuTopology {
+  // The clusters, fastest first. On devices without heterogeneous
+  // multiprocessing there is a single cluster.
+  std::vector<CpuCluster> clusters;
+
+  // Returns the number of online CPUs.
+  int GetNumberOfCpus() const;
+
+  // Returns the number of performance cores, i.e. of the CPUs that are not in
+  // the slowest cluster, or of all CPUs if there is a single cluster.
+  int GetNumberOfPerformanceCores() const;
+
+  // Returns the indices of the performance cores, in increasing order.
+  std::vector<int> GetPerformanceCpus() const;
+};
+
+// Reads the topology of the online CPUs from sysfs. Returns false if it
+// cannot be determined.
+//
+// CPUs are grouped by their cpu_capacity where the kernel exposes it (arm64
+// kernels with energy aware scheduling), and by cpuinfo_max_freq otherwise.
+// The latter can't tell apart cores that only differ by microarchitecture:
+// for example, the Snapdragon 632 SoC used in Motorola Moto G7 has
+// performance and efficiency cores with the same cpuinfo_max_freq.
+bool ReadCpuTopology(CpuTopology* topology);
+
+// Returns the topology of the online CPUs like ReadCpuTopology(), but only
+// reads sysfs the first time it's called in the process, or after the number
+// of online CPUs changed (e.g. after CPU hotplug) or InvalidateCpuTopology()
+// was called. Later calls return a copy of the cached topology. Thread-safe.
+bool GetCpuTopology(CpuTopology* topology);
+
+// Drops the cached topology, so that the next GetCpuTopology() call reads it
+// again. Only needed if CPUs may have been replaced by others without changing
+// the number of online CPUs. Thread-safe.
+void InvalidateCpuTopology();
+
+// Returns the number of performance cores that are available for decoding.
+// This is a heuristic that works on most common android devices. Returns 0 on
+// error or if the number of performance cores cannot be determined.
+int GetNumberOfPerformanceCoresOnline();
+
+}  // namespace decoder_jni
+
+#endif  // LIBRARIES_DECODER_SRC_MAIN_JNI_CPU_INFO_H_
@@ -0,0 +1,68 @@
+#
+# Copyright 2026 The Android Open Source Project
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+
+# Native code shared between the decoder modules, for modules using
+# ndk-build. Set DECODER_JNI_ROOT to this directory, include this file and add
+# decoder_jni to LOCAL_STATIC_LIBRARIES. See CMakeLists.txt for CMake.
+
+DECODER_JNI_SRC_FILES := bit_depth_converter.cc \
+                         cpu_info.cc \
+                         decoder_stats.cc \
+                         p010_surface.cc \
+                         pixel_kernels.cc \
+                         pixel_kernels_avx2.cc \
+                         pixel_kernels_neon.cc \
+                         pixel_kernels_sse2.cc \
+                         pixel_kernels_sse41.cc \
+                         plane_copy.cc \
+                         thread_pool.cc \
+                         thread_scheduling.cc
+
+# The SVE kernels are only used on devices supporting SVE, so only their file
+# is compiled with it.
+ifeq ($(TARGET_ARCH_ABI),arm64-v8a)
+include $(CLEAR_VARS)
+LOCAL_PATH := $(DECODER_JNI_ROOT)
+LOCAL_MODULE := decoder_jni_sve
+LOCAL_CPP_EXTENSION := .cc
+LOCAL_SRC_FILES := pixel_kernels_sve.cc
+LOCAL_CPPFLAGS := -march=armv8.2-a+sve
+include $(BUILD_STATIC_LIBRARY)
+DECODER_JNI_STATIC_LIBRARIES := decoder_jni_sve
+else
+DECODER_JNI_SRC_FILES += pixel_kernels_sve.cc
+DECODER_JNI_STATIC_LIBRARIES :=
+endif
+
+# getauxval() needs API level 18, so NEON is detected with cpufeatures on
+# armeabi-v7a.
+ifeq ($(TARGET_ARCH_ABI),armeabi-v7a)
+DECODER_JNI_STATIC_LIBRARIES += cpufeatures
+endif
+
+include $(CLEAR_VARS)
+LOCAL_PATH := $(DECODER_JNI_ROOT)
+LOCAL_MODULE := decoder_jni
+LOCAL_CPP_EXTENSION := .cc
+LOCAL_SRC_FILES := $(DECODER_JNI_SRC_FILES)
+LOCAL_STATIC_LIBRARIES := $(DECODER_JNI_STATIC_LIBRARIES)
+LOCAL_EXPORT_C_INCLUDES := $(DECODER_JNI_ROOT)
+LOCAL_EXPORT_LDLIBS := -landroid -ldl
+include $(BUILD_STATIC_LIBRARY)
+
+ifeq ($(TARGET_ARCH_ABI),armeabi-v7a)
+$(call import-module,android/cpufeatures)
+endif
@@ -0,0 +1,112 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "decoder_stats.h"
+
+#include <time.h>
+#ifdef __ANDROID__
+#include <dlfcn.h>
+#endif  // __ANDROID__
+
+namespace decoder_jni {
+
+namespace {
+
+#ifdef __ANDROID__
+// The NDK tracing API, which is looked up at runtime because it was added in
+// API level 23.
+struct TraceFunctions {
+  TraceFunctions()
+      : is_enabled(reinterpret_cast<bool (*)()>(
+            dlsym(RTLD_DEFAULT, "ATrace_isEnabled"))),
+        begin_section(reinterpret_cast<void (*)(const char*)>(
+            dlsym(RTLD_DEFAULT, "ATrace_beginSection"))),
+        end_section(reinterpret_cast<void (*)()>(
+            dlsym(RTLD_DEFAULT, "ATrace_endSection"))) {}
+
+  bool IsAvailable() const {
+    return is_enabled != nullptr && begin_section != nullptr &&
+           end_section != nullptr;
+  }
+
+  bool (*const is_enabled)();
+  void (*const begin_section)(const char*);
+  void (*const end_section)();
+};
+
+const TraceFunctions& GetTraceFunctions() {
+  static const TraceFunctions functions;
+  return functions;
+}
+#endif  // __ANDROID__
+
+}  // namespace
+
+int64_t GetMonotonicTimeNs() {
+  timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return static_cast<int64_t>(now.tv_sec) * 1000000000 + now.tv_nsec;
+}
+
+void DecoderStats::AddDuration(Stage stage, int64_t duration_ns) {
+  Durations& durations = durations_[stage];
+  durations.count.fetch_add(1, std::memory_order_relaxed);
+  durations.total_ns.fetch_add(duration_ns, std::memory_order_relaxed);
+  int64_t max_ns = durations.max_ns.load(std::memory_order_relaxed);
+  while (duration_ns > max_ns &&
+         !durations.max_ns.compare_exchange_weak(max_ns, duration_ns,
+                                                 std::memory_order_relaxed)) {
+  }
+}
+
+void DecoderStats::GetValues(int64_t* values) const {
+  for (int stage = 0; stage < kNumStages; stage++) {
+    const Durations& durations = durations_[stage];
+    values[kValueDecodeCount + 3 * stage] =
+        durations.count.load(std::memory_order_relaxed);
+    values[kValueDecodeTimeNs + 3 * stage] =
+        durations.total_ns.load(std::memory_order_relaxed);
+    values[kValueMaxDecodeTimeNs + 3 * stage] =
+        durations.max_ns.load(std::memory_order_relaxed);
+  }
+  values[kValueBufferAllocationCount] =
+      buffer_allocation_count_.load(std::memory_order_relaxed);
+  values[kValueDecoderThreadCount] =
+      decoder_thread_count_.load(std::memory_order_relaxed);
+  values[kValueConversionThreadCount] =
+      conversion_thread_count_.load(std::memory_order_relaxed);
+}
+
+ScopedTrace::ScopedTrace(const char* name) : enabled_(false) {
+#ifdef __ANDROID__
+  const TraceFunctions& functions = GetTraceFunctions();
+  enabled_ = functions.IsAvailable() && functions.is_enabled();
+  if (enabled_) {
+    functions.begin_section(name);
+  }
+#else
+  (void)name;
+#endif  // __ANDROID__
+}
+
+ScopedTrace::~ScopedTrace() {
+#ifdef __ANDROID__
+  if (enabled_) {
+    GetTraceFunctions().end_section();
+  }
+#endif  // __ANDROID__
+}
+
+}  // namespace decoder_jni
@@ -0,0 +1,172 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef LIBRARIES_DECODER_SRC_MAIN_JNI_DECODER_STATS_H_
+#define LIBRARIES_DECODER_SRC_MAIN_JNI_DECODER_STATS_H_
+
+#include <atomic>
+#include <cstdint>
+
+namespace decoder_jni {
+
+// Returns the time of the monotonic clock in nanoseconds.
+int64_t GetMonotonicTimeNs();
+
+// Performance counters of a video decoder JNI wrapper, which attribute the
+// time spent per frame to decoding, conversion and rendering.
+//
+// The counters are always updated, at the cost of a few relaxed atomic
+// operations per frame. They may be updated from any thread (e.g. buffer
+// allocations on decoder worker threads) and read concurrently by GetValues().
+class DecoderStats {
+ public:
+  // The stages whose durations are measured.
+  enum Stage {
+    // Decoding a frame in the decoder library.
+    kStageDecode,
+    // Copying or converting a frame to the data of a YUV output buffer.
+    kStageConvert,
+    // Copying a frame to a surface.
+    kStageRender,
+    kNumStages
+  };
+
+  // The values written by GetValues(), in order. Must be kept in sync with
+  // VideoDecoderStats.java.
+  enum Value {
+    // The number of measured durations, their total and their maximum in
+    // nanoseconds, for each Stage.
+    kValueDecodeCount,
+    kValueDecodeTimeNs,
+    kValueMaxDecodeTimeNs,
+    kValueConvertCount,
+    kValueConvertTimeNs,
+    kValueMaxConvertTimeNs,
+    kValueRenderCount,
+    kValueRenderTimeNs,
+    kValueMaxRenderTimeNs,
+    // The number of frame buffers in the pool, the number in use and the
+    // maximum number in use at any time.
+    kValueBufferCount,
+    kValueBuffersInUse,
+    kValueMaxBuffersInUse,
+    // The number of frame buffer data allocations, including reallocations.
+    kValueBufferAllocationCount,
+    // The number of threads of the decoder library, and of the bit depth
+    // converter (zero if no frame has been converted).
+    kValueDecoderThreadCount,
+    kValueConversionThreadCount,
+    kNumValues
+  };
+
+  DecoderStats() = default;
+
+  // Not copyable or movable.
+  DecoderStats(const DecoderStats&) = delete;
+  DecoderStats(DecoderStats&&) = delete;
+  DecoderStats& operator=(const DecoderStats&) = delete;
+  DecoderStats& operator=(DecoderStats&&) = delete;
+
+  // Adds a measured duration of |stage|.
+  void AddDuration(Stage stage, int64_t duration_ns);
+
+  // Counts an allocation of frame buffer data.
+  void AddBufferAllocation() {
+    buffer_allocation_count_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  void SetDecoderThreadCount(int count) {
+    decoder_thread_count_.store(count, std::memory_order_relaxed);
+  }
+
+  void SetConversionThreadCount(int count) {
+    conversion_thread_count_.store(count, std::memory_order_relaxed);
+  }
+
+  // Writes kNumValues values to |values|, taking the buffer counts from
+  // |frame_pool| (a FramePool).
+  template <typename Pool>
+  void GetValues(const Pool& frame_pool, int64_t* values) const {
+    GetValues(values);
+    values[kValueBufferCount] = frame_pool.num_buffers();
+    values[kValueBuffersInUse] = frame_pool.num_buffers_in_use();
+    values[kValueMaxBuffersInUse] = frame_pool.max_num_buffers_in_use();
+  }
+
+ private:
+  struct Durations {
+    std::atomic<int64_t> count{0};
+    std::atomic<int64_t> total_ns{0};
+    std::atomic<int64_t> max_ns{0};
+  };
+
+  // Writes all values except for the buffer counts.
+  void GetValues(int64_t* values) const;
+
+  Durations durations_[kNumStages];
+  std::atomic<int64_t> buffer_allocation_count_{0};
+  std::atomic<int> decoder_thread_count_{0};
+  std::atomic<int> conversion_thread_count_{0};
+};
+
+// Marks a trace section named |name| for the lifetime of the object, while
+// system tracing (e.g. with Perfetto or systrace) of the app is enabled. Does
+// nothing on devices without the NDK tracing API (before API level 23) and on
+// the host.
+class ScopedTrace {
+ public:
+  explicit ScopedTrace(const char* name);
+  ~ScopedTrace();
+
+  // Not copyable or movable.
+  ScopedTrace(const ScopedTrace&) = delete;
+  ScopedTrace(ScopedTrace&&) = delete;
+  ScopedTrace& operator=(const ScopedTrace&) = delete;
+  ScopedTrace& operator=(ScopedTrace&&) = delete;
+
+ private:
+  bool enabled_;
+};
+
+// Adds the lifetime of the object to a stage of |stats|, and marks it as a
+// trace section named |name|.
+class ScopedStageTimer {
+ public:
+  ScopedStageTimer(DecoderStats* stats, DecoderStats::Stage stage,
+                   const char* name)
+      : trace_(name),
+        stats_(stats),
+        stage_(stage),
+        start_time_ns_(GetMonotonicTimeNs()) {}
+  ~ScopedStageTimer() {
+    stats_->AddDuration(stage_, GetMonotonicTimeNs() - start_time_ns_);
+  }
+
+  // Not copyable or movable.
+  ScopedStageTimer(const ScopedStageTimer&) = delete;
+  ScopedStageTimer(ScopedStageTimer&&) = delete;
+  ScopedStageTimer& operator=(const ScopedStageTimer&) = delete;
+  ScopedStageTimer& operator=(ScopedStageTimer&&) = delete;
+
+ private:
+  const ScopedTrace trace_;
+  DecoderStats* const stats_;
+  const DecoderStats::Stage stage_;
+  const int64_t start_time_ns_;
+};
+
+}  // namespace decoder_jni
+
+#endif  // LIBRARIES_DECODER_SRC_MAIN_JNI_DECODER_STATS_H_
@@ -0,0 +1,304 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef LIBRARIES_DECODER_SRC_MAIN_JNI_FRAME_POOL_H_
+#define LIBRARIES_DECODER_SRC_MAIN_JNI_FRAME_POOL_H_
+
+#include <atomic>
+#include <cstdint>
+#include <new>
+
+namespace decoder_jni {
+
+// A pool of reference counted frame buffers shared by the video decoder JNI
+// wrappers.
+//
+// Buffers are identified by a non-negative integer id, which stays valid for
+// the lifetime of the pool. Acquire(), Get(), AddReference() and Release() are
+// lock-free and can be called concurrently from decoder worker threads and the
+// playback thread. The number of buffers is not bounded: the pool grows when
+// all existing buffers are in use.
+//
+// |T| must have a constructor taking the buffer id. Buffers are never destroyed
+// before the pool, so a released buffer keeps its allocations and can be
+// reused without reallocating.
+//
+// Released buffers are kept in one free list per size class, so callers that
+// allocate differently sized buffers (e.g. across resolution switches) can
+// reuse a buffer that already fits. The meaning of a size class is up to the
+// caller. Pools with a single size class can use Acquire().
+//
+// The pool counts the buffers in use (with at least one reference) and their
+// maximum, e.g. for DecoderStats.
+template <typename T, int kNumSizeClasses = 1>
+class FramePool {
+ public:
+  FramePool()
+      : buffer_count_(0), buffers_in_use_(0), max_buffers_in_use_(0) {
+    for (int i = 0; i < kMaxChunks; i++) {
+      chunks_[i].store(nullptr, std::memory_order_relaxed);
+    }
+    for (int i = 0; i < kNumSizeClasses; i++) {
+      free_list_heads_[i].store(0, std::memory_order_relaxed);
+    }
+  }
+
+  // Must only be called once no other thread accesses the pool.
+  ~FramePool() {
+    for (int chunk_index = 0; chunk_index < kMaxChunks; chunk_index++) {
+      Entry* const chunk = chunks_[chunk_index].load(std::memory_order_acquire);
+      if (chunk == nullptr) continue;
+      for (int i = 0; i < ChunkSize(chunk_index); i++) {
+        delete chunk[i].buffer.load(std::memory_order_relaxed);
+      }
+      delete[] chunk;
+    }
+  }
+
+  // Not copyable or movable.
+  FramePool(const FramePool&) = delete;
+  FramePool(FramePool&&) = delete;
+  FramePool& operator=(const FramePool&) = delete;
+  FramePool& operator=(FramePool&&) = delete;
+
+  // Returns a buffer with a reference count of one and sets |id| to its id.
+  // Released buffers are reused before new ones are allocated. Returns nullptr
+  // if a new buffer could not be allocated.
+  T* Acquire(int* id) {
+    T* const buffer = AcquireReleased(/*size_class=*/0, id);
+    return buffer != nullptr ? buffer : AcquireNew(/*size_class=*/0, id);
+  }
+
+  // Returns a released buffer of the given size class with a reference count
+  // of one and sets |id| to its id, or returns nullptr if there is none.
+  T* AcquireReleased(int size_class, int* id) {
+    const int free_id = PopFreeBuffer(size_class);
+    if (free_id < 0) return nullptr;
+    Entry* const entry = GetEntry(free_id);
+    entry->reference_count.store(1, std::memory_order_relaxed);
+    AddBufferInUse();
+    *id = free_id;
+    return entry->buffer.load(std::memory_order_relaxed);
+  }
+
+  // Allocates a new buffer in the given size class with a reference count of
+  // one and sets |id| to its id. Returns nullptr if the allocation failed.
+  T* AcquireNew(int size_class, int* id) {
+    const int new_id = buffer_count_.fetch_add(1, std::memory_order_relaxed);
+    Entry* const entry = GetOrCreateEntry(new_id);
+    if (entry == nullptr) return nullptr;
+    T* const buffer = new (std::nothrow) T(new_id);
+    if (buffer == nullptr) return nullptr;
+    entry->size_class = size_class;
+    entry->reference_count.store(1, std::memory_order_relaxed);
+    entry->buffer.store(buffer, std::memory_order_release);
+    AddBufferInUse();
+    *id = new_id;
+    return buffer;
+  }
+
+  // Moves a buffer to another size class, e.g. after it has been reallocated.
+  // Must only be called by the thread that acquired the buffer, before the
+  // buffer is shared.
+  void SetSizeClass(int id, int size_class) {
+    Entry* const entry = GetEntry(id);
+    if (entry != nullptr) entry->size_class = size_class;
+  }
+
+  // Returns the buffer with the given id, or nullptr if |id| is invalid.
+  T* Get(int id) const {
+    const Entry* const entry = GetEntry(id);
+    return entry == nullptr ? nullptr
+                            : entry->buffer.load(std::memory_order_acquire);
+  }
+
+  // Adds a reference to the buffer with the given id. Returns false if |id| is
+  // invalid.
+  bool AddReference(int id) {
+    Entry* const entry = GetEntry(id);
+    if (entry == nullptr) return false;
+    entry->reference_count.fetch_add(1, std::memory_order_relaxed);
+    return true;
+  }
+
+  // Removes a reference from the buffer with the given id, making it available
+  // for reuse once no references remain. Returns false if |id| is invalid or
+  // the buffer has already been released.
+  bool Release(int id) {
+    Entry* const entry = GetEntry(id);
+    if (entry == nullptr) return false;
+    int count = entry->reference_count.load(std::memory_order_relaxed);
+    do {
+      if (count <= 0) return false;
+    } while (!entry->reference_count.compare_exchange_weak(
+        count, count - 1, std::memory_order_acq_rel,
+        std::memory_order_relaxed));
+    if (count == 1) {
+      buffers_in_use_.fetch_sub(1, std::memory_order_relaxed);
+      PushFreeBuffer(entry, id);
+    }
+    return true;
+  }
+
+  // Calls |function| with every buffer allocated by the pool. Must not be
+  // called concurrently with Acquire().
+  template <typename Function>
+  void ForEach(Function function) const {
+    const int count = buffer_count_.load(std::memory_order_acquire);
+    for (int id = 0; id < count; id++) {
+      T* const buffer = Get(id);
+      if (buffer != nullptr) function(buffer);
+    }
+  }
+
+  // Returns the number of buffers allocated by the pool.
+  int num_buffers() const {
+    return buffer_count_.load(std::memory_order_relaxed);
+  }
+
+  // Returns the number of buffers that have at least one reference.
+  int num_buffers_in_use() const {
+    return buffers_in_use_.load(std::memory_order_relaxed);
+  }
+
+  // Returns the maximum number of buffers that were in use at any one time.
+  int max_num_buffers_in_use() const {
+    return max_buffers_in_use_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  struct Entry {
+    Entry()
+        : buffer(nullptr), reference_count(0), size_class(0), next_free(0) {}
+
+    std::atomic<T*> buffer;
+    std::atomic<int> reference_count;
+    // The free list the buffer is returned to. Only written while the buffer
+    // is held by a single owner, and published by the release of its last
+    // reference.
+    int size_class;
+    // The id of the next free buffer plus one, or zero if this is the last
+    // one. Only meaningful while the buffer is in the free list.
+    std::atomic<int> next_free;
+  };
+
+  // Entries are stored in chunks of doubling size so that lookups never need
+  // to take a lock or move existing entries. Chunk i holds
+  // kFirstChunkSize << i entries.
+  static const int kFirstChunkSize = 32;
+  static const int kMaxChunks = 26;
+
+  static int ChunkSize(int chunk_index) {
+    return kFirstChunkSize << chunk_index;
+  }
+
+  static int ChunkIndex(int id) {
+    const unsigned int value =
+        static_cast<unsigned int>(id / kFirstChunkSize + 1);
+    return 31 - __builtin_clz(value);
+  }
+
+  static int ChunkOffset(int id, int chunk_index) {
+    return id - kFirstChunkSize * ((1 << chunk_index) - 1);
+  }
+
+  Entry* GetEntry(int id) const {
+    if (id < 0 || id >= buffer_count_.load(std::memory_order_acquire)) {
+      return nullptr;
+    }
+    const int chunk_index = ChunkIndex(id);
+    Entry* const chunk = chunks_[chunk_index].load(std::memory_order_acquire);
+    return chunk == nullptr ? nullptr : &chunk[ChunkOffset(id, chunk_index)];
+  }
+
+  Entry* GetOrCreateEntry(int id) {
+    const int chunk_index = ChunkIndex(id);
+    if (chunk_index >= kMaxChunks) return nullptr;
+    Entry* chunk = chunks_[chunk_index].load(std::memory_order_acquire);
+    if (chunk == nullptr) {
+      Entry* const new_chunk =
+          new (std::nothrow) Entry[ChunkSize(chunk_index)];
+      if (new_chunk == nullptr) return nullptr;
+      if (chunks_[chunk_index].compare_exchange_strong(
+              chunk, new_chunk, std::memory_order_acq_rel,
+              std::memory_order_acquire)) {
+        chunk = new_chunk;
+      } else {
+        // Another thread installed the chunk first.
+        delete[] new_chunk;
+      }
+    }
+    return &chunk[ChunkOffset(id, chunk_index)];
+  }
+
+  void AddBufferInUse() {
+    const int in_use =
+        buffers_in_use_.fetch_add(1, std::memory_order_relaxed) + 1;
+    int max_in_use = max_buffers_in_use_.load(std::memory_order_relaxed);
+    while (in_use > max_in_use &&
+           !max_buffers_in_use_.compare_exchange_weak(
+               max_in_use, in_use, std::memory_order_relaxed)) {
+    }
+  }
+
+  // Each free list is a lock-free stack. Its head packs the id of the top
+  // buffer plus one (zero when empty) in the low 32 bits and a modification
+  // counter in the high 32 bits, which protects against ABA races between
+  // concurrent pops and pushes.
+  static uint64_t PackHead(uint64_t tag, int next_plus_one) {
+    return (tag << 32) | static_cast<uint32_t>(next_plus_one);
+  }
+
+  void PushFreeBuffer(Entry* entry, int id) {
+    std::atomic<uint64_t>& free_list_head = free_list_heads_[entry->size_class];
+    uint64_t head = free_list_head.load(std::memory_order_relaxed);
+    uint64_t new_head;
+    do {
+      entry->next_free.store(static_cast<int>(head & 0xFFFFFFFF),
+                             std::memory_order_relaxed);
+      new_head = PackHead((head >> 32) + 1, id + 1);
+    } while (!free_list_head.compare_exchange_weak(
+        head, new_head, std::memory_order_release, std::memory_order_relaxed));
+  }
+
+  int PopFreeBuffer(int size_class) {
+    std::atomic<uint64_t>& free_list_head = free_list_heads_[size_class];
+    uint64_t head = free_list_head.load(std::memory_order_acquire);
+    while (true) {
+      const int top_plus_one = static_cast<int>(head & 0xFFFFFFFF);
+      if (top_plus_one == 0) return -1;
+      // Buffers are never removed from the pool, so the entry stays valid
+      // even if another thread pops it concurrently. The tag makes the
+      // exchange below fail in that case.
+      const int next_plus_one = GetEntry(top_plus_one - 1)->next_free.load(
+          std::memory_order_relaxed);
+      if (free_list_head.compare_exchange_weak(
+              head, PackHead((head >> 32) + 1, next_plus_one),
+              std::memory_order_acquire, std::memory_order_acquire)) {
+        return top_plus_one - 1;
+      }
+    }
+  }
+
+  std::atomic<Entry*> chunks_[kMaxChunks];
+  std::atomic<uint64_t> free_list_heads_[kNumSizeClasses];
+  std::atomic<int> buffer_count_;
+  std::atomic<int> buffers_in_use_;
+  std::atomic<int> max_buffers_in_use_;
+};
+
+}  // namespace decoder_jni
+
+#endif  // LIBRARIES_DECODER_SRC_MAIN_JNI_FRAME_POOL_H_
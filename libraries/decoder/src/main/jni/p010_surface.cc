@@ -0,0 +1,214 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "p010_surface.h"
+
+#include <android/hardware_buffer.h>
+#include <dlfcn.h>
+
+#include <algorithm>
+
+namespace decoder_jni {
+
+namespace {
+
+// ADataSpace components. See android/data_space.h.
+const int32_t kStandardBt709 = 1 << 16;
+const int32_t kStandardBt2020 = 6 << 16;
+const int32_t kTransferSmpte170m = 3 << 22;
+const int32_t kTransferSt2084 = 7 << 22;
+const int32_t kTransferHlg = 8 << 22;
+const int32_t kRangeFull = 1 << 27;
+const int32_t kRangeLimited = 2 << 27;
+
+using SetBuffersDataSpaceFunction = int32_t (*)(ANativeWindow*, int32_t);
+
+// Returns ANativeWindow_setBuffersDataSpace, which is looked up at runtime
+// because it was added in API level 28.
+SetBuffersDataSpaceFunction GetSetBuffersDataSpaceFunction() {
+  static const SetBuffersDataSpaceFunction function =
+      reinterpret_cast<SetBuffersDataSpaceFunction>(
+          dlsym(RTLD_DEFAULT, "ANativeWindow_setBuffersDataSpace"));
+  return function;
+}
+
+// The AHardwareBuffer functions used to query the layout of P010 buffers.
+struct HardwareBufferFunctions {
+  int (*allocate)(const AHardwareBuffer_Desc*, AHardwareBuffer**);
+  int (*lock_planes)(AHardwareBuffer*, uint64_t, int32_t, const ARect*,
+                     AHardwareBuffer_Planes*);
+  int (*unlock)(AHardwareBuffer*, int32_t*);
+  void (*release)(AHardwareBuffer*);
+};
+
+// Returns the AHardwareBuffer functions, which are looked up at runtime because
+// AHardwareBuffer_lockPlanes was added in API level 29. Their values are null
+// if any of them isn't available.
+const HardwareBufferFunctions& GetHardwareBufferFunctions() {
+  static const HardwareBufferFunctions functions = []() {
+    HardwareBufferFunctions result;
+    result.allocate = reinterpret_cast<decltype(result.allocate)>(
+        dlsym(RTLD_DEFAULT, "AHardwareBuffer_allocate"));
+    result.lock_planes = reinterpret_cast<decltype(result.lock_planes)>(
+        dlsym(RTLD_DEFAULT, "AHardwareBuffer_lockPlanes"));
+    result.unlock = reinterpret_cast<decltype(result.unlock)>(
+        dlsym(RTLD_DEFAULT, "AHardwareBuffer_unlock"));
+    result.release = reinterpret_cast<decltype(result.release)>(
+        dlsym(RTLD_DEFAULT, "AHardwareBuffer_release"));
+    if (!result.allocate || !result.lock_planes || !result.unlock ||
+        !result.release) {
+      result = HardwareBufferFunctions();
+    }
+    return result;
+  }();
+  return functions;
+}
+
+// Queries the layout of |width| x |height| P010 buffers. Returns false if it
+// isn't known or isn't one that CopyFrameToP010Buffer can write.
+bool QueryP010Layout(int width, int height, P010Layout* layout) {
+  const HardwareBufferFunctions& functions = GetHardwareBufferFunctions();
+  if (!functions.lock_planes) {
+    return false;
+  }
+  AHardwareBuffer_Desc description = {};
+  description.width = width;
+  description.height = height;
+  description.layers = 1;
+  description.format = kImageFormatYCbCrP010;
+  // Window buffers are also written by the CPU and read by the GPU or the
+  // compositor.
+  description.usage = AHARDWAREBUFFER_USAGE_CPU_WRITE_OFTEN |
+                      AHARDWAREBUFFER_USAGE_GPU_SAMPLED_IMAGE;
+  AHardwareBuffer* hardware_buffer = nullptr;
+  if (functions.allocate(&description, &hardware_buffer) != 0 ||
+      hardware_buffer == nullptr) {
+    return false;
+  }
+  bool known = false;
+  AHardwareBuffer_Planes planes;
+  if (functions.lock_planes(hardware_buffer,
+                            AHARDWAREBUFFER_USAGE_CPU_WRITE_OFTEN,
+                            /*fence=*/-1, /*rect=*/nullptr, &planes) == 0) {
+    const AHardwareBuffer_Plane& y = planes.planes[0];
+    const AHardwareBuffer_Plane& u = planes.planes[1];
+    const AHardwareBuffer_Plane& v = planes.planes[2];
+    const uint8_t* const y_data = static_cast<const uint8_t*>(y.data);
+    const uint8_t* const u_data = static_cast<const uint8_t*>(u.data);
+    const uint8_t* const v_data = static_cast<const uint8_t*>(v.data);
+    // The UV plane has to follow the Y plane, with V samples right after U
+    // samples.
+    known = planes.planeCount == 3 && y.pixelStride == 2 &&
+            u.pixelStride == 4 && v.pixelStride == 4 &&
+            u.rowStride == v.rowStride && v_data == u_data + 2 &&
+            u_data - y_data >= static_cast<int64_t>(y.rowStride) * height;
+    if (known) {
+      layout->y_stride = y.rowStride;
+      layout->uv_offset = static_cast<int>(u_data - y_data);
+      layout->uv_stride = u.rowStride;
+    }
+    functions.unlock(hardware_buffer, /*fence=*/nullptr);
+  }
+  functions.release(hardware_buffer);
+  return known;
+}
+
+}  // namespace
+
+const P010Layout* P010LayoutCache::Get(int width, int height) {
+  if (disabled_) {
+    return nullptr;
+  }
+  if (width != width_ || height != height_) {
+    width_ = width;
+    height_ = height;
+    known_ = QueryP010Layout(width, height, &layout_);
+  }
+  return known_ ? &layout_ : nullptr;
+}
+
+int32_t GetHighBitDepthDataSpace(bool bt2020, int color_transfer,
+                                 bool full_range) {
+  int32_t transfer;
+  switch (color_transfer) {
+    case kColorTransferSdr:
+      transfer = kTransferSmpte170m;
+      break;
+    case kColorTransferSt2084:
+      transfer = kTransferSt2084;
+      break;
+    case kColorTransferHlg:
+      transfer = kTransferHlg;
+      break;
+    default:
+      return 0;
+  }
+  return (bt2020 ? kStandardBt2020 : kStandardBt709) | transfer |
+         (full_range ? kRangeFull : kRangeLimited);
+}
+
+bool SetNativeWindowDataSpace(ANativeWindow* window, int32_t data_space) {
+  const SetBuffersDataSpaceFunction set_buffers_data_space =
+      GetSetBuffersDataSpaceFunction();
+  return set_buffers_data_space != nullptr &&
+         set_buffers_data_space(window, data_space) == 0;
+}
+
+bool CopyFrameToP010Buffer(const PlaneCopier& plane_copier,
+                           const uint8_t* const planes[3],
+                           const int strides[3], int width, int height,
+                           int bit_depth, const P010Layout& layout,
+                           const ANativeWindow_Buffer& buffer) {
+  // P010 samples are MSB-aligned. Consumers only read the 10 most significant
+  // bits, so higher bit depths are truncated.
+  const int shift = std::max(16 - bit_depth, 0);
+  // The buffer's stride is in pixels, and P010 samples take two bytes.
+  const int y_stride = buffer.stride * 2;
+  const int copy_height = std::min(height, static_cast<int>(buffer.height));
+  uint8_t* const y_plane = static_cast<uint8_t*>(buffer.bits);
+  plane_copier.ShiftPlane16(planes[0], strides[0], y_plane, y_stride, width,
+                            copy_height, shift);
+  if (y_stride != layout.y_stride) {
+    return false;
+  }
+
+  plane_copier.InterleaveChromaPlanes16(
+      planes[1], strides[1], planes[2], strides[2], y_plane + layout.uv_offset,
+      layout.uv_stride, (width + 1) / 2, (copy_height + 1) / 2, shift);
+  return true;
+}
+
+void ConvertFrameToYv12Buffer(BitDepthConverter* bit_depth_converter,
+                              const uint8_t* const planes[3],
+                              const int strides[3], int width, int height,
+                              const ANativeWindow_Buffer& buffer) {
+  // YV12 has a Y plane followed by V and U planes, whose stride is half of the
+  // Y stride, aligned to 16 bytes.
+  const int copy_height = std::min(height, static_cast<int>(buffer.height));
+  const int uv_stride = ((buffer.stride / 2) + 15) & ~15;
+  const int buffer_uv_height = (buffer.height + 1) / 2;
+  uint8_t* const y_plane = static_cast<uint8_t*>(buffer.bits);
+  uint8_t* const v_plane = y_plane + buffer.stride * buffer.height;
+  uint8_t* const u_plane = v_plane + uv_stride * buffer_uv_height;
+  const int uv_width = (width + 1) / 2;
+  const int uv_height = (copy_height + 1) / 2;
+  const BitDepthConverter::Plane converted_planes[3] = {
+      {planes[0], strides[0], y_plane, buffer.stride, width, copy_height},
+      {planes[1], strides[1], u_plane, uv_stride, uv_width, uv_height},
+      {planes[2], strides[2], v_plane, uv_stride, uv_width, uv_height}};
+  bit_depth_converter->Convert10BitTo8Bit(converted_planes, 3);
+}
+
+}  // namespace decoder_jni
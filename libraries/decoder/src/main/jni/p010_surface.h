@@ -0,0 +1,100 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef LIBRARIES_DECODER_SRC_MAIN_JNI_P010_SURFACE_H_
+#define LIBRARIES_DECODER_SRC_MAIN_JNI_P010_SURFACE_H_
+
+#include <android/native_window.h>
+
+#include <cstdint>
+
+#include "bit_depth_converter.h"  // NOLINT
+#include "plane_copy.h"  // NOLINT
+
+namespace decoder_jni {
+
+// Android's YCbCr P010 format (AHARDWAREBUFFER_FORMAT_YCbCr_P010). Samples are
+// stored in the high bits of 16-bit words, with a Y plane and an interleaved UV
+// plane. Where the UV plane starts depends on the device.
+const int kImageFormatYCbCrP010 = 0x36;
+
+// The layout of a P010 buffer. Offsets and strides are in bytes.
+struct P010Layout {
+  int y_stride;
+  // The offset of the UV plane from the start of the Y plane.
+  int uv_offset;
+  int uv_stride;
+};
+
+// Caches the layout of P010 buffers of the current frame size.
+//
+// Window buffers don't expose their planes, so the layout is queried with
+// AHardwareBuffer_lockPlanes (API level 29) on a CPU-writable P010 buffer of
+// the same size, which is only allocated when the frame size changes.
+class P010LayoutCache {
+ public:
+  // Returns the layout of |width| x |height| P010 buffers, or nullptr if it
+  // isn't known, e.g. before API level 29, if the device can't allocate P010
+  // buffers, or after Disable.
+  const P010Layout* Get(int width, int height);
+
+  // Makes Get return nullptr from now on, e.g. if a window rejected P010.
+  void Disable() { disabled_ = true; }
+
+ private:
+  bool disabled_ = false;
+  int width_ = 0;
+  int height_ = 0;
+  bool known_ = false;
+  P010Layout layout_ = {};
+};
+
+// Color transfer values, matching C.COLOR_TRANSFER_*.
+const int kColorTransferSdr = 3;
+const int kColorTransferSt2084 = 6;
+const int kColorTransferHlg = 7;
+
+// Returns the ADataSpace for high bit depth frames with the given color
+// transfer (one of the kColorTransfer* values), or 0 (ADATASPACE_UNKNOWN) if
+// the transfer isn't known.
+int32_t GetHighBitDepthDataSpace(bool bt2020, int color_transfer,
+                                 bool full_range);
+
+// Sets the data space of buffers queued to |window|. Returns false if the
+// device doesn't support setting the data space (before API level 28).
+bool SetNativeWindowDataSpace(ANativeWindow* window, int32_t data_space);
+
+// Copies a 4:2:0 frame with 16-bit samples of |bit_depth| bits into a locked
+// ANativeWindow buffer whose format is kImageFormatYCbCrP010, with |layout|.
+// Strides are in bytes. Returns false if the stride of |buffer| doesn't match
+// |layout|, in which case only the Y plane is copied, as the UV plane can't be
+// located.
+bool CopyFrameToP010Buffer(const PlaneCopier& plane_copier,
+                           const uint8_t* const planes[3],
+                           const int strides[3], int width, int height,
+                           int bit_depth, const P010Layout& layout,
+                           const ANativeWindow_Buffer& buffer);
+
+// Converts a 4:2:0 frame with 10-bit samples stored in 16-bit words to 8 bits,
+// into a locked ANativeWindow buffer whose format is YV12, for windows that
+// can't be rendered to as P010. Strides are in bytes.
+void ConvertFrameToYv12Buffer(BitDepthConverter* bit_depth_converter,
+                              const uint8_t* const planes[3],
+                              const int strides[3], int width, int height,
+                              const ANativeWindow_Buffer& buffer);
+
+}  // namespace decoder_jni
+
+#endif  // LIBRARIES_DECODER_SRC_MAIN_JNI_P010_SURFACE_H_
@@ -0,0 +1,135 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "pixel_kernels.h"
+
+#if defined(__arm__) && defined(__ANDROID__)
+#include <cpu-features.h>
+#elif defined(__arm__) || defined(__aarch64__)
+#include <sys/auxv.h>
+#elif defined(__i386__) || defined(__x86_64__)
+#include <emmintrin.h>
+#endif
+
+#include <cstring>
+
+#include "pixel_kernels_internal.h"  // NOLINT
+
+namespace decoder_jni {
+
+namespace {
+
+#if defined(__aarch64__)
+const unsigned long kHwcapSve = 1 << 22;  // NOLINT
+#elif defined(__arm__) && !defined(__ANDROID__)
+const unsigned long kHwcapNeon = 1 << 12;  // NOLINT
+#endif
+
+uint32_t DetectIsas() {
+  uint32_t isas = 0;
+#if defined(__aarch64__)
+  // NEON is mandatory on arm64.
+  isas |= kIsaNeon;
+  if (getauxval(AT_HWCAP) & kHwcapSve) isas |= kIsaSve;
+#elif defined(__arm__)
+  // NEON is optional on armeabi-v7a.
+#if defined(__ANDROID__)
+  // getauxval() needs API level 18, so use the NDK's cpufeatures library.
+  if (android_getCpuFeatures() & ANDROID_CPU_ARM_FEATURE_NEON) {
+    isas |= kIsaNeon;
+  }
+#else
+  if (getauxval(AT_HWCAP) & kHwcapNeon) isas |= kIsaNeon;
+#endif  // defined(__ANDROID__)
+#elif defined(__i386__) || defined(__x86_64__)
+  // SSE2 is part of all Android x86 ABIs.
+  isas |= kIsaSse2;
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("sse4.1")) isas |= kIsaSse41;
+  if (__builtin_cpu_supports("avx2")) isas |= kIsaAvx2;
+#endif
+  return isas;
+}
+
+void CopyRowMemcpy(const uint8_t* source, uint8_t* destination, int width) {
+  std::memcpy(destination, source, width);
+}
+
+void CopyRowPairMemcpy(const uint8_t* source_a, const uint8_t* source_b,
+                       uint8_t* destination_a, uint8_t* destination_b,
+                       int width) {
+  std::memcpy(destination_a, source_a, width);
+  std::memcpy(destination_b, source_b, width);
+}
+
+void ConvertRow10To8(const uint16_t* source, uint8_t* destination, int width,
+                     uint32_t seed) {
+  ConvertRow10To8Standard(source, destination, width, seed,
+                          /*first_index=*/0);
+}
+
+}  // namespace
+
+void ShiftRow16Standard(const uint16_t* source, uint16_t* destination,
+                        int width, int shift) {
+  for (int x = 0; x < width; x++) {
+    destination[x] = static_cast<uint16_t>(source[x] << shift);
+  }
+}
+
+void InterleaveRow16Standard(const uint16_t* source_a,
+                             const uint16_t* source_b, uint16_t* destination,
+                             int width, int shift) {
+  for (int x = 0; x < width; x++) {
+    destination[2 * x] = static_cast<uint16_t>(source_a[x] << shift);
+    destination[2 * x + 1] = static_cast<uint16_t>(source_b[x] << shift);
+  }
+}
+
+void ConvertRow10To8Standard(const uint16_t* source, uint8_t* destination,
+                             int width, uint32_t seed, int first_index) {
+  for (int x = 0; x < width; x++) {
+    destination[x] = Convert10To8(source[x], GetDither(seed, first_index + x));
+  }
+}
+
+uint32_t GetSupportedIsas() {
+  static const uint32_t isas = DetectIsas();
+  return isas;
+}
+
+PixelKernels GetPixelKernels(uint32_t isas) {
+  PixelKernels kernels = {CopyRowMemcpy,      CopyRowMemcpy,
+                          CopyRowPairMemcpy,  CopyRowPairMemcpy,
+                          ShiftRow16Standard, InterleaveRow16Standard,
+                          ConvertRow10To8};
+  // Kernels of later instruction sets take precedence.
+  if (isas & kIsaNeon) AddNeonKernels(&kernels);
+  if (isas & kIsaSve) AddSveKernels(&kernels);
+  if (isas & kIsaSse2) AddSse2Kernels(&kernels);
+  if (isas & kIsaSse41) AddSse41Kernels(&kernels);
+  if (isas & kIsaAvx2) AddAvx2Kernels(&kernels);
+  return kernels;
+}
+
+void FinishStreamingStores() {
+#if defined(__i386__) || defined(__x86_64__)
+  _mm_sfence();
+#elif defined(__aarch64__)
+  __asm__ __volatile__("dmb ishst" ::: "memory");
+#endif
+}
+
+}  // namespace decoder_jni
@@ -0,0 +1,88 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef LIBRARIES_DECODER_SRC_MAIN_JNI_PIXEL_KERNELS_H_
+#define LIBRARIES_DECODER_SRC_MAIN_JNI_PIXEL_KERNELS_H_
+
+#include <cstdint>
+
+namespace decoder_jni {
+
+// SIMD instruction set extensions that pixel kernels are specialized for.
+enum Isa : uint32_t {
+  kIsaNeon = 1 << 0,
+  kIsaSve = 1 << 1,
+  kIsaSse2 = 1 << 2,
+  kIsaSse41 = 1 << 3,
+  kIsaAvx2 = 1 << 4,
+};
+
+// Returns a bitmask of the Isa values supported by the device. They are
+// detected at runtime on the first call.
+uint32_t GetSupportedIsas();
+
+// Row kernels shared by the video decoder JNI wrappers. All implementations of
+// a kernel produce identical output.
+struct PixelKernels {
+  // Copies |width| bytes.
+  void (*copy_row)(const uint8_t* source, uint8_t* destination, int width);
+  // Like copy_row, but bypasses the cache where supported. Callers must call
+  // FinishStreamingStores() once done.
+  void (*copy_row_streaming)(const uint8_t* source, uint8_t* destination,
+                             int width);
+  // Copies |width| bytes of two rows in a single pass.
+  void (*copy_row_pair)(const uint8_t* source_a, const uint8_t* source_b,
+                        uint8_t* destination_a, uint8_t* destination_b,
+                        int width);
+  // Like copy_row_pair, but bypasses the cache where supported.
+  void (*copy_row_pair_streaming)(const uint8_t* source_a,
+                                  const uint8_t* source_b,
+                                  uint8_t* destination_a,
+                                  uint8_t* destination_b, int width);
+  // Copies |width| 16-bit samples, shifting them left by |shift| bits.
+  void (*shift_row_16)(const uint16_t* source, uint16_t* destination,
+                       int width, int shift);
+  // Interleaves |width| 16-bit samples of two rows, shifting them left by
+  // |shift| bits.
+  void (*interleave_row_16)(const uint16_t* source_a, const uint16_t* source_b,
+                            uint16_t* destination, int width, int shift);
+  // Converts |width| 10-bit samples to 8 bits with a random dither. Sample i
+  // is rounded by the two low bits of byte i % 4 of MixBits(seed + i / 4), and
+  // the result saturates at 255.
+  void (*convert_row_10_to_8)(const uint16_t* source, uint8_t* destination,
+                              int width, uint32_t seed);
+};
+
+// Returns the fastest kernels that only use the instruction sets in |isas|,
+// which must be supported by the device.
+PixelKernels GetPixelKernels(uint32_t isas);
+
+// Makes streaming stores visible to other threads and devices (such as the
+// compositor reading an ANativeWindow buffer).
+void FinishStreamingStores();
+
+// Mixes the bits of |value| (the MurmurHash3 finalizer).
+inline uint32_t MixBits(uint32_t value) {
+  value ^= value >> 16;
+  value *= 0x85ebca6b;
+  value ^= value >> 13;
+  value *= 0xc2b2ae35;
+  value ^= value >> 16;
+  return value;
+}
+
+}  // namespace decoder_jni
+
+#endif  // LIBRARIES_DECODER_SRC_MAIN_JNI_PIXEL_KERNELS_H_
@@ -0,0 +1,227 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "pixel_kernels_internal.h"  // NOLINT
+
+#if defined(__i386__) || defined(__x86_64__)
+#include <immintrin.h>
+
+#include <cstring>
+#endif
+
+namespace decoder_jni {
+
+#if defined(__i386__) || defined(__x86_64__)
+
+namespace {
+
+// The kernels are compiled for AVX2 individually, so that the rest of the
+// library keeps running on devices without it.
+#define AVX2_TARGET __attribute__((target("avx2")))
+
+// Returns the number of bytes to copy before |destination| is 32-byte aligned,
+// as required by streaming stores.
+inline int UnalignedHeadSize(const uint8_t* destination, int width) {
+  const int head =
+      static_cast<int>(-reinterpret_cast<uintptr_t>(destination) & 31);
+  return head < width ? head : width;
+}
+
+AVX2_TARGET inline __m256i Load32(const void* source) {
+  return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(source));
+}
+
+template <bool kStreaming>
+AVX2_TARGET inline void Store32(void* destination, __m256i value) {
+  if (kStreaming) {
+    _mm256_stream_si256(reinterpret_cast<__m256i*>(destination), value);
+  } else {
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(destination), value);
+  }
+}
+
+template <bool kStreaming>
+AVX2_TARGET void CopyRowAvx2(const uint8_t* source, uint8_t* destination,
+                             int width) {
+  int x = 0;
+  if (kStreaming) {
+    x = UnalignedHeadSize(destination, width);
+    std::memcpy(destination, source, x);
+  }
+  for (; x + 128 <= width; x += 128) {
+    Prefetch(source + x + kPrefetchDistance);
+    Prefetch(source + x + kPrefetchDistance + 64);
+    const __m256i v0 = Load32(source + x);
+    const __m256i v1 = Load32(source + x + 32);
+    const __m256i v2 = Load32(source + x + 64);
+    const __m256i v3 = Load32(source + x + 96);
+    Store32<kStreaming>(destination + x, v0);
+    Store32<kStreaming>(destination + x + 32, v1);
+    Store32<kStreaming>(destination + x + 64, v2);
+    Store32<kStreaming>(destination + x + 96, v3);
+  }
+  for (; x + 32 <= width; x += 32) {
+    Store32<kStreaming>(destination + x, Load32(source + x));
+  }
+  if (x < width) {
+    std::memcpy(destination + x, source + x, width - x);
+  }
+}
+
+template <bool kStreaming>
+AVX2_TARGET void CopyRowPairAvx2(const uint8_t* source_a,
+                                 const uint8_t* source_b,
+                                 uint8_t* destination_a,
+                                 uint8_t* destination_b, int width) {
+  // Streaming stores need aligned destinations, so the combined pass is only
+  // used when both destination rows are aligned the same way.
+  if (kStreaming && UnalignedHeadSize(destination_a, width) !=
+                        UnalignedHeadSize(destination_b, width)) {
+    CopyRowAvx2<kStreaming>(source_a, destination_a, width);
+    CopyRowAvx2<kStreaming>(source_b, destination_b, width);
+    return;
+  }
+  int x = 0;
+  if (kStreaming) {
+    x = UnalignedHeadSize(destination_a, width);
+    std::memcpy(destination_a, source_a, x);
+    std::memcpy(destination_b, source_b, x);
+  }
+  for (; x + 64 <= width; x += 64) {
+    Prefetch(source_a + x + kPrefetchDistance);
+    Prefetch(source_b + x + kPrefetchDistance);
+    const __m256i a0 = Load32(source_a + x);
+    const __m256i a1 = Load32(source_a + x + 32);
+    const __m256i b0 = Load32(source_b + x);
+    const __m256i b1 = Load32(source_b + x + 32);
+    Store32<kStreaming>(destination_a + x, a0);
+    Store32<kStreaming>(destination_a + x + 32, a1);
+    Store32<kStreaming>(destination_b + x, b0);
+    Store32<kStreaming>(destination_b + x + 32, b1);
+  }
+  for (; x + 32 <= width; x += 32) {
+    Store32<kStreaming>(destination_a + x, Load32(source_a + x));
+    Store32<kStreaming>(destination_b + x, Load32(source_b + x));
+  }
+  if (x < width) {
+    std::memcpy(destination_a + x, source_a + x, width - x);
+    std::memcpy(destination_b + x, source_b + x, width - x);
+  }
+}
+
+AVX2_TARGET void ShiftRow16Avx2(const uint16_t* source, uint16_t* destination,
+                                int width, int shift) {
+  const __m128i shift_vector = _mm_cvtsi32_si128(shift);
+  int x = 0;
+  for (; x + 32 <= width; x += 32) {
+    Prefetch(reinterpret_cast<const uint8_t*>(source + x) + kPrefetchDistance);
+    const __m256i v0 = Load32(source + x);
+    const __m256i v1 = Load32(source + x + 16);
+    Store32</*kStreaming=*/false>(destination + x,
+                                  _mm256_sll_epi16(v0, shift_vector));
+    Store32</*kStreaming=*/false>(destination + x + 16,
+                                  _mm256_sll_epi16(v1, shift_vector));
+  }
+  ShiftRow16Standard(source + x, destination + x, width - x, shift);
+}
+
+AVX2_TARGET void InterleaveRow16Avx2(const uint16_t* source_a,
+                                     const uint16_t* source_b,
+                                     uint16_t* destination, int width,
+                                     int shift) {
+  const __m128i shift_vector = _mm_cvtsi32_si128(shift);
+  int x = 0;
+  for (; x + 16 <= width; x += 16) {
+    Prefetch(reinterpret_cast<const uint8_t*>(source_a + x) +
+             kPrefetchDistance);
+    Prefetch(reinterpret_cast<const uint8_t*>(source_b + x) +
+             kPrefetchDistance);
+    const __m256i a = _mm256_sll_epi16(Load32(source_a + x), shift_vector);
+    const __m256i b = _mm256_sll_epi16(Load32(source_b + x), shift_vector);
+    // Unpacking works within 128-bit lanes, so the halves are reordered.
+    const __m256i low = _mm256_unpacklo_epi16(a, b);
+    const __m256i high = _mm256_unpackhi_epi16(a, b);
+    Store32</*kStreaming=*/false>(destination + 2 * x,
+                                  _mm256_permute2x128_si256(low, high, 0x20));
+    Store32</*kStreaming=*/false>(destination + 2 * x + 16,
+                                  _mm256_permute2x128_si256(low, high, 0x31));
+  }
+  InterleaveRow16Standard(source_a + x, source_b + x, destination + 2 * x,
+                          width - x, shift);
+}
+
+// Returns the dither of 32 samples starting at sample |index| of a row, which
+// must be a multiple of four.
+AVX2_TARGET inline __m256i GetDither32(uint32_t seed, int index) {
+  __m256i value = _mm256_add_epi32(
+      _mm256_set1_epi32(
+          static_cast<int>(seed + static_cast<uint32_t>(index / 4))),
+      _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+  value = _mm256_xor_si256(value, _mm256_srli_epi32(value, 16));
+  value = _mm256_mullo_epi32(
+      value, _mm256_set1_epi32(static_cast<int>(0x85ebca6b)));
+  value = _mm256_xor_si256(value, _mm256_srli_epi32(value, 13));
+  value = _mm256_mullo_epi32(
+      value, _mm256_set1_epi32(static_cast<int>(0xc2b2ae35)));
+  value = _mm256_xor_si256(value, _mm256_srli_epi32(value, 16));
+  // Byte j of lane k is the dither source of sample 4 * k + j.
+  return _mm256_and_si256(value, _mm256_set1_epi8(3));
+}
+
+AVX2_TARGET void ConvertRow10To8Avx2(const uint16_t* source,
+                                     uint8_t* destination, int width,
+                                     uint32_t seed) {
+  int x = 0;
+  for (; x + 32 <= width; x += 32) {
+    Prefetch(reinterpret_cast<const uint8_t*>(source + x) + kPrefetchDistance);
+    const __m256i dither = GetDither32(seed, x);
+    const __m256i v0 = _mm256_adds_epu16(
+        Load32(source + x),
+        _mm256_cvtepu8_epi16(_mm256_castsi256_si128(dither)));
+    const __m256i v1 = _mm256_adds_epu16(
+        Load32(source + x + 16),
+        _mm256_cvtepu8_epi16(_mm256_extracti128_si256(dither, 1)));
+    // packus works within 128-bit lanes, so the 64-bit quarters are
+    // reordered. The shifted values fit in 15 bits, so its signed saturation
+    // clamps them to 255 as required.
+    const __m256i packed = _mm256_packus_epi16(_mm256_srli_epi16(v0, 2),
+                                               _mm256_srli_epi16(v1, 2));
+    Store32</*kStreaming=*/false>(destination + x,
+                                  _mm256_permute4x64_epi64(packed, 0xD8));
+  }
+  ConvertRow10To8Standard(source + x, destination + x, width - x, seed, x);
+}
+
+#undef AVX2_TARGET
+
+}  // namespace
+
+void AddAvx2Kernels(PixelKernels* kernels) {
+  kernels->copy_row = CopyRowAvx2</*kStreaming=*/false>;
+  kernels->copy_row_streaming = CopyRowAvx2</*kStreaming=*/true>;
+  kernels->copy_row_pair = CopyRowPairAvx2</*kStreaming=*/false>;
+  kernels->copy_row_pair_streaming = CopyRowPairAvx2</*kStreaming=*/true>;
+  kernels->shift_row_16 = ShiftRow16Avx2;
+  kernels->interleave_row_16 = InterleaveRow16Avx2;
+  kernels->convert_row_10_to_8 = ConvertRow10To8Avx2;
+}
+
+#else  // !(defined(__i386__) || defined(__x86_64__))
+
+void AddAvx2Kernels(PixelKernels* kernels) { (void)kernels; }
+
+#endif  // defined(__i386__) || defined(__x86_64__)
+
+}  // namespace decoder_jni
@@ -0,0 +1,69 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef LIBRARIES_DECODER_SRC_MAIN_JNI_PIXEL_KERNELS_INTERNAL_H_
+#define LIBRARIES_DECODER_SRC_MAIN_JNI_PIXEL_KERNELS_INTERNAL_H_
+
+#include <algorithm>
+#include <cstdint>
+
+#include "pixel_kernels.h"  // NOLINT
+
+namespace decoder_jni {
+
+// How far ahead of the current position sources are prefetched.
+const int kPrefetchDistance = 256;
+
+inline void Prefetch(const void* address) {
+  // Prefetches never fault, so prefetching past the end of a row is fine.
+  __builtin_prefetch(address, /*rw=*/0, /*locality=*/0);
+}
+
+// Returns the dither of sample |index| of a row, as documented for
+// PixelKernels::convert_row_10_to_8.
+inline int GetDither(uint32_t seed, int index) {
+  return (MixBits(seed + static_cast<uint32_t>(index / 4)) >>
+          (8 * (index % 4))) &
+         3;
+}
+
+inline uint8_t Convert10To8(uint16_t sample, int dither) {
+  return static_cast<uint8_t>(std::min((sample + dither) >> 2, 255));
+}
+
+// Portable implementations, used when no SIMD kernel is available and for the
+// last samples of rows.
+void ShiftRow16Standard(const uint16_t* source, uint16_t* destination,
+                        int width, int shift);
+void InterleaveRow16Standard(const uint16_t* source_a,
+                             const uint16_t* source_b, uint16_t* destination,
+                             int width, int shift);
+// |first_index| is the index of the first sample within the row, which must
+// be a multiple of four.
+void ConvertRow10To8Standard(const uint16_t* source, uint8_t* destination,
+                             int width, uint32_t seed, int first_index);
+
+// Each of these replaces the kernels in |kernels| that have an implementation
+// for the instruction set. They do nothing when building for an architecture
+// without the instruction set.
+void AddNeonKernels(PixelKernels* kernels);
+void AddSveKernels(PixelKernels* kernels);
+void AddSse2Kernels(PixelKernels* kernels);
+void AddSse41Kernels(PixelKernels* kernels);
+void AddAvx2Kernels(PixelKernels* kernels);
+
+}  // namespace decoder_jni
+
+#endif  // LIBRARIES_DECODER_SRC_MAIN_JNI_PIXEL_KERNELS_INTERNAL_H_
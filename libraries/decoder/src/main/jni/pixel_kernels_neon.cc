@@ -0,0 +1,175 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "pixel_kernels_internal.h"  // NOLINT
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+
+#include <cstring>
+#endif
+
+namespace decoder_jni {
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+
+namespace {
+
+
+template <bool kStreaming>
+inline void Store16(uint8_t* destination, uint8x16_t value) {
+#if defined(__aarch64__) && defined(__clang__)
+  if (kStreaming) {
+    // Lowered to STNP, a store with a non-temporal hint.
+    __builtin_nontemporal_store(value, reinterpret_cast<uint8x16_t*>(
+                                           destination));
+    return;
+  }
+#endif  // defined(__aarch64__) && defined(__clang__)
+  vst1q_u8(destination, value);
+}
+
+template <bool kStreaming>
+void CopyRowNeon(const uint8_t* source, uint8_t* destination, int width) {
+  int x = 0;
+  for (; x + 64 <= width; x += 64) {
+    Prefetch(source + x + kPrefetchDistance);
+    const uint8x16_t v0 = vld1q_u8(source + x);
+    const uint8x16_t v1 = vld1q_u8(source + x + 16);
+    const uint8x16_t v2 = vld1q_u8(source + x + 32);
+    const uint8x16_t v3 = vld1q_u8(source + x + 48);
+    Store16<kStreaming>(destination + x, v0);
+    Store16<kStreaming>(destination + x + 16, v1);
+    Store16<kStreaming>(destination + x + 32, v2);
+    Store16<kStreaming>(destination + x + 48, v3);
+  }
+  for (; x + 16 <= width; x += 16) {
+    Store16<kStreaming>(destination + x, vld1q_u8(source + x));
+  }
+  if (x < width) {
+    std::memcpy(destination + x, source + x, width - x);
+  }
+}
+
+template <bool kStreaming>
+void CopyRowPairNeon(const uint8_t* source_a, const uint8_t* source_b,
+                     uint8_t* destination_a, uint8_t* destination_b,
+                     int width) {
+  int x = 0;
+  for (; x + 32 <= width; x += 32) {
+    Prefetch(source_a + x + kPrefetchDistance);
+    Prefetch(source_b + x + kPrefetchDistance);
+    const uint8x16_t a0 = vld1q_u8(source_a + x);
+    const uint8x16_t a1 = vld1q_u8(source_a + x + 16);
+    const uint8x16_t b0 = vld1q_u8(source_b + x);
+    const uint8x16_t b1 = vld1q_u8(source_b + x + 16);
+    Store16<kStreaming>(destination_a + x, a0);
+    Store16<kStreaming>(destination_a + x + 16, a1);
+    Store16<kStreaming>(destination_b + x, b0);
+    Store16<kStreaming>(destination_b + x + 16, b1);
+  }
+  for (; x + 16 <= width; x += 16) {
+    Store16<kStreaming>(destination_a + x, vld1q_u8(source_a + x));
+    Store16<kStreaming>(destination_b + x, vld1q_u8(source_b + x));
+  }
+  if (x < width) {
+    std::memcpy(destination_a + x, source_a + x, width - x);
+    std::memcpy(destination_b + x, source_b + x, width - x);
+  }
+}
+
+void ShiftRow16Neon(const uint16_t* source, uint16_t* destination, int width,
+                    int shift) {
+  const int16x8_t shift_vector = vdupq_n_s16(static_cast<int16_t>(shift));
+  int x = 0;
+  for (; x + 16 <= width; x += 16) {
+    Prefetch(reinterpret_cast<const uint8_t*>(source + x) + kPrefetchDistance);
+    const uint16x8_t v0 = vld1q_u16(source + x);
+    const uint16x8_t v1 = vld1q_u16(source + x + 8);
+    vst1q_u16(destination + x, vshlq_u16(v0, shift_vector));
+    vst1q_u16(destination + x + 8, vshlq_u16(v1, shift_vector));
+  }
+  ShiftRow16Standard(source + x, destination + x, width - x, shift);
+}
+
+void InterleaveRow16Neon(const uint16_t* source_a, const uint16_t* source_b,
+                         uint16_t* destination, int width, int shift) {
+  const int16x8_t shift_vector = vdupq_n_s16(static_cast<int16_t>(shift));
+  int x = 0;
+  for (; x + 8 <= width; x += 8) {
+    Prefetch(reinterpret_cast<const uint8_t*>(source_a + x) +
+             kPrefetchDistance);
+    Prefetch(reinterpret_cast<const uint8_t*>(source_b + x) +
+             kPrefetchDistance);
+    uint16x8x2_t interleaved;
+    interleaved.val[0] = vshlq_u16(vld1q_u16(source_a + x), shift_vector);
+    interleaved.val[1] = vshlq_u16(vld1q_u16(source_b + x), shift_vector);
+    vst2q_u16(destination + 2 * x, interleaved);
+  }
+  InterleaveRow16Standard(source_a + x, source_b + x, destination + 2 * x,
+                          width - x, shift);
+}
+
+// Returns the dither of 16 samples starting at sample |index| of a row, which
+// must be a multiple of four.
+inline uint8x16_t GetDither16(uint32_t seed, int index) {
+  static const uint32_t kOffsets[4] = {0, 1, 2, 3};
+  uint32x4_t value =
+      vaddq_u32(vdupq_n_u32(seed + static_cast<uint32_t>(index / 4)),
+                vld1q_u32(kOffsets));
+  value = veorq_u32(value, vshrq_n_u32(value, 16));
+  value = vmulq_n_u32(value, 0x85ebca6b);
+  value = veorq_u32(value, vshrq_n_u32(value, 13));
+  value = vmulq_n_u32(value, 0xc2b2ae35);
+  value = veorq_u32(value, vshrq_n_u32(value, 16));
+  // Byte j of lane k is the dither source of sample 4 * k + j.
+  return vandq_u8(vreinterpretq_u8_u32(value), vdupq_n_u8(3));
+}
+
+void ConvertRow10To8Neon(const uint16_t* source, uint8_t* destination,
+                         int width, uint32_t seed) {
+  int x = 0;
+  for (; x + 16 <= width; x += 16) {
+    Prefetch(reinterpret_cast<const uint8_t*>(source + x) + kPrefetchDistance);
+    const uint8x16_t dither = GetDither16(seed, x);
+    const uint16x8_t v0 =
+        vqaddq_u16(vld1q_u16(source + x), vmovl_u8(vget_low_u8(dither)));
+    const uint16x8_t v1 =
+        vqaddq_u16(vld1q_u16(source + x + 8), vmovl_u8(vget_high_u8(dither)));
+    vst1q_u8(destination + x, vcombine_u8(vqmovn_u16(vshrq_n_u16(v0, 2)),
+                                          vqmovn_u16(vshrq_n_u16(v1, 2))));
+  }
+  ConvertRow10To8Standard(source + x, destination + x, width - x, seed, x);
+}
+
+}  // namespace
+
+void AddNeonKernels(PixelKernels* kernels) {
+  kernels->copy_row = CopyRowNeon</*kStreaming=*/false>;
+  kernels->copy_row_streaming = CopyRowNeon</*kStreaming=*/true>;
+  kernels->copy_row_pair = CopyRowPairNeon</*kStreaming=*/false>;
+  kernels->copy_row_pair_streaming = CopyRowPairNeon</*kStreaming=*/true>;
+  kernels->shift_row_16 = ShiftRow16Neon;
+  kernels->interleave_row_16 = InterleaveRow16Neon;
+  kernels->convert_row_10_to_8 = ConvertRow10To8Neon;
+}
+
+#else  // !(defined(__ARM_NEON) || defined(__ARM_NEON__))
+
+void AddNeonKernels(PixelKernels* kernels) { (void)kernels; }
+
+#endif  // defined(__ARM_NEON) || defined(__ARM_NEON__)
+
+}  // namespace decoder_jni
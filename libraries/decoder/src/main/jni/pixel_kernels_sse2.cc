@@ -0,0 +1,175 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "pixel_kernels_internal.h"  // NOLINT
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+
+#include <cstring>
+#endif
+
+namespace decoder_jni {
+
+#if defined(__SSE2__)
+
+namespace {
+
+
+// Returns the number of bytes to copy before |destination| is 16-byte aligned,
+// as required by streaming stores.
+inline int UnalignedHeadSize(const uint8_t* destination, int width) {
+  const int head =
+      static_cast<int>(-reinterpret_cast<uintptr_t>(destination) & 15);
+  return head < width ? head : width;
+}
+
+template <bool kStreaming>
+inline void Store16(uint8_t* destination, __m128i value) {
+  if (kStreaming) {
+    _mm_stream_si128(reinterpret_cast<__m128i*>(destination), value);
+  } else {
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(destination), value);
+  }
+}
+
+inline __m128i Load16(const uint8_t* source) {
+  return _mm_loadu_si128(reinterpret_cast<const __m128i*>(source));
+}
+
+template <bool kStreaming>
+void CopyRowSse2(const uint8_t* source, uint8_t* destination, int width) {
+  int x = 0;
+  if (kStreaming) {
+    x = UnalignedHeadSize(destination, width);
+    std::memcpy(destination, source, x);
+  }
+  for (; x + 64 <= width; x += 64) {
+    Prefetch(source + x + kPrefetchDistance);
+    const __m128i v0 = Load16(source + x);
+    const __m128i v1 = Load16(source + x + 16);
+    const __m128i v2 = Load16(source + x + 32);
+    const __m128i v3 = Load16(source + x + 48);
+    Store16<kStreaming>(destination + x, v0);
+    Store16<kStreaming>(destination + x + 16, v1);
+    Store16<kStreaming>(destination + x + 32, v2);
+    Store16<kStreaming>(destination + x + 48, v3);
+  }
+  for (; x + 16 <= width; x += 16) {
+    Store16<kStreaming>(destination + x, Load16(source + x));
+  }
+  if (x < width) {
+    std::memcpy(destination + x, source + x, width - x);
+  }
+}
+
+template <bool kStreaming>
+void CopyRowPairSse2(const uint8_t* source_a, const uint8_t* source_b,
+                     uint8_t* destination_a, uint8_t* destination_b,
+                     int width) {
+  // Streaming stores need aligned destinations, so the combined pass is only
+  // used when both destination rows are aligned the same way.
+  if (kStreaming && UnalignedHeadSize(destination_a, width) !=
+                        UnalignedHeadSize(destination_b, width)) {
+    CopyRowSse2<kStreaming>(source_a, destination_a, width);
+    CopyRowSse2<kStreaming>(source_b, destination_b, width);
+    return;
+  }
+  int x = 0;
+  if (kStreaming) {
+    x = UnalignedHeadSize(destination_a, width);
+    std::memcpy(destination_a, source_a, x);
+    std::memcpy(destination_b, source_b, x);
+  }
+  for (; x + 32 <= width; x += 32) {
+    Prefetch(source_a + x + kPrefetchDistance);
+    Prefetch(source_b + x + kPrefetchDistance);
+    const __m128i a0 = Load16(source_a + x);
+    const __m128i a1 = Load16(source_a + x + 16);
+    const __m128i b0 = Load16(source_b + x);
+    const __m128i b1 = Load16(source_b + x + 16);
+    Store16<kStreaming>(destination_a + x, a0);
+    Store16<kStreaming>(destination_a + x + 16, a1);
+    Store16<kStreaming>(destination_b + x, b0);
+    Store16<kStreaming>(destination_b + x + 16, b1);
+  }
+  for (; x + 16 <= width; x += 16) {
+    Store16<kStreaming>(destination_a + x, Load16(source_a + x));
+    Store16<kStreaming>(destination_b + x, Load16(source_b + x));
+  }
+  if (x < width) {
+    std::memcpy(destination_a + x, source_a + x, width - x);
+    std::memcpy(destination_b + x, source_b + x, width - x);
+  }
+}
+
+void ShiftRow16Sse2(const uint16_t* source, uint16_t* destination, int width,
+                    int shift) {
+  const __m128i shift_vector = _mm_cvtsi32_si128(shift);
+  int x = 0;
+  for (; x + 16 <= width; x += 16) {
+    Prefetch(reinterpret_cast<const uint8_t*>(source + x) + kPrefetchDistance);
+    const __m128i v0 =
+        Load16(reinterpret_cast<const uint8_t*>(source + x));
+    const __m128i v1 =
+        Load16(reinterpret_cast<const uint8_t*>(source + x + 8));
+    Store16</*kStreaming=*/false>(reinterpret_cast<uint8_t*>(destination + x),
+                                  _mm_sll_epi16(v0, shift_vector));
+    Store16</*kStreaming=*/false>(
+        reinterpret_cast<uint8_t*>(destination + x + 8),
+        _mm_sll_epi16(v1, shift_vector));
+  }
+  ShiftRow16Standard(source + x, destination + x, width - x, shift);
+}
+
+void InterleaveRow16Sse2(const uint16_t* source_a, const uint16_t* source_b,
+                         uint16_t* destination, int width, int shift) {
+  const __m128i shift_vector = _mm_cvtsi32_si128(shift);
+  int x = 0;
+  for (; x + 8 <= width; x += 8) {
+    Prefetch(reinterpret_cast<const uint8_t*>(source_a + x) +
+             kPrefetchDistance);
+    Prefetch(reinterpret_cast<const uint8_t*>(source_b + x) +
+             kPrefetchDistance);
+    const __m128i a = _mm_sll_epi16(
+        Load16(reinterpret_cast<const uint8_t*>(source_a + x)), shift_vector);
+    const __m128i b = _mm_sll_epi16(
+        Load16(reinterpret_cast<const uint8_t*>(source_b + x)), shift_vector);
+    uint8_t* const row = reinterpret_cast<uint8_t*>(destination + 2 * x);
+    Store16</*kStreaming=*/false>(row, _mm_unpacklo_epi16(a, b));
+    Store16</*kStreaming=*/false>(row + 16, _mm_unpackhi_epi16(a, b));
+  }
+  InterleaveRow16Standard(source_a + x, source_b + x, destination + 2 * x,
+                          width - x, shift);
+}
+
+}  // namespace
+
+void AddSse2Kernels(PixelKernels* kernels) {
+  kernels->copy_row = CopyRowSse2</*kStreaming=*/false>;
+  kernels->copy_row_streaming = CopyRowSse2</*kStreaming=*/true>;
+  kernels->copy_row_pair = CopyRowPairSse2</*kStreaming=*/false>;
+  kernels->copy_row_pair_streaming = CopyRowPairSse2</*kStreaming=*/true>;
+  kernels->shift_row_16 = ShiftRow16Sse2;
+  kernels->interleave_row_16 = InterleaveRow16Sse2;
+}
+
+#else  // !defined(__SSE2__)
+
+void AddSse2Kernels(PixelKernels* kernels) { (void)kernels; }
+
+#endif  // defined(__SSE2__)
+
+}  // namespace decoder_jni
@@ -0,0 +1,83 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "pixel_kernels_internal.h"  // NOLINT
+
+#if defined(__i386__) || defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+namespace decoder_jni {
+
+#if defined(__i386__) || defined(__x86_64__)
+
+namespace {
+
+// The kernels are compiled for SSE4.1 individually, so that the rest of the
+// library keeps running on devices without it.
+#define SSE41_TARGET __attribute__((target("sse4.1")))
+
+// Returns the dither of 16 samples starting at sample |index| of a row, which
+// must be a multiple of four.
+SSE41_TARGET inline __m128i GetDither16(uint32_t seed, int index) {
+  __m128i value = _mm_add_epi32(
+      _mm_set1_epi32(static_cast<int>(seed + static_cast<uint32_t>(index / 4))),
+      _mm_setr_epi32(0, 1, 2, 3));
+  value = _mm_xor_si128(value, _mm_srli_epi32(value, 16));
+  value = _mm_mullo_epi32(value, _mm_set1_epi32(static_cast<int>(0x85ebca6b)));
+  value = _mm_xor_si128(value, _mm_srli_epi32(value, 13));
+  value = _mm_mullo_epi32(value, _mm_set1_epi32(static_cast<int>(0xc2b2ae35)));
+  value = _mm_xor_si128(value, _mm_srli_epi32(value, 16));
+  // Byte j of lane k is the dither source of sample 4 * k + j.
+  return _mm_and_si128(value, _mm_set1_epi8(3));
+}
+
+SSE41_TARGET void ConvertRow10To8Sse41(const uint16_t* source,
+                                       uint8_t* destination, int width,
+                                       uint32_t seed) {
+  int x = 0;
+  for (; x + 16 <= width; x += 16) {
+    Prefetch(reinterpret_cast<const uint8_t*>(source + x) + kPrefetchDistance);
+    const __m128i dither = GetDither16(seed, x);
+    const __m128i v0 = _mm_adds_epu16(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + x)),
+        _mm_cvtepu8_epi16(dither));
+    const __m128i v1 = _mm_adds_epu16(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + x + 8)),
+        _mm_unpackhi_epi8(dither, _mm_setzero_si128()));
+    // The shifted values fit in 15 bits, so the signed saturation of packus
+    // clamps them to 255 as required.
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(destination + x),
+                     _mm_packus_epi16(_mm_srli_epi16(v0, 2),
+                                      _mm_srli_epi16(v1, 2)));
+  }
+  ConvertRow10To8Standard(source + x, destination + x, width - x, seed, x);
+}
+
+#undef SSE41_TARGET
+
+}  // namespace
+
+void AddSse41Kernels(PixelKernels* kernels) {
+  kernels->convert_row_10_to_8 = ConvertRow10To8Sse41;
+}
+
+#else  // !(defined(__i386__) || defined(__x86_64__))
+
+void AddSse41Kernels(PixelKernels* kernels) { (void)kernels; }
+
+#endif  // defined(__i386__) || defined(__x86_64__)
+
+}  // namespace decoder_jni
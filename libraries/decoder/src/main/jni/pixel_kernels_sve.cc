@@ -0,0 +1,147 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "pixel_kernels_internal.h"  // NOLINT
+
+// This file is compiled with SVE enabled on arm64 (see CMakeLists.txt and
+// decoder_jni.mk), and its kernels are only used when the device supports it.
+#if defined(__ARM_FEATURE_SVE)
+#include <arm_sve.h>
+#endif
+
+namespace decoder_jni {
+
+#if defined(__ARM_FEATURE_SVE)
+
+namespace {
+
+// SVE kernels process whole rows with predicated loops, so they don't need
+// scalar code for the last samples of a row.
+
+template <bool kStreaming>
+void CopyRowSve(const uint8_t* source, uint8_t* destination, int width) {
+  for (int x = 0; x < width; x += static_cast<int>(svcntb())) {
+    Prefetch(source + x + kPrefetchDistance);
+    const svbool_t predicate = svwhilelt_b8_s32(x, width);
+    const svuint8_t value = svld1_u8(predicate, source + x);
+    if (kStreaming) {
+      svstnt1_u8(predicate, destination + x, value);
+    } else {
+      svst1_u8(predicate, destination + x, value);
+    }
+  }
+}
+
+template <bool kStreaming>
+void CopyRowPairSve(const uint8_t* source_a, const uint8_t* source_b,
+                    uint8_t* destination_a, uint8_t* destination_b,
+                    int width) {
+  for (int x = 0; x < width; x += static_cast<int>(svcntb())) {
+    Prefetch(source_a + x + kPrefetchDistance);
+    Prefetch(source_b + x + kPrefetchDistance);
+    const svbool_t predicate = svwhilelt_b8_s32(x, width);
+    const svuint8_t a = svld1_u8(predicate, source_a + x);
+    const svuint8_t b = svld1_u8(predicate, source_b + x);
+    if (kStreaming) {
+      svstnt1_u8(predicate, destination_a + x, a);
+      svstnt1_u8(predicate, destination_b + x, b);
+    } else {
+      svst1_u8(predicate, destination_a + x, a);
+      svst1_u8(predicate, destination_b + x, b);
+    }
+  }
+}
+
+void ShiftRow16Sve(const uint16_t* source, uint16_t* destination, int width,
+                   int shift) {
+  for (int x = 0; x < width; x += static_cast<int>(svcnth())) {
+    Prefetch(reinterpret_cast<const uint8_t*>(source + x) + kPrefetchDistance);
+    const svbool_t predicate = svwhilelt_b16_s32(x, width);
+    const svuint16_t value = svld1_u16(predicate, source + x);
+    svst1_u16(predicate, destination + x,
+              svlsl_n_u16_x(predicate, value, static_cast<uint16_t>(shift)));
+  }
+}
+
+void InterleaveRow16Sve(const uint16_t* source_a, const uint16_t* source_b,
+                        uint16_t* destination, int width, int shift) {
+  for (int x = 0; x < width; x += static_cast<int>(svcnth())) {
+    Prefetch(reinterpret_cast<const uint8_t*>(source_a + x) +
+             kPrefetchDistance);
+    Prefetch(reinterpret_cast<const uint8_t*>(source_b + x) +
+             kPrefetchDistance);
+    const svbool_t predicate = svwhilelt_b16_s32(x, width);
+    const svuint16_t a = svlsl_n_u16_x(
+        predicate, svld1_u16(predicate, source_a + x),
+        static_cast<uint16_t>(shift));
+    const svuint16_t b = svlsl_n_u16_x(
+        predicate, svld1_u16(predicate, source_b + x),
+        static_cast<uint16_t>(shift));
+    svst2_u16(predicate, destination + 2 * x, svcreate2_u16(a, b));
+  }
+}
+
+void ConvertRow10To8Sve(const uint16_t* source, uint8_t* destination,
+                        int width, uint32_t seed) {
+  const svbool_t all_words = svptrue_b32();
+  const int half_step = static_cast<int>(svcnth());
+  // Each iteration converts one byte vector of samples, i.e. two vectors of
+  // 16-bit samples.
+  for (int x = 0; x < width; x += 2 * half_step) {
+    Prefetch(reinterpret_cast<const uint8_t*>(source + x) + kPrefetchDistance);
+    svuint32_t hash = svindex_u32(seed + static_cast<uint32_t>(x / 4), 1);
+    hash = sveor_u32_x(all_words, hash, svlsr_n_u32_x(all_words, hash, 16));
+    hash = svmul_n_u32_x(all_words, hash, 0x85ebca6b);
+    hash = sveor_u32_x(all_words, hash, svlsr_n_u32_x(all_words, hash, 13));
+    hash = svmul_n_u32_x(all_words, hash, 0xc2b2ae35);
+    hash = sveor_u32_x(all_words, hash, svlsr_n_u32_x(all_words, hash, 16));
+    // Byte j of lane k is the dither source of sample 4 * k + j.
+    const svuint8_t dither =
+        svand_n_u8_x(svptrue_b8(), svreinterpret_u8_u32(hash), 3);
+
+    const svbool_t low_predicate = svwhilelt_b16_s32(x, width);
+    const svbool_t high_predicate = svwhilelt_b16_s32(x + half_step, width);
+    const svbool_t all_halves = svptrue_b16();
+    svuint16_t low = svqadd_u16(svld1_u16(low_predicate, source + x),
+                                svunpklo_u16(dither));
+    svuint16_t high =
+        svqadd_u16(svld1_u16(high_predicate, source + x + half_step),
+                   svunpkhi_u16(dither));
+    low = svmin_n_u16_x(all_halves, svlsr_n_u16_x(all_halves, low, 2), 255);
+    high = svmin_n_u16_x(all_halves, svlsr_n_u16_x(all_halves, high, 2), 255);
+    svst1b_u16(low_predicate, destination + x, low);
+    svst1b_u16(high_predicate, destination + x + half_step, high);
+  }
+}
+
+}  // namespace
+
+void AddSveKernels(PixelKernels* kernels) {
+  kernels->copy_row = CopyRowSve</*kStreaming=*/false>;
+  kernels->copy_row_streaming = CopyRowSve</*kStreaming=*/true>;
+  kernels->copy_row_pair = CopyRowPairSve</*kStreaming=*/false>;
+  kernels->copy_row_pair_streaming = CopyRowPairSve</*kStreaming=*/true>;
+  kernels->shift_row_16 = ShiftRow16Sve;
+  kernels->interleave_row_16 = InterleaveRow16Sve;
+  kernels->convert_row_10_to_8 = ConvertRow10To8Sve;
+}
+
+#else  // !defined(__ARM_FEATURE_SVE)
+
+void AddSveKernels(PixelKernels* kernels) { (void)kernels; }
+
+#endif  // defined(__ARM_FEATURE_SVE)
+
+}  // namespace decoder_jni
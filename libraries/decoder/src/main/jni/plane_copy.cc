@@ -0,0 +1,100 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "plane_copy.h"
+
+#include <cstddef>
+
+namespace decoder_jni {
+
+namespace {
+
+// Planes larger than this (in total, for the chroma planes) are copied with
+// streaming stores. This is larger than the L2 cache of most mobile and TV
+// SoCs, which the copy would otherwise flush.
+const int64_t kStreamingThresholdBytes = 1024 * 1024;
+
+}  // namespace
+
+PlaneCopier::PlaneCopier() : PlaneCopier(GetSupportedIsas()) {}
+
+PlaneCopier::PlaneCopier(uint32_t isas) : kernels_(GetPixelKernels(isas)) {}
+
+void PlaneCopier::CopyPlane(const uint8_t* source, int source_stride,
+                            uint8_t* destination, int destination_stride,
+                            int width, int height) const {
+  if (width <= 0 || height <= 0) return;
+  const bool streaming =
+      static_cast<int64_t>(width) * height >= kStreamingThresholdBytes;
+  const auto copy_row =
+      streaming ? kernels_.copy_row_streaming : kernels_.copy_row;
+  while (height--) {
+    copy_row(source, destination, width);
+    source += source_stride;
+    destination += destination_stride;
+  }
+  if (streaming) FinishStreamingStores();
+}
+
+void PlaneCopier::CopyChromaPlanes(const uint8_t* source_u,
+                                   int source_u_stride,
+                                   const uint8_t* source_v,
+                                   int source_v_stride, uint8_t* destination_u,
+                                   uint8_t* destination_v,
+                                   int destination_stride, int width,
+                                   int height) const {
+  if (width <= 0 || height <= 0) return;
+  const bool streaming =
+      2 * static_cast<int64_t>(width) * height >= kStreamingThresholdBytes;
+  const auto copy_row_pair =
+      streaming ? kernels_.copy_row_pair_streaming : kernels_.copy_row_pair;
+  while (height--) {
+    copy_row_pair(source_u, source_v, destination_u, destination_v, width);
+    source_u += source_u_stride;
+    source_v += source_v_stride;
+    destination_u += destination_stride;
+    destination_v += destination_stride;
+  }
+  if (streaming) FinishStreamingStores();
+}
+
+void PlaneCopier::ShiftPlane16(const uint8_t* source, int source_stride,
+                               uint8_t* destination, int destination_stride,
+                               int width, int height, int shift) const {
+  while (height-- > 0) {
+    kernels_.shift_row_16(reinterpret_cast<const uint16_t*>(source),
+                          reinterpret_cast<uint16_t*>(destination), width,
+                          shift);
+    source += source_stride;
+    destination += destination_stride;
+  }
+}
+
+void PlaneCopier::InterleaveChromaPlanes16(
+    const uint8_t* source_u, int source_u_stride, const uint8_t* source_v,
+    int source_v_stride, uint8_t* destination, int destination_stride,
+    int width, int height, int shift) const {
+  while (height-- > 0) {
+    kernels_.interleave_row_16(reinterpret_cast<const uint16_t*>(source_u),
+                               reinterpret_cast<const uint16_t*>(source_v),
+                               reinterpret_cast<uint16_t*>(destination), width,
+                               shift);
+    source_u += source_u_stride;
+    source_v += source_v_stride;
+    destination += destination_stride;
+  }
+}
+
+}  // namespace decoder_jni
@@ -0,0 +1,72 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef LIBRARIES_DECODER_SRC_MAIN_JNI_PLANE_COPY_H_
+#define LIBRARIES_DECODER_SRC_MAIN_JNI_PLANE_COPY_H_
+
+#include <cstdint>
+
+#include "pixel_kernels.h"  // NOLINT
+
+namespace decoder_jni {
+
+// Copies frame planes, e.g. into ANativeWindow buffers when rendering to a
+// surface, using the fastest row copy kernels supported by the device.
+//
+// The kernels (see pixel_kernels.h) use SIMD loads and stores, prefetch ahead
+// of the source, and bypass the cache with streaming stores when the
+// copied planes are too large to stay in cache anyway, so that the destination
+// doesn't evict the decoder's reference frames.
+class PlaneCopier {
+ public:
+  // Uses the kernels of all instruction sets supported by the device.
+  PlaneCopier();
+  // Only uses the kernels of the instruction sets in |isas|, a bitmask of Isa
+  // values.
+  explicit PlaneCopier(uint32_t isas);
+
+  // Copies |height| rows of |width| bytes from |source| to |destination|.
+  void CopyPlane(const uint8_t* source, int source_stride,
+                 uint8_t* destination, int destination_stride, int width,
+                 int height) const;
+
+  // Copies |height| rows of |width| bytes of both chroma planes in a single
+  // pass. The destination planes must have the same stride.
+  void CopyChromaPlanes(const uint8_t* source_u, int source_u_stride,
+                        const uint8_t* source_v, int source_v_stride,
+                        uint8_t* destination_u, uint8_t* destination_v,
+                        int destination_stride, int width, int height) const;
+
+  // Copies |height| rows of |width| 16-bit samples, shifting each sample left
+  // by |shift| bits (e.g. to MSB-align 10-bit samples). Strides are in bytes.
+  void ShiftPlane16(const uint8_t* source, int source_stride,
+                    uint8_t* destination, int destination_stride, int width,
+                    int height, int shift) const;
+
+  // Interleaves |height| rows of |width| 16-bit samples of both chroma planes
+  // into a single UV plane (as used by P010), shifting each sample left by
+  // |shift| bits. Strides are in bytes.
+  void InterleaveChromaPlanes16(const uint8_t* source_u, int source_u_stride,
+                                const uint8_t* source_v, int source_v_stride,
+                                uint8_t* destination, int destination_stride,
+                                int width, int height, int shift) const;
+
+ private:
+  const PixelKernels kernels_;
+};
+
+}  // namespace decoder_jni
+
+#endif  // LIBRARIES_DECODER_SRC_MAIN_JNI_PLANE_COPY_H_
@@ -0,0 +1,91 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "thread_pool.h"
+
+namespace decoder_jni {
+
+ThreadPool::ThreadPool(int num_threads) {
+  for (int i = 1; i < num_threads; i++) {
+    workers_.emplace_back(&ThreadPool::WorkerLoop, this);
+  }
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  work_available_.notify_all();
+  for (std::thread& worker : workers_) {
+    worker.join();
+  }
+}
+
+void ThreadPool::ParallelFor(int count, const std::function<void(int)>& task) {
+  if (count <= 0) return;
+  if (workers_.empty() || count == 1) {
+    for (int i = 0; i < count; i++) task(i);
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    task_ = &task;
+    task_count_ = count;
+    next_task_.store(0, std::memory_order_relaxed);
+    busy_workers_ = static_cast<int>(workers_.size());
+    batch_++;
+  }
+  work_available_.notify_all();
+  RunTasks();
+  std::unique_lock<std::mutex> lock(mutex_);
+  work_done_.wait(lock, [this] { return busy_workers_ == 0; });
+  task_ = nullptr;
+}
+
+void ThreadPool::WorkerLoop() {
+  uint64_t last_batch = 0;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      work_available_.wait(lock, [this, last_batch] {
+        return stopping_ || batch_ != last_batch;
+      });
+      if (stopping_) return;
+      last_batch = batch_;
+    }
+    RunTasks();
+    bool last_worker;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      last_worker = --busy_workers_ == 0;
+    }
+    if (last_worker) work_done_.notify_one();
+  }
+}
+
+void ThreadPool::RunTasks() {
+  // |task_| and |task_count_| are published by the mutex, and only change once
+  // all workers have finished the batch.
+  const std::function<void(int)>& task = *task_;
+  const int count = task_count_;
+  while (true) {
+    const int index = next_task_.fetch_add(1, std::memory_order_relaxed);
+    if (index >= count) return;
+    task(index);
+  }
+}
+
+}  // namespace decoder_jni
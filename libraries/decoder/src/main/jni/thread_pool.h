@@ -0,0 +1,81 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef LIBRARIES_DECODER_SRC_MAIN_JNI_THREAD_POOL_H_
+#define LIBRARIES_DECODER_SRC_MAIN_JNI_THREAD_POOL_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace decoder_jni {
+
+// A small pool of persistent worker threads for splitting per-frame work (such
+// as pixel format conversion) into independent tasks.
+class ThreadPool {
+ public:
+  // Creates a pool that runs tasks on |num_threads| threads in total, including
+  // the thread calling ParallelFor(). |num_threads| - 1 worker threads are
+  // started, so a pool with a single thread runs all tasks inline.
+  explicit ThreadPool(int num_threads);
+
+  // Stops and joins the worker threads.
+  ~ThreadPool();
+
+  // Not copyable or movable.
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool(ThreadPool&&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+  ThreadPool& operator=(ThreadPool&&) = delete;
+
+  // Returns the number of threads tasks are run on.
+  int num_threads() const { return static_cast<int>(workers_.size()) + 1; }
+
+  // Calls |task| with each index in [0, |count|) and returns once all calls
+  // have returned. Calls are distributed over the worker threads and the
+  // calling thread in no particular order. Must not be called concurrently or
+  // from within a task.
+  void ParallelFor(int count, const std::function<void(int)>& task);
+
+ private:
+  void WorkerLoop();
+  // Runs tasks of the current batch until there are none left.
+  void RunTasks();
+
+  std::vector<std::thread> workers_;
+
+  std::mutex mutex_;
+  std::condition_variable work_available_;
+  std::condition_variable work_done_;
+  // The following are guarded by |mutex_|.
+  bool stopping_ = false;
+  // Incremented for each ParallelFor() call.
+  uint64_t batch_ = 0;
+  // The number of workers still running tasks of the current batch.
+  int busy_workers_ = 0;
+  const std::function<void(int)>* task_ = nullptr;
+  int task_count_ = 0;
+
+  // The next task index of the current batch.
+  std::atomic<int> next_task_{0};
+};
+
+}  // namespace decoder_jni
+
+#endif  // LIBRARIES_DECODER_SRC_MAIN_JNI_THREAD_POOL_H_
@@ -0,0 +1,70 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#include "thread_scheduling.h"  // NOLINT
+
+#include <algorithm>
+#include <vector>
+
+namespace decoder_jni {
+namespace {
+
+// The number of pixels per decoder thread, i.e. of a 360p frame.
+constexpr long kPixelsPerThread = 640 * 360;  // NOLINT
+
+}  // namespace
+
+int GetDecoderThreadCount(const CpuTopology& topology, int width, int height) {
+  const int max_threads = std::max(topology.GetNumberOfPerformanceCores(), 1);
+  if (width <= 0 || height <= 0) {
+    return max_threads;
+  }
+  const long pixels = static_cast<long>(width) * height;  // NOLINT
+  const long threads =                                    // NOLINT
+      (pixels + kPixelsPerThread - 1) / kPixelsPerThread;
+  return static_cast<int>(std::min<long>(threads, max_threads));  // NOLINT
+}
+
+bool SetPerformanceCoreAffinity(const CpuTopology& topology) {
+  if (topology.clusters.size() <= 1) {
+    return false;
+  }
+  cpu_set_t affinity;
+  CPU_ZERO(&affinity);
+  for (const int cpu : topology.GetPerformanceCpus()) {
+    if (cpu < CPU_SETSIZE) {
+      CPU_SET(cpu, &affinity);
+    }
+  }
+  // A pid of 0 is the calling thread.
+  return sched_setaffinity(0, sizeof(affinity), &affinity) == 0;
+}
+
+ScopedPerformanceCoreAffinity::ScopedPerformanceCoreAffinity(
+    const CpuTopology& topology, bool enabled) {
+  if (!enabled || sched_getaffinity(0, sizeof(previous_affinity_),
+                                    &previous_affinity_) != 0) {
+    return;
+  }
+  restore_ = SetPerformanceCoreAffinity(topology);
+}
+
+ScopedPerformanceCoreAffinity::~ScopedPerformanceCoreAffinity() {
+  if (restore_) {
+    sched_setaffinity(0, sizeof(previous_affinity_), &previous_affinity_);
+  }
+}
+
+}  // namespace decoder_jni
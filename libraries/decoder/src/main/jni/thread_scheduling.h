@@ -0,0 +1,58 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+#ifndef LIBRARIES_DECODER_SRC_MAIN_JNI_THREAD_SCHEDULING_H_
+#define LIBRARIES_DECODER_SRC_MAIN_JNI_THREAD_SCHEDULING_H_
+
+#include <sched.h>
+
+#include "cpu_info.h"  // NOLINT
+
+namespace decoder_jni {
+
+// Returns the number of threads to decode video of the given size with: one
+// thread per 640x360 pixels, but no more than the number of performance cores,
+// so that no decoder thread has to wait for an efficiency core. Returns the
+// number of performance cores if |width| or |height| is unknown (<= 0).
+int GetDecoderThreadCount(const CpuTopology& topology, int width, int height);
+
+// Restricts the calling thread to the performance cores of |topology|. Threads
+// it creates afterwards inherit the restriction. Returns false if the topology
+// has a single cluster, in which case there is nothing to restrict, or if the
+// affinity cannot be changed.
+bool SetPerformanceCoreAffinity(const CpuTopology& topology);
+
+// Restricts the calling thread to the performance cores while in scope, e.g.
+// while a decoder library creates its worker threads, and restores the
+// previous affinity of the calling thread when going out of scope.
+class ScopedPerformanceCoreAffinity {
+ public:
+  // Does nothing if |enabled| is false.
+  ScopedPerformanceCoreAffinity(const CpuTopology& topology, bool enabled);
+  ~ScopedPerformanceCoreAffinity();
+
+  // Not copyable or movable.
+  ScopedPerformanceCoreAffinity(const ScopedPerformanceCoreAffinity&) = delete;
+  ScopedPerformanceCoreAffinity& operator=(
+      const ScopedPerformanceCoreAffinity&) = delete;
+
+ private:
+  bool restore_ = false;
+  cpu_set_t previous_affinity_;
+};
+
+}  // namespace decoder_jni
+
+#endif  // LIBRARIES_DECODER_SRC_MAIN_JNI_THREAD_SCHEDULING_H_
@@ -0,0 +1,207 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package androidx.media3.decoder;
+
+import static com.google.common.truth.Truth.assertThat;
+
+import androidx.annotation.Nullable;
+import androidx.media3.common.C;
+import androidx.test.ext.junit.runners.AndroidJUnit4;
+import java.util.ArrayDeque;
+import java.util.ArrayList;
+import java.util.List;
+import java.util.concurrent.atomic.AtomicInteger;
+import org.junit.Test;
+import org.junit.runner.RunWith;
+
+/** Unit tests for {@link SimpleDecoder}. */
+@RunWith(AndroidJUnit4.class)
+public class SimpleDecoderTest {
+
+  private static final long TIMEOUT_MS = 10_000;
+
+  @Test
+  public void drain_outputsDelayedBuffersBeforeEndOfStream() throws Exception {
+    DelayingDecoder decoder = new DelayingDecoder(/* delay= */ 2);
+    List<Long> outputTimesUs;
+    try {
+      for (long timeUs = 0; timeUs < 5; timeUs++) {
+        queueInputBuffer(decoder, timeUs, /* flags= */ 0);
+      }
+      queueInputBuffer(decoder, /* timeUs= */ 0, C.BUFFER_FLAG_END_OF_STREAM);
+      outputTimesUs =
+          dequeueOutputTimesUntilEndOfStream(
+              decoder, /* skippedOutputBufferCounts= */ new ArrayList<>());
+    } finally {
+      decoder.release();
+    }
+
+    assertThat(outputTimesUs).containsExactly(0L, 1L, 2L, 3L, 4L).inOrder();
+  }
+
+  @Test
+  public void drain_afterFlush_discardsBuffersDelayedBeforeFlush() throws Exception {
+    DelayingDecoder decoder = new DelayingDecoder(/* delay= */ 2);
+    List<Long> outputTimesUs;
+    try {
+      queueInputBuffer(decoder, /* timeUs= */ 0, /* flags= */ 0);
+      queueInputBuffer(decoder, /* timeUs= */ 1, /* flags= */ 0);
+      // Flush once both buffers are held back by the decoder, rather than still queued.
+      long deadlineMs = System.currentTimeMillis() + TIMEOUT_MS;
+      while (decoder.decodedBufferCount.get() < 2 && System.currentTimeMillis() < deadlineMs) {
+        Thread.sleep(1);
+      }
+      assertThat(decoder.decodedBufferCount.get()).isEqualTo(2);
+      decoder.flush();
+      queueInputBuffer(decoder, /* timeUs= */ 0, C.BUFFER_FLAG_END_OF_STREAM);
+      outputTimesUs =
+          dequeueOutputTimesUntilEndOfStream(
+              decoder, /* skippedOutputBufferCounts= */ new ArrayList<>());
+    } finally {
+      decoder.release();
+    }
+
+    assertThat(outputTimesUs).isEmpty();
+  }
+
+  @Test
+  public void decode_withOutputHeldBack_doesNotCountSkippedBuffers() throws Exception {
+    DelayingDecoder decoder = new DelayingDecoder(/* delay= */ 2);
+    List<Integer> skippedOutputBufferCounts = new ArrayList<>();
+    try {
+      for (long timeUs = 0; timeUs < 5; timeUs++) {
+        queueInputBuffer(decoder, timeUs, /* flags= */ 0);
+      }
+      queueInputBuffer(decoder, /* timeUs= */ 0, C.BUFFER_FLAG_END_OF_STREAM);
+      dequeueOutputTimesUntilEndOfStream(decoder, skippedOutputBufferCounts);
+    } finally {
+      decoder.release();
+    }
+
+    assertThat(skippedOutputBufferCounts).containsExactly(0, 0, 0, 0, 0);
+  }
+
+  private static void queueInputBuffer(DelayingDecoder decoder, long timeUs, int flags)
+      throws Exception {
+    long deadlineMs = System.currentTimeMillis() + TIMEOUT_MS;
+    @Nullable DecoderInputBuffer inputBuffer = decoder.dequeueInputBuffer();
+    while (inputBuffer == null && System.currentTimeMillis() < deadlineMs) {
+      Thread.sleep(1);
+      inputBuffer = decoder.dequeueInputBuffer();
+    }
+    assertThat(inputBuffer).isNotNull();
+    inputBuffer.timeUs = timeUs;
+    inputBuffer.setFlags(flags);
+    decoder.queueInputBuffer(inputBuffer);
+  }
+
+  /**
+   * Dequeues output buffers until the end of stream buffer, and returns the timestamps of the
+   * other buffers. Their skipped output buffer counts are added to {@code
+   * skippedOutputBufferCounts}.
+   */
+  private static List<Long> dequeueOutputTimesUntilEndOfStream(
+      DelayingDecoder decoder, List<Integer> skippedOutputBufferCounts) throws Exception {
+    List<Long> outputTimesUs = new ArrayList<>();
+    boolean outputEndOfStream = false;
+    long deadlineMs = System.currentTimeMillis() + TIMEOUT_MS;
+    while (!outputEndOfStream && System.currentTimeMillis() < deadlineMs) {
+      @Nullable SimpleDecoderOutputBuffer outputBuffer = decoder.dequeueOutputBuffer();
+      if (outputBuffer == null) {
+        Thread.sleep(1);
+        continue;
+      }
+      if (outputBuffer.isEndOfStream()) {
+        outputEndOfStream = true;
+      } else {
+        outputTimesUs.add(outputBuffer.timeUs);
+        skippedOutputBufferCounts.add(outputBuffer.skippedOutputBufferCount);
+      }
+      outputBuffer.release();
+    }
+    assertThat(outputEndOfStream).isTrue();
+    return outputTimesUs;
+  }
+
+  /** A decoder that outputs each input buffer after the given number of further input buffers. */
+  private static final class DelayingDecoder
+      extends SimpleDecoder<DecoderInputBuffer, SimpleDecoderOutputBuffer, DecoderException> {
+
+    private final int delay;
+    private final ArrayDeque<Long> pendingTimesUs;
+
+    /** The number of input buffers decoded, excluding the end of stream. */
+    public final AtomicInteger decodedBufferCount;
+
+    public DelayingDecoder(int delay) {
+      super(new DecoderInputBuffer[2], new SimpleDecoderOutputBuffer[2]);
+      this.delay = delay;
+      pendingTimesUs = new ArrayDeque<>();
+      decodedBufferCount = new AtomicInteger();
+    }
+
+    @Override
+    public String getName() {
+      return "DelayingDecoder";
+    }
+
+    @Override
+    protected DecoderInputBuffer createInputBuffer() {
+      return new DecoderInputBuffer(DecoderInputBuffer.BUFFER_REPLACEMENT_MODE_NORMAL);
+    }
+
+    @Override
+    protected SimpleDecoderOutputBuffer createOutputBuffer() {
+      return new SimpleDecoderOutputBuffer(this::releaseOutputBuffer);
+    }
+
+    @Override
+    protected DecoderException createUnexpectedDecodeException(Throwable error) {
+      return new DecoderException("Unexpected decode error", error);
+    }
+
+    @Nullable
+    @Override
+    protected DecoderException decode(
+        DecoderInputBuffer inputBuffer, SimpleDecoderOutputBuffer outputBuffer, boolean reset) {
+      if (reset) {
+        pendingTimesUs.clear();
+      }
+      pendingTimesUs.add(inputBuffer.timeUs);
+      if (pendingTimesUs.size() <= delay) {
+        holdBackOutput();
+      } else {
+        outputBuffer.timeUs = pendingTimesUs.remove();
+      }
+      decodedBufferCount.incrementAndGet();
+      return null;
+    }
+
+    @Nullable
+    @Override
+    protected DecoderException drain(SimpleDecoderOutputBuffer outputBuffer, boolean reset) {
+      if (reset) {
+        pendingTimesUs.clear();
+      }
+      if (pendingTimesUs.isEmpty()) {
+        outputBuffer.addFlag(C.BUFFER_FLAG_END_OF_STREAM);
+      } else {
+        outputBuffer.timeUs = pendingTimesUs.remove();
+      }
+      return null;
+    }
+  }
+}
@@ -0,0 +1,154 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+// Tests of the decoder stats and the buffer counts of the frame pool.
+
+#include <chrono>  // NOLINT
+#include <cinttypes>
+#include <cstdint>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#include "decoder_stats.h"  // NOLINT
+#include "frame_pool.h"     // NOLINT
+
+namespace decoder_jni {
+namespace {
+
+int failure_count = 0;
+
+void Expect(const char* name, int64_t actual, int64_t expected) {
+  if (actual != expected) {
+    std::printf("FAILED: %s is %" PRId64 ", expected %" PRId64 "\n", name,
+                actual, expected);
+    failure_count++;
+  }
+}
+
+struct TestBuffer {
+  explicit TestBuffer(int id) : id(id) {}
+  const int id;
+};
+
+void TestDurations() {
+  DecoderStats stats;
+  stats.AddDuration(DecoderStats::kStageDecode, 300);
+  stats.AddDuration(DecoderStats::kStageDecode, 500);
+  stats.AddDuration(DecoderStats::kStageDecode, 100);
+  stats.AddDuration(DecoderStats::kStageRender, 40);
+  FramePool<TestBuffer> pool;
+  int64_t values[DecoderStats::kNumValues];
+  stats.GetValues(pool, values);
+  Expect("decode count", values[DecoderStats::kValueDecodeCount], 3);
+  Expect("decode time", values[DecoderStats::kValueDecodeTimeNs], 900);
+  Expect("max decode time", values[DecoderStats::kValueMaxDecodeTimeNs], 500);
+  Expect("convert count", values[DecoderStats::kValueConvertCount], 0);
+  Expect("max convert time", values[DecoderStats::kValueMaxConvertTimeNs], 0);
+  Expect("render count", values[DecoderStats::kValueRenderCount], 1);
+  Expect("render time", values[DecoderStats::kValueRenderTimeNs], 40);
+}
+
+void TestCountsAndThreads() {
+  DecoderStats stats;
+  stats.AddBufferAllocation();
+  stats.AddBufferAllocation();
+  stats.SetDecoderThreadCount(4);
+  FramePool<TestBuffer> pool;
+  int64_t values[DecoderStats::kNumValues];
+  stats.GetValues(pool, values);
+  Expect("allocations", values[DecoderStats::kValueBufferAllocationCount], 2);
+  Expect("decoder threads", values[DecoderStats::kValueDecoderThreadCount], 4);
+  Expect("conversion threads",
+         values[DecoderStats::kValueConversionThreadCount], 0);
+}
+
+void TestScopedStageTimer() {
+  DecoderStats stats;
+  const int64_t start_time_ns = GetMonotonicTimeNs();
+  {
+    const ScopedStageTimer timer(&stats, DecoderStats::kStageConvert,
+                                 "convert");
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+  }
+  const int64_t elapsed_ns = GetMonotonicTimeNs() - start_time_ns;
+  FramePool<TestBuffer> pool;
+  int64_t values[DecoderStats::kNumValues];
+  stats.GetValues(pool, values);
+  Expect("convert count", values[DecoderStats::kValueConvertCount], 1);
+  const int64_t convert_time_ns = values[DecoderStats::kValueConvertTimeNs];
+  Expect("convert time in range",
+         convert_time_ns >= 2000000 && convert_time_ns <= elapsed_ns, true);
+}
+
+void TestPoolBufferCounts() {
+  FramePool<TestBuffer> pool;
+  int first_id;
+  int second_id;
+  pool.Acquire(&first_id);
+  pool.Acquire(&second_id);
+  pool.AddReference(first_id);
+  Expect("in use", pool.num_buffers_in_use(), 2);
+  pool.Release(first_id);
+  // The first buffer still has a reference.
+  Expect("in use after first release", pool.num_buffers_in_use(), 2);
+  pool.Release(first_id);
+  pool.Release(second_id);
+  Expect("in use after last release", pool.num_buffers_in_use(), 0);
+  int reused_id;
+  pool.Acquire(&reused_id);
+  Expect("buffers", pool.num_buffers(), 2);
+  Expect("in use after reuse", pool.num_buffers_in_use(), 1);
+  Expect("max in use", pool.max_num_buffers_in_use(), 2);
+}
+
+void TestConcurrentPoolBufferCounts() {
+  const int kNumThreads = 4;
+  const int kNumIterations = 10000;
+  FramePool<TestBuffer> pool;
+  std::vector<std::thread> threads;
+  for (int i = 0; i < kNumThreads; i++) {
+    threads.emplace_back([&pool]() {
+      for (int j = 0; j < kNumIterations; j++) {
+        int id;
+        if (pool.Acquire(&id) != nullptr) pool.Release(id);
+      }
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  Expect("in use", pool.num_buffers_in_use(), 0);
+  Expect("max in use bounded", pool.max_num_buffers_in_use() <= kNumThreads,
+         true);
+}
+
+}  // namespace
+}  // namespace decoder_jni
+
+int main() {
+  using namespace decoder_jni;  // NOLINT
+  TestDurations();
+  TestCountsAndThreads();
+  TestScopedStageTimer();
+  TestPoolBufferCounts();
+  TestConcurrentPoolBufferCounts();
+  if (failure_count > 0) {
+    std::printf("%d failures\n", failure_count);
+    return 1;
+  }
+  std::printf("All tests passed\n");
+  return 0;
+}
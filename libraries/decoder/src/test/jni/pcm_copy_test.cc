@@ -0,0 +1,522 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Tests of the PCM copy functions of the FLAC decoder.
+//
+// The copies of the source encoding, including the NEON and SSE interleaving
+// kernels and the 24-bit packing, must be byte-for-byte identical to a scalar
+// reference for all sample sizes, channel counts and sample counts covering
+// the vector loops and their tails. The float, dithered 16-bit and downmixing
+// conversions are compared with a double precision reference. Guard bytes
+// around each destination catch overruns.
+
+#include <cinttypes>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "include/pcm_copy.h"  // NOLINT
+
+namespace {
+
+// Sample counts covering the vector loops, their tails, the 24-bit blocks and
+// empty copies.
+const unsigned kSampleCounts[] = {0,  1,  3,  4,  5,   15,  16,  17,
+                                  31, 32, 33, 63, 64, 65, 100, 1000};
+const unsigned kMaxSampleCount = 1000;
+const unsigned kMaxChannels = 8;
+
+// Offsets of the source channels from their allocations, in samples, and of
+// the destinations, in bytes.
+const unsigned kSourceOffsets[] = {0, 1, 3};
+const unsigned kDestinationOffsets[] = {0, 1, 3};
+
+// Guard bytes before and after each destination.
+const unsigned kGuardSize = 64;
+const uint8_t kGuardValue = 0xA5;
+
+// The downmix coefficients of pcm_copy.cc, for each channel count.
+const double kMinus3Db = 0.70710678;
+const double kDownmixLeft[9][8] = {
+    {},
+    {},
+    {},
+    {1.0, 0.0, kMinus3Db},
+    {1.0, 0.0, kMinus3Db, 0.0},
+    {1.0, 0.0, kMinus3Db, kMinus3Db, 0.0},
+    {1.0, 0.0, kMinus3Db, 0.0, kMinus3Db, 0.0},
+    {1.0, 0.0, kMinus3Db, 0.0, 0.5, kMinus3Db, 0.0},
+    {1.0, 0.0, kMinus3Db, 0.0, kMinus3Db, 0.0, kMinus3Db, 0.0},
+};
+const double kDownmixRight[9][8] = {
+    {},
+    {},
+    {},
+    {0.0, 1.0, kMinus3Db},
+    {0.0, 1.0, 0.0, kMinus3Db},
+    {0.0, 1.0, kMinus3Db, 0.0, kMinus3Db},
+    {0.0, 1.0, kMinus3Db, 0.0, 0.0, kMinus3Db},
+    {0.0, 1.0, kMinus3Db, 0.0, 0.5, 0.0, kMinus3Db},
+    {0.0, 1.0, kMinus3Db, 0.0, 0.0, kMinus3Db, 0.0, kMinus3Db},
+};
+
+int failure_count = 0;
+
+// A deterministic pseudo-random number generator.
+class Random {
+ public:
+  explicit Random(uint32_t seed) : state_(seed) {}
+
+  uint32_t Next() {
+    state_ = state_ * 1664525 + 1013904223;
+    return state_ ^ (state_ >> 15);
+  }
+
+ private:
+  uint32_t state_;
+};
+
+int64_t MaxSample(unsigned bytes_per_sample) {
+  return (static_cast<int64_t>(1) << (8 * bytes_per_sample - 1)) - 1;
+}
+
+int64_t MinSample(unsigned bytes_per_sample) {
+  return -(static_cast<int64_t>(1) << (8 * bytes_per_sample - 1));
+}
+
+// Planar source channels, as written by libFLAC: 32-bit samples sign extended
+// from |bytes_per_sample| bytes.
+class Source {
+ public:
+  Source(unsigned bytes_per_sample, unsigned channels, unsigned offset,
+         uint32_t seed)
+      : storage_(channels) {
+    Random random(seed);
+    const int64_t range = MaxSample(bytes_per_sample) -
+                          MinSample(bytes_per_sample) + 1;
+    for (unsigned c = 0; c < channels; c++) {
+      storage_[c].resize(offset + kMaxSampleCount);
+      for (unsigned i = 0; i < kMaxSampleCount; i++) {
+        const uint32_t value = random.Next();
+        int64_t sample;
+        // Some samples are at full scale, so that overflows are covered too.
+        if (value % 16 == 0) {
+          sample = MaxSample(bytes_per_sample);
+        } else if (value % 16 == 1) {
+          sample = MinSample(bytes_per_sample);
+        } else {
+          sample = MinSample(bytes_per_sample) +
+                   static_cast<int64_t>(random.Next()) % range;
+        }
+        storage_[c][offset + i] = static_cast<int>(sample);
+      }
+      channels_[c] = storage_[c].data() + offset;
+    }
+  }
+
+  // Sets all the samples of all the channels to |value|.
+  void Fill(int value) {
+    for (size_t c = 0; c < storage_.size(); c++) {
+      for (unsigned i = 0; i < kMaxSampleCount; i++) {
+        channels_[c][i] = value;
+      }
+    }
+  }
+
+  const int* const* channels() const { return channels_; }
+
+ private:
+  std::vector<std::vector<int>> storage_;
+  int* channels_[kMaxChannels];
+};
+
+// A destination surrounded by guard bytes.
+class Destination {
+ public:
+  Destination(size_t size, unsigned offset)
+      : storage_(offset + size + 2 * kGuardSize, kGuardValue),
+        offset_(offset),
+        size_(size) {}
+
+  int8_t* data() {
+    return reinterpret_cast<int8_t*>(storage_.data() + kGuardSize + offset_);
+  }
+
+  const uint8_t* bytes() const {
+    return storage_.data() + kGuardSize + offset_;
+  }
+
+  // Returns whether the bytes around the destination are unchanged.
+  bool CheckGuards() const {
+    for (size_t i = 0; i < storage_.size(); i++) {
+      if ((i < kGuardSize + offset_ || i >= kGuardSize + offset_ + size_) &&
+          storage_[i] != kGuardValue) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+ private:
+  std::vector<uint8_t> storage_;
+  const unsigned offset_;
+  const size_t size_;
+};
+
+void Fail(const char* name, unsigned bytes_per_sample, unsigned channels,
+          unsigned samples, const char* message) {
+  failure_count++;
+  std::printf("%s, %u bytes, %u channels, %u samples: %s\n", name,
+              bytes_per_sample, channels, samples, message);
+}
+
+int16_t ReadInt16(const uint8_t* bytes) {
+  int16_t value;
+  std::memcpy(&value, bytes, sizeof(value));
+  return value;
+}
+
+float ReadFloat(const uint8_t* bytes) {
+  float value;
+  std::memcpy(&value, bytes, sizeof(value));
+  return value;
+}
+
+// Returns the little endian integer of |size| bytes at |bytes|.
+int64_t ReadInt(const uint8_t* bytes, unsigned size) {
+  uint64_t value = 0;
+  for (unsigned i = 0; i < size; i++) {
+    value |= static_cast<uint64_t>(bytes[i]) << (8 * i);
+  }
+  const unsigned shift = 64 - 8 * size;
+  return static_cast<int64_t>(value << shift) >> shift;
+}
+
+// Checks the copies of the source encoding, with and without a downmix to
+// stereo, which doesn't apply to 1 and 2 channels.
+void TestSourceCopy(bool big_endian) {
+  const char* const name = big_endian ? "big endian" : "little endian";
+  for (unsigned bytes = 1; bytes <= 4; bytes++) {
+    for (unsigned channels = 1; channels <= kMaxChannels; channels++) {
+      for (bool downmix : {false, true}) {
+        if (downmix && (big_endian || channels > 2)) continue;
+        const PcmCopyFunction copy =
+            big_endian ? getBigEndianPcmCopyFunction()
+                       : getLittleEndianPcmCopyFunction(
+                             kPcmOutputEncodingSource, downmix, bytes,
+                             channels);
+        if (copy == NULL) {
+          Fail(name, bytes, channels, 0, "no copy function");
+          continue;
+        }
+        for (unsigned source_offset : kSourceOffsets) {
+          const Source source(bytes, channels, source_offset,
+                              bytes * 97 + channels * 13 + source_offset);
+          for (unsigned destination_offset : kDestinationOffsets) {
+            for (unsigned samples : kSampleCounts) {
+              const size_t size = samples * channels * bytes;
+              Destination destination(size, destination_offset);
+              copy(destination.data(), source.channels(), bytes, samples,
+                   channels, NULL);
+              if (!destination.CheckGuards()) {
+                Fail(name, bytes, channels, samples, "overrun");
+              }
+              const uint8_t* output = destination.bytes();
+              bool matches = true;
+              for (unsigned i = 0; i < samples && matches; i++) {
+                for (unsigned c = 0; c < channels && matches; c++) {
+                  const uint32_t value =
+                      static_cast<uint32_t>(source.channels()[c][i]);
+                  for (unsigned b = 0; b < bytes; b++) {
+                    const unsigned shift =
+                        8 * (big_endian ? bytes - 1 - b : b);
+                    if (*output++ != static_cast<uint8_t>(value >> shift)) {
+                      matches = false;
+                    }
+                  }
+                }
+              }
+              if (!matches) {
+                Fail(name, bytes, channels, samples, "wrong samples");
+              }
+            }
+          }
+        }
+      }
+    }
+  }
+}
+
+// Checks the float output, which must match the scalar conversion exactly.
+void TestFloat() {
+  for (unsigned bytes = 1; bytes <= 4; bytes++) {
+    const float scale = 1.0f / static_cast<float>(1u << (8 * bytes - 1));
+    for (unsigned channels = 1; channels <= kMaxChannels; channels++) {
+      const PcmCopyFunction copy = getLittleEndianPcmCopyFunction(
+          kPcmOutputEncodingFloat, /* downmixToStereo= */ false, bytes,
+          channels);
+      if (copy == NULL) {
+        Fail("float", bytes, channels, 0, "no copy function");
+        continue;
+      }
+      for (unsigned source_offset : kSourceOffsets) {
+        const Source source(bytes, channels, source_offset, bytes + channels);
+        for (unsigned samples : kSampleCounts) {
+          Destination destination(samples * channels * 4, /* offset= */ 1);
+          copy(destination.data(), source.channels(), bytes, samples, channels,
+               NULL);
+          if (!destination.CheckGuards()) {
+            Fail("float", bytes, channels, samples, "overrun");
+          }
+          bool matches = true;
+          for (unsigned i = 0; i < samples; i++) {
+            for (unsigned c = 0; c < channels; c++) {
+              const float expected =
+                  static_cast<float>(source.channels()[c][i]) * scale;
+              const float actual =
+                  ReadFloat(destination.bytes() + 4 * (i * channels + c));
+              if (actual != expected || actual < -1.0f || actual > 1.0f) {
+                matches = false;
+              }
+            }
+          }
+          if (!matches) {
+            Fail("float", bytes, channels, samples, "wrong samples");
+          }
+        }
+      }
+    }
+  }
+}
+
+// Checks the 16-bit output. Larger samples are dithered, so each output must
+// be within one LSB of the rounded sample, and smaller samples are shifted.
+void TestInt16() {
+  const unsigned samples = kMaxSampleCount;
+  for (unsigned bytes = 1; bytes <= 4; bytes++) {
+    const int shift = 8 * static_cast<int>(bytes) - 16;
+    for (unsigned channels = 1; channels <= kMaxChannels; channels++) {
+      const PcmCopyFunction copy = getLittleEndianPcmCopyFunction(
+          kPcmOutputEncoding16Bit, /* downmixToStereo= */ false, bytes,
+          channels);
+      if (copy == NULL) {
+        Fail("16-bit", bytes, channels, 0, "no copy function");
+        continue;
+      }
+      Source source(bytes, channels, /* offset= */ 0, bytes * channels);
+      const size_t size = samples * channels * 2;
+      uint32_t dither_state = 1234;
+      Destination destination(size, /* offset= */ 0);
+      copy(destination.data(), source.channels(), bytes, samples, channels,
+           &dither_state);
+      if (!destination.CheckGuards()) {
+        Fail("16-bit", bytes, channels, samples, "overrun");
+      }
+      bool matches = true;
+      for (unsigned i = 0; i < samples; i++) {
+        for (unsigned c = 0; c < channels; c++) {
+          const int64_t value = source.channels()[c][i];
+          const int64_t actual =
+              ReadInt16(destination.bytes() + 2 * (i * channels + c));
+          if (shift <= 0) {
+            matches &= actual == value * (1 << -shift);
+            continue;
+          }
+          const double exact = static_cast<double>(value) / (1 << shift);
+          const double rounded = std::fmax(
+              -32768.0, std::fmin(std::floor(exact + 0.5), 32767.0));
+          matches &= std::fabs(static_cast<double>(actual) - rounded) <= 1.0;
+        }
+      }
+      if (!matches) {
+        Fail("16-bit", bytes, channels, samples, "wrong samples");
+      }
+      if (shift <= 0) continue;
+
+      // The dither state is written back, and the same state gives the same
+      // output.
+      if (dither_state == 1234) {
+        Fail("16-bit", bytes, channels, samples, "dither state unchanged");
+      }
+      uint32_t repeated_dither_state = 1234;
+      Destination repeated(size, /* offset= */ 0);
+      copy(repeated.data(), source.channels(), bytes, samples, channels,
+           &repeated_dither_state);
+      if (repeated_dither_state != dither_state ||
+          std::memcmp(repeated.bytes(), destination.bytes(), size) != 0) {
+        Fail("16-bit", bytes, channels, samples, "not deterministic");
+      }
+
+      // Full scale samples are clamped rather than wrapped around.
+      const int64_t extremes[] = {MaxSample(bytes), MinSample(bytes)};
+      for (int64_t extreme : extremes) {
+        source.Fill(static_cast<int>(extreme));
+        copy(destination.data(), source.channels(), bytes, samples, channels,
+             &dither_state);
+        for (unsigned i = 0; i < samples * channels; i++) {
+          const int16_t actual = ReadInt16(destination.bytes() + 2 * i);
+          if (extreme > 0 ? actual < 32766 : actual > -32767) {
+            Fail("16-bit", bytes, channels, samples, "wrapped around");
+            break;
+          }
+        }
+      }
+    }
+  }
+}
+
+// Returns the downmixed sample, in [-1, 1], of the channel with the given
+// coefficients.
+double Downmix(const double* coefficients, const double* sum_coefficients,
+               const int* const* src, unsigned channels, unsigned i,
+               unsigned bytes) {
+  double sum = 0.0;
+  double value = 0.0;
+  for (unsigned c = 0; c < channels; c++) {
+    sum += sum_coefficients[c];
+    value += coefficients[c] * src[c][i];
+  }
+  return value / sum / -static_cast<double>(MinSample(bytes));
+}
+
+// Checks the downmixes of 3 to 8 channels to stereo, with each encoding.
+void TestDownmix() {
+  const PcmOutputEncoding encodings[] = {kPcmOutputEncodingSource,
+                                         kPcmOutputEncodingFloat,
+                                         kPcmOutputEncoding16Bit};
+  const char* const names[] = {"source downmix", "float downmix",
+                               "16-bit downmix"};
+  const unsigned samples = 100;
+  for (int e = 0; e < 3; e++) {
+    const PcmOutputEncoding encoding = encodings[e];
+    for (unsigned bytes = 1; bytes <= 4; bytes++) {
+      const unsigned output_bytes = getPcmOutputBytesPerSample(encoding, bytes);
+      // The downmix is computed in single precision.
+      double tolerance;
+      if (encoding == kPcmOutputEncodingFloat) {
+        tolerance = 1e-6;
+      } else {
+        const double scale = -static_cast<double>(MinSample(output_bytes));
+        tolerance = (encoding == kPcmOutputEncoding16Bit ? 2.0 : 1.0) / scale +
+                    1e-6;
+      }
+      for (unsigned channels = 3; channels <= kMaxChannels; channels++) {
+        const PcmCopyFunction copy = getLittleEndianPcmCopyFunction(
+            encoding, /* downmixToStereo= */ true, bytes, channels);
+        if (getPcmOutputChannels(/* downmixToStereo= */ true, channels) != 2 ||
+            copy == NULL) {
+          Fail(names[e], bytes, channels, 0, "no copy function");
+          continue;
+        }
+        Source source(bytes, channels, /* offset= */ 0, bytes * channels);
+        for (int pass = 0; pass < 3; pass++) {
+          // Full scale samples in all the channels must not clip.
+          if (pass == 1) source.Fill(static_cast<int>(MaxSample(bytes)));
+          if (pass == 2) source.Fill(static_cast<int>(MinSample(bytes)));
+          uint32_t dither_state = 1;
+          Destination destination(samples * 2 * output_bytes,
+                                  /* offset= */ 3);
+          copy(destination.data(), source.channels(), bytes, samples, channels,
+               &dither_state);
+          if (!destination.CheckGuards()) {
+            Fail(names[e], bytes, channels, samples, "overrun");
+          }
+          bool matches = true;
+          for (unsigned i = 0; i < samples; i++) {
+            for (unsigned side = 0; side < 2; side++) {
+              const double expected = Downmix(
+                  side == 0 ? kDownmixLeft[channels] : kDownmixRight[channels],
+                  kDownmixLeft[channels], source.channels(), channels, i,
+                  bytes);
+              const uint8_t* output =
+                  destination.bytes() + output_bytes * (2 * i + side);
+              double actual;
+              if (encoding == kPcmOutputEncodingFloat) {
+                actual = ReadFloat(output);
+              } else {
+                actual = static_cast<double>(ReadInt(output, output_bytes)) /
+                         -static_cast<double>(MinSample(output_bytes));
+              }
+              matches &= std::fabs(actual - expected) <= tolerance;
+            }
+          }
+          if (!matches) {
+            Fail(names[e], bytes, channels, samples,
+                 pass == 0 ? "wrong samples" : "clipped");
+          }
+        }
+      }
+    }
+  }
+}
+
+void TestOutputFormat() {
+  for (unsigned channels = 1; channels <= kMaxChannels; channels++) {
+    const unsigned downmixed_channels = channels > 2 ? 2 : channels;
+    if (getPcmOutputChannels(/* downmixToStereo= */ false, channels) !=
+            channels ||
+        getPcmOutputChannels(/* downmixToStereo= */ true, channels) !=
+            downmixed_channels) {
+      Fail("getPcmOutputChannels", 0, channels, 0, "wrong channel count");
+    }
+  }
+  for (unsigned bytes = 1; bytes <= 4; bytes++) {
+    if (getPcmOutputBytesPerSample(kPcmOutputEncodingSource, bytes) != bytes ||
+        getPcmOutputBytesPerSample(kPcmOutputEncodingFloat, bytes) != 4 ||
+        getPcmOutputBytesPerSample(kPcmOutputEncoding16Bit, bytes) != 2) {
+      Fail("getPcmOutputBytesPerSample", bytes, 0, 0, "wrong sample size");
+    }
+  }
+  const unsigned unsupported[][2] = {{0, 2}, {5, 2}, {2, 0}, {2, 9}};
+  for (const unsigned* format : unsupported) {
+    if (getLittleEndianPcmCopyFunction(kPcmOutputEncodingSource,
+                                       /* downmixToStereo= */ false,
+                                       format[0], format[1]) != NULL) {
+      Fail("getLittleEndianPcmCopyFunction", format[0], format[1], 0,
+           "unsupported format has a copy function");
+    }
+  }
+}
+
+}  // namespace
+
+int main() {
+#if defined(__SSSE3__) && (defined(__x86_64__) || defined(__i386__))
+  if (!__builtin_cpu_supports("ssse3")) {
+    std::printf("SSSE3 not supported, skipped\n");
+    return 0;
+  }
+#endif
+  TestSourceCopy(/* big_endian= */ false);
+  // The big endian copy is only used, and only writes big endian samples, on
+  // big endian hosts.
+  const int endian = 1;
+  if (*reinterpret_cast<const char*>(&endian) == 0) {
+    TestSourceCopy(/* big_endian= */ true);
+  }
+  TestFloat();
+  TestInt16();
+  TestDownmix();
+  TestOutputFormat();
+  if (failure_count > 0) {
+    std::printf("%d failures\n", failure_count);
+    return 1;
+  }
+  std::printf("All tests passed\n");
+  return 0;
+}
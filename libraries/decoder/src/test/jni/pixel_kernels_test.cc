@@ -0,0 +1,434 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Golden output tests of the pixel kernels.
+//
+// Every kernel is run on deterministic inputs with all combinations of the
+// instruction sets supported by the host, and the hash of its output
+// (including guard bytes around each destination row, to catch overruns) is
+// compared with a golden value computed with the portable kernels. A SIMD
+// kernel therefore passes only if it's byte-for-byte identical to the
+// portable one.
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "bit_depth_converter.h"  // NOLINT
+#include "pixel_kernels.h"  // NOLINT
+#include "plane_copy.h"  // NOLINT
+
+namespace decoder_jni {
+namespace {
+
+const uint32_t kAllIsas[] = {kIsaNeon, kIsaSve, kIsaSse2, kIsaSse41,
+                             kIsaAvx2};
+
+// Row widths covering the vector loops, their tails and empty rows.
+const int kWidths[] = {0,  1,  3,  4,   15,  16,  17,  31,  32,   33,
+                       63, 64, 65, 127, 128, 129, 255, 257, 1000, 1927};
+
+// Offsets of the rows from aligned addresses, in bytes.
+const int kOffsets[] = {0, 1, 2, 7, 16, 30};
+const int kMaxOffset = 32;
+// The maximum size of a row, in bytes.
+const int kMaxRowSize = 4 * 2048;
+
+// Guard bytes before and after each destination row.
+const int kGuardSize = 64;
+const uint8_t kGuardValue = 0xA5;
+
+// Golden hashes of the outputs of the portable kernels.
+const uint64_t kCopyRowGolden = 0xa6b6a1fba37a1949;
+const uint64_t kCopyRowPairGolden = 0x109065c4764df162;
+const uint64_t kShiftRow16Golden = 0xff99e4175df85bdb;
+const uint64_t kInterleaveRow16Golden = 0x51e10dbd2695df6d;
+const uint64_t kConvertRow10To8Golden = 0x079aed847834fd54;
+const uint64_t kPlaneCopierGolden = 0x274212a1782d634e;
+const uint64_t kBitDepthConverterGolden = 0xa5ca4c504f3b3c59;
+
+int failure_count = 0;
+
+// A 64-bit FNV-1a hash.
+class Hasher {
+ public:
+  void Update(const void* data, size_t size) {
+    const uint8_t* const bytes = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < size; i++) {
+      hash_ = (hash_ ^ bytes[i]) * 0x100000001b3;
+    }
+  }
+
+  uint64_t hash() const { return hash_; }
+
+ private:
+  uint64_t hash_ = 0xcbf29ce484222325;
+};
+
+// A deterministic pseudo-random number generator.
+class Random {
+ public:
+  explicit Random(uint32_t seed) : state_(seed) {}
+
+  uint32_t Next() {
+    state_ = state_ * 1664525 + 1013904223;
+    return MixBits(state_);
+  }
+
+ private:
+  uint32_t state_;
+};
+
+// A buffer of bytes whose start is 64-byte aligned.
+class AlignedBuffer {
+ public:
+  explicit AlignedBuffer(size_t size) : storage_(size + 64) {
+    const uintptr_t address = reinterpret_cast<uintptr_t>(storage_.data());
+    data_ = storage_.data() + (-address & 63);
+  }
+
+  uint8_t* data() { return data_; }
+
+ private:
+  std::vector<uint8_t> storage_;
+  uint8_t* data_;
+};
+
+void FillRandom(uint8_t* data, size_t size, Random* random) {
+  for (size_t i = 0; i < size; i++) {
+    data[i] = static_cast<uint8_t>(random->Next());
+  }
+}
+
+// Fills |data| with 16-bit samples. Most are 10-bit, but some use all 16 bits
+// so that saturation is covered too.
+void FillRandom16(uint8_t* data, size_t count, Random* random) {
+  for (size_t i = 0; i < count; i++) {
+    const uint32_t value = random->Next();
+    const uint16_t sample = static_cast<uint16_t>(
+        (value & 0xF000) == 0 ? value >> 16 : (value >> 16) & 0x3FF);
+    std::memcpy(data + 2 * i, &sample, sizeof(sample));
+  }
+}
+
+std::vector<uint32_t> GetIsaCombinations() {
+  std::vector<uint32_t> isas_list;
+  std::vector<uint32_t> supported;
+  for (uint32_t isa : kAllIsas) {
+    if (GetSupportedIsas() & isa) supported.push_back(isa);
+  }
+  for (uint32_t mask = 0; mask < (1u << supported.size()); mask++) {
+    uint32_t isas = 0;
+    for (size_t i = 0; i < supported.size(); i++) {
+      if (mask & (1u << i)) isas |= supported[i];
+    }
+    isas_list.push_back(isas);
+  }
+  return isas_list;
+}
+
+// Destination rows with guard bytes.
+class Destination {
+ public:
+  Destination() : buffer_(kGuardSize + kMaxOffset + kMaxRowSize + kGuardSize) {}
+
+  // Returns a row at |offset| bytes from an aligned address, with guard bytes
+  // around |size| bytes.
+  uint8_t* Row(int offset, int size) {
+    size_ = size;
+    row_ = buffer_.data() + kGuardSize + offset;
+    std::memset(row_ - kGuardSize, kGuardValue, kGuardSize);
+    std::memset(row_ + size, kGuardValue, kGuardSize);
+    return row_;
+  }
+
+  // Hashes the row and the guard bytes around it.
+  void Hash(Hasher* hasher) const {
+    hasher->Update(row_ - kGuardSize, kGuardSize + size_ + kGuardSize);
+  }
+
+ private:
+  AlignedBuffer buffer_;
+  uint8_t* row_ = nullptr;
+  int size_ = 0;
+};
+
+uint64_t RunCopyRow(const PixelKernels& kernels) {
+  Random random(1);
+  AlignedBuffer source(4096);
+  Destination destination;
+  Hasher hasher;
+  for (bool streaming : {false, true}) {
+    const auto copy_row =
+        streaming ? kernels.copy_row_streaming : kernels.copy_row;
+    for (int width : kWidths) {
+      for (int source_offset : kOffsets) {
+        for (int destination_offset : kOffsets) {
+          FillRandom(source.data() + source_offset, width, &random);
+          uint8_t* const row = destination.Row(destination_offset, width);
+          copy_row(source.data() + source_offset, row, width);
+          destination.Hash(&hasher);
+        }
+      }
+    }
+  }
+  FinishStreamingStores();
+  return hasher.hash();
+}
+
+uint64_t RunCopyRowPair(const PixelKernels& kernels) {
+  Random random(2);
+  AlignedBuffer source_a(4096);
+  AlignedBuffer source_b(4096);
+  Destination destination_a;
+  Destination destination_b;
+  Hasher hasher;
+  for (bool streaming : {false, true}) {
+    const auto copy_row_pair =
+        streaming ? kernels.copy_row_pair_streaming : kernels.copy_row_pair;
+    for (int width : kWidths) {
+      for (int offset_a : kOffsets) {
+        // Covers destinations that are aligned the same way and differently.
+        for (int offset_b : {offset_a, (offset_a + 3) % 32}) {
+          FillRandom(source_a.data() + offset_b, width, &random);
+          FillRandom(source_b.data() + offset_a, width, &random);
+          uint8_t* const row_a = destination_a.Row(offset_a, width);
+          uint8_t* const row_b = destination_b.Row(offset_b, width);
+          copy_row_pair(source_a.data() + offset_b, source_b.data() + offset_a,
+                        row_a, row_b, width);
+          destination_a.Hash(&hasher);
+          destination_b.Hash(&hasher);
+        }
+      }
+    }
+  }
+  FinishStreamingStores();
+  return hasher.hash();
+}
+
+uint64_t RunShiftRow16(const PixelKernels& kernels) {
+  Random random(3);
+  AlignedBuffer source(4096);
+  Destination destination;
+  Hasher hasher;
+  for (int shift : {0, 6}) {
+    for (int width : kWidths) {
+      for (int offset : {0, 2, 6}) {
+        FillRandom16(source.data() + offset, width, &random);
+        uint8_t* const row = destination.Row(offset, 2 * width);
+        kernels.shift_row_16(
+            reinterpret_cast<const uint16_t*>(source.data() + offset),
+            reinterpret_cast<uint16_t*>(row), width, shift);
+        destination.Hash(&hasher);
+      }
+    }
+  }
+  return hasher.hash();
+}
+
+uint64_t RunInterleaveRow16(const PixelKernels& kernels) {
+  Random random(4);
+  AlignedBuffer source_a(4096);
+  AlignedBuffer source_b(4096);
+  Destination destination;
+  Hasher hasher;
+  for (int shift : {0, 6}) {
+    for (int width : kWidths) {
+      for (int offset : {0, 2, 6}) {
+        FillRandom16(source_a.data() + offset, width, &random);
+        FillRandom16(source_b.data(), width, &random);
+        uint8_t* const row = destination.Row(offset, 4 * width);
+        kernels.interleave_row_16(
+            reinterpret_cast<const uint16_t*>(source_a.data() + offset),
+            reinterpret_cast<const uint16_t*>(source_b.data()),
+            reinterpret_cast<uint16_t*>(row), width, shift);
+        destination.Hash(&hasher);
+      }
+    }
+  }
+  return hasher.hash();
+}
+
+uint64_t RunConvertRow10To8(const PixelKernels& kernels) {
+  Random random(5);
+  AlignedBuffer source(4096);
+  Destination destination;
+  Hasher hasher;
+  for (int width : kWidths) {
+    for (int offset : {0, 2, 6}) {
+      FillRandom16(source.data() + offset, width, &random);
+      const uint32_t seed = random.Next();
+      uint8_t* const row = destination.Row(offset, width);
+      kernels.convert_row_10_to_8(
+          reinterpret_cast<const uint16_t*>(source.data() + offset), row,
+          width, seed);
+      destination.Hash(&hasher);
+    }
+  }
+  return hasher.hash();
+}
+
+// Checks the portable conversion against its documented definition, which
+// the golden hash then pins down for all kernels.
+bool CheckConvertRow10To8Definition() {
+  const PixelKernels kernels = GetPixelKernels(0);
+  Random random(6);
+  const int width = 1000;
+  AlignedBuffer source(2 * width);
+  std::vector<uint8_t> destination(width);
+  FillRandom16(source.data(), width, &random);
+  const uint32_t seed = random.Next();
+  const uint16_t* const samples =
+      reinterpret_cast<const uint16_t*>(source.data());
+  kernels.convert_row_10_to_8(samples, destination.data(), width, seed);
+  for (int i = 0; i < width; i++) {
+    const uint32_t dither =
+        (MixBits(seed + static_cast<uint32_t>(i / 4)) >> (8 * (i % 4))) & 3;
+    const uint32_t expected = std::min((samples[i] + dither) >> 2, 255u);
+    if (destination[i] != expected) {
+      std::printf("Sample %d: expected %u, got %u\n", i, expected,
+                  destination[i]);
+      return false;
+    }
+  }
+  return true;
+}
+
+uint64_t RunPlaneCopier(uint32_t isas) {
+  const PlaneCopier copier(isas);
+  Random random(7);
+  Hasher hasher;
+  // The second size is above the threshold for streaming stores.
+  for (int width : {97, 1601}) {
+    const int height = width == 97 ? 13 : 700;
+    const int source_stride = width + 35;
+    const int destination_stride = width + 77;
+    const size_t source_size = static_cast<size_t>(source_stride) * height;
+    const size_t destination_size =
+        static_cast<size_t>(destination_stride) * height;
+    AlignedBuffer source_a(2 * source_size + 8);
+    AlignedBuffer source_b(2 * source_size + 8);
+    AlignedBuffer destination_a(4 * destination_size + 8);
+    AlignedBuffer destination_b(4 * destination_size + 8);
+    FillRandom(source_a.data(), 2 * source_size + 8, &random);
+    FillRandom(source_b.data(), 2 * source_size + 8, &random);
+
+    std::memset(destination_a.data(), kGuardValue, 4 * destination_size + 8);
+    copier.CopyPlane(source_a.data() + 1, source_stride,
+                     destination_a.data() + 3, destination_stride, width,
+                     height);
+    hasher.Update(destination_a.data(), destination_size + 8);
+
+    std::memset(destination_a.data(), kGuardValue, 4 * destination_size + 8);
+    std::memset(destination_b.data(), kGuardValue, 4 * destination_size + 8);
+    copier.CopyChromaPlanes(source_a.data() + 5, source_stride,
+                            source_b.data(), source_stride,
+                            destination_a.data(), destination_b.data() + 8,
+                            destination_stride, width / 2, height);
+    hasher.Update(destination_a.data(), destination_size + 8);
+    hasher.Update(destination_b.data(), destination_size + 8);
+
+    std::memset(destination_a.data(), kGuardValue, 4 * destination_size + 8);
+    copier.ShiftPlane16(source_a.data(), 2 * source_stride,
+                        destination_a.data() + 2, 2 * destination_stride,
+                        width, height, 6);
+    hasher.Update(destination_a.data(), 2 * destination_size + 8);
+
+    std::memset(destination_a.data(), kGuardValue, 4 * destination_size + 8);
+    copier.InterleaveChromaPlanes16(source_a.data(), 2 * source_stride,
+                                    source_b.data() + 2, 2 * source_stride,
+                                    destination_a.data(),
+                                    4 * destination_stride, width, height, 6);
+    hasher.Update(destination_a.data(), 4 * destination_size + 8);
+  }
+  return hasher.hash();
+}
+
+uint64_t RunBitDepthConverter(uint32_t isas, int max_threads) {
+  BitDepthConverter converter(isas, max_threads);
+  Random random(8);
+  Hasher hasher;
+  const int widths[] = {1283, 642, 642};
+  const int heights[] = {77, 39, 39};
+  std::vector<AlignedBuffer> sources;
+  std::vector<AlignedBuffer> destinations;
+  for (int i = 0; i < 3; i++) {
+    sources.emplace_back(static_cast<size_t>(2 * widths[i] + 16) * heights[i]);
+    destinations.emplace_back(static_cast<size_t>(widths[i] + 8) * heights[i]);
+  }
+  // The dither differs between frames, so two frames are converted.
+  for (int frame = 0; frame < 2; frame++) {
+    BitDepthConverter::Plane planes[3];
+    for (int i = 0; i < 3; i++) {
+      const size_t destination_size =
+          static_cast<size_t>(widths[i] + 8) * heights[i];
+      FillRandom16(sources[i].data(),
+                   static_cast<size_t>(widths[i] + 8) * heights[i], &random);
+      std::memset(destinations[i].data(), kGuardValue, destination_size);
+      planes[i] = {sources[i].data(),      2 * widths[i] + 16,
+                   destinations[i].data(), widths[i] + 8,
+                   widths[i],              heights[i]};
+    }
+    converter.Convert10BitTo8Bit(planes, 3);
+    for (int i = 0; i < 3; i++) {
+      hasher.Update(destinations[i].data(),
+                    static_cast<size_t>(widths[i] + 8) * heights[i]);
+    }
+  }
+  return hasher.hash();
+}
+
+void Expect(const char* name, uint32_t isas, uint64_t actual,
+            uint64_t expected) {
+  if (actual == expected) return;
+  failure_count++;
+  std::printf("%s with ISAs 0x%" PRIx32 ": got 0x%016" PRIx64
+              ", expected 0x%016" PRIx64 "\n",
+              name, isas, actual, expected);
+}
+
+}  // namespace
+}  // namespace decoder_jni
+
+int main() {
+  using namespace decoder_jni;  // NOLINT
+  std::printf("Supported ISAs: 0x%" PRIx32 "\n", GetSupportedIsas());
+  if (!CheckConvertRow10To8Definition()) failure_count++;
+  for (uint32_t isas : GetIsaCombinations()) {
+    const PixelKernels kernels = GetPixelKernels(isas);
+    Expect("copy_row", isas, RunCopyRow(kernels), kCopyRowGolden);
+    Expect("copy_row_pair", isas, RunCopyRowPair(kernels), kCopyRowPairGolden);
+    Expect("shift_row_16", isas, RunShiftRow16(kernels), kShiftRow16Golden);
+    Expect("interleave_row_16", isas, RunInterleaveRow16(kernels),
+           kInterleaveRow16Golden);
+    Expect("convert_row_10_to_8", isas, RunConvertRow10To8(kernels),
+           kConvertRow10To8Golden);
+    Expect("PlaneCopier", isas, RunPlaneCopier(isas), kPlaneCopierGolden);
+    for (int max_threads : {1, 4}) {
+      Expect("BitDepthConverter", isas, RunBitDepthConverter(isas, max_threads),
+             kBitDepthConverterGolden);
+    }
+  }
+  if (failure_count > 0) {
+    std::printf("%d failures\n", failure_count);
+    return 1;
+  }
+  std::printf("All tests passed\n");
+  return 0;
+}
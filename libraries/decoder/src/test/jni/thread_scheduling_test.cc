@@ -0,0 +1,163 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+// Tests of the CPU topology and the decoder thread scheduling heuristics.
+
+#include <sched.h>
+
+#include <cstdio>
+#include <vector>
+
+#include "cpu_info.h"           // NOLINT
+#include "thread_scheduling.h"  // NOLINT
+
+namespace decoder_jni {
+namespace {
+
+int failure_count = 0;
+
+void Expect(const char* name, int actual, int expected) {
+  if (actual != expected) {
+    std::printf("FAILED: %s is %d, expected %d\n", name, actual, expected);
+    failure_count++;
+  }
+}
+
+CpuCluster CreateCluster(int first_cpu, int num_cpus, int capacity) {
+  CpuCluster cluster;
+  for (int i = 0; i < num_cpus; i++) {
+    cluster.cpus.push_back(first_cpu + i);
+  }
+  cluster.capacity = capacity;
+  return cluster;
+}
+
+// A tri-cluster SoC: 1 prime core, 3 big cores and 4 little cores, with the
+// little cores first as on most devices.
+CpuTopology CreateTriClusterTopology() {
+  CpuTopology topology;
+  topology.clusters.push_back(CreateCluster(7, 1, 1024));
+  topology.clusters.push_back(CreateCluster(4, 3, 870));
+  topology.clusters.push_back(CreateCluster(0, 4, 325));
+  return topology;
+}
+
+void TestTriClusterTopology() {
+  const CpuTopology topology = CreateTriClusterTopology();
+  Expect("GetNumberOfCpus", topology.GetNumberOfCpus(), 8);
+  Expect("GetNumberOfPerformanceCores",
+         topology.GetNumberOfPerformanceCores(), 4);
+  const std::vector<int> cpus = topology.GetPerformanceCpus();
+  Expect("GetPerformanceCpus().size()", static_cast<int>(cpus.size()), 4);
+  for (int i = 0; i < static_cast<int>(cpus.size()); i++) {
+    Expect("GetPerformanceCpus()[i]", cpus[i], 4 + i);
+  }
+}
+
+void TestSymmetricTopology() {
+  CpuTopology topology;
+  topology.clusters.push_back(CreateCluster(0, 4, 1024));
+  Expect("GetNumberOfPerformanceCores",
+         topology.GetNumberOfPerformanceCores(), 4);
+  Expect("GetPerformanceCpus().size()",
+         static_cast<int>(topology.GetPerformanceCpus().size()), 4);
+  // There's nothing to restrict the threads to.
+  Expect("SetPerformanceCoreAffinity", SetPerformanceCoreAffinity(topology),
+         false);
+}
+
+void TestGetDecoderThreadCount() {
+  const CpuTopology topology = CreateTriClusterTopology();
+  Expect("threads(unknown size)", GetDecoderThreadCount(topology, -1, -1), 4);
+  Expect("threads(240p)", GetDecoderThreadCount(topology, 426, 240), 1);
+  Expect("threads(360p)", GetDecoderThreadCount(topology, 640, 360), 1);
+  Expect("threads(480p)", GetDecoderThreadCount(topology, 854, 480), 2);
+  Expect("threads(720p)", GetDecoderThreadCount(topology, 1280, 720), 4);
+  Expect("threads(2160p)", GetDecoderThreadCount(topology, 3840, 2160), 4);
+  Expect("threads(empty topology)",
+         GetDecoderThreadCount(CpuTopology(), 1920, 1080), 1);
+}
+
+void TestReadCpuTopology() {
+  CpuTopology topology;
+  if (!ReadCpuTopology(&topology)) {
+    std::printf("CPU topology not available\n");
+    return;
+  }
+  std::printf("%d CPUs in %d clusters\n", topology.GetNumberOfCpus(),
+              static_cast<int>(topology.clusters.size()));
+  Expect("GetNumberOfPerformanceCoresOnline",
+         GetNumberOfPerformanceCoresOnline(),
+         topology.GetNumberOfPerformanceCores());
+  Expect("clusters[0].capacity", topology.clusters[0].capacity, 1024);
+  for (size_t i = 1; i < topology.clusters.size(); i++) {
+    Expect("clusters sorted", topology.clusters[i].capacity <
+                                  topology.clusters[i - 1].capacity,
+           true);
+  }
+}
+
+void TestGetCpuTopology() {
+  CpuTopology topology;
+  const bool available = ReadCpuTopology(&topology);
+  for (int i = 0; i < 3; i++) {
+    if (i == 2) {
+      InvalidateCpuTopology();
+    }
+    CpuTopology cached_topology;
+    Expect("GetCpuTopology", GetCpuTopology(&cached_topology), available);
+    if (!available) {
+      continue;
+    }
+    Expect("cached clusters.size()",
+           static_cast<int>(cached_topology.clusters.size()),
+           static_cast<int>(topology.clusters.size()));
+    Expect("cached GetNumberOfCpus", cached_topology.GetNumberOfCpus(),
+           topology.GetNumberOfCpus());
+  }
+}
+
+void TestScopedPerformanceCoreAffinity() {
+  cpu_set_t before;
+  if (sched_getaffinity(0, sizeof(before), &before) != 0) {
+    return;
+  }
+  {
+    const ScopedPerformanceCoreAffinity affinity(CreateTriClusterTopology(),
+                                                 /* enabled= */ true);
+  }
+  cpu_set_t after;
+  Expect("sched_getaffinity", sched_getaffinity(0, sizeof(after), &after), 0);
+  Expect("affinity restored", CPU_EQUAL(&before, &after) != 0, true);
+}
+
+}  // namespace
+}  // namespace decoder_jni
+
+int main() {
+  using namespace decoder_jni;  // NOLINT
+  TestTriClusterTopology();
+  TestSymmetricTopology();
+  TestGetDecoderThreadCount();
+  TestReadCpuTopology();
+  TestGetCpuTopology();
+  TestScopedPerformanceCoreAffinity();
+  if (failure_count > 0) {
+    std::printf("%d failures\n", failure_count);
+    return 1;
+  }
+  std::printf("All tests passed\n");
+  return 0;
+}
@@ -16,18 +16,22 @@
 package androidx.media3.decoder.av1;
 
 import static androidx.annotation.VisibleForTesting.PACKAGE_PRIVATE;
+import static java.lang.Math.max;
 import static java.lang.Runtime.getRuntime;
 
 import android.view.Surface;
 import androidx.annotation.Nullable;
 import androidx.annotation.VisibleForTesting;
 import androidx.media3.common.C;
+import androidx.media3.common.Format;
 import androidx.media3.common.util.UnstableApi;
 import androidx.media3.common.util.Util;
 import androidx.media3.decoder.DecoderInputBuffer;
 import androidx.media3.decoder.SimpleDecoder;
 import androidx.media3.decoder.VideoDecoderOutputBuffer;
+import androidx.media3.decoder.VideoDecoderStats;
 import java.nio.ByteBuffer;
+import java.util.ArrayDeque;
 
 /** Gav1 decoder. */
 @VisibleForTesting(otherwise = PACKAGE_PRIVATE)
@@ -38,8 +42,12 @@ public final class Gav1Decoder
   private static final int GAV1_ERROR = 0;
   private static final int GAV1_OK = 1;
   private static final int GAV1_DECODE_ONLY = 2;
+  private static final int GAV1_TRY_AGAIN = 3;
 
   private final long gav1DecoderContext;
+  private final int maxFramesInFlight;
+  /** Input buffers that have been passed to libgav1, but whose frames have not been dequeued. */
+  private final ArrayDeque<PendingFrame> pendingFrames;
 
   private volatile @C.VideoOutputMode int outputMode;
 
@@ -57,6 +65,76 @@ public final class Gav1Decoder
   public Gav1Decoder(
       int numInputBuffers, int numOutputBuffers, int initialInputBufferSize, int threads)
       throws Gav1DecoderException {
+    this(
+        numInputBuffers,
+        numOutputBuffers,
+        initialInputBufferSize,
+        threads,
+        /* maxFramesInFlight= */ 1);
+  }
+
+  /**
+   * Creates a Gav1Decoder.
+   *
+   * @param numInputBuffers Number of input buffers.
+   * @param numOutputBuffers Number of output buffers.
+   * @param initialInputBufferSize The initial size of each input buffer, in bytes.
+   * @param threads Number of threads libgav1 will use to decode. If {@link
+   *     Libgav1VideoRenderer#THREAD_COUNT_AUTODETECT} is passed, then this class will auto detect
+   *     the number of threads to be used.
+   * @param maxFramesInFlight The maximum number of frames libgav1 may decode in parallel. If
+   *     greater than one, libgav1's frame parallel mode is used, and each frame is output after up
+   *     to {@code maxFramesInFlight - 1} further input buffers have been queued.
+   * @throws Gav1DecoderException Thrown if an exception occurs when initializing the decoder.
+   */
+  public Gav1Decoder(
+      int numInputBuffers,
+      int numOutputBuffers,
+      int initialInputBufferSize,
+      int threads,
+      int maxFramesInFlight)
+      throws Gav1DecoderException {
+    this(
+        numInputBuffers,
+        numOutputBuffers,
+        initialInputBufferSize,
+        threads,
+        maxFramesInFlight,
+        /* width= */ Format.NO_VALUE,
+        /* height= */ Format.NO_VALUE,
+        /* performanceCoreAffinityEnabled= */ false);
+  }
+
+  /**
+   * Creates a Gav1Decoder.
+   *
+   * @param numInputBuffers Number of input buffers.
+   * @param numOutputBuffers Number of output buffers.
+   * @param initialInputBufferSize The initial size of each input buffer, in bytes.
+   * @param threads Number of threads libgav1 will use to decode. If {@link
+   *     Libgav1VideoRenderer#THREAD_COUNT_AUTODETECT} is passed, then this class will auto detect
+   *     the number of threads to be used.
+   * @param maxFramesInFlight The maximum number of frames libgav1 may decode in parallel. If
+   *     greater than one, libgav1's frame parallel mode is used, and each frame is output after up
+   *     to {@code maxFramesInFlight - 1} further input buffers have been queued.
+   * @param maxWidth The maximum width of the video in pixels, or {@link Format#NO_VALUE} if
+   *     unknown. Used to auto detect the number of threads.
+   * @param maxHeight The maximum height of the video in pixels, or {@link Format#NO_VALUE} if
+   *     unknown. Used to auto detect the number of threads.
+   * @param performanceCoreAffinityEnabled Whether to restrict the decoder threads to the
+   *     performance cores on devices with heterogeneous cores (e.g. big.LITTLE).
+   * @throws Gav1DecoderException Thrown if an exception occurs when initializing the decoder.
+   */
+  public Gav1Decoder(
+      int numInputBuffers,
+      int numOutputBuffers,
+      int initialInputBufferSize,
+      int threads,
+      int maxFramesInFlight,
+      int maxWidth,
+      int maxHeight,
+      boolean performanceCoreAffinityEnabled)
+      throws Gav1DecoderException {
     super(new DecoderInputBuffer[numInputBuffers], new VideoDecoderOutputBuffer[numOutputBuffers]);
     if (!Gav1Library.isAvailable()) {
       throw new Gav1DecoderException("Failed to load decoder native library.");
@@ -64,14 +142,17 @@ public final class Gav1Decoder
 
     if (threads == Libgav1VideoRenderer.THREAD_COUNT_AUTODETECT) {
       // Try to get the optimal number of threads from the AV1 heuristic.
-      threads = gav1GetThreads();
+      threads = gav1GetThreads(maxWidth, maxHeight);
       if (threads <= 0) {
         // If that is not available, default to the number of available processors.
         threads = getRuntime().availableProcessors();
       }
     }
 
-    gav1DecoderContext = gav1Init(threads);
+    this.maxFramesInFlight = max(maxFramesInFlight, 1);
+    pendingFrames = new ArrayDeque<>();
+    gav1DecoderContext =
+        gav1Init(threads, this.maxFramesInFlight, performanceCoreAffinityEnabled);
     if (gav1DecoderContext == GAV1_ERROR || gav1CheckError(gav1DecoderContext) == GAV1_ERROR) {
       throw new Gav1DecoderException(
           "Failed to initialize decoder. Error: " + gav1GetErrorMessage(gav1DecoderContext));
@@ -98,16 +179,90 @@ public final class Gav1Decoder
   @Nullable
   protected Gav1DecoderException decode(
       DecoderInputBuffer inputBuffer, VideoDecoderOutputBuffer outputBuffer, boolean reset) {
+    if (reset) {
+      @Nullable Gav1DecoderException exception = flushPendingFrames();
+      if (exception != null) {
+        return exception;
+      }
+    }
+
     ByteBuffer inputData = Util.castNonNull(inputBuffer.data);
     int inputSize = inputData.limit();
-    if (gav1Decode(gav1DecoderContext, inputData, inputSize) == GAV1_ERROR) {
+    int decodeResult = gav1Decode(gav1DecoderContext, inputData, inputSize);
+    boolean outputFrame = false;
+    if (decodeResult == GAV1_TRY_AGAIN && !pendingFrames.isEmpty()) {
+      // Libgav1 can't accept more frames, so output the oldest one before retrying.
+      @Nullable Gav1DecoderException exception = dequeueFrame(outputBuffer);
+      if (exception != null) {
+        return exception;
+      }
+      outputFrame = true;
+      decodeResult = gav1Decode(gav1DecoderContext, inputData, inputSize);
+    }
+    if (decodeResult == GAV1_TRY_AGAIN) {
+      // The native error state isn't set in this case, as it's not an error in itself.
+      return new Gav1DecoderException(
+          "gav1Decode error: Decoder didn't accept the input after a frame was dequeued.");
+    } else if (decodeResult != GAV1_OK) {
       return new Gav1DecoderException(
           "gav1Decode error: " + gav1GetErrorMessage(gav1DecoderContext));
     }
+    pendingFrames.add(new PendingFrame(inputBuffer));
+
+    if (outputFrame) {
+      return null;
+    }
+    if (pendingFrames.size() < maxFramesInFlight) {
+      // Keep more frames in flight before dequeuing the oldest one. No frame is output for this
+      // input buffer yet, which isn't a skipped frame.
+      holdBackOutput();
+      return null;
+    }
+    return dequeueFrame(outputBuffer);
+  }
+
+  @Override
+  @Nullable
+  protected Gav1DecoderException drain(VideoDecoderOutputBuffer outputBuffer, boolean reset) {
+    if (reset) {
+      @Nullable Gav1DecoderException exception = flushPendingFrames();
+      if (exception != null) {
+        return exception;
+      }
+    }
+    if (pendingFrames.isEmpty()) {
+      outputBuffer.addFlag(C.BUFFER_FLAG_END_OF_STREAM);
+      return null;
+    }
+    return dequeueFrame(outputBuffer);
+  }
 
-    boolean decodeOnly = inputBuffer.isDecodeOnly();
+  /** Drops the frames decoded before a flush, if any. */
+  @Nullable
+  private Gav1DecoderException flushPendingFrames() {
+    if (pendingFrames.isEmpty()) {
+      return null;
+    }
+    pendingFrames.clear();
+    if (gav1Flush(gav1DecoderContext) == GAV1_ERROR) {
+      return new Gav1DecoderException(
+          "gav1Flush error: " + gav1GetErrorMessage(gav1DecoderContext));
+    }
+    return null;
+  }
+
+  /**
+   * Dequeues the frame of the oldest pending input buffer into {@code outputBuffer}, blocking until
+   * it's decoded.
+   */
+  @Nullable
+  private Gav1DecoderException dequeueFrame(VideoDecoderOutputBuffer outputBuffer) {
+    PendingFrame frame = pendingFrames.remove();
+    // The output buffer takes the flags of the input buffer the frame was decoded from.
+    outputBuffer.setFlags(frame.flags);
+    boolean decodeOnly = outputBuffer.isDecodeOnly();
     if (!decodeOnly) {
-      outputBuffer.init(inputBuffer.timeUs, outputMode, /* supplementalData= */ null);
+      outputBuffer.init(frame.timeUs, outputMode, /* supplementalData= */ null);
     }
     // We need to dequeue the decoded frame from the decoder even when the input data is
     // decode-only.
@@ -120,9 +275,8 @@ public final class Gav1Decoder
       outputBuffer.addFlag(C.BUFFER_FLAG_DECODE_ONLY);
     }
     if (!decodeOnly) {
-      outputBuffer.format = inputBuffer.format;
+      outputBuffer.format = frame.format;
     }
-
     return null;
   }
 
@@ -156,10 +310,28 @@ public final class Gav1Decoder
     this.outputMode = outputMode;
   }
 
+  /**
+   * Returns the performance counters of the decoder since it was created.
+   *
+   * <p>May be called from any thread, but not after {@link #release()}.
+   *
+   * <p>This method is experimental, and will be renamed or removed in a future release.
+   */
+  public VideoDecoderStats experimentalGetStats() {
+    long[] values = new long[VideoDecoderStats.VALUE_COUNT];
+    gav1GetStats(gav1DecoderContext, values);
+    return new VideoDecoderStats(values);
+  }
+
   /**
    * Renders output buffer to the given surface. Must only be called when in {@link
    * C#VIDEO_OUTPUT_MODE_SURFACE_YUV} mode.
    *
+   * <p>High bit depth frames are rendered as 10-bit P010 buffers, with a data space derived from
+   * the color config of the bitstream. If the device doesn't report the layout of P010 buffers
+   * (before API level 29), or the surface rejects them, 10-bit frames are converted to 8 bits
+   * instead.
+   *
    * @param outputBuffer Output buffer.
    * @param surface Output surface.
    * @throws Gav1DecoderException Thrown if called with invalid output mode or frame rendering
@@ -180,9 +352,14 @@ public final class Gav1Decoder
    * Initializes a libgav1 decoder.
    *
    * @param threads Number of threads to be used by a libgav1 decoder.
+   * @param maxFramesInFlight The maximum number of frames that will be enqueued before the oldest
+   *     one is dequeued. Libgav1's frame parallel mode is used if greater than one.
+   * @param performanceCoreAffinity Whether to restrict the decoder threads to the performance
+   *     cores.
    * @return The address of the decoder context or {@link #GAV1_ERROR} if there was an error.
    */
-  private native long gav1Init(int threads);
+  private native long gav1Init(
+      int threads, int maxFramesInFlight, boolean performanceCoreAffinity);
 
   /**
    * Deallocates the decoder context.
@@ -197,10 +374,19 @@ public final class Gav1Decoder
    * @param context Decoder context.
    * @param encodedData Encoded data.
    * @param length Length of the data buffer.
-   * @return {@link #GAV1_OK} if successful, {@link #GAV1_ERROR} if an error occurred.
+   * @return {@link #GAV1_OK} if successful, {@link #GAV1_TRY_AGAIN} if a frame must be dequeued
+   *     before more data can be decoded, {@link #GAV1_ERROR} if an error occurred.
    */
   private native int gav1Decode(long context, ByteBuffer encodedData, int length);
 
+  /**
+   * Drops the frames that have been decoded but not dequeued, and resets the decoder.
+   *
+   * @param context Decoder context.
+   * @return {@link #GAV1_OK} if successful, {@link #GAV1_ERROR} if an error occurred.
+   */
+  private native int gav1Flush(long context);
+
   /**
    * Gets the decoded frame.
    *
@@ -247,10 +433,36 @@ public final class Gav1Decoder
    */
   private native int gav1CheckError(long context);
 
+  /**
+   * Writes the stats of the decoder.
+   *
+   * @param context Decoder context.
+   * @param values An array of at least {@link VideoDecoderStats#VALUE_COUNT} values.
+   */
+  private native void gav1GetStats(long context, long[] values);
+
   /**
    * Returns the optimal number of threads to be used for AV1 decoding.
    *
+   * @param width The width of the video in pixels, or {@link Format#NO_VALUE} if unknown.
+   * @param height The height of the video in pixels, or {@link Format#NO_VALUE} if unknown.
    * @return Optimal number of threads if there was no error, 0 if an error occurred.
    */
-  private native int gav1GetThreads();
+  private native int gav1GetThreads(int width, int height);
+
+  /** An input buffer that has been passed to libgav1. */
+  private static final class PendingFrame {
+
+    public final long timeUs;
+    public final @C.BufferFlags int flags;
+    @Nullable public final Format format;
+
+    public PendingFrame(DecoderInputBuffer inputBuffer) {
+      timeUs = inputBuffer.timeUs;
+      flags =
+          (inputBuffer.isDecodeOnly() ? C.BUFFER_FLAG_DECODE_ONLY : 0)
+              | (inputBuffer.isFirstSample() ? C.BUFFER_FLAG_FIRST_SAMPLE : 0);
+      format = inputBuffer.format;
+    }
+  }
 }
@@ -38,9 +38,10 @@ import androidx.media3.exoplayer.video.VideoRendererEventListener;
 public class Libgav1VideoRenderer extends DecoderVideoRenderer {
 
   /**
-   * Attempts to use as many threads as performance processors available on the device. If the
-   * number of performance processors cannot be detected, the number of available processors is
-   * used.
+   * Attempts to use one thread per 640x360 pixels of the largest frames of the video, but no more
+   * threads than performance processors available on the device. If the maximum size of the video
+   * is unknown, one thread per performance processor is used. If the number of performance
+   * processors cannot be detected, the number of available processors is used.
    */
   public static final int THREAD_COUNT_AUTODETECT = 0;
 
@@ -64,6 +65,8 @@ public class Libgav1VideoRenderer extends DecoderVideoRenderer {
 
   private final int threads;
 
+  private int maxFramesInFlight;
+  private boolean performanceCoreAffinityEnabled;
   @Nullable private Gav1Decoder decoder;
 
   /**
@@ -120,6 +123,40 @@ public class Libgav1VideoRenderer extends DecoderVideoRenderer {
     this.threads = threads;
     this.numInputBuffers = numInputBuffers;
     this.numOutputBuffers = numOutputBuffers;
+    maxFramesInFlight = 1;
+  }
+
+  /**
+   * Sets the maximum number of frames that libgav1 may decode in parallel. If greater than one,
+   * libgav1's frame parallel mode is used, which scales to more cores than tile threading for
+   * streams with few tiles, at the cost of delaying each output frame by up to {@code
+   * maxFramesInFlight - 1} input buffers. One (frame parallel mode disabled) by default.
+   *
+   * <p>Takes effect the next time a decoder is created.
+   *
+   * <p>This method is experimental, and will be renamed or removed in a future release.
+   *
+   * @param maxFramesInFlight The maximum number of frames in flight.
+   */
+  public void experimentalSetMaxFramesInFlight(int maxFramesInFlight) {
+    this.maxFramesInFlight = maxFramesInFlight;
+  }
+
+  /**
+   * Sets whether to restrict the decoder threads to the performance cores on devices with
+   * heterogeneous cores (e.g. big.LITTLE), so that frames aren't delayed by threads scheduled on
+   * efficiency cores. Disabled by default.
+   *
+   * <p>Takes effect the next time a decoder is created.
+   *
+   * <p>This method is experimental, and will be renamed or removed in a future release.
+   *
+   * @param performanceCoreAffinityEnabled Whether to restrict the decoder threads to the
+   *     performance cores.
+   */
+  public void experimentalSetPerformanceCoreAffinityEnabled(
+      boolean performanceCoreAffinityEnabled) {
+    this.performanceCoreAffinityEnabled = performanceCoreAffinityEnabled;
   }
 
   @Override
@@ -147,7 +184,17 @@ public class Libgav1VideoRenderer extends DecoderVideoRenderer {
     int initialInputBufferSize =
         format.maxInputSize != Format.NO_VALUE ? format.maxInputSize : DEFAULT_INPUT_BUFFER_SIZE;
     Gav1Decoder decoder =
-        new Gav1Decoder(numInputBuffers, numOutputBuffers, initialInputBufferSize, threads);
+        new Gav1Decoder(
+            numInputBuffers,
+            numOutputBuffers,
+            initialInputBufferSize,
+            threads,
+            maxFramesInFlight,
+            // The decoder is reused when the size changes, so the thread count is sized for the
+            // largest frames. If their size is unknown, all the performance cores are used.
+            format.maxWidth,
+            format.maxHeight,
+            performanceCoreAffinityEnabled);
     this.decoder = decoder;
     TraceUtil.endSection();
     return decoder;
@@ -22,18 +22,23 @@
 #ifdef CPU_FEATURES_ARCH_ARM
 #include "cpuinfo_arm.h"  // NOLINT
 #endif                    // CPU_FEATURES_ARCH_ARM
-#ifdef CPU_FEATURES_COMPILED_ANY_ARM_NEON
-#include <arm_neon.h>
-#endif  // CPU_FEATURES_COMPILED_ANY_ARM_NEON
 #include <jni.h>
 
+#include <algorithm>
+#include <atomic>
 #include <cstdint>
 #include <cstring>
-#include <mutex>  // NOLINT
+#include <memory>
 #include <new>
 
-#include "cpu_info.h"  // NOLINT
+#include "bit_depth_converter.h"  // NOLINT
+#include "cpu_info.h"             // NOLINT
+#include "decoder_stats.h"        // NOLINT
+#include "frame_pool.h"           // NOLINT
 #include "gav1/decoder.h"
+#include "p010_surface.h"       // NOLINT
+#include "plane_copy.h"         // NOLINT
+#include "thread_scheduling.h"  // NOLINT
 
 #define LOG_TAG "gav1_jni"
 #define LOGE(...) \
@@ -47,11 +52,48 @@
   JNIEXPORT RETURN_TYPE Java_androidx_media3_decoder_av1_Gav1Decoder_##NAME( \
       JNIEnv* env, jobject thiz, ##__VA_ARGS__)
 
+namespace {
+
+// JNI references for the VideoDecoderOutputBuffer class, resolved in
+// JNI_OnLoad and shared by all decoders.
+jclass output_buffer_class;
+jfieldID decoder_private_field;
+jfieldID output_mode_field;
+jfieldID data_field;
+jmethodID init_for_private_frame_method;
+jmethodID init_for_yuv_frame_method;
+
+}  // namespace
+
 jint JNI_OnLoad(JavaVM* vm, void* reserved) {
   JNIEnv* env;
   if (vm->GetEnv(reinterpret_cast<void**>(&env), JNI_VERSION_1_6) != JNI_OK) {
     return -1;
   }
+
+  // Populate JNI References once, rather than for each decoder.
+  const jclass local_output_buffer_class =
+      env->FindClass("androidx/media3/decoder/VideoDecoderOutputBuffer");
+  if (local_output_buffer_class == nullptr) {
+    return -1;
+  }
+  output_buffer_class =
+      static_cast<jclass>(env->NewGlobalRef(local_output_buffer_class));
+  env->DeleteLocalRef(local_output_buffer_class);
+  decoder_private_field =
+      env->GetFieldID(output_buffer_class, "decoderPrivate", "I");
+  output_mode_field = env->GetFieldID(output_buffer_class, "mode", "I");
+  data_field =
+      env->GetFieldID(output_buffer_class, "data", "Ljava/nio/ByteBuffer;");
+  init_for_private_frame_method =
+      env->GetMethodID(output_buffer_class, "initForPrivateFrame", "(II)V");
+  init_for_yuv_frame_method =
+      env->GetMethodID(output_buffer_class, "initForYuvFrame", "(IIIII)Z");
+  if (decoder_private_field == nullptr || output_mode_field == nullptr ||
+      data_field == nullptr || init_for_private_frame_method == nullptr ||
+      init_for_yuv_frame_method == nullptr) {
+    return -1;
+  }
   return JNI_VERSION_1_6;
 }
 
@@ -77,6 +119,7 @@ const int kColorSpaceUnknown = 0;
 const int kStatusError = 0;
 const int kStatusOk = 1;
 const int kStatusDecodeOnly = 2;
+const int kStatusTryAgain = 3;
 
 // Status codes specific to the JNI wrapper code.
 enum JniStatusCode {
@@ -100,8 +143,8 @@ const char* GetJniErrorMessage(JniStatusCode error_code) {
     case kJniStatusBitDepth12NotSupportedWithYuv:
       return "Bit depth 12 is not supported with YUV.";
     case kJniStatusHighBitDepthNotSupportedWithSurfaceYuv:
-      return "High bit depth (10 or 12 bits per pixel) output format is not "
-             "supported with YUV surface.";
+      return "High bit depth (10 or 12 bits per pixel) output format is only "
+             "supported with 4:2:0 subsampling with YUV surface.";
     case kJniStatusInvalidNumOfPlanes:
       return "Libgav1 decoded buffer has invalid number of planes.";
     case kJniStatusANativeWindowError:
@@ -118,7 +161,7 @@ const char* GetJniErrorMessage(JniStatusCode error_code) {
 // Manages frame buffer and reference information.
 class JniFrameBuffer {
  public:
-  explicit JniFrameBuffer(int id) : id_(id), reference_count_(0) {}
+  explicit JniFrameBuffer(int id) : id_(id) {}
   ~JniFrameBuffer() {
     for (int plane_index = kPlaneY; plane_index < kMaxPlanes; plane_index++) {
       delete[] raw_buffer_[plane_index];
@@ -141,6 +184,20 @@ class JniFrameBuffer {
       displayed_height_[plane_index] =
           decoder_buffer.displayed_height[plane_index];
     }
+    bitdepth_ = decoder_buffer.bitdepth;
+    bt2020_ = decoder_buffer.color_primary == libgav1::kColorPrimaryBt2020;
+    full_range_ = decoder_buffer.color_range == libgav1::kColorRangeFull;
+    switch (decoder_buffer.transfer_characteristics) {
+      case libgav1::kTransferCharacteristicsSmpte2084:
+        color_transfer_ = decoder_jni::kColorTransferSt2084;
+        break;
+      case libgav1::kTransferCharacteristicsHlg:
+        color_transfer_ = decoder_jni::kColorTransferHlg;
+        break;
+      default:
+        color_transfer_ = decoder_jni::kColorTransferSdr;
+        break;
+    }
   }
 
   int Stride(int plane_index) const { return stride_[plane_index]; }
@@ -151,21 +208,22 @@ class JniFrameBuffer {
   int DisplayedHeight(int plane_index) const {
     return displayed_height_[plane_index];
   }
-
-  // Methods maintaining reference count are not thread-safe. They must be
-  // called with a lock held.
-  void AddReference() { ++reference_count_; }
-  void RemoveReference() { reference_count_--; }
-  bool InUse() const { return reference_count_ != 0; }
+  int Bitdepth() const { return bitdepth_; }
+  // Returns the ADataSpace of the frame if it has a high bit depth.
+  int32_t HighBitDepthDataSpace() const {
+    return decoder_jni::GetHighBitDepthDataSpace(bt2020_, color_transfer_,
+                                                 full_range_);
+  }
 
   uint8_t* RawBuffer(int plane_index) const { return raw_buffer_[plane_index]; }
   void* BufferPrivateData() const { return const_cast<int*>(&id_); }
 
   // Attempts to reallocate data planes if the existing ones don't have enough
-  // capacity. Returns true if the allocation was successful or wasn't needed,
-  // false if the allocation failed.
+  // capacity, counting allocations in |stats|. Returns true if the allocation
+  // was successful or wasn't needed, false if the allocation failed.
   bool MaybeReallocateGav1DataPlanes(int y_plane_min_size,
-                                     int uv_plane_min_size) {
+                                     int uv_plane_min_size,
+                                     decoder_jni::DecoderStats* stats) {
     for (int plane_index = kPlaneY; plane_index < kMaxPlanes; plane_index++) {
       const int min_size =
           (plane_index == kPlaneY) ? y_plane_min_size : uv_plane_min_size;
@@ -177,6 +235,7 @@ class JniFrameBuffer {
         return false;
       }
       raw_buffer_size_[plane_index] = min_size;
+      stats->AddBufferAllocation();
     }
     return true;
   }
@@ -186,8 +245,11 @@ class JniFrameBuffer {
   uint8_t* plane_[kMaxPlanes];
   int displayed_width_[kMaxPlanes];
   int displayed_height_[kMaxPlanes];
+  int bitdepth_ = 8;
+  bool bt2020_ = false;
+  bool full_range_ = false;
+  int color_transfer_ = decoder_jni::kColorTransferSdr;
   const int id_;
-  int reference_count_;
   // Pointers to the raw buffers allocated for the data planes.
   uint8_t* raw_buffer_[kMaxPlanes] = {};
   // Sizes of the raw buffers in bytes.
@@ -195,75 +257,49 @@ class JniFrameBuffer {
 };
 
 // Manages frame buffers used by libgav1 decoder and ExoPlayer.
-// Handles synchronization between libgav1 and ExoPlayer threads.
+// Handles synchronization between libgav1 and ExoPlayer threads. The reference
+// counts are maintained by a lock-free pool, so libgav1 worker threads and the
+// playback thread never block each other.
 class JniBufferManager {
  public:
-  ~JniBufferManager() {
-    // This lock does not do anything since libgav1 has released all the frame
-    // buffers. It exists to merely be consistent with all other usage of
-    // |all_buffers_| and |all_buffer_count_|.
-    std::lock_guard<std::mutex> lock(mutex_);
-    while (all_buffer_count_--) {
-      delete all_buffers_[all_buffer_count_];
-    }
-  }
+  // Counts frame buffer allocations in |stats|.
+  explicit JniBufferManager(decoder_jni::DecoderStats* stats) : stats_(stats) {}
 
   JniStatusCode GetBuffer(size_t y_plane_min_size, size_t uv_plane_min_size,
                           JniFrameBuffer** jni_buffer) {
-    std::lock_guard<std::mutex> lock(mutex_);
-
-    JniFrameBuffer* output_buffer;
-    if (free_buffer_count_) {
-      output_buffer = free_buffers_[--free_buffer_count_];
-    } else if (all_buffer_count_ < kMaxFrames) {
-      output_buffer = new (std::nothrow) JniFrameBuffer(all_buffer_count_);
-      if (output_buffer == nullptr) return kJniStatusOutOfMemory;
-      all_buffers_[all_buffer_count_++] = output_buffer;
-    } else {
-      // Maximum number of buffers is being used.
-      return kJniStatusOutOfMemory;
-    }
-    if (!output_buffer->MaybeReallocateGav1DataPlanes(y_plane_min_size,
-                                                      uv_plane_min_size)) {
+    int id;
+    JniFrameBuffer* const output_buffer = pool_.Acquire(&id);
+    if (output_buffer == nullptr) return kJniStatusOutOfMemory;
+    if (!output_buffer->MaybeReallocateGav1DataPlanes(
+            y_plane_min_size, uv_plane_min_size, stats_)) {
+      pool_.Release(id);
       return kJniStatusOutOfMemory;
     }
 
-    output_buffer->AddReference();
     *jni_buffer = output_buffer;
 
     return kJniStatusOk;
   }
 
-  JniFrameBuffer* GetBuffer(int id) const { return all_buffers_[id]; }
+  JniFrameBuffer* GetBuffer(int id) const { return pool_.Get(id); }
 
-  void AddBufferReference(int id) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    all_buffers_[id]->AddReference();
-  }
+  void AddBufferReference(int id) { pool_.AddReference(id); }
 
   JniStatusCode ReleaseBuffer(int id) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    JniFrameBuffer* buffer = all_buffers_[id];
-    if (!buffer->InUse()) {
+    if (!pool_.Release(id)) {
       return kJniStatusBufferAlreadyReleased;
     }
-    buffer->RemoveReference();
-    if (!buffer->InUse()) {
-      free_buffers_[free_buffer_count_++] = buffer;
-    }
     return kJniStatusOk;
   }
 
- private:
-  static const int kMaxFrames = 32;
-
-  JniFrameBuffer* all_buffers_[kMaxFrames];
-  int all_buffer_count_ = 0;
-
-  JniFrameBuffer* free_buffers_[kMaxFrames];
-  int free_buffer_count_ = 0;
+  // Writes the values of the decoder stats, including the buffer counts.
+  void GetStatsValues(int64_t* values) const {
+    stats_->GetValues(pool_, values);
+  }
 
-  std::mutex mutex_;
+ private:
+  decoder_jni::DecoderStats* const stats_;
+  decoder_jni::FramePool<JniFrameBuffer> pool_;
 };
 
 struct JniContext {
@@ -282,6 +318,8 @@ struct JniContext {
     }
     native_window_width = 0;
     native_window_height = 0;
+    native_window_format = 0;
+    native_window_data_space = 0;
     native_window = ANativeWindow_fromSurface(env, new_surface);
     if (native_window == nullptr) {
       jni_status_code = kJniStatusANativeWindowError;
@@ -292,13 +330,8 @@ struct JniContext {
     return true;
   }
 
-  jfieldID decoder_private_field;
-  jfieldID output_mode_field;
-  jfieldID data_field;
-  jmethodID init_for_private_frame_method;
-  jmethodID init_for_yuv_frame_method;
-
-  JniBufferManager buffer_manager;
+  decoder_jni::DecoderStats stats;
+  JniBufferManager buffer_manager{&stats};
   // The libgav1 decoder instance has to be deleted before |buffer_manager| is
   // destructed. This will make sure that libgav1 releases all the frame
   // buffers that it might be holding references to. So this has to be declared
@@ -310,9 +343,33 @@ struct JniContext {
   jobject surface = nullptr;
   int native_window_width = 0;
   int native_window_height = 0;
+  int native_window_format = 0;
+  int32_t native_window_data_space = 0;
+  // The layout of P010 window buffers, for rendering high bit depth frames.
+  decoder_jni::P010LayoutCache p010_layouts;
+  const decoder_jni::PlaneCopier plane_copier;
+  // Created for the first 10-bit frame converted to 8 bits.
+  std::unique_ptr<decoder_jni::BitDepthConverter> bit_depth_converter;
+
+  // Whether libgav1 decodes several frames in parallel, in which case it
+  // keeps reading input buffers after gav1Decode returns.
+  bool frame_parallel = false;
+
+  // The topology the decoder threads are restricted to the performance cores
+  // of, if |performance_core_affinity| is true.
+  decoder_jni::CpuTopology cpu_topology;
+  bool performance_core_affinity = false;
+  // Whether the thread calling gav1Decode has been restricted to the
+  // performance cores.
+  bool decode_thread_pinned = false;
+
+  // The time spent enqueuing frames since the last dequeued frame, which is
+  // counted as part of its decode time.
+  int64_t enqueue_time_ns = 0;
 
   Libgav1StatusCode libgav1_status_code = kLibgav1StatusOk;
-  JniStatusCode jni_status_code = kJniStatusOk;
+  // Atomic as the frame buffer callbacks may run on libgav1 worker threads.
+  std::atomic<JniStatusCode> jni_status_code{kJniStatusOk};
 };
 
 Libgav1StatusCode Libgav1GetFrameBuffer(void* callback_private_data,
@@ -330,10 +387,11 @@ Libgav1StatusCode Libgav1GetFrameBuffer(void* callback_private_data,
 
   JniContext* const context = static_cast<JniContext*>(callback_private_data);
   JniFrameBuffer* jni_buffer;
-  context->jni_status_code = context->buffer_manager.GetBuffer(
+  const JniStatusCode jni_status = context->buffer_manager.GetBuffer(
       info.y_buffer_size, info.uv_buffer_size, &jni_buffer);
-  if (context->jni_status_code != kJniStatusOk) {
-    LOGE("%s", GetJniErrorMessage(context->jni_status_code));
+  if (jni_status != kJniStatusOk) {
+    context->jni_status_code = jni_status;
+    LOGE("%s", GetJniErrorMessage(jni_status));
     return kLibgav1StatusOutOfMemory;
   }
 
@@ -351,21 +409,57 @@ void Libgav1ReleaseFrameBuffer(void* callback_private_data,
                                void* buffer_private_data) {
   JniContext* const context = static_cast<JniContext*>(callback_private_data);
   const int buffer_id = *static_cast<const int*>(buffer_private_data);
-  context->jni_status_code = context->buffer_manager.ReleaseBuffer(buffer_id);
-  if (context->jni_status_code != kJniStatusOk) {
-    LOGE("%s", GetJniErrorMessage(context->jni_status_code));
+  const JniStatusCode jni_status =
+      context->buffer_manager.ReleaseBuffer(buffer_id);
+  if (jni_status != kJniStatusOk) {
+    context->jni_status_code = jni_status;
+    LOGE("%s", GetJniErrorMessage(jni_status));
   }
 }
 
+void Libgav1ReleaseInputBuffer(void* /* callback_private_data */,
+                               void* buffer_private_data) {
+  // The copy of the input made by gav1Decode in frame parallel mode, if any.
+  delete[] static_cast<uint8_t*>(buffer_private_data);
+}
+
 constexpr int AlignTo16(int value) { return (value + 15) & (~15); }
 
-void CopyPlane(const uint8_t* source, int source_stride, uint8_t* destination,
-               int destination_stride, int width, int height) {
-  while (height--) {
-    std::memcpy(destination, source, width);
-    source += source_stride;
-    destination += destination_stride;
+// Returns the bit depth converter of |context|, creating it if needed, or
+// nullptr if it can't be allocated.
+decoder_jni::BitDepthConverter* GetBitDepthConverter(JniContext* context) {
+  if (context->bit_depth_converter == nullptr) {
+    context->bit_depth_converter.reset(
+        new (std::nothrow) decoder_jni::BitDepthConverter());
+    if (context->bit_depth_converter == nullptr) {
+      return nullptr;
+    }
+    context->stats.SetConversionThreadCount(
+        context->bit_depth_converter->num_threads());
+  }
+  return context->bit_depth_converter.get();
+}
+
+// Sets the geometry of the native window of |context| if needed, and locks its
+// next buffer. Returns false on failure.
+bool LockNativeWindow(JniContext* context, int width, int height, int format,
+                      ANativeWindow_Buffer* buffer) {
+  if (context->native_window_width != width ||
+      context->native_window_height != height ||
+      context->native_window_format != format) {
+    if (ANativeWindow_setBuffersGeometry(context->native_window, width, height,
+                                         format)) {
+      // Set the geometry again for the next frame.
+      context->native_window_width = 0;
+      return false;
+    }
+    context->native_window_width = width;
+    context->native_window_height = height;
+    context->native_window_format = format;
   }
+  return ANativeWindow_lock(context->native_window, buffer,
+                            /*inOutDirtyBounds=*/nullptr) == 0 &&
+         buffer->bits != nullptr;
 }
 
 void CopyFrameToDataBuffer(const libgav1::DecoderBuffer* decoder_buffer,
@@ -380,128 +474,29 @@ void CopyFrameToDataBuffer(const libgav1::DecoderBuffer* decoder_buffer,
 }
 
 void Convert10BitFrameTo8BitDataBuffer(
-    const libgav1::DecoderBuffer* decoder_buffer, jbyte* data) {
-  for (int plane_index = kPlaneY; plane_index < decoder_buffer->NumPlanes();
-       plane_index++) {
-    int sample = 0;
-    const uint8_t* source = decoder_buffer->plane[plane_index];
-    for (int i = 0; i < decoder_buffer->displayed_height[plane_index]; i++) {
-      const uint16_t* source_16 = reinterpret_cast<const uint16_t*>(source);
-      for (int j = 0; j < decoder_buffer->displayed_width[plane_index]; j++) {
-        // Lightweight dither. Carryover the remainder of each 10->8 bit
-        // conversion to the next pixel.
-        sample += source_16[j];
-        data[j] = sample >> 2;
-        sample &= 3;  // Remainder.
-      }
-      source += decoder_buffer->stride[plane_index];
-      data += decoder_buffer->stride[plane_index];
-    }
-  }
+    const libgav1::DecoderBuffer* decoder_buffer, jbyte* data,
+    decoder_jni::BitDepthConverter* bit_depth_converter) {
+  decoder_jni::BitDepthConverter::Plane planes[kMaxPlanes];
+  const int num_planes = std::min(decoder_buffer->NumPlanes(), kMaxPlanes);
+  uint8_t* destination = reinterpret_cast<uint8_t*>(data);
+  for (int plane_index = kPlaneY; plane_index < num_planes; plane_index++) {
+    decoder_jni::BitDepthConverter::Plane& plane = planes[plane_index];
+    plane.source = decoder_buffer->plane[plane_index];
+    plane.source_stride = decoder_buffer->stride[plane_index];
+    plane.destination = destination;
+    plane.destination_stride = decoder_buffer->stride[plane_index];
+    plane.width = decoder_buffer->displayed_width[plane_index];
+    plane.height = decoder_buffer->displayed_height[plane_index];
+    destination += static_cast<uint64_t>(plane.destination_stride) *
+                   plane.height;
+  }
+  bit_depth_converter->Convert10BitTo8Bit(planes, num_planes);
 }
 
-#ifdef CPU_FEATURES_COMPILED_ANY_ARM_NEON
-void Convert10BitFrameTo8BitDataBufferNeon(
-    const libgav1::DecoderBuffer* decoder_buffer, jbyte* data) {
-  uint32x2_t lcg_value = vdup_n_u32(random());
-  lcg_value = vset_lane_u32(random(), lcg_value, 1);
-  // LCG values recommended in "Numerical Recipes".
-  const uint32x2_t LCG_MULT = vdup_n_u32(1664525);
-  const uint32x2_t LCG_INCR = vdup_n_u32(1013904223);
-
-  for (int plane_index = kPlaneY; plane_index < kMaxPlanes; plane_index++) {
-    const uint8_t* source = decoder_buffer->plane[plane_index];
-
-    for (int i = 0; i < decoder_buffer->displayed_height[plane_index]; i++) {
-      const uint16_t* source_16 = reinterpret_cast<const uint16_t*>(source);
-      uint8_t* destination = reinterpret_cast<uint8_t*>(data);
-
-      // Each read consumes 4 2-byte samples, but to reduce branches and
-      // random steps we unroll to 4 rounds, so each loop consumes 16
-      // samples.
-      const int j_max = decoder_buffer->displayed_width[plane_index] & ~15;
-      int j;
-      for (j = 0; j < j_max; j += 16) {
-        // Run a round of the RNG.
-        lcg_value = vmla_u32(LCG_INCR, lcg_value, LCG_MULT);
-
-        // Round 1.
-        // The lower two bits of this LCG parameterization are garbage,
-        // leaving streaks on the image. We access the upper bits of each
-        // 16-bit lane by shifting. (We use this both as an 8- and 16-bit
-        // vector, so the choice of which one to keep it as is arbitrary.)
-        uint8x8_t randvec =
-            vreinterpret_u8_u16(vshr_n_u16(vreinterpret_u16_u32(lcg_value), 8));
-
-        // We retrieve the values and shift them so that the bits we'll
-        // shift out (after biasing) are in the upper 8 bits of each 16-bit
-        // lane.
-        uint16x4_t values = vshl_n_u16(vld1_u16(source_16), 6);
-        // We add the bias bits in the lower 8 to the shifted values to get
-        // the final values in the upper 8 bits.
-        uint16x4_t added_1 = vqadd_u16(values, vreinterpret_u16_u8(randvec));
-        source_16 += 4;
-
-        // Round 2.
-        // Shifting the randvec bits left by 2 bits, as an 8-bit vector,
-        // should leave us with enough bias to get the needed rounding
-        // operation.
-        randvec = vshl_n_u8(randvec, 2);
-
-        // Retrieve and sum the next 4 pixels.
-        values = vshl_n_u16(vld1_u16(source_16), 6);
-        uint16x4_t added_2 = vqadd_u16(values, vreinterpret_u16_u8(randvec));
-        source_16 += 4;
-
-        // Reinterpret the two added vectors as 8x8, zip them together, and
-        // discard the lower portions.
-        uint8x8_t zipped =
-            vuzp_u8(vreinterpret_u8_u16(added_1), vreinterpret_u8_u16(added_2))
-                .val[1];
-        vst1_u8(destination, zipped);
-        destination += 8;
-
-        // Run it again with the next two rounds using the remaining
-        // entropy in randvec.
-
-        // Round 3.
-        randvec = vshl_n_u8(randvec, 2);
-        values = vshl_n_u16(vld1_u16(source_16), 6);
-        added_1 = vqadd_u16(values, vreinterpret_u16_u8(randvec));
-        source_16 += 4;
-
-        // Round 4.
-        randvec = vshl_n_u8(randvec, 2);
-        values = vshl_n_u16(vld1_u16(source_16), 6);
-        added_2 = vqadd_u16(values, vreinterpret_u16_u8(randvec));
-        source_16 += 4;
-
-        zipped =
-            vuzp_u8(vreinterpret_u8_u16(added_1), vreinterpret_u8_u16(added_2))
-                .val[1];
-        vst1_u8(destination, zipped);
-        destination += 8;
-      }
-
-      uint32_t randval = 0;
-      // For the remaining pixels in each row - usually none, as most
-      // standard sizes are divisible by 32 - convert them "by hand".
-      for (; j < decoder_buffer->displayed_width[plane_index]; j++) {
-        if (!randval) randval = random();
-        destination[j] = (source_16[j] + (randval & 3)) >> 2;
-        randval >>= 2;
-      }
-
-      source += decoder_buffer->stride[plane_index];
-      data += decoder_buffer->stride[plane_index];
-    }
-  }
-}
-#endif  // CPU_FEATURES_COMPILED_ANY_ARM_NEON
-
 }  // namespace
 
-DECODER_FUNC(jlong, gav1Init, jint threads) {
+DECODER_FUNC(jlong, gav1Init, jint threads, jint maxFramesInFlight,
+             jboolean performanceCoreAffinity) {
   JniContext* context = new (std::nothrow) JniContext();
   if (context == nullptr) {
     return kStatusError;
@@ -524,28 +519,31 @@ DECODER_FUNC(jlong, gav1Init, jint threads) {
 
   libgav1::DecoderSettings settings;
   settings.threads = threads;
+  context->stats.SetDecoderThreadCount(threads);
+  // Java keeps up to |maxFramesInFlight| frames enqueued before dequeuing the
+  // oldest one, which blocks until it's decoded.
+  context->frame_parallel = maxFramesInFlight > 1;
+  settings.frame_parallel = context->frame_parallel;
+  settings.blocking_dequeue = true;
   settings.get_frame_buffer = Libgav1GetFrameBuffer;
   settings.release_frame_buffer = Libgav1ReleaseFrameBuffer;
+  settings.release_input_buffer = Libgav1ReleaseInputBuffer;
   settings.callback_private_data = context;
 
-  context->libgav1_status_code = context->decoder.Init(&settings);
+  context->performance_core_affinity =
+      performanceCoreAffinity &&
+      decoder_jni::GetCpuTopology(&context->cpu_topology);
+  {
+    // Libgav1 creates its worker threads in Init(), which inherit the
+    // affinity of the calling thread.
+    const decoder_jni::ScopedPerformanceCoreAffinity affinity(
+        context->cpu_topology, context->performance_core_affinity);
+    context->libgav1_status_code = context->decoder.Init(&settings);
+  }
   if (context->libgav1_status_code != kLibgav1StatusOk) {
     return reinterpret_cast<jlong>(context);
   }
 
-  // Populate JNI References.
-  const jclass outputBufferClass =
-      env->FindClass("androidx/media3/decoder/VideoDecoderOutputBuffer");
-  context->decoder_private_field =
-      env->GetFieldID(outputBufferClass, "decoderPrivate", "I");
-  context->output_mode_field = env->GetFieldID(outputBufferClass, "mode", "I");
-  context->data_field =
-      env->GetFieldID(outputBufferClass, "data", "Ljava/nio/ByteBuffer;");
-  context->init_for_private_frame_method =
-      env->GetMethodID(outputBufferClass, "initForPrivateFrame", "(II)V");
-  context->init_for_yuv_frame_method =
-      env->GetMethodID(outputBufferClass, "initForYuvFrame", "(IIIII)Z");
-
   return reinterpret_cast<jlong>(context);
 }
 
@@ -557,11 +555,55 @@ DECODER_FUNC(void, gav1Close, jlong jContext) {
 DECODER_FUNC(jint, gav1Decode, jlong jContext, jobject encodedData,
              jint length) {
   JniContext* const context = reinterpret_cast<JniContext*>(jContext);
-  const uint8_t* const buffer = reinterpret_cast<const uint8_t*>(
+  if (context->performance_core_affinity && !context->decode_thread_pinned) {
+    // The decode thread is owned by the Java decoder, and also decodes tiles
+    // in non frame parallel mode, so its affinity isn't restored.
+    decoder_jni::SetPerformanceCoreAffinity(context->cpu_topology);
+    context->decode_thread_pinned = true;
+  }
+  const uint8_t* buffer = reinterpret_cast<const uint8_t*>(
       env->GetDirectBufferAddress(encodedData));
-  context->libgav1_status_code =
-      context->decoder.EnqueueFrame(buffer, length, /*user_private_data=*/0,
-                                    /*buffer_private_data=*/nullptr);
+  uint8_t* input_copy = nullptr;
+  if (context->frame_parallel) {
+    // Libgav1 reads the input until the frame is decoded, but Java reuses the
+    // input buffer once this call returns. The copy is deleted by
+    // Libgav1ReleaseInputBuffer.
+    input_copy = new (std::nothrow) uint8_t[length];
+    if (input_copy == nullptr) {
+      context->jni_status_code = kJniStatusOutOfMemory;
+      return kStatusError;
+    }
+    memcpy(input_copy, buffer, length);
+    buffer = input_copy;
+  }
+  const int64_t enqueue_start_time_ns = decoder_jni::GetMonotonicTimeNs();
+  Libgav1StatusCode status;
+  {
+    const decoder_jni::ScopedTrace trace("gav1EnqueueFrame");
+    status =
+        context->decoder.EnqueueFrame(buffer, length, /*user_private_data=*/0,
+                                      /*buffer_private_data=*/input_copy);
+  }
+  context->enqueue_time_ns +=
+      decoder_jni::GetMonotonicTimeNs() - enqueue_start_time_ns;
+  if (status != kLibgav1StatusOk) {
+    // Libgav1 only takes ownership of the input if it was enqueued.
+    delete[] input_copy;
+    if (status == kLibgav1StatusTryAgain) {
+      // All frame threads are busy. Java has to dequeue a frame first.
+      return kStatusTryAgain;
+    }
+    context->libgav1_status_code = status;
+    return kStatusError;
+  }
+  return kStatusOk;
+}
+
+DECODER_FUNC(jint, gav1Flush, jlong jContext) {
+  JniContext* const context = reinterpret_cast<JniContext*>(jContext);
+  // Drops the frames in flight and resets the decoder state. Frames already
+  // output to Java keep their references.
+  context->libgav1_status_code = context->decoder.SignalEOS();
   if (context->libgav1_status_code != kLibgav1StatusOk) {
     return kStatusError;
   }
@@ -572,10 +614,21 @@ DECODER_FUNC(jint, gav1GetFrame, jlong jContext, jobject jOutputBuffer,
              jboolean decodeOnly) {
   JniContext* const context = reinterpret_cast<JniContext*>(jContext);
   const libgav1::DecoderBuffer* decoder_buffer;
-  context->libgav1_status_code = context->decoder.DequeueFrame(&decoder_buffer);
+  const int64_t dequeue_start_time_ns = decoder_jni::GetMonotonicTimeNs();
+  {
+    // Blocks until the frame is decoded.
+    const decoder_jni::ScopedTrace trace("gav1DequeueFrame");
+    context->libgav1_status_code =
+        context->decoder.DequeueFrame(&decoder_buffer);
+  }
   if (context->libgav1_status_code != kLibgav1StatusOk) {
     return kStatusError;
   }
+  context->stats.AddDuration(decoder_jni::DecoderStats::kStageDecode,
+                             context->enqueue_time_ns +
+                                 decoder_jni::GetMonotonicTimeNs() -
+                                 dequeue_start_time_ns);
+  context->enqueue_time_ns = 0;
 
   if (decodeOnly || decoder_buffer == nullptr) {
     // This is not an error. The input data was decode-only or no displayable
@@ -583,13 +636,12 @@ DECODER_FUNC(jint, gav1GetFrame, jlong jContext, jobject jOutputBuffer,
     return kStatusDecodeOnly;
   }
 
-  const int output_mode =
-      env->GetIntField(jOutputBuffer, context->output_mode_field);
+  const int output_mode = env->GetIntField(jOutputBuffer, output_mode_field);
   if (output_mode == kOutputModeYuv) {
     // Resize the buffer if required. Default color conversion will be used as
     // libgav1::DecoderBuffer doesn't expose color space info.
     const jboolean init_result = env->CallBooleanMethod(
-        jOutputBuffer, context->init_for_yuv_frame_method,
+        jOutputBuffer, init_for_yuv_frame_method,
         decoder_buffer->displayed_width[kPlaneY],
         decoder_buffer->displayed_height[kPlaneY],
         decoder_buffer->stride[kPlaneY], decoder_buffer->stride[kPlaneU],
@@ -603,28 +655,37 @@ DECODER_FUNC(jint, gav1GetFrame, jlong jContext, jobject jOutputBuffer,
       return kStatusError;
     }
 
-    const jobject data_object =
-        env->GetObjectField(jOutputBuffer, context->data_field);
+    const jobject data_object = env->GetObjectField(jOutputBuffer, data_field);
     jbyte* const data =
         reinterpret_cast<jbyte*>(env->GetDirectBufferAddress(data_object));
 
+    const decoder_jni::ScopedStageTimer timer(
+        &context->stats, decoder_jni::DecoderStats::kStageConvert,
+        "gav1CopyFrame");
     switch (decoder_buffer->bitdepth) {
       case 8:
         CopyFrameToDataBuffer(decoder_buffer, data);
         break;
-      case 10:
-#ifdef CPU_FEATURES_COMPILED_ANY_ARM_NEON
-        Convert10BitFrameTo8BitDataBufferNeon(decoder_buffer, data);
-#else
-        Convert10BitFrameTo8BitDataBuffer(decoder_buffer, data);
-#endif  // CPU_FEATURES_COMPILED_ANY_ARM_NEON
+      case 10: {
+        decoder_jni::BitDepthConverter* const bit_depth_converter =
+            GetBitDepthConverter(context);
+        if (bit_depth_converter == nullptr) {
+          context->jni_status_code = kJniStatusOutOfMemory;
+          return kStatusError;
+        }
+        Convert10BitFrameTo8BitDataBuffer(decoder_buffer, data,
+                                          bit_depth_converter);
         break;
+      }
       default:
         context->jni_status_code = kJniStatusBitDepth12NotSupportedWithYuv;
         return kStatusError;
     }
   } else if (output_mode == kOutputModeSurfaceYuv) {
-    if (decoder_buffer->bitdepth != 8) {
+    // High bit depth 4:2:0 frames are rendered as P010, or converted to 8 bits
+    // (see gav1RenderFrame).
+    if (decoder_buffer->bitdepth != 8 &&
+        decoder_buffer->image_format != libgav1::kImageFormatYuv420) {
       context->jni_status_code =
           kJniStatusHighBitDepthNotSupportedWithSurfaceYuv;
       return kStatusError;
@@ -641,14 +702,14 @@ DECODER_FUNC(jint, gav1GetFrame, jlong jContext, jobject jOutputBuffer,
     JniFrameBuffer* const jni_buffer =
         context->buffer_manager.GetBuffer(buffer_id);
     jni_buffer->SetFrameData(*decoder_buffer);
-    env->CallVoidMethod(jOutputBuffer, context->init_for_private_frame_method,
+    env->CallVoidMethod(jOutputBuffer, init_for_private_frame_method,
                         decoder_buffer->displayed_width[kPlaneY],
                         decoder_buffer->displayed_height[kPlaneY]);
     if (env->ExceptionCheck()) {
       // Exception is thrown in Java when returning from the native call.
       return kStatusError;
     }
-    env->SetIntField(jOutputBuffer, context->decoder_private_field, buffer_id);
+    env->SetIntField(jOutputBuffer, decoder_private_field, buffer_id);
   }
 
   return kStatusOk;
@@ -657,8 +718,10 @@ DECODER_FUNC(jint, gav1GetFrame, jlong jContext, jobject jOutputBuffer,
 DECODER_FUNC(jint, gav1RenderFrame, jlong jContext, jobject jSurface,
              jobject jOutputBuffer) {
   JniContext* const context = reinterpret_cast<JniContext*>(jContext);
-  const int buffer_id =
-      env->GetIntField(jOutputBuffer, context->decoder_private_field);
+  const decoder_jni::ScopedStageTimer timer(
+      &context->stats, decoder_jni::DecoderStats::kStageRender,
+      "gav1RenderFrame");
+  const int buffer_id = env->GetIntField(jOutputBuffer, decoder_private_field);
   JniFrameBuffer* const jni_buffer =
       context->buffer_manager.GetBuffer(buffer_id);
 
@@ -666,31 +729,83 @@ DECODER_FUNC(jint, gav1RenderFrame, jlong jContext, jobject jSurface,
     return kStatusError;
   }
 
-  if (context->native_window_width != jni_buffer->DisplayedWidth(kPlaneY) ||
-      context->native_window_height != jni_buffer->DisplayedHeight(kPlaneY)) {
-    if (ANativeWindow_setBuffersGeometry(
-            context->native_window, jni_buffer->DisplayedWidth(kPlaneY),
-            jni_buffer->DisplayedHeight(kPlaneY), kImageFormatYV12)) {
-      context->jni_status_code = kJniStatusANativeWindowError;
+  const int width = jni_buffer->DisplayedWidth(kPlaneY);
+  const int height = jni_buffer->DisplayedHeight(kPlaneY);
+  const bool high_bit_depth = jni_buffer->Bitdepth() > 8;
+  // High bit depth frames are rendered as P010 if the layout of P010 buffers is
+  // known, and converted to 8 bits otherwise.
+  const decoder_jni::P010Layout* p010_layout =
+      high_bit_depth ? context->p010_layouts.Get(width, height) : nullptr;
+  ANativeWindow_Buffer native_window_buffer;
+  if (p010_layout != nullptr &&
+      !LockNativeWindow(context, width, height,
+                        decoder_jni::kImageFormatYCbCrP010,
+                        &native_window_buffer)) {
+    LOGE("Failed to render P010 buffers. Converting to 8 bits instead.");
+    context->p010_layouts.Disable();
+    p010_layout = nullptr;
+  }
+  decoder_jni::BitDepthConverter* bit_depth_converter = nullptr;
+  if (high_bit_depth && p010_layout == nullptr) {
+    if (jni_buffer->Bitdepth() != 10) {
+      context->jni_status_code = kJniStatusBitDepth12NotSupportedWithYuv;
+      return kStatusError;
+    }
+    bit_depth_converter = GetBitDepthConverter(context);
+    if (bit_depth_converter == nullptr) {
+      context->jni_status_code = kJniStatusOutOfMemory;
       return kStatusError;
     }
-    context->native_window_width = jni_buffer->DisplayedWidth(kPlaneY);
-    context->native_window_height = jni_buffer->DisplayedHeight(kPlaneY);
   }
-
-  ANativeWindow_Buffer native_window_buffer;
-  if (ANativeWindow_lock(context->native_window, &native_window_buffer,
-                         /*inOutDirtyBounds=*/nullptr) ||
-      native_window_buffer.bits == nullptr) {
+  if (p010_layout == nullptr &&
+      !LockNativeWindow(context, width, height, kImageFormatYV12,
+                        &native_window_buffer)) {
     context->jni_status_code = kJniStatusANativeWindowError;
     return kStatusError;
   }
 
+  if (high_bit_depth) {
+    // The data space is best effort: it can't be set before API level 28.
+    // Converted frames are output with the default data space.
+    const int32_t data_space =
+        p010_layout != nullptr ? jni_buffer->HighBitDepthDataSpace() : 0;
+    if (data_space != context->native_window_data_space &&
+        decoder_jni::SetNativeWindowDataSpace(context->native_window,
+                                              data_space)) {
+      context->native_window_data_space = data_space;
+    }
+    const uint8_t* const planes[kMaxPlanes] = {jni_buffer->Plane(kPlaneY),
+                                               jni_buffer->Plane(kPlaneU),
+                                               jni_buffer->Plane(kPlaneV)};
+    const int strides[kMaxPlanes] = {jni_buffer->Stride(kPlaneY),
+                                     jni_buffer->Stride(kPlaneU),
+                                     jni_buffer->Stride(kPlaneV)};
+    if (p010_layout == nullptr) {
+      decoder_jni::ConvertFrameToYv12Buffer(bit_depth_converter, planes,
+                                            strides, width, height,
+                                            native_window_buffer);
+    } else if (!decoder_jni::CopyFrameToP010Buffer(
+                   context->plane_copier, planes, strides, width, height,
+                   jni_buffer->Bitdepth(), *p010_layout,
+                   native_window_buffer)) {
+      // The UV plane can't be located, so later frames are converted.
+      LOGE("Unexpected P010 buffer stride %d. Converting to 8 bits instead.",
+           native_window_buffer.stride);
+      context->p010_layouts.Disable();
+    }
+    if (ANativeWindow_unlockAndPost(context->native_window)) {
+      context->jni_status_code = kJniStatusANativeWindowError;
+      return kStatusError;
+    }
+    return kStatusOk;
+  }
+
   // Y plane
-  CopyPlane(jni_buffer->Plane(kPlaneY), jni_buffer->Stride(kPlaneY),
-            reinterpret_cast<uint8_t*>(native_window_buffer.bits),
-            native_window_buffer.stride, jni_buffer->DisplayedWidth(kPlaneY),
-            jni_buffer->DisplayedHeight(kPlaneY));
+  context->plane_copier.CopyPlane(
+      jni_buffer->Plane(kPlaneY), jni_buffer->Stride(kPlaneY),
+      reinterpret_cast<uint8_t*>(native_window_buffer.bits),
+      native_window_buffer.stride, jni_buffer->DisplayedWidth(kPlaneY),
+      jni_buffer->DisplayedHeight(kPlaneY));
 
   const int y_plane_size =
       native_window_buffer.stride * native_window_buffer.height;
@@ -701,26 +816,20 @@ DECODER_FUNC(jint, gav1RenderFrame, jlong jContext, jobject jSurface,
 
   // TODO(b/140606738): Handle monochrome videos.
 
-  // V plane
-  // Since the format for ANativeWindow is YV12, V plane is being processed
-  // before U plane.
-  const int v_plane_height = std::min(native_window_buffer_uv_height,
-                                      jni_buffer->DisplayedHeight(kPlaneV));
-  CopyPlane(
+  // V and U planes
+  // Since the format for ANativeWindow is YV12, the V plane comes before the U
+  // plane. Both planes are copied in a single pass.
+  const int uv_plane_height = std::min(native_window_buffer_uv_height,
+                                       jni_buffer->DisplayedHeight(kPlaneV));
+  const int v_plane_size = uv_plane_height * native_window_buffer_uv_stride;
+  uint8_t* const v_plane =
+      reinterpret_cast<uint8_t*>(native_window_buffer.bits) + y_plane_size;
+  context->plane_copier.CopyChromaPlanes(
+      jni_buffer->Plane(kPlaneU), jni_buffer->Stride(kPlaneU),
       jni_buffer->Plane(kPlaneV), jni_buffer->Stride(kPlaneV),
-      reinterpret_cast<uint8_t*>(native_window_buffer.bits) + y_plane_size,
-      native_window_buffer_uv_stride, jni_buffer->DisplayedWidth(kPlaneV),
-      v_plane_height);
-
-  const int v_plane_size = v_plane_height * native_window_buffer_uv_stride;
-
-  // U plane
-  CopyPlane(jni_buffer->Plane(kPlaneU), jni_buffer->Stride(kPlaneU),
-            reinterpret_cast<uint8_t*>(native_window_buffer.bits) +
-                y_plane_size + v_plane_size,
-            native_window_buffer_uv_stride, jni_buffer->DisplayedWidth(kPlaneU),
-            std::min(native_window_buffer_uv_height,
-                     jni_buffer->DisplayedHeight(kPlaneU)));
+      /*destination_u=*/v_plane + v_plane_size, /*destination_v=*/v_plane,
+      native_window_buffer_uv_stride, jni_buffer->DisplayedWidth(kPlaneU),
+      uv_plane_height);
 
   if (ANativeWindow_unlockAndPost(context->native_window)) {
     context->jni_status_code = kJniStatusANativeWindowError;
@@ -732,9 +841,8 @@ DECODER_FUNC(jint, gav1RenderFrame, jlong jContext, jobject jSurface,
 
 DECODER_FUNC(void, gav1ReleaseFrame, jlong jContext, jobject jOutputBuffer) {
   JniContext* const context = reinterpret_cast<JniContext*>(jContext);
-  const int buffer_id =
-      env->GetIntField(jOutputBuffer, context->decoder_private_field);
-  env->SetIntField(jOutputBuffer, context->decoder_private_field, -1);
+  const int buffer_id = env->GetIntField(jOutputBuffer, decoder_private_field);
+  env->SetIntField(jOutputBuffer, decoder_private_field, -1);
   context->jni_status_code = context->buffer_manager.ReleaseBuffer(buffer_id);
   if (context->jni_status_code != kJniStatusOk) {
     LOGE("%s", GetJniErrorMessage(context->jni_status_code));
@@ -767,8 +875,23 @@ DECODER_FUNC(jint, gav1CheckError, jlong jContext) {
   return kStatusOk;
 }
 
-DECODER_FUNC(jint, gav1GetThreads) {
-  return gav1_jni::GetNumberOfPerformanceCoresOnline();
+DECODER_FUNC(void, gav1GetStats, jlong jContext, jlongArray jValues) {
+  JniContext* const context = reinterpret_cast<JniContext*>(jContext);
+  if (env->GetArrayLength(jValues) < decoder_jni::DecoderStats::kNumValues) {
+    return;
+  }
+  int64_t values[decoder_jni::DecoderStats::kNumValues];
+  context->buffer_manager.GetStatsValues(values);
+  env->SetLongArrayRegion(jValues, 0, decoder_jni::DecoderStats::kNumValues,
+                          reinterpret_cast<const jlong*>(values));
+}
+
+DECODER_FUNC(jint, gav1GetThreads, jint width, jint height) {
+  decoder_jni::CpuTopology topology;
+  if (!decoder_jni::GetCpuTopology(&topology)) {
+    return 0;
+  }
+  return decoder_jni::GetDecoderThreadCount(topology, width, height);
 }
 
 // TODO(b/139902005): Add functions for getting libgav1 version and build
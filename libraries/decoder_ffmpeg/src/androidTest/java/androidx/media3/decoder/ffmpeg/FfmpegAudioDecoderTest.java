@@ -0,0 +1,116 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package androidx.media3.decoder.ffmpeg;
+
+import static com.google.common.truth.Truth.assertThat;
+import static org.junit.Assert.fail;
+import static org.junit.Assume.assumeTrue;
+
+import android.content.Context;
+import androidx.media3.common.Format;
+import androidx.media3.common.MimeTypes;
+import androidx.media3.extractor.ogg.OggExtractor;
+import androidx.media3.test.utils.FakeExtractorOutput;
+import androidx.media3.test.utils.FakeTrackOutput;
+import androidx.media3.test.utils.TestUtil;
+import androidx.test.core.app.ApplicationProvider;
+import androidx.test.ext.junit.runners.AndroidJUnit4;
+import java.io.ByteArrayOutputStream;
+import java.nio.ByteBuffer;
+import java.util.Arrays;
+import org.junit.Before;
+import org.junit.Test;
+import org.junit.runner.RunWith;
+
+/** Tests for {@link FfmpegAudioDecoder}. */
+@RunWith(AndroidJUnit4.class)
+public final class FfmpegAudioDecoderTest {
+
+  private static final String BEAR_VORBIS_PATH = "media/ogg/bear_vorbis.ogg";
+
+  @Before
+  public void setUp() {
+    if (!FfmpegLibrary.isAvailable()) {
+      fail("FFmpeg library not available.");
+    }
+    assumeTrue(FfmpegLibrary.supportsFormat(MimeTypes.AUDIO_VORBIS));
+  }
+
+  @Test
+  public void decodePackets_outputBufferSmallerThanPacketOutput_outputsAllSamples()
+      throws Exception {
+    Context context = ApplicationProvider.getApplicationContext();
+    FakeExtractorOutput extractorOutput =
+        TestUtil.extractAllSamplesFromFile(new OggExtractor(), context, BEAR_VORBIS_PATH);
+    FakeTrackOutput trackOutput = extractorOutput.trackOutputs.valueAt(0);
+    Format format = trackOutput.lastFormat;
+    int packetCount = trackOutput.getSampleCount();
+    int[] packetSizes = new int[packetCount];
+    ByteArrayOutputStream packets = new ByteArrayOutputStream();
+    for (int i = 0; i < packetCount; i++) {
+      byte[] sampleData = trackOutput.getSampleData(i);
+      packetSizes[i] = sampleData.length;
+      packets.write(sampleData);
+    }
+    byte[] inputData = packets.toByteArray();
+
+    // Vorbis packets alternate between short and long blocks, so the output of a packet is often
+    // larger than all the previous ones, and doesn't fit in the space left.
+    byte[] expectedOutput =
+        decodeAllPackets(format, inputData, packetSizes, /* outputBufferSize= */ 1 << 22);
+    byte[] output = decodeAllPackets(format, inputData, packetSizes, /* outputBufferSize= */ 5000);
+
+    assertThat(expectedOutput.length).isGreaterThan(0);
+    assertThat(output).isEqualTo(expectedOutput);
+  }
+
+  private static byte[] decodeAllPackets(
+      Format format, byte[] inputData, int[] packetSizes, int outputBufferSize) throws Exception {
+    FfmpegAudioDecoder decoder =
+        new FfmpegAudioDecoder(
+            format,
+            /* numInputBuffers= */ 1,
+            /* numOutputBuffers= */ 1,
+            /* initialInputBufferSize= */ inputData.length,
+            /* outputFloat= */ false,
+            /* threads= */ 1);
+    ByteBuffer input = ByteBuffer.allocateDirect(inputData.length);
+    input.put(inputData);
+    input.flip();
+    ByteBuffer outputData = ByteBuffer.allocateDirect(outputBufferSize);
+    ByteArrayOutputStream output = new ByteArrayOutputStream();
+    int packetIndex = 0;
+    boolean finished = false;
+    while (!finished) {
+      // The last call, without packets, outputs the rest of the last packet.
+      finished = packetIndex == packetSizes.length;
+      int[] remainingPacketSizes = Arrays.copyOfRange(packetSizes, packetIndex, packetSizes.length);
+      int[] outputOffsets = new int[remainingPacketSizes.length + 1];
+      int decodedPacketCount =
+          decoder.decodePackets(
+              input, remainingPacketSizes, remainingPacketSizes.length, outputData, outputOffsets);
+      byte[] outputBytes = new byte[outputOffsets[decodedPacketCount]];
+      outputData.duplicate().get(outputBytes);
+      output.write(outputBytes);
+      for (int i = 0; i < decodedPacketCount; i++) {
+        input.position(input.position() + remainingPacketSizes[i]);
+      }
+      packetIndex += decodedPacketCount;
+    }
+    decoder.release();
+    return output.toByteArray();
+  }
+}
@@ -21,6 +21,7 @@ import androidx.media3.common.Format;
 import androidx.media3.common.MimeTypes;
 import androidx.media3.common.util.Assertions;
 import androidx.media3.common.util.ParsableByteArray;
+import androidx.media3.common.util.UnstableApi;
 import androidx.media3.common.util.Util;
 import androidx.media3.decoder.DecoderInputBuffer;
 import androidx.media3.decoder.SimpleDecoder;
@@ -29,7 +30,8 @@ import java.nio.ByteBuffer;
 import java.util.List;
 
 /** FFmpeg audio decoder. */
-/* package */ final class FfmpegAudioDecoder
+@UnstableApi
+public final class FfmpegAudioDecoder
     extends SimpleDecoder<DecoderInputBuffer, SimpleDecoderOutputBuffer, FfmpegDecoderException> {
 
   // Output buffer sizes when decoding PCM mu-law streams, which is the maximum FFmpeg outputs.
@@ -38,23 +40,37 @@ import java.util.List;
 
   private static final int AUDIO_DECODER_ERROR_INVALID_DATA = -1;
   private static final int AUDIO_DECODER_ERROR_OTHER = -2;
+  private static final int AUDIO_DECODER_ERROR_BUFFER_TOO_SMALL = -3;
 
   private final String codecName;
   @Nullable private final byte[] extraData;
   private final @C.PcmEncoding int encoding;
   private final int outputBufferSize;
 
-  private long nativeContext; // May be reassigned on resetting the codec.
+  private long nativeContext;
   private boolean hasOutputFormat;
   private volatile int channelCount;
   private volatile int sampleRate;
 
+  /**
+   * Creates an FFmpeg audio decoder.
+   *
+   * @param format The input format.
+   * @param numInputBuffers The number of input buffers.
+   * @param numOutputBuffers The number of output buffers.
+   * @param initialInputBufferSize The initial size of each input buffer, in bytes.
+   * @param outputFloat Whether to output 32-bit float samples instead of 16-bit integer samples.
+   * @param threads The number of threads FFmpeg may use to decode, or {@link
+   *     FfmpegAudioRenderer#THREAD_COUNT_AUTODETECT}.
+   * @throws FfmpegDecoderException If initializing the decoder fails.
+   */
   public FfmpegAudioDecoder(
       Format format,
       int numInputBuffers,
       int numOutputBuffers,
       int initialInputBufferSize,
-      boolean outputFloat)
+      boolean outputFloat,
+      int threads)
       throws FfmpegDecoderException {
     super(new DecoderInputBuffer[numInputBuffers], new SimpleDecoderOutputBuffer[numOutputBuffers]);
     if (!FfmpegLibrary.isAvailable()) {
@@ -65,8 +81,16 @@ import java.util.List;
     extraData = getExtraData(format.sampleMimeType, format.initializationData);
     encoding = outputFloat ? C.ENCODING_PCM_FLOAT : C.ENCODING_PCM_16BIT;
     outputBufferSize = outputFloat ? OUTPUT_BUFFER_SIZE_32BIT : OUTPUT_BUFFER_SIZE_16BIT;
+    if (threads == FfmpegAudioRenderer.THREAD_COUNT_AUTODETECT) {
+      threads = ffmpegGetThreads();
+      if (threads <= 0) {
+        // If the number of performance processors is unknown, use all available processors.
+        threads = Runtime.getRuntime().availableProcessors();
+      }
+    }
     nativeContext =
-        ffmpegInitialize(codecName, extraData, outputFloat, format.sampleRate, format.channelCount);
+        ffmpegInitialize(
+            codecName, extraData, outputFloat, format.sampleRate, format.channelCount, threads);
     if (nativeContext == 0) {
       throw new FfmpegDecoderException("Initialization failed.");
     }
@@ -100,17 +124,18 @@ import java.util.List;
   protected FfmpegDecoderException decode(
       DecoderInputBuffer inputBuffer, SimpleDecoderOutputBuffer outputBuffer, boolean reset) {
     if (reset) {
-      nativeContext = ffmpegReset(nativeContext, extraData);
-      if (nativeContext == 0) {
-        return new FfmpegDecoderException("Error resetting (see logcat).");
-      }
+      ffmpegReset(nativeContext);
     }
     ByteBuffer inputData = Util.castNonNull(inputBuffer.data);
     int inputSize = inputData.limit();
     ByteBuffer outputData = outputBuffer.init(inputBuffer.timeUs, outputBufferSize);
-    int result = ffmpegDecode(nativeContext, inputData, inputSize, outputData, outputBufferSize);
+    int result =
+        ffmpegDecode(
+            nativeContext, inputData, inputSize, inputBuffer.timeUs, outputData, outputBufferSize);
     if (result == AUDIO_DECODER_ERROR_OTHER) {
       return new FfmpegDecoderException("Error decoding (see logcat).");
+    } else if (result == AUDIO_DECODER_ERROR_BUFFER_TOO_SMALL) {
+      return new FfmpegDecoderException("Output buffer too small (see logcat).");
     } else if (result == AUDIO_DECODER_ERROR_INVALID_DATA) {
       // Treat invalid data errors as non-fatal to match the behavior of MediaCodec. No output will
       // be produced for this buffer, so mark it as decode-only to ensure that the audio sink's
@@ -122,19 +147,91 @@ import java.util.List;
       outputBuffer.setFlags(C.BUFFER_FLAG_DECODE_ONLY);
       return null;
     }
-    if (!hasOutputFormat) {
-      channelCount = ffmpegGetChannelCount(nativeContext);
-      sampleRate = ffmpegGetSampleRate(nativeContext);
-      if (sampleRate == 0 && "alac".equals(codecName)) {
-        Assertions.checkNotNull(extraData);
-        // ALAC decoder did not set the sample rate in earlier versions of FFmpeg. See
-        // https://trac.ffmpeg.org/ticket/6096.
-        ParsableByteArray parsableExtraData = new ParsableByteArray(extraData);
-        parsableExtraData.setPosition(extraData.length - 4);
-        sampleRate = parsableExtraData.readUnsignedIntToInt();
-      }
-      hasOutputFormat = true;
+    setOutputTimeUs(outputBuffer);
+    maybeUpdateOutputFormat();
+    outputData.position(0);
+    outputData.limit(result);
+    return null;
+  }
+
+  /**
+   * Decodes several packets in a single native call, into one contiguous buffer. This is intended
+   * for decoding a stream offline, e.g. for transcoding or indexing short low-bitrate packets,
+   * without queueing each packet through {@link #queueInputBuffer}. It must not be called while
+   * input buffers are queued.
+   *
+   * <p>Packets with invalid data produce no output, as in normal decoding.
+   *
+   * <p>The size of a packet's output is only known after decoding it, so decoding stops early if
+   * the space left in the output buffer is less than the largest output of a packet so far. In
+   * that case the remaining packets should be passed to the next call. If the output of a packet
+   * doesn't fit in the space left, the packet is counted as decoded, and the rest of its output is
+   * written at the start of the output of the next call, before {@code outputOffsets[0]}, so no
+   * samples are lost. A call without packets only writes that output, e.g. at the end of the
+   * stream. Decoding also stops early if
+   * a packet can't be decoded after others were, in which case the packets decoded before it are
+   * returned, and the next call, starting at that packet, throws.
+   *
+   * @param inputData A direct buffer holding the packets back to back, from its position.
+   * @param packetSizes The sizes of the packets, in bytes.
+   * @param packetCount The number of packets.
+   * @param outputData A direct buffer to decode into, from its position to its capacity. Its
+   *     position and limit aren't changed.
+   * @param outputOffsets Receives the offsets in {@code outputData} at which the output of the
+   *     decoded packets starts, followed by the offset at which the output of the last decoded
+   *     packet ends. Output before {@code outputOffsets[0]} belongs to the last packet of the
+   *     previous call. Must have at least {@code packetCount + 1} elements.
+   * @return The number of packets decoded.
+   * @throws FfmpegDecoderException If the first packet can't be decoded, or if a decoded frame
+   *     doesn't fit in the whole output buffer.
+   */
+  public int decodePackets(
+      ByteBuffer inputData,
+      int[] packetSizes,
+      int packetCount,
+      ByteBuffer outputData,
+      int[] outputOffsets)
+      throws FfmpegDecoderException {
+    Assertions.checkArgument(inputData.isDirect() && outputData.isDirect());
+    Assertions.checkArgument(packetCount >= 0 && packetCount <= packetSizes.length);
+    Assertions.checkArgument(packetCount < outputOffsets.length);
+    int result =
+        ffmpegDecodePackets(
+            nativeContext,
+            inputData,
+            inputData.position(),
+            packetSizes,
+            packetCount,
+            outputData,
+            outputData.position(),
+            outputOffsets);
+    if (result == AUDIO_DECODER_ERROR_BUFFER_TOO_SMALL) {
+      throw new FfmpegDecoderException("Output buffer too small (see logcat).");
+    } else if (result < 0) {
+      throw new FfmpegDecoderException("Error decoding (see logcat).");
+    }
+    if (outputOffsets[result] > outputData.position()) {
+      maybeUpdateOutputFormat();
+    }
+    return result;
+  }
+
+  @Override
+  @Nullable
+  protected FfmpegDecoderException drain(SimpleDecoderOutputBuffer outputBuffer, boolean reset) {
+    if (reset) {
+      ffmpegReset(nativeContext);
+    }
+    // Decoders may hold back frames, e.g. when decoding several packets in parallel.
+    ByteBuffer outputData = outputBuffer.init(C.TIME_UNSET, outputBufferSize);
+    int result = ffmpegDrain(nativeContext, outputData, outputBufferSize);
+    if (result < 0) {
+      return new FfmpegDecoderException("Error draining (see logcat).");
+    } else if (result == 0) {
+      outputBuffer.addFlag(C.BUFFER_FLAG_END_OF_STREAM);
+      return null;
     }
+    setOutputTimeUs(outputBuffer);
     outputData.position(0);
     outputData.limit(result);
     return null;
@@ -213,21 +310,72 @@ import java.util.List;
     return extraData;
   }
 
+  /** Reads the output format from the native decoder, once it has output samples. */
+  private void maybeUpdateOutputFormat() {
+    if (hasOutputFormat) {
+      return;
+    }
+    channelCount = ffmpegGetChannelCount(nativeContext);
+    sampleRate = ffmpegGetSampleRate(nativeContext);
+    if (sampleRate == 0 && "alac".equals(codecName)) {
+      Assertions.checkNotNull(extraData);
+      // ALAC decoder did not set the sample rate in earlier versions of FFmpeg. See
+      // https://trac.ffmpeg.org/ticket/6096.
+      ParsableByteArray parsableExtraData = new ParsableByteArray(extraData);
+      parsableExtraData.setPosition(extraData.length - 4);
+      sampleRate = parsableExtraData.readUnsignedIntToInt();
+    }
+    hasOutputFormat = true;
+  }
+
+  /**
+   * Sets the time of an output buffer to the presentation time of its first frame, which differs
+   * from the time of the input buffer if the decoder held back frames of earlier input buffers.
+   */
+  private void setOutputTimeUs(SimpleDecoderOutputBuffer outputBuffer) {
+    long outputTimeUs = ffmpegGetOutputTimeUs(nativeContext);
+    if (outputTimeUs != C.TIME_UNSET) {
+      outputBuffer.timeUs = outputTimeUs;
+    }
+  }
+
+  private native int ffmpegGetThreads();
+
   private native long ffmpegInitialize(
       String codecName,
       @Nullable byte[] extraData,
       boolean outputFloat,
       int rawSampleRate,
-      int rawChannelCount);
+      int rawChannelCount,
+      int threads);
 
   private native int ffmpegDecode(
-      long context, ByteBuffer inputData, int inputSize, ByteBuffer outputData, int outputSize);
+      long context,
+      ByteBuffer inputData,
+      int inputSize,
+      long timeUs,
+      ByteBuffer outputData,
+      int outputSize);
+
+  private native int ffmpegDecodePackets(
+      long context,
+      ByteBuffer inputData,
+      int inputOffset,
+      int[] packetSizes,
+      int packetCount,
+      ByteBuffer outputData,
+      int outputOffset,
+      int[] outputOffsets);
+
+  private native int ffmpegDrain(long context, ByteBuffer outputData, int outputSize);
+
+  private native long ffmpegGetOutputTimeUs(long context);
 
   private native int ffmpegGetChannelCount(long context);
 
   private native int ffmpegGetSampleRate(long context);
 
-  private native long ffmpegReset(long context, @Nullable byte[] extraData);
+  private native void ffmpegReset(long context);
 
   private native void ffmpegRelease(long context);
 }
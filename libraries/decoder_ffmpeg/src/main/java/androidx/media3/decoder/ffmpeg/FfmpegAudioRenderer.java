@@ -40,6 +40,13 @@ import androidx.media3.exoplayer.audio.DefaultAudioSink;
 @UnstableApi
 public final class FfmpegAudioRenderer extends DecoderAudioRenderer<FfmpegAudioDecoder> {
 
+  /**
+   * Attempts to use as many threads as there are performance processors on the device, for codecs
+   * that support multi-threaded decoding. If the number of performance processors cannot be
+   * detected, the number of available processors is used.
+   */
+  public static final int THREAD_COUNT_AUTODETECT = 0;
+
   private static final String TAG = "FfmpegAudioRenderer";
 
   /** The number of input and output buffers. */
@@ -47,6 +54,8 @@ public final class FfmpegAudioRenderer extends DecoderAudioRenderer<FfmpegAudioD
   /** The default input buffer size. */
   private static final int DEFAULT_INPUT_BUFFER_SIZE = 960 * 6;
 
+  private int threadCount;
+
   public FfmpegAudioRenderer() {
     this(/* eventHandler= */ null, /* eventListener= */ null);
   }
@@ -82,6 +91,24 @@ public final class FfmpegAudioRenderer extends DecoderAudioRenderer<FfmpegAudioD
       @Nullable AudioRendererEventListener eventListener,
       AudioSink audioSink) {
     super(eventHandler, eventListener, audioSink);
+    threadCount = 1;
+  }
+
+  /**
+   * Sets the number of threads that FFmpeg uses to decode, for codecs that support multi-threaded
+   * decoding (for example FLAC and ALAC). The default is 1, so decoding is single-threaded unless
+   * enabled here.
+   *
+   * <p>Frame-threaded decoding delays the output by up to one packet per thread.
+   *
+   * <p>Takes effect when the next decoder is created.
+   *
+   * <p>This method is experimental, and will be renamed or removed in a future release.
+   *
+   * @param threadCount The number of threads, or {@link #THREAD_COUNT_AUTODETECT}.
+   */
+  public void experimentalSetThreadCount(int threadCount) {
+    this.threadCount = threadCount;
   }
 
   @Override
@@ -118,7 +145,12 @@ public final class FfmpegAudioRenderer extends DecoderAudioRenderer<FfmpegAudioD
         format.maxInputSize != Format.NO_VALUE ? format.maxInputSize : DEFAULT_INPUT_BUFFER_SIZE;
     FfmpegAudioDecoder decoder =
         new FfmpegAudioDecoder(
-            format, NUM_BUFFERS, NUM_BUFFERS, initialInputBufferSize, shouldOutputFloat(format));
+            format,
+            NUM_BUFFERS,
+            NUM_BUFFERS,
+            initialInputBufferSize,
+            shouldOutputFloat(format),
+            threadCount);
     TraceUtil.endSection();
     return decoder;
   }
@@ -16,6 +16,7 @@
 #include <android/log.h>
 #include <jni.h>
 #include <stdlib.h>
+#include <string.h>
 
 extern "C" {
 #ifdef __cplusplus
@@ -32,6 +33,16 @@ extern "C" {
 #include <libswresample/swresample.h>
 }
 
+#include "cpu_info.h"  // NOLINT
+
+#if defined(__ARM_NEON__) || defined(__ARM_NEON) || defined(__aarch64__)
+#include <arm_neon.h>
+#define INTERLEAVE_NEON
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define INTERLEAVE_SSE2
+#endif
+
 #define LOG_TAG "ffmpeg_jni"
 #define LOGE(...) \
   ((void)__android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__))
@@ -58,6 +69,8 @@ extern "C" {
           JNIEnv *env, jobject thiz, ##__VA_ARGS__)
 
 #define ERROR_STRING_BUFFER_LENGTH 256
+// The number of input buffers whose AVBufferRef wrappers are kept.
+#define MAX_INPUT_BUFFER_REFS 32
 
 // Output format corresponding to AudioFormat.ENCODING_PCM_16BIT.
 static const AVSampleFormat OUTPUT_FORMAT_PCM_16BIT = AV_SAMPLE_FMT_S16;
@@ -66,6 +79,56 @@ static const AVSampleFormat OUTPUT_FORMAT_PCM_FLOAT = AV_SAMPLE_FMT_FLT;
 
 static const int AUDIO_DECODER_ERROR_INVALID_DATA = -1;
 static const int AUDIO_DECODER_ERROR_OTHER = -2;
+static const int AUDIO_DECODER_ERROR_BUFFER_TOO_SMALL = -3;
+
+// C.TIME_UNSET.
+static const jlong TIME_UNSET = INT64_MIN + 1;
+
+/**
+ * The native state of a decoder, referenced by FfmpegAudioDecoder.
+ */
+struct FfmpegAudioContext {
+  AVCodecContext *codecContext;
+  // Whether input is skipped until the next TrueHD major sync, after a reset.
+  bool awaitingMajorSync;
+  // The largest output of a packet so far, in bytes.
+  int maxPacketOutputSize;
+  // Whether the end of the stream has been sent to the decoder.
+  bool draining;
+  // The presentation time of the first frame output by the last call to
+  // decodePacket or drainFrame, or TIME_UNSET if it's unknown.
+  jlong outputTimeUs;
+  // The frame that decoded samples are received into, reused for all packets.
+  AVFrame *frame;
+  // Whether frame holds a received frame that didn't fit in the output buffer.
+  // It's output first by the next call to receiveFrames.
+  bool hasPendingFrame;
+  // The packet that input data is sent in, reused for all packets.
+  AVPacket *packet;
+  // Wrappers of the Java input buffers, created the first time each buffer is
+  // decoded from, so that packets can reference the input data instead of
+  // FFmpeg copying it. They don't own the memory, so a wrapper of a released
+  // buffer is harmless, and is replaced once MAX_INPUT_BUFFER_REFS newer
+  // buffers have been seen.
+  AVBufferRef *inputBufferRefs[MAX_INPUT_BUFFER_REFS];
+  int nextInputBufferRef;
+  // Whether packets reference the input buffers. Only possible if FFmpeg
+  // releases its references before ffmpegDecode returns, because Java reuses
+  // the buffers afterwards.
+  bool zeroCopyInput;
+  // The resampler, or NULL if no frame has needed converting since the last
+  // reset, and the input format it is configured for.
+  SwrContext *resampleContext;
+  AVSampleFormat resampleSampleFormat;
+  uint64_t resampleChannelLayout;
+  int resampleSampleRate;
+  // The output channel layout and sample rate. They're taken from the first
+  // decoded frame, and kept if the stream changes later, because the output
+  // format is only read once. Zero until a frame has been decoded.
+  uint64_t outputChannelLayout;
+  int outputChannelCount;
+  int outputSampleRate;
+};
 
 /**
  * Returns the AVCodec with the specified name, or NULL if it is not available.
@@ -75,20 +138,93 @@ AVCodec *getCodecByName(JNIEnv *env, jstring codecName);
 /**
  * Allocates and opens a new AVCodecContext for the specified codec, passing the
  * provided extraData as initialization data for the decoder if it is non-NULL.
- * Returns the created context.
+ * The decoder uses up to threadCount threads if the codec supports frame or
+ * slice threading. Returns the created context.
  */
 AVCodecContext *createContext(JNIEnv *env, AVCodec *codec, jbyteArray extraData,
                               jboolean outputFloat, jint rawSampleRate,
-                              jint rawChannelCount);
+                              jint rawChannelCount, jint threadCount);
+
+/**
+ * Allocates a new FfmpegAudioContext, with a codec context created as in
+ * createContext. Returns the created context, or NULL on failure.
+ */
+FfmpegAudioContext *createAudioContext(JNIEnv *env, AVCodec *codec,
+                                       jbyteArray extraData,
+                                       jboolean outputFloat, jint rawSampleRate,
+                                       jint rawChannelCount, jint threadCount);
+
+/**
+ * Returns a reference to the wrapper of the input buffer with the specified
+ * address and capacity, creating it if needed, or NULL on failure.
+ */
+AVBufferRef *getInputBufferRef(FfmpegAudioContext *audioContext, uint8_t *data,
+                               int capacity);
 
 /**
  * Decodes the packet into the output buffer, returning the number of bytes
  * written, or a negative AUDIO_DECODER_ERROR constant value in the case of an
  * error.
  */
-int decodePacket(AVCodecContext *context, AVPacket *packet,
+int decodePacket(FfmpegAudioContext *audioContext, AVPacket *packet,
                  uint8_t *outputBuffer, int outputSize);
 
+/**
+ * Outputs the next frame held back by the decoder after the end of the stream,
+ * e.g. by frame threading, returning the number of bytes written, 0 if there
+ * are no frames left, or a negative AUDIO_DECODER_ERROR constant value in the
+ * case of an error.
+ */
+int drainFrame(FfmpegAudioContext *audioContext, uint8_t *outputBuffer,
+               int outputSize);
+
+/**
+ * Skips the input data before the next TrueHD major sync if the decoder is
+ * waiting for one after a reset. Returns false if the data has no major sync,
+ * and so has to be dropped.
+ */
+bool skipUntilMajorSync(FfmpegAudioContext *audioContext, uint8_t **data,
+                        int *size);
+
+/**
+ * Returns the offset of the first TrueHD access unit in the data that starts
+ * with a major sync, or -1 if there is none.
+ */
+int findTrueHdMajorSync(const uint8_t *data, int size);
+
+/**
+ * Receives decoded frames into the output buffer until the decoder needs more
+ * input, or until maxFrameCount frames have been received if it's positive.
+ * A frame that doesn't fit in the output buffer is kept as the pending frame,
+ * and receiving stops. Returns the number of bytes written, or a negative
+ * AUDIO_DECODER_ERROR constant value in the case of an error.
+ */
+int receiveFrames(FfmpegAudioContext *audioContext, uint8_t *outputBuffer,
+                  int outputSize, int maxFrameCount);
+
+/**
+ * Drops the pending frame, if any, for callers whose output buffer is expected
+ * to fit the output of a packet. Returns AUDIO_DECODER_ERROR_BUFFER_TOO_SMALL
+ * if there was one, and result otherwise.
+ */
+int dropPendingFrame(FfmpegAudioContext *audioContext, int outputSize,
+                     int result);
+
+/**
+ * Returns a resampler converting frames with the format of the specified frame
+ * to the output format, reusing the current one if it has the same input
+ * format. Returns NULL on failure.
+ */
+SwrContext *getResampleContext(FfmpegAudioContext *audioContext,
+                               const AVFrame *frame);
+
+/**
+ * Copies the samples of a frame whose format is outputFormat, or its planar
+ * variant, to the output buffer, interleaving them if needed.
+ */
+void copyFrame(const AVFrame *frame, AVSampleFormat outputFormat,
+               int channelCount, uint8_t *outputBuffer);
+
 /**
  * Outputs a log message describing the avcodec error number.
  */
@@ -99,12 +235,24 @@ void logError(const char *functionName, int errorNumber);
  */
 void releaseContext(AVCodecContext *context);
 
+/**
+ * Releases the resampler of the specified audio context, if any.
+ */
+void releaseResampleContext(FfmpegAudioContext *audioContext);
+
+/**
+ * Releases the specified audio context and its codec context.
+ */
+void releaseAudioContext(FfmpegAudioContext *audioContext);
+
 jint JNI_OnLoad(JavaVM *vm, void *reserved) {
   JNIEnv *env;
   if (vm->GetEnv(reinterpret_cast<void **>(&env), JNI_VERSION_1_6) != JNI_OK) {
     return -1;
   }
+#if LIBAVCODEC_VERSION_INT < AV_VERSION_INT(58, 9, 100)
   avcodec_register_all();
+#endif
   return JNI_VERSION_1_6;
 }
 
@@ -120,20 +268,31 @@ LIBRARY_FUNC(jboolean, ffmpegHasDecoder, jstring codecName) {
   return getCodecByName(env, codecName) != NULL;
 }
 
+AUDIO_DECODER_FUNC(jint, ffmpegGetThreads) {
+  decoder_jni::CpuTopology topology;
+  if (!decoder_jni::GetCpuTopology(&topology)) {
+    return 0;
+  }
+  return topology.GetNumberOfPerformanceCores();
+}
+
 AUDIO_DECODER_FUNC(jlong, ffmpegInitialize, jstring codecName,
                    jbyteArray extraData, jboolean outputFloat,
-                   jint rawSampleRate, jint rawChannelCount) {
+                   jint rawSampleRate, jint rawChannelCount,
+                   jint threadCount) {
   AVCodec *codec = getCodecByName(env, codecName);
   if (!codec) {
     LOGE("Codec not found.");
     return 0L;
   }
-  return (jlong)createContext(env, codec, extraData, outputFloat, rawSampleRate,
-                              rawChannelCount);
+  return (jlong)createAudioContext(env, codec, extraData, outputFloat,
+                                   rawSampleRate, rawChannelCount,
+                                   threadCount);
 }
 
 AUDIO_DECODER_FUNC(jint, ffmpegDecode, jlong context, jobject inputData,
-                   jint inputSize, jobject outputData, jint outputSize) {
+                   jint inputSize, jlong timeUs, jobject outputData,
+                   jint outputSize) {
   if (!context) {
     LOGE("Context must be non-NULL.");
     return -1;
@@ -150,14 +309,169 @@ AUDIO_DECODER_FUNC(jint, ffmpegDecode, jlong context, jobject inputData,
     LOGE("Invalid output buffer length: %d", outputSize);
     return -1;
   }
+  uint8_t *inputStart = (uint8_t *)env->GetDirectBufferAddress(inputData);
+  jlong inputCapacity = env->GetDirectBufferCapacity(inputData);
+  uint8_t *outputBuffer = (uint8_t *)env->GetDirectBufferAddress(outputData);
+  FfmpegAudioContext *audioContext = (FfmpegAudioContext *)context;
+  uint8_t *inputBuffer = inputStart;
+  if (!skipUntilMajorSync(audioContext, &inputBuffer, &inputSize)) {
+    return 0;
+  }
+  AVPacket *packet = audioContext->packet;
+  // Reference the input buffer if it has room for the padding FFmpeg reads
+  // past the end of the data. Otherwise FFmpeg copies the data into a padded
+  // buffer of its own.
+  AVBufferRef *inputBufferRef = NULL;
+  int inputEnd = (int)(inputBuffer - inputStart) + inputSize;
+  if (audioContext->zeroCopyInput &&
+      inputEnd + AV_INPUT_BUFFER_PADDING_SIZE <= inputCapacity) {
+    memset(inputStart + inputEnd, 0, AV_INPUT_BUFFER_PADDING_SIZE);
+    inputBufferRef =
+        getInputBufferRef(audioContext, inputStart, (int)inputCapacity);
+    if (inputBufferRef) {
+      packet->buf = av_buffer_ref(inputBufferRef);
+    }
+  }
+  packet->data = inputBuffer;
+  packet->size = inputSize;
+  packet->pts = timeUs;
+  int result = decodePacket(audioContext, packet, outputBuffer, outputSize);
+  av_packet_unref(packet);
+  if (inputBufferRef && av_buffer_get_ref_count(inputBufferRef) > 1) {
+    LOGE("Decoder kept a reference to the input buffer. Copying input.");
+    audioContext->zeroCopyInput = false;
+  }
+  return dropPendingFrame(audioContext, outputSize, result);
+}
+
+AUDIO_DECODER_FUNC(jint, ffmpegDecodePackets, jlong context, jobject inputData,
+                   jint inputOffset, jintArray packetSizes, jint packetCount,
+                   jobject outputData, jint outputOffset,
+                   jintArray outputOffsets) {
+  if (!context) {
+    LOGE("Context must be non-NULL.");
+    return -1;
+  }
   uint8_t *inputBuffer = (uint8_t *)env->GetDirectBufferAddress(inputData);
+  jlong inputCapacity = env->GetDirectBufferCapacity(inputData);
+  uint8_t *outputBuffer = (uint8_t *)env->GetDirectBufferAddress(outputData);
+  jlong outputCapacity = env->GetDirectBufferCapacity(outputData);
+  if (!inputBuffer || !outputBuffer) {
+    LOGE("Input and output buffers must be direct.");
+    return -1;
+  }
+  if (packetCount < 0 || packetCount > env->GetArrayLength(packetSizes) ||
+      packetCount >= env->GetArrayLength(outputOffsets)) {
+    LOGE("Invalid packet count: %d.", packetCount);
+    return -1;
+  }
+  FfmpegAudioContext *audioContext = (FfmpegAudioContext *)context;
+  AVPacket *packet = audioContext->packet;
+  jint *sizes = env->GetIntArrayElements(packetSizes, NULL);
+  jint *offsets = env->GetIntArrayElements(outputOffsets, NULL);
+  if (!sizes || !offsets) {
+    if (sizes) {
+      env->ReleaseIntArrayElements(packetSizes, sizes, JNI_ABORT);
+    }
+    if (offsets) {
+      env->ReleaseIntArrayElements(outputOffsets, offsets, JNI_ABORT);
+    }
+    LOGE("Failed to access the packet arrays.");
+    return -1;
+  }
+  jlong inputPosition = inputOffset;
+  jlong outputPosition = outputOffset;
+  int result = 0;
+  if (audioContext->hasPendingFrame) {
+    // Finish the output of the last packet of the previous call.
+    result = receiveFrames(audioContext, outputBuffer + outputPosition,
+                           (int)(outputCapacity - outputPosition),
+                           /* maxFrameCount= */ 0);
+    if (result == 0 && audioContext->hasPendingFrame) {
+      // The frame doesn't fit in the whole output buffer.
+      result = dropPendingFrame(audioContext,
+                                (int)(outputCapacity - outputPosition), result);
+    }
+    if (result < 0) {
+      env->ReleaseIntArrayElements(packetSizes, sizes, JNI_ABORT);
+      env->ReleaseIntArrayElements(outputOffsets, offsets, JNI_ABORT);
+      return result;
+    }
+    outputPosition += result;
+  }
+  offsets[0] = (jint)outputPosition;
+  int decodedPacketCount = 0;
+  // A packet whose output doesn't fit is counted as decoded, and the rest of
+  // its output is written by the next call.
+  for (; decodedPacketCount < packetCount && !audioContext->hasPendingFrame;
+       decodedPacketCount++) {
+    int packetSize = sizes[decodedPacketCount];
+    if (packetSize < 0 || packetSize > inputCapacity - inputPosition) {
+      LOGE("Invalid packet size: %d.", packetSize);
+      result = -1;
+      break;
+    }
+    // The output size of a packet is only known once it's decoded, so the
+    // largest output so far is used as an estimate.
+    if (decodedPacketCount > 0 &&
+        audioContext->maxPacketOutputSize > outputCapacity - outputPosition) {
+      // The remaining packets are left for the next call.
+      break;
+    }
+    uint8_t *packetData = inputBuffer + inputPosition;
+    inputPosition += packetSize;
+    result = 0;
+    if (skipUntilMajorSync(audioContext, &packetData, &packetSize)) {
+      // The packets are back to back, so they can't be referenced without
+      // overwriting the next packet with padding, and FFmpeg copies them.
+      packet->data = packetData;
+      packet->size = packetSize;
+      result = decodePacket(audioContext, packet, outputBuffer + outputPosition,
+                            (int)(outputCapacity - outputPosition));
+      av_packet_unref(packet);
+    }
+    if (result == AUDIO_DECODER_ERROR_INVALID_DATA) {
+      // Like in ffmpegDecode, invalid packets produce no output.
+      result = 0;
+    } else if (result < 0) {
+      break;
+    }
+    outputPosition += result;
+    offsets[decodedPacketCount + 1] = (jint)outputPosition;
+  }
+  env->ReleaseIntArrayElements(packetSizes, sizes, JNI_ABORT);
+  env->ReleaseIntArrayElements(outputOffsets, offsets, 0);
+  // The decoder state has advanced past the packets decoded before an error,
+  // so they're returned, and the error is reported by the next call.
+  return result < 0 && decodedPacketCount == 0 ? result : decodedPacketCount;
+}
+
+AUDIO_DECODER_FUNC(jint, ffmpegDrain, jlong context, jobject outputData,
+                   jint outputSize) {
+  if (!context) {
+    LOGE("Context must be non-NULL.");
+    return -1;
+  }
+  if (!outputData) {
+    LOGE("Output buffer must be non-NULL.");
+    return -1;
+  }
+  if (outputSize < 0) {
+    LOGE("Invalid output buffer length: %d", outputSize);
+    return -1;
+  }
   uint8_t *outputBuffer = (uint8_t *)env->GetDirectBufferAddress(outputData);
-  AVPacket packet;
-  av_init_packet(&packet);
-  packet.data = inputBuffer;
-  packet.size = inputSize;
-  return decodePacket((AVCodecContext *)context, &packet, outputBuffer,
-                      outputSize);
+  FfmpegAudioContext *audioContext = (FfmpegAudioContext *)context;
+  int result = drainFrame(audioContext, outputBuffer, outputSize);
+  return dropPendingFrame(audioContext, outputSize, result);
+}
+
+AUDIO_DECODER_FUNC(jlong, ffmpegGetOutputTimeUs, jlong context) {
+  if (!context) {
+    LOGE("Context must be non-NULL.");
+    return TIME_UNSET;
+  }
+  return ((FfmpegAudioContext *)context)->outputTimeUs;
 }
 
 AUDIO_DECODER_FUNC(jint, ffmpegGetChannelCount, jlong context) {
@@ -165,7 +479,10 @@ AUDIO_DECODER_FUNC(jint, ffmpegGetChannelCount, jlong context) {
     LOGE("Context must be non-NULL.");
     return -1;
   }
-  return ((AVCodecContext *)context)->channels;
+  FfmpegAudioContext *audioContext = (FfmpegAudioContext *)context;
+  return audioContext->outputChannelCount
+             ? audioContext->outputChannelCount
+             : audioContext->codecContext->channels;
 }
 
 AUDIO_DECODER_FUNC(jint, ffmpegGetSampleRate, jlong context) {
@@ -173,40 +490,43 @@ AUDIO_DECODER_FUNC(jint, ffmpegGetSampleRate, jlong context) {
     LOGE("Context must be non-NULL.");
     return -1;
   }
-  return ((AVCodecContext *)context)->sample_rate;
+  FfmpegAudioContext *audioContext = (FfmpegAudioContext *)context;
+  return audioContext->outputSampleRate
+             ? audioContext->outputSampleRate
+             : audioContext->codecContext->sample_rate;
 }
 
-AUDIO_DECODER_FUNC(jlong, ffmpegReset, jlong jContext, jbyteArray extraData) {
-  AVCodecContext *context = (AVCodecContext *)jContext;
-  if (!context) {
+AUDIO_DECODER_FUNC(void, ffmpegReset, jlong jContext) {
+  FfmpegAudioContext *audioContext = (FfmpegAudioContext *)jContext;
+  if (!audioContext) {
     LOGE("Tried to reset without a context.");
-    return 0L;
+    return;
   }
 
-  AVCodecID codecId = context->codec_id;
-  if (codecId == AV_CODEC_ID_TRUEHD) {
-    // Release and recreate the context if the codec is TrueHD.
-    // TODO: Figure out why flushing doesn't work for this codec.
-    releaseContext(context);
-    AVCodec *codec = avcodec_find_decoder(codecId);
-    if (!codec) {
-      LOGE("Unexpected error finding codec %d.", codecId);
-      return 0L;
-    }
-    jboolean outputFloat =
-        (jboolean)(context->request_sample_fmt == OUTPUT_FORMAT_PCM_FLOAT);
-    return (jlong)createContext(env, codec, extraData, outputFloat,
-                                /* rawSampleRate= */ -1,
-                                /* rawChannelCount= */ -1);
+  // Drop any samples buffered in the resampler, keeping its configuration.
+  if (audioContext->resampleContext &&
+      swr_init(audioContext->resampleContext) < 0) {
+    releaseResampleContext(audioContext);
+  }
+  if (audioContext->hasPendingFrame) {
+    av_frame_unref(audioContext->frame);
+    audioContext->hasPendingFrame = false;
   }
+  audioContext->draining = false;
 
+  AVCodecContext *context = audioContext->codecContext;
   avcodec_flush_buffers(context);
-  return (jlong)context;
+  if (context->codec_id == AV_CODEC_ID_TRUEHD) {
+    // The TrueHD decoder doesn't reset its substream state when flushed, so
+    // decoding has to resume from a major sync, where that state is sent
+    // again, like in a new decoder.
+    audioContext->awaitingMajorSync = true;
+  }
 }
 
 AUDIO_DECODER_FUNC(void, ffmpegRelease, jlong context) {
   if (context) {
-    releaseContext((AVCodecContext *)context);
+    releaseAudioContext((FfmpegAudioContext *)context);
   }
 }
 
@@ -222,7 +542,7 @@ AVCodec *getCodecByName(JNIEnv *env, jstring codecName) {
 
 AVCodecContext *createContext(JNIEnv *env, AVCodec *codec, jbyteArray extraData,
                               jboolean outputFloat, jint rawSampleRate,
-                              jint rawChannelCount) {
+                              jint rawChannelCount, jint threadCount) {
   AVCodecContext *context = avcodec_alloc_context3(codec);
   if (!context) {
     LOGE("Failed to allocate context.");
@@ -249,6 +569,19 @@ AVCodecContext *createContext(JNIEnv *env, AVCodec *codec, jbyteArray extraData,
     context->channel_layout = av_get_default_channel_layout(rawChannelCount);
   }
   context->err_recognition = AV_EF_IGNORE_ERR;
+  int threadType = 0;
+  if (codec->capabilities & AV_CODEC_CAP_FRAME_THREADS) {
+    threadType |= FF_THREAD_FRAME;
+  }
+  if (codec->capabilities & AV_CODEC_CAP_SLICE_THREADS) {
+    threadType |= FF_THREAD_SLICE;
+  }
+  if (threadCount > 1 && threadType) {
+    context->thread_count = threadCount;
+    context->thread_type = threadType;
+  } else {
+    context->thread_count = 1;
+  }
   int result = avcodec_open2(context, codec, NULL);
   if (result < 0) {
     logError("avcodec_open2", result);
@@ -258,86 +591,227 @@ AVCodecContext *createContext(JNIEnv *env, AVCodec *codec, jbyteArray extraData,
   return context;
 }
 
-int decodePacket(AVCodecContext *context, AVPacket *packet,
+FfmpegAudioContext *createAudioContext(JNIEnv *env, AVCodec *codec,
+                                       jbyteArray extraData,
+                                       jboolean outputFloat, jint rawSampleRate,
+                                       jint rawChannelCount, jint threadCount) {
+  FfmpegAudioContext *audioContext =
+      (FfmpegAudioContext *)calloc(1, sizeof(FfmpegAudioContext));
+  if (!audioContext) {
+    LOGE("Failed to allocate audio context.");
+    return NULL;
+  }
+  audioContext->frame = av_frame_alloc();
+  audioContext->packet = av_packet_alloc();
+  if (!audioContext->frame || !audioContext->packet) {
+    LOGE("Failed to allocate frame or packet.");
+    releaseAudioContext(audioContext);
+    return NULL;
+  }
+  audioContext->outputTimeUs = TIME_UNSET;
+  audioContext->codecContext =
+      createContext(env, codec, extraData, outputFloat, rawSampleRate,
+                    rawChannelCount, threadCount);
+  if (!audioContext->codecContext) {
+    releaseAudioContext(audioContext);
+    return NULL;
+  }
+  // Frame threads hold on to packets until they're decoded, after
+  // ffmpegDecode has returned.
+  audioContext->zeroCopyInput =
+      !(audioContext->codecContext->active_thread_type & FF_THREAD_FRAME);
+  return audioContext;
+}
+
+void releaseNothing(void *opaque, uint8_t *data) {
+  // The memory is owned by the Java input buffer.
+}
+
+AVBufferRef *getInputBufferRef(FfmpegAudioContext *audioContext, uint8_t *data,
+                               int capacity) {
+  for (int i = 0; i < MAX_INPUT_BUFFER_REFS; i++) {
+    AVBufferRef *inputBufferRef = audioContext->inputBufferRefs[i];
+    if (inputBufferRef && inputBufferRef->data == data &&
+        inputBufferRef->size == capacity) {
+      return inputBufferRef;
+    }
+  }
+  AVBufferRef *inputBufferRef = av_buffer_create(
+      data, capacity, releaseNothing, NULL, AV_BUFFER_FLAG_READONLY);
+  if (!inputBufferRef) {
+    return NULL;
+  }
+  AVBufferRef **slot =
+      &audioContext->inputBufferRefs[audioContext->nextInputBufferRef];
+  av_buffer_unref(slot);
+  *slot = inputBufferRef;
+  audioContext->nextInputBufferRef =
+      (audioContext->nextInputBufferRef + 1) % MAX_INPUT_BUFFER_REFS;
+  return inputBufferRef;
+}
+
+int decodePacket(FfmpegAudioContext *audioContext, AVPacket *packet,
                  uint8_t *outputBuffer, int outputSize) {
   int result = 0;
   // Queue input data.
-  result = avcodec_send_packet(context, packet);
+  result = avcodec_send_packet(audioContext->codecContext, packet);
   if (result) {
     logError("avcodec_send_packet", result);
     return result == AVERROR_INVALIDDATA ? AUDIO_DECODER_ERROR_INVALID_DATA
                                          : AUDIO_DECODER_ERROR_OTHER;
   }
+  result = receiveFrames(audioContext, outputBuffer, outputSize,
+                         /* maxFrameCount= */ 0);
+  if (result > audioContext->maxPacketOutputSize) {
+    audioContext->maxPacketOutputSize = result;
+  }
+  return result;
+}
+
+int drainFrame(FfmpegAudioContext *audioContext, uint8_t *outputBuffer,
+               int outputSize) {
+  if (!audioContext->draining) {
+    // Signal the end of the stream, so that the decoder outputs the frames it
+    // has held back.
+    int result = avcodec_send_packet(audioContext->codecContext, NULL);
+    if (result) {
+      logError("avcodec_send_packet", result);
+      return AUDIO_DECODER_ERROR_OTHER;
+    }
+    audioContext->draining = true;
+  }
+  // Frames are output one at a time, as the output buffer is only sized for
+  // the output of one packet.
+  return receiveFrames(audioContext, outputBuffer, outputSize,
+                       /* maxFrameCount= */ 1);
+}
+
+bool skipUntilMajorSync(FfmpegAudioContext *audioContext, uint8_t **data,
+                        int *size) {
+  if (!audioContext->awaitingMajorSync) {
+    return true;
+  }
+  int offset = findTrueHdMajorSync(*data, *size);
+  if (offset < 0) {
+    // A new decoder wouldn't output anything before the major sync either.
+    return false;
+  }
+  *data += offset;
+  *size -= offset;
+  audioContext->awaitingMajorSync = false;
+  return true;
+}
+
+int findTrueHdMajorSync(const uint8_t *data, int size) {
+  int offset = 0;
+  // Each access unit starts with its length in 16-bit words, in the low 12
+  // bits of its first two bytes. The major sync follows the 4 byte header.
+  while (offset + 8 <= size) {
+    const uint8_t *accessUnit = data + offset;
+    if (accessUnit[4] == 0xF8 && accessUnit[5] == 0x72 &&
+        accessUnit[6] == 0x6F && (accessUnit[7] & 0xFE) == 0xBA) {
+      return offset;
+    }
+    int accessUnitSize = (((accessUnit[0] & 0x0F) << 8) | accessUnit[1]) * 2;
+    if (accessUnitSize < 4) {
+      break;
+    }
+    offset += accessUnitSize;
+  }
+  return -1;
+}
+
+int receiveFrames(FfmpegAudioContext *audioContext, uint8_t *outputBuffer,
+                  int outputSize, int maxFrameCount) {
+  AVCodecContext *context = audioContext->codecContext;
+  AVFrame *frame = audioContext->frame;
+  int result = 0;
+  audioContext->outputTimeUs = TIME_UNSET;
 
   // Dequeue output data until it runs out.
   int outSize = 0;
-  while (true) {
-    AVFrame *frame = av_frame_alloc();
-    if (!frame) {
-      LOGE("Failed to allocate output frame.");
-      return -1;
-    }
-    result = avcodec_receive_frame(context, frame);
-    if (result) {
-      av_frame_free(&frame);
-      if (result == AVERROR(EAGAIN)) {
-        break;
+  for (int frameCount = 0; maxFrameCount <= 0 || frameCount < maxFrameCount;
+       frameCount++) {
+    if (audioContext->hasPendingFrame) {
+      audioContext->hasPendingFrame = false;
+    } else {
+      result = avcodec_receive_frame(context, frame);
+      if (result) {
+        if (result == AVERROR(EAGAIN) || result == AVERROR_EOF) {
+          break;
+        }
+        logError("avcodec_receive_frame", result);
+        return result == AVERROR_INVALIDDATA ? AUDIO_DECODER_ERROR_INVALID_DATA
+                                             : AUDIO_DECODER_ERROR_OTHER;
       }
-      logError("avcodec_receive_frame", result);
-      return result;
+    }
+    if (frameCount == 0 && frame->pts != AV_NOPTS_VALUE) {
+      audioContext->outputTimeUs = frame->pts;
     }
 
-    // Resample output.
-    AVSampleFormat sampleFormat = context->sample_fmt;
-    int channelCount = context->channels;
-    int channelLayout = context->channel_layout;
-    int sampleRate = context->sample_rate;
-    int sampleCount = frame->nb_samples;
-    int dataSize = av_samples_get_buffer_size(NULL, channelCount, sampleCount,
-                                              sampleFormat, 1);
-    SwrContext *resampleContext;
-    if (context->opaque) {
-      resampleContext = (SwrContext *)context->opaque;
-    } else {
-      resampleContext = swr_alloc();
-      av_opt_set_int(resampleContext, "in_channel_layout", channelLayout, 0);
-      av_opt_set_int(resampleContext, "out_channel_layout", channelLayout, 0);
-      av_opt_set_int(resampleContext, "in_sample_rate", sampleRate, 0);
-      av_opt_set_int(resampleContext, "out_sample_rate", sampleRate, 0);
-      av_opt_set_int(resampleContext, "in_sample_fmt", sampleFormat, 0);
-      // The output format is always the requested format.
-      av_opt_set_int(resampleContext, "out_sample_fmt",
-                     context->request_sample_fmt, 0);
-      result = swr_init(resampleContext);
-      if (result < 0) {
-        logError("swr_init", result);
-        av_frame_free(&frame);
-        return -1;
+    if (!audioContext->outputChannelLayout) {
+      audioContext->outputChannelLayout =
+          frame->channel_layout
+              ? frame->channel_layout
+              : av_get_default_channel_layout(frame->channels);
+      audioContext->outputChannelCount = frame->channels;
+      audioContext->outputSampleRate = frame->sample_rate;
+    }
+    AVSampleFormat outputFormat = context->request_sample_fmt;
+    int channelCount = audioContext->outputChannelCount;
+    // Samples that are already in the output format, or its planar variant,
+    // are copied directly instead of being resampled.
+    bool copy =
+        av_get_packed_sample_fmt((AVSampleFormat)frame->format) ==
+            outputFormat &&
+        frame->channels == channelCount &&
+        (!frame->channel_layout ||
+         frame->channel_layout == audioContext->outputChannelLayout) &&
+        frame->sample_rate == audioContext->outputSampleRate;
+    SwrContext *resampleContext = NULL;
+    if (!copy) {
+      resampleContext = getResampleContext(audioContext, frame);
+      if (!resampleContext) {
+        av_frame_unref(frame);
+        return AUDIO_DECODER_ERROR_OTHER;
       }
-      context->opaque = resampleContext;
     }
-    int inSampleSize = av_get_bytes_per_sample(sampleFormat);
-    int outSampleSize = av_get_bytes_per_sample(context->request_sample_fmt);
-    int outSamples = swr_get_out_samples(resampleContext, sampleCount);
+    int outSampleSize = av_get_bytes_per_sample(outputFormat);
+    int outSamples = copy ? frame->nb_samples
+                          : swr_get_out_samples(resampleContext,
+                                                frame->nb_samples);
     int bufferOutSize = outSampleSize * channelCount * outSamples;
     if (outSize + bufferOutSize > outputSize) {
-      LOGE("Output buffer size (%d) too small for output data (%d).",
-           outputSize, outSize + bufferOutSize);
-      av_frame_free(&frame);
-      return -1;
-    }
-    result = swr_convert(resampleContext, &outputBuffer, bufferOutSize,
-                         (const uint8_t **)frame->data, frame->nb_samples);
-    av_frame_free(&frame);
-    if (result < 0) {
-      logError("swr_convert", result);
-      return result;
+      // Keep the frame instead of dropping its samples. The output of the
+      // packet is at least this large.
+      audioContext->hasPendingFrame = true;
+      if (outSize + bufferOutSize > audioContext->maxPacketOutputSize) {
+        audioContext->maxPacketOutputSize = outSize + bufferOutSize;
+      }
+      break;
     }
-    int available = swr_get_out_samples(resampleContext, 0);
-    if (available != 0) {
-      LOGE("Expected no samples remaining after resampling, but found %d.",
-           available);
-      return -1;
+    if (copy) {
+      copyFrame(frame, outputFormat, channelCount, outputBuffer);
+      av_frame_unref(frame);
+    } else {
+      result = swr_convert(resampleContext, &outputBuffer, outSamples,
+                           (const uint8_t **)frame->extended_data,
+                           frame->nb_samples);
+      av_frame_unref(frame);
+      if (result < 0) {
+        logError("swr_convert", result);
+        return AUDIO_DECODER_ERROR_OTHER;
+      }
+      // Converting the sample rate delays some samples until the next frame,
+      // but the other conversions are expected to output everything.
+      int available = swr_get_out_samples(resampleContext, 0);
+      if (available != 0 &&
+          audioContext->resampleSampleRate == audioContext->outputSampleRate) {
+        LOGE("Expected no samples remaining after resampling, but found %d.",
+             available);
+        return AUDIO_DECODER_ERROR_OTHER;
+      }
+      bufferOutSize = outSampleSize * channelCount * result;
     }
     outputBuffer += bufferOutSize;
     outSize += bufferOutSize;
@@ -345,21 +819,166 @@ int decodePacket(AVCodecContext *context, AVPacket *packet,
   return outSize;
 }
 
+int dropPendingFrame(FfmpegAudioContext *audioContext, int outputSize,
+                     int result) {
+  if (!audioContext->hasPendingFrame) {
+    return result;
+  }
+  LOGE("Output buffer size (%d) too small for the output of a packet.",
+       outputSize);
+  av_frame_unref(audioContext->frame);
+  audioContext->hasPendingFrame = false;
+  return AUDIO_DECODER_ERROR_BUFFER_TOO_SMALL;
+}
+
+SwrContext *getResampleContext(FfmpegAudioContext *audioContext,
+                               const AVFrame *frame) {
+  AVSampleFormat sampleFormat = (AVSampleFormat)frame->format;
+  uint64_t channelLayout = frame->channel_layout
+                               ? frame->channel_layout
+                               : av_get_default_channel_layout(frame->channels);
+  int sampleRate = frame->sample_rate;
+  if (audioContext->resampleContext &&
+      audioContext->resampleSampleFormat == sampleFormat &&
+      audioContext->resampleChannelLayout == channelLayout &&
+      audioContext->resampleSampleRate == sampleRate) {
+    return audioContext->resampleContext;
+  }
+  releaseResampleContext(audioContext);
+  SwrContext *resampleContext = swr_alloc();
+  if (!resampleContext) {
+    LOGE("Failed to allocate resampler.");
+    return NULL;
+  }
+  av_opt_set_int(resampleContext, "in_channel_layout", channelLayout, 0);
+  av_opt_set_int(resampleContext, "out_channel_layout",
+                 audioContext->outputChannelLayout, 0);
+  av_opt_set_int(resampleContext, "in_sample_rate", sampleRate, 0);
+  av_opt_set_int(resampleContext, "out_sample_rate",
+                 audioContext->outputSampleRate, 0);
+  av_opt_set_int(resampleContext, "in_sample_fmt", sampleFormat, 0);
+  // The output format is always the requested format.
+  av_opt_set_int(resampleContext, "out_sample_fmt",
+                 audioContext->codecContext->request_sample_fmt, 0);
+  int result = swr_init(resampleContext);
+  if (result < 0) {
+    logError("swr_init", result);
+    swr_free(&resampleContext);
+    return NULL;
+  }
+  audioContext->resampleContext = resampleContext;
+  audioContext->resampleSampleFormat = sampleFormat;
+  audioContext->resampleChannelLayout = channelLayout;
+  audioContext->resampleSampleRate = sampleRate;
+  return resampleContext;
+}
+
+void interleaveStereo(const float *left, const float *right, int sampleCount,
+                      float *output) {
+  int i = 0;
+#if defined(INTERLEAVE_NEON)
+  for (; i + 4 <= sampleCount; i += 4) {
+    float32x4x2_t samples;
+    samples.val[0] = vld1q_f32(left + i);
+    samples.val[1] = vld1q_f32(right + i);
+    vst2q_f32(output + 2 * i, samples);
+  }
+#elif defined(INTERLEAVE_SSE2)
+  for (; i + 4 <= sampleCount; i += 4) {
+    __m128 leftSamples = _mm_loadu_ps(left + i);
+    __m128 rightSamples = _mm_loadu_ps(right + i);
+    _mm_storeu_ps(output + 2 * i, _mm_unpacklo_ps(leftSamples, rightSamples));
+    _mm_storeu_ps(output + 2 * i + 4,
+                  _mm_unpackhi_ps(leftSamples, rightSamples));
+  }
+#endif
+  for (; i < sampleCount; i++) {
+    output[2 * i] = left[i];
+    output[2 * i + 1] = right[i];
+  }
+}
+
+void interleaveStereo(const int16_t *left, const int16_t *right,
+                      int sampleCount, int16_t *output) {
+  int i = 0;
+#if defined(INTERLEAVE_NEON)
+  for (; i + 8 <= sampleCount; i += 8) {
+    int16x8x2_t samples;
+    samples.val[0] = vld1q_s16(left + i);
+    samples.val[1] = vld1q_s16(right + i);
+    vst2q_s16(output + 2 * i, samples);
+  }
+#elif defined(INTERLEAVE_SSE2)
+  for (; i + 8 <= sampleCount; i += 8) {
+    __m128i leftSamples = _mm_loadu_si128((const __m128i *)(left + i));
+    __m128i rightSamples = _mm_loadu_si128((const __m128i *)(right + i));
+    _mm_storeu_si128((__m128i *)(output + 2 * i),
+                     _mm_unpacklo_epi16(leftSamples, rightSamples));
+    _mm_storeu_si128((__m128i *)(output + 2 * i + 8),
+                     _mm_unpackhi_epi16(leftSamples, rightSamples));
+  }
+#endif
+  for (; i < sampleCount; i++) {
+    output[2 * i] = left[i];
+    output[2 * i + 1] = right[i];
+  }
+}
+
+template <typename T>
+void interleave(const AVFrame *frame, int channelCount, T *output) {
+  const T **planes = (const T **)frame->extended_data;
+  int sampleCount = frame->nb_samples;
+  if (channelCount == 2) {
+    interleaveStereo(planes[0], planes[1], sampleCount, output);
+    return;
+  }
+  for (int i = 0; i < sampleCount; i++) {
+    for (int channel = 0; channel < channelCount; channel++) {
+      *output++ = planes[channel][i];
+    }
+  }
+}
+
+void copyFrame(const AVFrame *frame, AVSampleFormat outputFormat,
+               int channelCount, uint8_t *outputBuffer) {
+  if (frame->format == outputFormat) {
+    memcpy(outputBuffer, frame->data[0],
+           frame->nb_samples * channelCount *
+               av_get_bytes_per_sample(outputFormat));
+  } else if (outputFormat == OUTPUT_FORMAT_PCM_FLOAT) {
+    interleave(frame, channelCount, (float *)outputBuffer);
+  } else {
+    interleave(frame, channelCount, (int16_t *)outputBuffer);
+  }
+}
+
 void logError(const char *functionName, int errorNumber) {
-  char *buffer = (char *)malloc(ERROR_STRING_BUFFER_LENGTH * sizeof(char));
+  char buffer[ERROR_STRING_BUFFER_LENGTH];
   av_strerror(errorNumber, buffer, ERROR_STRING_BUFFER_LENGTH);
   LOGE("Error in %s: %s", functionName, buffer);
-  free(buffer);
 }
 
 void releaseContext(AVCodecContext *context) {
   if (!context) {
     return;
   }
-  SwrContext *swrContext;
-  if ((swrContext = (SwrContext *)context->opaque)) {
-    swr_free(&swrContext);
-    context->opaque = NULL;
-  }
   avcodec_free_context(&context);
 }
+
+void releaseAudioContext(FfmpegAudioContext *audioContext) {
+  if (!audioContext) {
+    return;
+  }
+  releaseResampleContext(audioContext);
+  releaseContext(audioContext->codecContext);
+  for (int i = 0; i < MAX_INPUT_BUFFER_REFS; i++) {
+    av_buffer_unref(&audioContext->inputBufferRefs[i]);
+  }
+  av_packet_free(&audioContext->packet);
+  av_frame_free(&audioContext->frame);
+  free(audioContext);
+}
+
+void releaseResampleContext(FfmpegAudioContext *audioContext) {
+  swr_free(&audioContext->resampleContext);
+}
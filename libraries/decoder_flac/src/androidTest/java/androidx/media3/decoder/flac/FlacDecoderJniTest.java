@@ -0,0 +1,130 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package androidx.media3.decoder.flac;
+
+import static com.google.common.truth.Truth.assertThat;
+import static org.junit.Assert.fail;
+
+import androidx.media3.common.C;
+import androidx.media3.common.Format;
+import androidx.media3.extractor.FlacStreamMetadata;
+import androidx.media3.test.utils.TestUtil;
+import androidx.test.core.app.ApplicationProvider;
+import androidx.test.ext.junit.runners.AndroidJUnit4;
+import java.io.ByteArrayOutputStream;
+import java.nio.ByteBuffer;
+import java.util.ArrayList;
+import java.util.List;
+import org.junit.Before;
+import org.junit.Test;
+import org.junit.runner.RunWith;
+
+/** Tests for {@link FlacDecoderJni}. */
+@RunWith(AndroidJUnit4.class)
+public final class FlacDecoderJniTest {
+
+  private static final String BEAR_PATH = "media/flac/bear.flac";
+
+  private byte[] fileData;
+
+  @Before
+  public void setUp() throws Exception {
+    if (!FlacLibrary.isAvailable()) {
+      fail("Flac library not available.");
+    }
+    fileData = TestUtil.getByteArray(ApplicationProvider.getApplicationContext(), BEAR_PATH);
+  }
+
+  @Test
+  public void decodeSamples_directBuffer_outputsSameFramesAsDecodeSample() throws Exception {
+    assertDecodeSamplesMatchesDecodeSample(
+        Format.NO_VALUE, /* downmixToStereo= */ false, /* directOutput= */ true);
+  }
+
+  @Test
+  public void decodeSamples_heapBuffer_outputsSameFramesAsDecodeSample() throws Exception {
+    assertDecodeSamplesMatchesDecodeSample(
+        Format.NO_VALUE, /* downmixToStereo= */ false, /* directOutput= */ false);
+  }
+
+  @Test
+  public void decodeSamples_floatOutput_outputsSameFramesAsDecodeSample() throws Exception {
+    assertDecodeSamplesMatchesDecodeSample(
+        C.ENCODING_PCM_FLOAT, /* downmixToStereo= */ true, /* directOutput= */ true);
+  }
+
+  private void assertDecodeSamplesMatchesDecodeSample(
+      @C.PcmEncoding int outputPcmEncoding, boolean downmixToStereo, boolean directOutput)
+      throws Exception {
+    List<Long> expectedFrameFirstSampleIndices = new ArrayList<>();
+    ByteArrayOutputStream expectedOutput = new ByteArrayOutputStream();
+    FlacDecoderJni decoderJni = createDecoderJni(outputPcmEncoding, downmixToStereo);
+    FlacStreamMetadata streamMetadata = decoderJni.decodeStreamMetadata();
+    int maxFrameSize =
+        streamMetadata.maxBlockSizeSamples * decoderJni.getOutputPcmFrameSize(streamMetadata);
+    ByteBuffer frame = ByteBuffer.allocateDirect(maxFrameSize);
+    while (true) {
+      decoderJni.decodeSample(frame);
+      if (frame.limit() == 0) {
+        break;
+      }
+      expectedFrameFirstSampleIndices.add(decoderJni.getLastFrameFirstSampleIndex());
+      expectedOutput.write(getBytes(frame));
+    }
+    decoderJni.release();
+
+    List<Long> frameFirstSampleIndices = new ArrayList<>();
+    ByteArrayOutputStream output = new ByteArrayOutputStream();
+    decoderJni = createDecoderJni(outputPcmEncoding, downmixToStereo);
+    decoderJni.decodeStreamMetadata();
+    // The buffer holds 3 frames and the array 4, so that both limit the frames per call.
+    int bufferSize = 3 * maxFrameSize + maxFrameSize / 2;
+    ByteBuffer frames =
+        directOutput ? ByteBuffer.allocateDirect(bufferSize) : ByteBuffer.allocate(bufferSize);
+    long[] batchFrameFirstSampleIndices = new long[5];
+    int frameCount;
+    long nextFrameFirstSampleIndex = 0;
+    while ((frameCount = decoderJni.decodeSamples(frames, batchFrameFirstSampleIndices)) > 0) {
+      assertThat(frameCount).isAtMost(4);
+      assertThat(batchFrameFirstSampleIndices[0]).isEqualTo(nextFrameFirstSampleIndex);
+      nextFrameFirstSampleIndex = batchFrameFirstSampleIndices[frameCount];
+      for (int i = 0; i < frameCount; i++) {
+        frameFirstSampleIndices.add(batchFrameFirstSampleIndices[i]);
+      }
+      assertThat(nextFrameFirstSampleIndex).isEqualTo(decoderJni.getNextFrameFirstSampleIndex());
+      output.write(getBytes(frames));
+    }
+    decoderJni.release();
+
+    assertThat(expectedFrameFirstSampleIndices.size()).isGreaterThan(4);
+    assertThat(frameFirstSampleIndices).isEqualTo(expectedFrameFirstSampleIndices);
+    assertThat(output.toByteArray()).isEqualTo(expectedOutput.toByteArray());
+  }
+
+  private FlacDecoderJni createDecoderJni(
+      @C.PcmEncoding int outputPcmEncoding, boolean downmixToStereo) throws Exception {
+    FlacDecoderJni decoderJni = new FlacDecoderJni();
+    decoderJni.setOutputMode(outputPcmEncoding, downmixToStereo);
+    decoderJni.setData(ByteBuffer.wrap(fileData));
+    return decoderJni;
+  }
+
+  private static byte[] getBytes(ByteBuffer buffer) {
+    byte[] bytes = new byte[buffer.remaining()];
+    buffer.duplicate().get(bytes);
+    return bytes;
+  }
+}
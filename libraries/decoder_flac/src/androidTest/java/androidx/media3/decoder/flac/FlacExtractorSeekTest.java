@@ -17,16 +17,21 @@ package androidx.media3.decoder.flac;
 
 import static com.google.common.truth.Truth.assertThat;
 
+import android.content.Context;
 import android.net.Uri;
+import android.os.ParcelFileDescriptor;
 import androidx.media3.common.C;
 import androidx.media3.common.util.Util;
 import androidx.media3.datasource.DefaultDataSource;
+import androidx.media3.extractor.BinarySearchSeeker;
 import androidx.media3.extractor.SeekMap;
 import androidx.media3.test.utils.FakeExtractorOutput;
 import androidx.media3.test.utils.FakeTrackOutput;
 import androidx.media3.test.utils.TestUtil;
 import androidx.test.core.app.ApplicationProvider;
 import androidx.test.ext.junit.runners.AndroidJUnit4;
+import java.io.File;
+import java.io.FileOutputStream;
 import java.io.IOException;
 import java.util.List;
 import org.junit.Test;
@@ -224,6 +229,31 @@ public final class FlacExtractorSeekTest {
     assertThat(seekMap.isSeekable()).isFalse();
   }
 
+  @Test
+  public void seeking_builtSeekIndex_usesIndexAsSeekTable() throws IOException {
+    String fileName = TEST_FILE_BINARY_SEARCH;
+    byte[] seekIndex;
+    try (ParcelFileDescriptor fileDescriptor = openAsset(fileName)) {
+      seekIndex =
+          FlacExtractor.experimentalBuildSeekIndex(
+              fileDescriptor, /* offset= */ 0, C.LENGTH_UNSET);
+    }
+    extractor.experimentalSetSeekIndex(seekIndex);
+    Uri fileUri = TestUtil.buildAssetUri(fileName);
+    SeekMap seekMap = TestUtil.extractSeekMap(extractor, extractorOutput, dataSource, fileUri);
+    FakeTrackOutput trackOutput = extractorOutput.trackOutputs.get(0);
+
+    long targetSeekTimeUs = 1_234_000;
+    int extractedFrameIndex =
+        TestUtil.seekToTimeUs(
+            extractor, seekMap, targetSeekTimeUs, dataSource, trackOutput, fileUri);
+
+    assertThat(seekMap).isNotInstanceOf(BinarySearchSeeker.BinarySearchSeekMap.class);
+    assertThat(extractedFrameIndex).isNotEqualTo(C.INDEX_UNSET);
+    assertFirstFrameAfterSeekPrecedesTargetSeekTime(
+        fileName, trackOutput, targetSeekTimeUs, extractedFrameIndex);
+  }
+
   private static void assertFirstFrameAfterSeekContainsTargetSeekTime(
       String fileName,
       FakeTrackOutput trackOutput,
@@ -282,4 +312,13 @@ public final class FlacExtractorSeekTest {
     return Util.binarySearchFloor(
         frameTimes, targetSeekTimeUs, /* inclusive= */ true, /* stayInBounds= */ false);
   }
+
+  private static ParcelFileDescriptor openAsset(String path) throws IOException {
+    Context context = ApplicationProvider.getApplicationContext();
+    File file = new File(context.getCacheDir(), new File(path).getName());
+    try (FileOutputStream outputStream = new FileOutputStream(file)) {
+      outputStream.write(TestUtil.getByteArray(context, path));
+    }
+    return ParcelFileDescriptor.open(file, ParcelFileDescriptor.MODE_READ_ONLY);
+  }
 }
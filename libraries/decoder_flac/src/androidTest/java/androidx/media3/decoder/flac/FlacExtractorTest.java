@@ -15,10 +15,19 @@
  */
 package androidx.media3.decoder.flac;
 
+import static com.google.common.truth.Truth.assertThat;
 import static org.junit.Assert.fail;
 
+import android.content.Context;
+import android.os.ParcelFileDescriptor;
+import androidx.media3.extractor.FlacStreamMetadata;
 import androidx.media3.test.utils.ExtractorAsserts;
+import androidx.media3.test.utils.TestUtil;
+import androidx.test.core.app.ApplicationProvider;
 import androidx.test.ext.junit.runners.AndroidJUnit4;
+import java.io.File;
+import java.io.FileOutputStream;
+import java.nio.ByteBuffer;
 import org.junit.Before;
 import org.junit.Test;
 import org.junit.runner.RunWith;
@@ -115,4 +124,41 @@ public class FlacExtractorTest {
         /* file= */ "media/flac/bear_uncommon_sample_rate.flac",
         /* dumpFilesPrefix= */ "extractordumps/flac/bear_uncommon_sample_rate_raw");
   }
+
+  @Test
+  public void readStreamMetadata_fromFileRegion_matchesMetadataReadFromJava() throws Exception {
+    Context context = ApplicationProvider.getApplicationContext();
+    byte[] data = TestUtil.getByteArray(context, "media/flac/bear_with_vorbis_comments.flac");
+    FlacDecoderJni decoderJni = new FlacDecoderJni();
+    FlacStreamMetadata expectedStreamMetadata;
+    try {
+      decoderJni.setData(ByteBuffer.wrap(data));
+      expectedStreamMetadata = decoderJni.decodeStreamMetadata();
+    } finally {
+      decoderJni.release();
+    }
+    // Surround the stream with other data, like in an AssetFileDescriptor.
+    int offset = 1000;
+    File file = new File(context.getCacheDir(), "bear_with_vorbis_comments_region");
+    try (FileOutputStream outputStream = new FileOutputStream(file)) {
+      outputStream.write(new byte[offset]);
+      outputStream.write(data);
+      outputStream.write(new byte[offset]);
+    }
+
+    FlacStreamMetadata streamMetadata;
+    try (ParcelFileDescriptor fileDescriptor =
+        ParcelFileDescriptor.open(file, ParcelFileDescriptor.MODE_READ_ONLY)) {
+      streamMetadata =
+          FlacExtractor.experimentalReadStreamMetadata(fileDescriptor, offset, data.length);
+    }
+
+    assertThat(streamMetadata.sampleRate).isEqualTo(expectedStreamMetadata.sampleRate);
+    assertThat(streamMetadata.channels).isEqualTo(expectedStreamMetadata.channels);
+    assertThat(streamMetadata.bitsPerSample).isEqualTo(expectedStreamMetadata.bitsPerSample);
+    assertThat(streamMetadata.totalSamples).isEqualTo(expectedStreamMetadata.totalSamples);
+    assertThat(streamMetadata.getMetadataCopyWithAppendedEntriesFrom(/* other= */ null))
+        .isEqualTo(
+            expectedStreamMetadata.getMetadataCopyWithAppendedEntriesFrom(/* other= */ null));
+  }
 }
@@ -0,0 +1,130 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package androidx.media3.decoder.flac;
+
+import static androidx.media3.common.util.Assertions.checkNotNull;
+import static com.google.common.truth.Truth.assertThat;
+import static org.junit.Assert.fail;
+
+import android.content.Context;
+import android.os.ParcelFileDescriptor;
+import androidx.media3.common.C;
+import androidx.media3.common.Metadata;
+import androidx.media3.extractor.metadata.flac.PictureFrame;
+import androidx.media3.extractor.metadata.vorbis.VorbisComment;
+import androidx.media3.test.utils.TestUtil;
+import androidx.test.core.app.ApplicationProvider;
+import androidx.test.ext.junit.runners.AndroidJUnit4;
+import java.io.File;
+import java.io.FileOutputStream;
+import java.io.IOException;
+import org.junit.Before;
+import org.junit.Test;
+import org.junit.runner.RunWith;
+
+/** Unit test for {@link FlacMetadataProbe}. */
+@RunWith(AndroidJUnit4.class)
+public class FlacMetadataProbeTest {
+
+  @Before
+  public void setUp() {
+    if (!FlacLibrary.isAvailable()) {
+      fail("Flac library not available.");
+    }
+  }
+
+  @Test
+  public void probe_readsStreamInfo() throws Exception {
+    try (ParcelFileDescriptor fileDescriptor = openAsset("media/flac/bear.flac")) {
+      FlacMetadataProbe probe =
+          FlacMetadataProbe.probe(
+              fileDescriptor, /* offset= */ 0, C.LENGTH_UNSET, /* vorbisCommentKeys= */ null);
+
+      assertThat(probe.streamMetadata.sampleRate).isEqualTo(48000);
+      assertThat(probe.streamMetadata.channels).isEqualTo(2);
+      assertThat(probe.streamMetadata.bitsPerSample).isEqualTo(16);
+      assertThat(probe.streamMetadata.totalSamples).isEqualTo(131568);
+      assertThat(probe.firstFramePosition).isEqualTo(8880);
+      assertThat(probe.pictures).isEmpty();
+    }
+  }
+
+  @Test
+  public void probe_withId3Tag_skipsTag() throws Exception {
+    try (ParcelFileDescriptor fileDescriptor = openAsset("media/flac/bear_with_id3.flac")) {
+      FlacMetadataProbe probe =
+          FlacMetadataProbe.probe(
+              fileDescriptor, /* offset= */ 0, C.LENGTH_UNSET, /* vorbisCommentKeys= */ null);
+
+      assertThat(probe.streamMetadata.totalSamples).isEqualTo(131568);
+    }
+  }
+
+  @Test
+  public void probe_withVorbisCommentKeys_returnsMatchingComments() throws Exception {
+    try (ParcelFileDescriptor fileDescriptor =
+        openAsset("media/flac/bear_with_vorbis_comments.flac")) {
+      FlacMetadataProbe probe =
+          FlacMetadataProbe.probe(
+              fileDescriptor, /* offset= */ 0, C.LENGTH_UNSET, new String[] {"title"});
+
+      Metadata metadata =
+          checkNotNull(
+              probe.streamMetadata.getMetadataCopyWithAppendedEntriesFrom(/* other= */ null));
+      assertThat(metadata.length()).isEqualTo(1);
+      assertThat(metadata.get(0)).isEqualTo(new VorbisComment("TITLE", "test title"));
+    }
+  }
+
+  @Test
+  public void readPicture_readsPictureData() throws Exception {
+    try (ParcelFileDescriptor fileDescriptor = openAsset("media/flac/bear_with_picture.flac")) {
+      FlacMetadataProbe probe =
+          FlacMetadataProbe.probe(
+              fileDescriptor, /* offset= */ 0, C.LENGTH_UNSET, /* vorbisCommentKeys= */ null);
+
+      assertThat(probe.pictures).hasSize(1);
+      FlacMetadataProbe.Picture picture = probe.pictures.get(0);
+      assertThat(picture.mimeType).isEqualTo("image/png");
+      assertThat(picture.width).isEqualTo(371);
+      assertThat(picture.height).isEqualTo(320);
+      assertThat(picture.dataLength).isEqualTo(30943);
+      PictureFrame pictureFrame = probe.readPicture(fileDescriptor, picture);
+      assertThat(pictureFrame.pictureData).hasLength(30943);
+      assertThat(pictureFrame.pictureData[1]).isEqualTo((byte) 'P');
+    }
+  }
+
+  @Test
+  public void probe_notFlac_throws() throws Exception {
+    try (ParcelFileDescriptor fileDescriptor = openAsset("media/mp3/bear-id3.mp3")) {
+      FlacMetadataProbe.probe(
+          fileDescriptor, /* offset= */ 0, C.LENGTH_UNSET, /* vorbisCommentKeys= */ null);
+      fail();
+    } catch (IOException e) {
+      // Expected.
+    }
+  }
+
+  private static ParcelFileDescriptor openAsset(String path) throws IOException {
+    Context context = ApplicationProvider.getApplicationContext();
+    File file = new File(context.getCacheDir(), new File(path).getName());
+    try (FileOutputStream outputStream = new FileOutputStream(file)) {
+      outputStream.write(TestUtil.getByteArray(context, path));
+    }
+    return ParcelFileDescriptor.open(file, ParcelFileDescriptor.MODE_READ_ONLY);
+  }
+}
@@ -16,7 +16,10 @@
 package androidx.media3.decoder.flac;
 
 import static java.lang.Math.max;
+import static java.lang.Math.min;
 
+import androidx.annotation.Nullable;
+import androidx.media3.common.C;
 import androidx.media3.common.util.Assertions;
 import androidx.media3.extractor.BinarySearchSeeker;
 import androidx.media3.extractor.ExtractorInput;
@@ -51,6 +54,9 @@ import java.nio.ByteBuffer;
 
   private static final int MIN_FRAME_HEADER_SIZE = 6;
 
+  private final FlacStreamMetadata streamMetadata;
+  private final long firstFramePosition;
+  private final long inputLength;
   private final FlacDecoderJni decoderJni;
 
   /**
@@ -78,9 +84,32 @@ import java.nio.ByteBuffer;
         /* ceilingBytePosition= */ inputLength,
         /* approxBytesPerFrame= */ streamMetadata.getApproxBytesPerFrame(),
         /* minimumSearchRange= */ max(MIN_FRAME_HEADER_SIZE, streamMetadata.minFrameSize));
+    this.streamMetadata = streamMetadata;
+    this.firstFramePosition = firstFramePosition;
+    this.inputLength = inputLength;
     this.decoderJni = Assertions.checkNotNull(decoderJni);
   }
 
+  @Override
+  protected SeekOperationParams createSeekParamsForTargetTimeUs(long timeUs) {
+    long targetSampleNumber = streamMetadata.getSampleNumber(timeUs);
+    @Nullable long[] bounds = decoderJni.getSeekIndexBounds(targetSampleNumber);
+    if (bounds == null) {
+      return super.createSeekParamsForTargetTimeUs(timeUs);
+    }
+    // Start from the frames indexed around the target, which are usually much closer than the
+    // start and end of the stream.
+    boolean hasCeiling = bounds[2] != C.INDEX_UNSET;
+    return new SeekOperationParams(
+        timeUs,
+        targetSampleNumber,
+        /* floorTimePosition= */ bounds[0],
+        /* ceilingTimePosition= */ hasCeiling ? bounds[2] : streamMetadata.totalSamples,
+        /* floorBytePosition= */ max(firstFramePosition, bounds[1]),
+        /* ceilingBytePosition= */ hasCeiling ? min(inputLength, bounds[3]) : inputLength,
+        streamMetadata.getApproxBytesPerFrame()) {};
+  }
+
   @Override
   protected void onSeekOperationFinished(boolean foundTargetFrame, long resultPosition) {
     if (!foundTargetFrame) {
@@ -19,6 +19,7 @@ import static androidx.annotation.VisibleForTesting.PACKAGE_PRIVATE;
 
 import androidx.annotation.Nullable;
 import androidx.annotation.VisibleForTesting;
+import androidx.media3.common.C;
 import androidx.media3.common.Format;
 import androidx.media3.common.ParserException;
 import androidx.media3.common.util.UnstableApi;
@@ -39,6 +40,9 @@ public final class FlacDecoder
 
   private final FlacStreamMetadata streamMetadata;
   private final FlacDecoderJni decoderJni;
+  private final @C.PcmEncoding int outputPcmEncoding;
+  private final int outputChannelCount;
+  private final int maxOutputFrameSize;
 
   /**
    * Creates a Flac decoder.
@@ -57,11 +61,44 @@ public final class FlacDecoder
       int maxInputBufferSize,
       List<byte[]> initializationData)
       throws FlacDecoderException {
+    this(
+        numInputBuffers,
+        numOutputBuffers,
+        maxInputBufferSize,
+        initializationData,
+        /* outputPcmEncoding= */ Format.NO_VALUE,
+        /* downmixToStereo= */ false);
+  }
+
+  /**
+   * Creates a Flac decoder.
+   *
+   * @param numInputBuffers The number of input buffers.
+   * @param numOutputBuffers The number of output buffers.
+   * @param maxInputBufferSize The maximum required input buffer size if known, or {@link
+   *     Format#NO_VALUE} otherwise.
+   * @param initializationData Codec-specific initialization data. It should contain only one entry
+   *     which is the flac file header.
+   * @param outputPcmEncoding {@link C#ENCODING_PCM_FLOAT} to output float samples, {@link
+   *     C#ENCODING_PCM_16BIT} to output 16-bit samples, with dither if the stream has a higher bit
+   *     depth, or {@link Format#NO_VALUE} to output samples with the bit depth of the stream.
+   * @param downmixToStereo Whether to downmix streams with more than two channels to stereo.
+   * @throws FlacDecoderException Thrown if an exception occurs when initializing the decoder.
+   */
+  public FlacDecoder(
+      int numInputBuffers,
+      int numOutputBuffers,
+      int maxInputBufferSize,
+      List<byte[]> initializationData,
+      @C.PcmEncoding int outputPcmEncoding,
+      boolean downmixToStereo)
+      throws FlacDecoderException {
     super(new DecoderInputBuffer[numInputBuffers], new SimpleDecoderOutputBuffer[numOutputBuffers]);
     if (initializationData.size() != 1) {
       throw new FlacDecoderException("Initialization data must be of length 1");
     }
     decoderJni = new FlacDecoderJni();
+    decoderJni.setOutputMode(outputPcmEncoding, downmixToStereo);
     decoderJni.setData(ByteBuffer.wrap(initializationData.get(0)));
     try {
       streamMetadata = decoderJni.decodeStreamMetadata();
@@ -72,6 +109,13 @@ public final class FlacDecoder
       throw new IllegalStateException(e);
     }
 
+    this.outputPcmEncoding =
+        FlacDecoderJni.getOutputPcmEncoding(outputPcmEncoding, streamMetadata.bitsPerSample);
+    outputChannelCount =
+        FlacDecoderJni.getOutputChannelCount(downmixToStereo, streamMetadata.channels);
+    maxOutputFrameSize =
+        streamMetadata.maxBlockSizeSamples * decoderJni.getOutputPcmFrameSize(streamMetadata);
+
     int initialInputBufferSize =
         maxInputBufferSize != Format.NO_VALUE ? maxInputBufferSize : streamMetadata.maxFrameSize;
     setInitialInputBufferSize(initialInputBufferSize);
@@ -106,7 +150,7 @@ public final class FlacDecoder
     }
     decoderJni.setData(Util.castNonNull(inputBuffer.data));
     ByteBuffer outputData =
-        outputBuffer.init(inputBuffer.timeUs, streamMetadata.getMaxDecodedFrameSize());
+        outputBuffer.init(inputBuffer.timeUs, maxOutputFrameSize);
     try {
       decoderJni.decodeSample(outputData);
     } catch (FlacDecoderJni.FlacFrameDecodeException e) {
@@ -128,4 +172,14 @@ public final class FlacDecoder
   public FlacStreamMetadata getStreamMetadata() {
     return streamMetadata;
   }
+
+  /** Returns the encoding of the decoded samples. */
+  public @C.PcmEncoding int getOutputPcmEncoding() {
+    return outputPcmEncoding;
+  }
+
+  /** Returns the number of channels of the decoded samples. */
+  public int getOutputChannelCount() {
+    return outputChannelCount;
+  }
 }
@@ -17,9 +17,12 @@ package androidx.media3.decoder.flac;
 
 import static java.lang.Math.min;
 
+import android.os.ParcelFileDescriptor;
 import androidx.annotation.Nullable;
 import androidx.media3.common.C;
+import androidx.media3.common.Format;
 import androidx.media3.common.ParserException;
+import androidx.media3.common.util.Assertions;
 import androidx.media3.common.util.Util;
 import androidx.media3.extractor.ExtractorInput;
 import androidx.media3.extractor.FlacStreamMetadata;
@@ -44,12 +47,21 @@ import java.nio.ByteBuffer;
 
   private static final int TEMP_BUFFER_SIZE = 8192; // The same buffer size as libflac.
 
+  // Output encodings, matching PcmOutputEncoding in the native code.
+  private static final int NATIVE_OUTPUT_ENCODING_SOURCE = 0;
+  private static final int NATIVE_OUTPUT_ENCODING_FLOAT = 1;
+  private static final int NATIVE_OUTPUT_ENCODING_16BIT = 2;
+
   private final long nativeDecoderContext;
 
   @Nullable private ByteBuffer byteBufferData;
   @Nullable private ExtractorInput extractorInput;
   @Nullable private byte[] tempBuffer;
   private boolean endOfExtractorInput;
+  private boolean fileDescriptorSet;
+  private @C.PcmEncoding int outputPcmEncoding;
+  private boolean downmixToStereo;
+  @Nullable private FlacStreamMetadata streamMetadata;
 
   public FlacDecoderJni() throws FlacDecoderException {
     if (!FlacLibrary.isAvailable()) {
@@ -59,6 +71,63 @@ import java.nio.ByteBuffer;
     if (nativeDecoderContext == 0) {
       throw new FlacDecoderException("Failed to initialize decoder");
     }
+    outputPcmEncoding = Format.NO_VALUE;
+  }
+
+  /**
+   * Returns the encoding of the decoded samples.
+   *
+   * @param outputPcmEncoding The output encoding passed to {@link #setOutputMode}.
+   * @param bitsPerSample The bit depth of the stream.
+   */
+  public static @C.PcmEncoding int getOutputPcmEncoding(
+      @C.PcmEncoding int outputPcmEncoding, int bitsPerSample) {
+    return outputPcmEncoding == Format.NO_VALUE
+        ? Util.getPcmEncoding(bitsPerSample)
+        : outputPcmEncoding;
+  }
+
+  /**
+   * Returns the number of channels of the decoded samples.
+   *
+   * @param downmixToStereo Whether downmixing is passed to {@link #setOutputMode}.
+   * @param channelCount The number of channels of the stream.
+   */
+  public static int getOutputChannelCount(boolean downmixToStereo, int channelCount) {
+    return downmixToStereo ? min(channelCount, 2) : channelCount;
+  }
+
+  /**
+   * Sets the format of the decoded samples, which are converted while they're interleaved.
+   * Defaults to integer samples with the bit depth and channel count of the stream.
+   *
+   * @param outputPcmEncoding {@link C#ENCODING_PCM_FLOAT}, {@link C#ENCODING_PCM_16BIT} for 16-bit
+   *     samples with triangular dither if the stream has a higher bit depth, or {@link
+   *     Format#NO_VALUE} for the bit depth of the stream.
+   * @param downmixToStereo Whether to downmix streams with more than two channels to stereo.
+   * @throws FlacDecoderException If the stream can't be decoded in this format.
+   */
+  public void setOutputMode(@C.PcmEncoding int outputPcmEncoding, boolean downmixToStereo)
+      throws FlacDecoderException {
+    int nativeEncoding;
+    switch (outputPcmEncoding) {
+      case Format.NO_VALUE:
+        nativeEncoding = NATIVE_OUTPUT_ENCODING_SOURCE;
+        break;
+      case C.ENCODING_PCM_FLOAT:
+        nativeEncoding = NATIVE_OUTPUT_ENCODING_FLOAT;
+        break;
+      case C.ENCODING_PCM_16BIT:
+        nativeEncoding = NATIVE_OUTPUT_ENCODING_16BIT;
+        break;
+      default:
+        throw new IllegalArgumentException("Unsupported output encoding: " + outputPcmEncoding);
+    }
+    if (!flacSetOutputMode(nativeDecoderContext, nativeEncoding, downmixToStereo)) {
+      throw new FlacDecoderException("Unsupported output mode");
+    }
+    this.outputPcmEncoding = outputPcmEncoding;
+    this.downmixToStereo = downmixToStereo;
   }
 
   /**
@@ -67,6 +136,7 @@ import java.nio.ByteBuffer;
    * @param byteBufferData Source {@link ByteBuffer}.
    */
   public void setData(ByteBuffer byteBufferData) {
+    clearFileDescriptor();
     this.byteBufferData = byteBufferData;
     this.extractorInput = null;
   }
@@ -77,6 +147,7 @@ import java.nio.ByteBuffer;
    * @param extractorInput Source {@link ExtractorInput}.
    */
   public void setData(ExtractorInput extractorInput) {
+    clearFileDescriptor();
     this.byteBufferData = null;
     this.extractorInput = extractorInput;
     endOfExtractorInput = false;
@@ -85,14 +156,41 @@ import java.nio.ByteBuffer;
     }
   }
 
+  /**
+   * Sets a file to be parsed, e.g. a downloaded file or the region of an {@link
+   * android.content.res.AssetFileDescriptor}. The file is read natively without calling back into
+   * Java, and positions passed to {@link #reset(long)} are seeked to directly.
+   *
+   * <p>The file descriptor is duplicated, so the caller may close it once this method returns.
+   *
+   * @param fileDescriptor The file descriptor of the file.
+   * @param offset The offset of the FLAC stream in the file, in bytes.
+   * @param length The length of the FLAC stream in bytes, or {@link C#LENGTH_UNSET} if it extends
+   *     to the end of the file.
+   * @throws FlacDecoderException If the file cannot be read.
+   */
+  public void setData(ParcelFileDescriptor fileDescriptor, long offset, long length)
+      throws FlacDecoderException {
+    this.byteBufferData = null;
+    this.extractorInput = null;
+    fileDescriptorSet = true;
+    if (!flacSetFileDescriptor(nativeDecoderContext, fileDescriptor.getFd(), offset, length)) {
+      fileDescriptorSet = false;
+      throw new FlacDecoderException("Failed to read file descriptor");
+    }
+  }
+
   /**
    * Returns whether the end of the data to be parsed has been reached, or true if no data was set.
    */
   public boolean isEndOfData() {
-    if (byteBufferData != null) {
+    if (fileDescriptorSet) {
+      return isDecoderAtEndOfInput();
+    } else if (byteBufferData != null) {
       return byteBufferData.remaining() == 0;
     } else if (extractorInput != null) {
-      return endOfExtractorInput;
+      // The native side reads ahead, so data may remain after the input has been read to the end.
+      return endOfExtractorInput && !flacHasBufferedData(nativeDecoderContext);
     } else {
       return true;
     }
@@ -126,24 +224,48 @@ import java.nio.ByteBuffer;
     } else if (extractorInput != null) {
       ExtractorInput extractorInput = this.extractorInput;
       byte[] tempBuffer = Util.castNonNull(this.tempBuffer);
-      byteCount = min(byteCount, TEMP_BUFFER_SIZE);
-      int read = readFromExtractorInput(extractorInput, tempBuffer, /* offset= */ 0, byteCount);
-      if (read < 4) {
-        // Reading less than 4 bytes, most of the time, happens because of getting the bytes left in
-        // the buffer of the input. Do another read to reduce the number of calls to this method
-        // from the native code.
-        read +=
-            readFromExtractorInput(
-                extractorInput, tempBuffer, read, /* length= */ byteCount - read);
+      int totalRead = 0;
+      while (totalRead < byteCount && !endOfExtractorInput) {
+        int length = min(byteCount - totalRead, TEMP_BUFFER_SIZE);
+        int read = readFromExtractorInput(extractorInput, tempBuffer, /* offset= */ 0, length);
+        if (read < 4 && read < length) {
+          // Reading less than 4 bytes, most of the time, happens because of getting the bytes left
+          // in the buffer of the input. Do another read to reduce the number of calls to this
+          // method from the native code.
+          read +=
+              readFromExtractorInput(extractorInput, tempBuffer, read, /* length= */ length - read);
+        }
+        target.put(tempBuffer, 0, read);
+        totalRead += read;
+        if (read < length) {
+          // Don't block waiting for more data than the input has available. The native code reads
+          // ahead, so it's fine to return less than requested.
+          break;
+        }
       }
-      byteCount = read;
-      target.put(tempBuffer, 0, byteCount);
+      byteCount = totalRead;
     } else {
       return -1;
     }
     return byteCount;
   }
 
+  /**
+   * Reads up to {@code length} bytes from the data source into {@code target}, from its start.
+   * Called from native code to read ahead into the same direct buffer repeatedly.
+   *
+   * @param target A target {@link ByteBuffer} into which data should be written.
+   * @param length The maximum number of bytes to read.
+   * @return Returns the number of bytes read, or -1 on failure. If all of the data has already been
+   *     read from the source, then 0 is returned.
+   */
+  @SuppressWarnings("unused") // Called from native code.
+  public int readDirect(ByteBuffer target, int length) throws IOException {
+    target.clear();
+    target.limit(length);
+    return read(target);
+  }
+
   /** Decodes and consumes the metadata from the FLAC stream. */
   public FlacStreamMetadata decodeStreamMetadata() throws IOException {
     FlacStreamMetadata streamMetadata = flacDecodeMetadata(nativeDecoderContext);
@@ -151,6 +273,7 @@ import java.nio.ByteBuffer;
       throw ParserException.createForMalformedContainer(
           "Failed to decode stream metadata", /* cause= */ null);
     }
+    this.streamMetadata = streamMetadata;
     return streamMetadata;
   }
 
@@ -195,6 +318,76 @@ import java.nio.ByteBuffer;
     }
   }
 
+  /**
+   * Decodes and consumes as many whole frames from the FLAC stream as fit in the given byte buffer,
+   * in a single native call. If any IO error occurs, resets the stream and input to the given
+   * {@code retryPosition}.
+   *
+   * @param output The byte buffer to hold the decoded frames, one after the other. Its limit is set
+   *     to the end of the decoded data.
+   * @param frameFirstSampleIndices An array of at least two elements. Up to {@code
+   *     frameFirstSampleIndices.length - 1} frames are decoded. On return, it holds the first
+   *     sample index of each decoded frame, followed by the first sample index of the next frame.
+   * @param retryPosition If any error happens, the input will be rewound to {@code retryPosition}.
+   * @return The number of decoded frames, or 0 if the decoder has read to the end of the input.
+   */
+  public int decodeSamplesWithBacktrackPosition(
+      ByteBuffer output, long[] frameFirstSampleIndices, long retryPosition)
+      throws IOException, FlacFrameDecodeException {
+    try {
+      return decodeSamples(output, frameFirstSampleIndices);
+    } catch (IOException e) {
+      if (retryPosition >= 0) {
+        reset(retryPosition);
+        if (extractorInput != null) {
+          extractorInput.setRetryPosition(retryPosition, e);
+        }
+      }
+      throw e;
+    }
+  }
+
+  /**
+   * Decodes and consumes as many whole frames from the FLAC stream as fit in the given byte buffer,
+   * in a single native call. The stream metadata must have been decoded.
+   *
+   * @param output The byte buffer to hold the decoded frames, one after the other. Its limit is set
+   *     to the end of the decoded data.
+   * @param frameFirstSampleIndices An array of at least two elements. Up to {@code
+   *     frameFirstSampleIndices.length - 1} frames are decoded. On return, it holds the first
+   *     sample index of each decoded frame, followed by the first sample index of the next frame.
+   * @return The number of decoded frames, or 0 if the decoder has read to the end of the input.
+   */
+  @SuppressWarnings("ByteBufferBackingArray")
+  public int decodeSamples(ByteBuffer output, long[] frameFirstSampleIndices)
+      throws IOException, FlacFrameDecodeException {
+    output.clear();
+    int frameCount =
+        output.isDirect()
+            ? flacDecodeFramesToBuffer(nativeDecoderContext, output, frameFirstSampleIndices)
+            : flacDecodeFramesToArray(
+                nativeDecoderContext, output.array(), frameFirstSampleIndices);
+    if (frameCount < 0) {
+      if (!isDecoderAtEndOfInput()) {
+        throw new FlacFrameDecodeException("Cannot decode FLAC frames", frameCount);
+      }
+      // The decoder has read to EOI.
+      output.limit(0);
+      return 0;
+    }
+    long sampleCount = frameFirstSampleIndices[frameCount] - frameFirstSampleIndices[0];
+    int pcmFrameSize = getOutputPcmFrameSize(Assertions.checkStateNotNull(streamMetadata));
+    output.limit((int) (sampleCount * pcmFrameSize));
+    return frameCount;
+  }
+
+  /** Returns the size of a decoded sample of all channels of the given stream. */
+  public int getOutputPcmFrameSize(FlacStreamMetadata streamMetadata) {
+    return Util.getPcmFrameSize(
+        getOutputPcmEncoding(outputPcmEncoding, streamMetadata.bitsPerSample),
+        getOutputChannelCount(downmixToStereo, streamMetadata.channels));
+  }
+
   /** Returns the position of the next data to be decoded, or -1 in case of error. */
   public long getDecodePosition() {
     return flacGetDecodePosition(nativeDecoderContext);
@@ -237,6 +430,55 @@ import java.nio.ByteBuffer;
     return new SeekMap.SeekPoints(firstSeekPoint, secondSeekPoint);
   }
 
+  /**
+   * Returns the sample numbers and byte positions of the indexed frames around a sample, as {@code
+   * {floorSampleNumber, floorPosition, ceilingSampleNumber, ceilingPosition}}. The ceiling is
+   * {@link C#INDEX_UNSET} if no later frame is indexed.
+   *
+   * <p>The frame index is built as frames are decoded, for streams without a seek table.
+   *
+   * @param sampleNumber The sample number.
+   * @return The bounds, or {@code null} if no frame at or before the sample is indexed.
+   */
+  @Nullable
+  public long[] getSeekIndexBounds(long sampleNumber) {
+    long[] bounds = new long[4];
+    if (!flacGetSeekIndexBounds(nativeDecoderContext, sampleNumber, bounds)) {
+      return null;
+    }
+    return bounds;
+  }
+
+  /**
+   * Returns the frame index of the stream, serialized so that it can be passed to {@link
+   * #setSeekIndex(byte[])} when the stream is played again.
+   */
+  public byte[] getSeekIndex() {
+    return flacGetSeekIndex(nativeDecoderContext);
+  }
+
+  /**
+   * Replaces the frame index with one returned by {@link #getSeekIndex()}. The index is discarded
+   * if it belongs to a different stream. Once complete, the index is used like a seek table by
+   * {@link #getSeekPoints(long)}.
+   *
+   * @param seekIndex The serialized frame index.
+   * @return Whether the index is valid.
+   */
+  public boolean setSeekIndex(byte[] seekIndex) {
+    return flacSetSeekIndex(nativeDecoderContext, seekIndex);
+  }
+
+  /**
+   * Indexes the frames of the whole stream by scanning their headers, blocking until the scan is
+   * done. Only possible after the stream metadata is decoded from a file descriptor.
+   *
+   * @return Whether the index is complete.
+   */
+  public boolean scanSeekIndex() {
+    return flacScanSeekIndex(nativeDecoderContext);
+  }
+
   public String getStateString() {
     return flacGetStateString(nativeDecoderContext);
   }
@@ -263,6 +505,13 @@ import java.nio.ByteBuffer;
     flacRelease(nativeDecoderContext);
   }
 
+  private void clearFileDescriptor() {
+    if (fileDescriptorSet) {
+      flacSetFileDescriptor(nativeDecoderContext, /* fd= */ -1, /* offset= */ 0, C.LENGTH_UNSET);
+      fileDescriptorSet = false;
+    }
+  }
+
   private int readFromExtractorInput(
       ExtractorInput extractorInput, byte[] tempBuffer, int offset, int length) throws IOException {
     int read = extractorInput.read(tempBuffer, offset, length);
@@ -281,6 +530,12 @@ import java.nio.ByteBuffer;
 
   private native int flacDecodeToArray(long context, byte[] outputArray) throws IOException;
 
+  private native int flacDecodeFramesToBuffer(
+      long context, ByteBuffer outputBuffer, long[] frameFirstSampleIndices) throws IOException;
+
+  private native int flacDecodeFramesToArray(
+      long context, byte[] outputArray, long[] frameFirstSampleIndices) throws IOException;
+
   private native long flacGetDecodePosition(long context);
 
   private native long flacGetLastFrameTimestamp(long context);
@@ -291,10 +546,25 @@ import java.nio.ByteBuffer;
 
   private native boolean flacGetSeekPoints(long context, long timeUs, long[] outSeekPoints);
 
+  private native boolean flacGetSeekIndexBounds(long context, long sampleNumber, long[] outBounds);
+
+  private native byte[] flacGetSeekIndex(long context);
+
+  private native boolean flacSetSeekIndex(long context, byte[] seekIndex);
+
+  private native boolean flacScanSeekIndex(long context);
+
   private native String flacGetStateString(long context);
 
   private native boolean flacIsDecoderAtEndOfStream(long context);
 
+  private native boolean flacSetFileDescriptor(long context, int fd, long offset, long length);
+
+  private native boolean flacHasBufferedData(long context);
+
+  private native boolean flacSetOutputMode(
+      long context, int outputEncoding, boolean downmixToStereo);
+
   private native void flacFlush(long context);
 
   private native void flacReset(long context, long newPosition);
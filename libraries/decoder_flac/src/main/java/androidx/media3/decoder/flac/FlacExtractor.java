@@ -16,8 +16,11 @@
 package androidx.media3.decoder.flac;
 
 import static androidx.media3.common.util.Util.getPcmEncoding;
+import static java.lang.Math.max;
+import static java.lang.Math.min;
 import static java.lang.annotation.ElementType.TYPE_USE;
 
+import android.os.ParcelFileDescriptor;
 import androidx.annotation.IntDef;
 import androidx.annotation.Nullable;
 import androidx.media3.common.C;
@@ -78,6 +81,12 @@ public final class FlacExtractor implements Extractor {
   public static final int FLAG_DISABLE_ID3_METADATA =
       androidx.media3.extractor.flac.FlacExtractor.FLAG_DISABLE_ID3_METADATA;
 
+  /** The maximum number of frames to decode per call to {@link #read}. */
+  private static final int MAX_FRAMES_PER_READ = 16;
+
+  /** The decoded data size above which fewer frames are decoded per call to {@link #read}. */
+  private static final int MAX_OUTPUT_BUFFER_SIZE = 256 * 1024;
+
   private final ParsableByteArray outputBuffer;
   private final boolean id3MetadataDisabled;
 
@@ -88,9 +97,11 @@ public final class FlacExtractor implements Extractor {
   private boolean streamMetadataDecoded;
   private @MonotonicNonNull FlacStreamMetadata streamMetadata;
   private @MonotonicNonNull OutputFrameHolder outputFrameHolder;
+  private long @MonotonicNonNull [] frameFirstSampleIndices;
 
   @Nullable private Metadata id3Metadata;
   @Nullable private FlacBinarySearchSeeker binarySearchSeeker;
+  @Nullable private byte[] seekIndex;
 
   /** Constructs an instance with {@code flags = 0}. */
   public FlacExtractor() {
@@ -108,6 +119,106 @@ public final class FlacExtractor implements Extractor {
     id3MetadataDisabled = (flags & FLAG_DISABLE_ID3_METADATA) != 0;
   }
 
+  /**
+   * Sets a frame index previously returned by {@link #experimentalGetSeekIndex()} for the same
+   * stream, so that a stream without a seek table can be seeked without a binary search once the
+   * index is complete. An index for a different stream is ignored.
+   *
+   * <p>Takes effect when the extractor is initialized.
+   *
+   * <p>This method is experimental, and will be renamed or removed in a future release.
+   *
+   * @param seekIndex The serialized frame index.
+   */
+  public void experimentalSetSeekIndex(byte[] seekIndex) {
+    this.seekIndex = seekIndex;
+  }
+
+  /**
+   * Returns the frame index built while extracting a stream without a seek table, so that it can be
+   * passed to {@link #experimentalSetSeekIndex(byte[])} when the stream is extracted again, or
+   * {@code null} if the extractor isn't initialized.
+   *
+   * <p>This method is experimental, and will be renamed or removed in a future release.
+   */
+  @Nullable
+  public byte[] experimentalGetSeekIndex() {
+    return decoderJni != null ? decoderJni.getSeekIndex() : null;
+  }
+
+  /**
+   * Builds the frame index of a local FLAC file, e.g. a downloaded file, by scanning the headers of
+   * its frames, so that it can be passed to {@link #experimentalSetSeekIndex(byte[])} before the
+   * file is played. The file is read natively, without calling into Java.
+   *
+   * <p>The call blocks until the whole file is scanned, so it should be made on a background
+   * thread. The file descriptor is only used during the call, so the caller keeps ownership of it.
+   *
+   * <p>This method is experimental, and will be renamed or removed in a future release.
+   *
+   * @param fileDescriptor The file descriptor of the file.
+   * @param offset The offset of the FLAC stream in the file, in bytes.
+   * @param length The length of the FLAC stream in bytes, or {@link C#LENGTH_UNSET} if it extends
+   *     to the end of the file.
+   * @return The serialized frame index.
+   * @throws IOException If the file can't be read or isn't a FLAC file.
+   */
+  public static byte[] experimentalBuildSeekIndex(
+      ParcelFileDescriptor fileDescriptor, long offset, long length) throws IOException {
+    FlacDecoderJni decoderJni;
+    try {
+      decoderJni = new FlacDecoderJni();
+    } catch (FlacDecoderException e) {
+      throw new IOException(e);
+    }
+    try {
+      decoderJni.setData(fileDescriptor, offset, length);
+      decoderJni.decodeStreamMetadata();
+      if (!decoderJni.scanSeekIndex()) {
+        throw new IOException("Failed to index frames");
+      }
+      return decoderJni.getSeekIndex();
+    } catch (FlacDecoderException e) {
+      throw new IOException(e);
+    } finally {
+      decoderJni.release();
+    }
+  }
+
+  /**
+   * Reads the metadata of a local FLAC file, e.g. a downloaded file, through a file descriptor. The
+   * file is read natively, without calling into Java, which makes this cheaper than extracting the
+   * metadata from an {@link ExtractorInput}, for example when indexing a media library.
+   *
+   * <p>The file descriptor is only used during the call, so the caller keeps ownership of it.
+   *
+   * <p>This method is experimental, and will be renamed or removed in a future release.
+   *
+   * @param fileDescriptor The file descriptor of the file.
+   * @param offset The offset of the FLAC stream in the file, in bytes.
+   * @param length The length of the FLAC stream in bytes, or {@link C#LENGTH_UNSET} if it extends
+   *     to the end of the file.
+   * @return The metadata of the stream.
+   * @throws IOException If the file can't be read or isn't a FLAC file.
+   */
+  public static FlacStreamMetadata experimentalReadStreamMetadata(
+      ParcelFileDescriptor fileDescriptor, long offset, long length) throws IOException {
+    FlacDecoderJni decoderJni;
+    try {
+      decoderJni = new FlacDecoderJni();
+    } catch (FlacDecoderException e) {
+      throw new IOException(e);
+    }
+    try {
+      decoderJni.setData(fileDescriptor, offset, length);
+      return decoderJni.decodeStreamMetadata();
+    } catch (FlacDecoderException e) {
+      throw new IOException(e);
+    } finally {
+      decoderJni.release();
+    }
+  }
+
   @Override
   public void init(ExtractorOutput output) {
     extractorOutput = output;
@@ -118,6 +229,9 @@ public final class FlacExtractor implements Extractor {
     } catch (FlacDecoderException e) {
       throw new RuntimeException(e);
     }
+    if (seekIndex != null) {
+      decoderJni.setSeekIndex(seekIndex);
+    }
   }
 
   @Override
@@ -142,17 +256,25 @@ public final class FlacExtractor implements Extractor {
 
       ByteBuffer outputByteBuffer = outputFrameHolder.byteBuffer;
       long lastDecodePosition = decoderJni.getDecodePosition();
+      int frameCount;
       try {
-        decoderJni.decodeSampleWithBacktrackPosition(outputByteBuffer, lastDecodePosition);
+        frameCount =
+            decoderJni.decodeSamplesWithBacktrackPosition(
+                outputByteBuffer, frameFirstSampleIndices, lastDecodePosition);
       } catch (FlacDecoderJni.FlacFrameDecodeException e) {
         throw new IOException("Cannot read frame at position " + lastDecodePosition, e);
       }
-      int outputSize = outputByteBuffer.limit();
-      if (outputSize == 0) {
+      if (frameCount == 0) {
         return RESULT_END_OF_INPUT;
       }
 
-      outputSample(outputBuffer, outputSize, decoderJni.getLastFrameTimestamp(), trackOutput);
+      outputSamples(
+          outputBuffer,
+          outputByteBuffer.limit(),
+          frameFirstSampleIndices,
+          frameCount,
+          streamMetadata,
+          trackOutput);
       return decoderJni.isEndOfData() ? RESULT_END_OF_INPUT : RESULT_CONTINUE;
     } finally {
       decoderJni.clearData();
@@ -190,7 +312,7 @@ public final class FlacExtractor implements Extractor {
   }
 
   @RequiresNonNull({"decoderJni", "extractorOutput", "trackOutput"}) // Requires initialized.
-  @EnsuresNonNull({"streamMetadata", "outputFrameHolder"}) // Ensures stream metadata decoded.
+  @EnsuresNonNull({"streamMetadata", "outputFrameHolder", "frameFirstSampleIndices"})
   @SuppressWarnings("nullness:contracts.postcondition")
   private void decodeStreamMetadata(ExtractorInput input) throws IOException {
     if (streamMetadataDecoded) {
@@ -210,7 +332,12 @@ public final class FlacExtractor implements Extractor {
     streamMetadataDecoded = true;
     if (this.streamMetadata == null) {
       this.streamMetadata = streamMetadata;
-      outputBuffer.reset(streamMetadata.getMaxDecodedFrameSize());
+      // Decode several frames per read when they're small, to reduce the number of native calls.
+      int maxDecodedFrameSize = streamMetadata.getMaxDecodedFrameSize();
+      int maxFramesPerRead =
+          max(1, min(MAX_FRAMES_PER_READ, MAX_OUTPUT_BUFFER_SIZE / maxDecodedFrameSize));
+      frameFirstSampleIndices = new long[maxFramesPerRead + 1];
+      outputBuffer.reset(maxFramesPerRead * maxDecodedFrameSize);
       outputFrameHolder = new OutputFrameHolder(ByteBuffer.wrap(outputBuffer.getData()));
       binarySearchSeeker =
           outputSeekMap(
@@ -294,6 +421,30 @@ public final class FlacExtractor implements Extractor {
         timeUs, C.BUFFER_FLAG_KEY_FRAME, size, /* offset= */ 0, /* cryptoData= */ null);
   }
 
+  private static void outputSamples(
+      ParsableByteArray sampleData,
+      int size,
+      long[] frameFirstSampleIndices,
+      int frameCount,
+      FlacStreamMetadata streamMetadata,
+      TrackOutput output) {
+    sampleData.setPosition(0);
+    output.sampleData(sampleData, size);
+    int pcmFrameSize = streamMetadata.channels * (streamMetadata.bitsPerSample / 8);
+    long endSampleIndex = frameFirstSampleIndices[frameCount];
+    for (int i = 0; i < frameCount; i++) {
+      long firstSampleIndex = frameFirstSampleIndices[i];
+      int frameSize = (int) (frameFirstSampleIndices[i + 1] - firstSampleIndex) * pcmFrameSize;
+      int offset = (int) (endSampleIndex - frameFirstSampleIndices[i + 1]) * pcmFrameSize;
+      output.sampleMetadata(
+          firstSampleIndex * C.MICROS_PER_SECOND / streamMetadata.sampleRate,
+          C.BUFFER_FLAG_KEY_FRAME,
+          frameSize,
+          offset,
+          /* cryptoData= */ null);
+    }
+  }
+
   /** A {@link SeekMap} implementation using a SeekTable within the Flac stream. */
   private static final class FlacSeekMap implements SeekMap {
 
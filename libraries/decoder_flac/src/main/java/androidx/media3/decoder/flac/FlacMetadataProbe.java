@@ -0,0 +1,188 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package androidx.media3.decoder.flac;
+
+import android.os.ParcelFileDescriptor;
+import androidx.annotation.Nullable;
+import androidx.media3.common.C;
+import androidx.media3.common.ParserException;
+import androidx.media3.common.util.UnstableApi;
+import androidx.media3.extractor.FlacStreamMetadata;
+import androidx.media3.extractor.metadata.flac.PictureFrame;
+import java.io.IOException;
+import java.util.Collections;
+import java.util.List;
+
+/**
+ * The metadata of a FLAC file, read without decoding the stream, e.g. to scan the files of a media
+ * library.
+ *
+ * <p>Only the metadata blocks of the file are read. Pictures are returned as references to their
+ * position in the file, and their data is only read by {@link #readPicture}.
+ *
+ * <p>Probing doesn't share any state, so files can be probed concurrently from several threads.
+ */
+@UnstableApi
+public final class FlacMetadataProbe {
+
+  /** A picture in a FLAC file, whose data hasn't been read. */
+  public static final class Picture {
+
+    /** The picture type, as defined by the FLAC specification. */
+    public final int pictureType;
+
+    /** The MIME type of the picture. */
+    public final String mimeType;
+
+    /** A description of the picture. */
+    public final String description;
+
+    /** The width of the picture in pixels. */
+    public final int width;
+
+    /** The height of the picture in pixels. */
+    public final int height;
+
+    /** The color depth of the picture in bits per pixel. */
+    public final int depth;
+
+    /** The number of colors used for indexed-color pictures, or 0 for other pictures. */
+    public final int colors;
+
+    /** The position of the picture data in the FLAC stream, in bytes. */
+    public final long dataPosition;
+
+    /** The length of the picture data in bytes. */
+    public final int dataLength;
+
+    @SuppressWarnings("unused") // Called from native code.
+    private Picture(
+        int pictureType,
+        String mimeType,
+        String description,
+        int width,
+        int height,
+        int depth,
+        int colors,
+        long dataPosition,
+        int dataLength) {
+      this.pictureType = pictureType;
+      this.mimeType = mimeType;
+      this.description = description;
+      this.width = width;
+      this.height = height;
+      this.depth = depth;
+      this.colors = colors;
+      this.dataPosition = dataPosition;
+      this.dataLength = dataLength;
+    }
+  }
+
+  /**
+   * The stream metadata. It contains the Vorbis comments that were requested, but no pictures,
+   * which are in {@link #pictures} instead.
+   */
+  public final FlacStreamMetadata streamMetadata;
+
+  /** The pictures in the file, in the order of their metadata blocks. */
+  public final List<Picture> pictures;
+
+  /** The position of the first frame in the FLAC stream, in bytes. */
+  public final long firstFramePosition;
+
+  /** The offset of the FLAC stream in the file, in bytes. */
+  private final long offset;
+
+  @SuppressWarnings("unused") // Called from native code.
+  private FlacMetadataProbe(
+      FlacStreamMetadata streamMetadata,
+      List<Picture> pictures,
+      long firstFramePosition,
+      long offset) {
+    this.streamMetadata = streamMetadata;
+    this.pictures = Collections.unmodifiableList(pictures);
+    this.firstFramePosition = firstFramePosition;
+    this.offset = offset;
+  }
+
+  /**
+   * Reads the metadata of a FLAC file.
+   *
+   * <p>The file descriptor is only used during the call, so the caller keeps ownership of it.
+   *
+   * @param fileDescriptor The file descriptor of the file.
+   * @param offset The offset of the FLAC stream in the file, in bytes.
+   * @param length The length of the FLAC stream in bytes, or {@link C#LENGTH_UNSET} if it extends
+   *     to the end of the file.
+   * @param vorbisCommentKeys The field names of the Vorbis comments to return, ignoring case, or
+   *     {@code null} to return all of them.
+   * @return The metadata.
+   * @throws IOException If the file can't be read or isn't a FLAC file.
+   */
+  public static FlacMetadataProbe probe(
+      ParcelFileDescriptor fileDescriptor,
+      long offset,
+      long length,
+      @Nullable String[] vorbisCommentKeys)
+      throws IOException {
+    if (!FlacLibrary.isAvailable()) {
+      throw new IOException("Failed to load decoder native libraries.");
+    }
+    @Nullable
+    FlacMetadataProbe probe =
+        flacProbe(fileDescriptor.getFd(), offset, length, vorbisCommentKeys);
+    if (probe == null) {
+      throw ParserException.createForMalformedContainer(
+          "Failed to probe stream metadata", /* cause= */ null);
+    }
+    return probe;
+  }
+
+  /**
+   * Reads the data of a picture.
+   *
+   * @param fileDescriptor The file descriptor of the file that was probed.
+   * @param picture One of the {@link #pictures}.
+   * @return The picture, with its data.
+   * @throws IOException If the picture data can't be read.
+   */
+  public PictureFrame readPicture(ParcelFileDescriptor fileDescriptor, Picture picture)
+      throws IOException {
+    @Nullable
+    byte[] pictureData =
+        flacReadPictureData(
+            fileDescriptor.getFd(), offset + picture.dataPosition, picture.dataLength);
+    if (pictureData == null) {
+      throw new IOException("Failed to read picture data");
+    }
+    return new PictureFrame(
+        picture.pictureType,
+        picture.mimeType,
+        picture.description,
+        picture.width,
+        picture.height,
+        picture.depth,
+        picture.colors,
+        pictureData);
+  }
+
+  @Nullable
+  private static native FlacMetadataProbe flacProbe(
+      int fd, long offset, long length, @Nullable String[] vorbisCommentKeys);
+
+  @Nullable
+  private static native byte[] flacReadPictureData(int fd, long position, int length);
+}
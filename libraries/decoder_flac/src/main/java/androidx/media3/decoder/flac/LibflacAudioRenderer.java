@@ -20,6 +20,7 @@ import androidx.annotation.Nullable;
 import androidx.media3.common.C;
 import androidx.media3.common.Format;
 import androidx.media3.common.MimeTypes;
+import androidx.media3.common.util.Assertions;
 import androidx.media3.common.util.TraceUtil;
 import androidx.media3.common.util.UnstableApi;
 import androidx.media3.common.util.Util;
@@ -39,6 +40,9 @@ public final class LibflacAudioRenderer extends DecoderAudioRenderer<FlacDecoder
   private static final int STREAM_MARKER_SIZE = 4;
   private static final int METADATA_BLOCK_HEADER_SIZE = 4;
 
+  private @C.PcmEncoding int outputPcmEncoding;
+  private boolean stereoDownmixEnabled;
+
   public LibflacAudioRenderer() {
     this(/* eventHandler= */ null, /* eventListener= */ null);
   }
@@ -56,6 +60,7 @@ public final class LibflacAudioRenderer extends DecoderAudioRenderer<FlacDecoder
       @Nullable AudioRendererEventListener eventListener,
       AudioProcessor... audioProcessors) {
     super(eventHandler, eventListener, audioProcessors);
+    outputPcmEncoding = Format.NO_VALUE;
   }
 
   /**
@@ -71,6 +76,42 @@ public final class LibflacAudioRenderer extends DecoderAudioRenderer<FlacDecoder
       @Nullable AudioRendererEventListener eventListener,
       AudioSink audioSink) {
     super(eventHandler, eventListener, audioSink);
+    outputPcmEncoding = Format.NO_VALUE;
+  }
+
+  /**
+   * Sets the encoding of the decoded samples. The native decoder converts the samples while it
+   * interleaves them, which avoids a conversion pass in the audio pipeline. Samples are output with
+   * the bit depth of the stream by default.
+   *
+   * <p>Takes effect the next time a decoder is created.
+   *
+   * <p>This method is experimental, and will be renamed or removed in a future release.
+   *
+   * @param outputPcmEncoding {@link C#ENCODING_PCM_FLOAT} to output float samples, {@link
+   *     C#ENCODING_PCM_16BIT} to output 16-bit samples, with dither if the stream has a higher bit
+   *     depth, or {@link Format#NO_VALUE} to output samples with the bit depth of the stream.
+   */
+  public void experimentalSetOutputPcmEncoding(@C.PcmEncoding int outputPcmEncoding) {
+    Assertions.checkArgument(
+        outputPcmEncoding == Format.NO_VALUE
+            || outputPcmEncoding == C.ENCODING_PCM_16BIT
+            || outputPcmEncoding == C.ENCODING_PCM_FLOAT);
+    this.outputPcmEncoding = outputPcmEncoding;
+  }
+
+  /**
+   * Sets whether the native decoder downmixes streams with more than two channels to stereo, in
+   * the same pass as it interleaves the samples. Disabled by default.
+   *
+   * <p>Takes effect the next time a decoder is created.
+   *
+   * <p>This method is experimental, and will be renamed or removed in a future release.
+   *
+   * @param stereoDownmixEnabled Whether to downmix streams with more than two channels to stereo.
+   */
+  public void experimentalSetStereoDownmixEnabled(boolean stereoDownmixEnabled) {
+    this.stereoDownmixEnabled = stereoDownmixEnabled;
   }
 
   @Override
@@ -92,7 +133,10 @@ public final class LibflacAudioRenderer extends DecoderAudioRenderer<FlacDecoder
       // ENCODING_PCM_16BIT. If the actual encoding is different then playback will still succeed as
       // long as the AudioSink supports it, which will always be true when using DefaultAudioSink.
       outputFormat =
-          Util.getPcmFormat(C.ENCODING_PCM_16BIT, format.channelCount, format.sampleRate);
+          Util.getPcmFormat(
+              outputPcmEncoding == Format.NO_VALUE ? C.ENCODING_PCM_16BIT : outputPcmEncoding,
+              FlacDecoderJni.getOutputChannelCount(stereoDownmixEnabled, format.channelCount),
+              format.sampleRate);
     } else {
       int streamMetadataOffset = STREAM_MARKER_SIZE + METADATA_BLOCK_HEADER_SIZE;
       FlacStreamMetadata streamMetadata =
@@ -113,20 +157,29 @@ public final class LibflacAudioRenderer extends DecoderAudioRenderer<FlacDecoder
       throws FlacDecoderException {
     TraceUtil.beginSection("createFlacDecoder");
     FlacDecoder decoder =
-        new FlacDecoder(NUM_BUFFERS, NUM_BUFFERS, format.maxInputSize, format.initializationData);
+        new FlacDecoder(
+            NUM_BUFFERS,
+            NUM_BUFFERS,
+            format.maxInputSize,
+            format.initializationData,
+            outputPcmEncoding,
+            stereoDownmixEnabled);
     TraceUtil.endSection();
     return decoder;
   }
 
   @Override
   protected Format getOutputFormat(FlacDecoder decoder) {
-    return getOutputFormat(decoder.getStreamMetadata());
+    return Util.getPcmFormat(
+        decoder.getOutputPcmEncoding(),
+        decoder.getOutputChannelCount(),
+        decoder.getStreamMetadata().sampleRate);
   }
 
-  private static Format getOutputFormat(FlacStreamMetadata streamMetadata) {
+  private Format getOutputFormat(FlacStreamMetadata streamMetadata) {
     return Util.getPcmFormat(
-        Util.getPcmEncoding(streamMetadata.bitsPerSample),
-        streamMetadata.channels,
+        FlacDecoderJni.getOutputPcmEncoding(outputPcmEncoding, streamMetadata.bitsPerSample),
+        FlacDecoderJni.getOutputChannelCount(stereoDownmixEnabled, streamMetadata.channels),
         streamMetadata.sampleRate);
   }
 }
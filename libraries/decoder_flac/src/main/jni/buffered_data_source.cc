@@ -0,0 +1,53 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "include/buffered_data_source.h"
+
+#include <cstring>
+
+BufferedDataSource::BufferedDataSource(DataSource *source, size_t capacity)
+    : mSource(source), mBuffer(capacity), mStart(0), mEnd(0), mOffset(0) {}
+
+ssize_t BufferedDataSource::readAt(off64_t offset, void *const data,
+                                   size_t size) {
+  if (offset != mOffset) {
+    clear();
+    mOffset = offset;
+  }
+  if (mStart == mEnd) {
+    if (size >= mBuffer.size()) {
+      ssize_t result = mSource->readAt(offset, data, size);
+      if (result > 0) {
+        mOffset += result;
+      }
+      return result;
+    }
+    ssize_t result = mSource->readAt(offset, mBuffer.data(), mBuffer.size());
+    if (result <= 0) {
+      return result;
+    }
+    mStart = 0;
+    mEnd = result;
+  }
+  size_t count = mEnd - mStart;
+  if (count > size) {
+    count = size;
+  }
+  memcpy(data, &mBuffer[mStart], count);
+  mStart += count;
+  mOffset += count;
+  return count;
+}
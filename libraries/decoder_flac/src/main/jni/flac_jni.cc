@@ -15,13 +15,20 @@
  */
 
 #include <android/log.h>
+#include <fcntl.h>
 #include <jni.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 #include <array>
+#include <cerrno>
 #include <cstdlib>
 #include <cstring>
+#include <vector>
 
+#include "include/buffered_data_source.h"
 #include "include/flac_parser.h"
+#include "include/flac_probe.h"
 
 #define LOG_TAG "flac_jni"
 #define ALOGE(...) \
@@ -40,47 +47,261 @@
       Java_androidx_media3_decoder_flac_FlacDecoderJni_##NAME(                \
           JNIEnv *env, jobject thiz, ##__VA_ARGS__)
 
+#define PROBE_FUNC(RETURN_TYPE, NAME, ...)                                    \
+  extern "C" {                                                                \
+  JNIEXPORT RETURN_TYPE                                                       \
+      Java_androidx_media3_decoder_flac_FlacMetadataProbe_##NAME(             \
+          JNIEnv *env, jclass clazz, ##__VA_ARGS__);                          \
+  }                                                                           \
+  JNIEXPORT RETURN_TYPE                                                       \
+      Java_androidx_media3_decoder_flac_FlacMetadataProbe_##NAME(             \
+          JNIEnv *env, jclass clazz, ##__VA_ARGS__)
+
+// Classes, methods and fields used from native code. They are resolved once in
+// JNI_OnLoad rather than on each call, and the classes are held as global
+// references so that the IDs stay valid.
+static jmethodID readMethod;
+static jmethodID readDirectMethod;
+static jclass arrayListClass;
+static jmethodID arrayListConstructor;
+static jmethodID arrayListAddMethod;
+static jclass pictureFrameClass;
+static jmethodID pictureFrameConstructor;
+static jclass flacStreamMetadataClass;
+static jmethodID flacStreamMetadataConstructor;
+static jclass probeClass;
+static jmethodID probeConstructor;
+static jclass probePictureClass;
+static jmethodID probePictureConstructor;
+
+// Returns a global reference to the class with the given name, or NULL if it
+// can't be found.
+static jclass findClass(JNIEnv *env, const char *name) {
+  jclass localClass = env->FindClass(name);
+  if (localClass == NULL) {
+    return NULL;
+  }
+  jclass globalClass = static_cast<jclass>(env->NewGlobalRef(localClass));
+  env->DeleteLocalRef(localClass);
+  return globalClass;
+}
+
+jint JNI_OnLoad(JavaVM *vm, void *reserved) {
+  JNIEnv *env;
+  if (vm->GetEnv(reinterpret_cast<void **>(&env), JNI_VERSION_1_6) != JNI_OK) {
+    return -1;
+  }
+  jclass flacDecoderJniClass =
+      env->FindClass("androidx/media3/decoder/flac/FlacDecoderJni");
+  if (flacDecoderJniClass == NULL) {
+    return -1;
+  }
+  readMethod = env->GetMethodID(flacDecoderJniClass, "read",
+                                "(Ljava/nio/ByteBuffer;)I");
+  readDirectMethod = env->GetMethodID(flacDecoderJniClass, "readDirect",
+                                      "(Ljava/nio/ByteBuffer;I)I");
+  env->DeleteLocalRef(flacDecoderJniClass);
+  if (readMethod == NULL || readDirectMethod == NULL) {
+    return -1;
+  }
+
+  arrayListClass = findClass(env, "java/util/ArrayList");
+  pictureFrameClass =
+      findClass(env, "androidx/media3/extractor/metadata/flac/PictureFrame");
+  flacStreamMetadataClass =
+      findClass(env, "androidx/media3/extractor/FlacStreamMetadata");
+  probeClass = findClass(env, "androidx/media3/decoder/flac/FlacMetadataProbe");
+  probePictureClass =
+      findClass(env, "androidx/media3/decoder/flac/FlacMetadataProbe$Picture");
+  if (arrayListClass == NULL || pictureFrameClass == NULL ||
+      flacStreamMetadataClass == NULL || probeClass == NULL ||
+      probePictureClass == NULL) {
+    return -1;
+  }
+
+  arrayListConstructor = env->GetMethodID(arrayListClass, "<init>", "()V");
+  arrayListAddMethod =
+      env->GetMethodID(arrayListClass, "add", "(Ljava/lang/Object;)Z");
+  pictureFrameConstructor =
+      env->GetMethodID(pictureFrameClass, "<init>",
+                       "(ILjava/lang/String;Ljava/lang/String;IIII[B)V");
+  flacStreamMetadataConstructor =
+      env->GetMethodID(flacStreamMetadataClass, "<init>",
+                       "(IIIIIIIJLjava/util/ArrayList;Ljava/util/ArrayList;)V");
+  probeConstructor = env->GetMethodID(
+      probeClass, "<init>",
+      "(Landroidx/media3/extractor/FlacStreamMetadata;Ljava/util/List;JJ)V");
+  probePictureConstructor =
+      env->GetMethodID(probePictureClass, "<init>",
+                       "(ILjava/lang/String;Ljava/lang/String;IIIIJI)V");
+  if (arrayListConstructor == NULL || arrayListAddMethod == NULL ||
+      pictureFrameConstructor == NULL ||
+      flacStreamMetadataConstructor == NULL || probeConstructor == NULL ||
+      probePictureConstructor == NULL) {
+    return -1;
+  }
+  return JNI_VERSION_1_6;
+}
+
 class JavaDataSource : public DataSource {
  public:
+  JavaDataSource()
+      : env(NULL),
+        flacDecoderJni(NULL),
+        directBuffer(NULL),
+        directBufferData(NULL),
+        directBufferCapacity(0) {}
+
   void setFlacDecoderJni(JNIEnv *env, jobject flacDecoderJni) {
     this->env = env;
     this->flacDecoderJni = flacDecoderJni;
-    if (mid == NULL) {
-      jclass cls = env->GetObjectClass(flacDecoderJni);
-      mid = env->GetMethodID(cls, "read", "(Ljava/nio/ByteBuffer;)I");
-      env->DeleteLocalRef(cls);
+  }
+
+  // Sets memory that is read into repeatedly (the buffer of a
+  // BufferedDataSource). Reads into it reuse a single direct ByteBuffer.
+  void setDirectBuffer(void *data, size_t capacity) {
+    directBufferData = data;
+    directBufferCapacity = capacity;
+  }
+
+  // Deletes the global reference to the direct ByteBuffer, if any.
+  void release(JNIEnv *env) {
+    if (directBuffer != NULL) {
+      env->DeleteGlobalRef(directBuffer);
+      directBuffer = NULL;
     }
   }
 
   ssize_t readAt(off64_t offset, void *const data, size_t size) {
-    jobject byteBuffer = env->NewDirectByteBuffer(data, size);
-    int result = env->CallIntMethod(flacDecoderJni, mid, byteBuffer);
+    int result;
+    if (data == directBufferData && size <= directBufferCapacity) {
+      if (directBuffer == NULL) {
+        jobject byteBuffer =
+            env->NewDirectByteBuffer(directBufferData, directBufferCapacity);
+        if (byteBuffer == NULL) {
+          return -1;
+        }
+        directBuffer = env->NewGlobalRef(byteBuffer);
+        env->DeleteLocalRef(byteBuffer);
+      }
+      result = env->CallIntMethod(flacDecoderJni, readDirectMethod,
+                                  directBuffer, static_cast<jint>(size));
+    } else {
+      jobject byteBuffer = env->NewDirectByteBuffer(data, size);
+      result = env->CallIntMethod(flacDecoderJni, readMethod, byteBuffer);
+      env->DeleteLocalRef(byteBuffer);
+    }
     if (env->ExceptionCheck()) {
       // Exception is thrown in Java when returning from the native call.
       result = -1;
     }
-    env->DeleteLocalRef(byteBuffer);
     return result;
   }
 
  private:
   JNIEnv *env;
   jobject flacDecoderJni;
-  jmethodID mid;
+  jobject directBuffer;
+  void *directBufferData;
+  size_t directBufferCapacity;
+};
+
+// A DataSource reading a file (or a part of it, e.g. of an
+// AssetFileDescriptor) with pread(), without calling into Java. Unlike
+// JavaDataSource, it honors the offsets of reads and knows its length, so
+// libFLAC can seek in it.
+//
+// The file isn't mapped into memory: a file that is truncated while it's being
+// read, e.g. a download that is restarted, would make reads from the mapping
+// raise SIGBUS, whereas pread() just returns fewer bytes.
+class FileDataSource : public DataSource {
+ public:
+  FileDataSource() : fd(-1), offset(0), length(0) {}
+
+  ~FileDataSource() { close(); }
+
+  // Opens |length| bytes of the file at |offset|, or the rest of the file if
+  // |length| is negative. |fd| is duplicated, so the caller keeps ownership.
+  // Returns false on failure.
+  bool open(int fd, off64_t offset, off64_t length) {
+    close();
+    // fstat64() needs API level 21 on 32-bit ABIs. The st_size of bionic's
+    // struct stat is 64-bit on all ABIs.
+    struct stat fileStat;
+    if (offset < 0 || fstat(fd, &fileStat) != 0 ||
+        offset > fileStat.st_size) {
+      ALOGE("FileDataSource invalid file, errno=%d", errno);
+      return false;
+    }
+    if (length < 0 || length > fileStat.st_size - offset) {
+      length = fileStat.st_size - offset;
+    }
+    this->fd = fcntl(fd, F_DUPFD_CLOEXEC, 0);
+    if (this->fd < 0) {
+      ALOGE("FileDataSource dup failed, errno=%d", errno);
+      return false;
+    }
+    this->offset = offset;
+    this->length = length;
+    return true;
+  }
+
+  void close() {
+    if (fd >= 0) {
+      ::close(fd);
+      fd = -1;
+    }
+  }
+
+  ssize_t readAt(off64_t position, void *const data, size_t size) {
+    if (position < 0) {
+      return -1;
+    }
+    if (position >= length) {
+      return 0;
+    }
+    if (static_cast<off64_t>(size) > length - position) {
+      size = length - position;
+    }
+    ssize_t result;
+    do {
+      result = pread64(fd, data, size, offset + position);
+    } while (result < 0 && errno == EINTR);
+    return result;
+  }
+
+  off64_t getLength() { return length; }
+
+  bool isOpen() const { return fd >= 0; }
+
+ private:
+  int fd;
+  off64_t offset;
+  off64_t length;
 };
 
 struct Context {
-  JavaDataSource *source;
+  JavaDataSource *javaSource;
+  // Reads ahead from |javaSource|, so that libFLAC's reads don't each call
+  // into Java.
+  BufferedDataSource *source;
+  // Used instead of |source| while a file descriptor is set.
+  FileDataSource *fileSource;
   FLACParser *parser;
 
   Context() {
-    source = new JavaDataSource();
+    javaSource = new JavaDataSource();
+    source = new BufferedDataSource(javaSource);
+    javaSource->setDirectBuffer(source->getBuffer(), source->getCapacity());
+    fileSource = new FileDataSource();
     parser = new FLACParser(source);
   }
 
   ~Context() {
     delete parser;
+    delete fileSource;
     delete source;
+    delete javaSource;
   }
 };
 
@@ -95,17 +316,12 @@ DECODER_FUNC(jlong, flacInit) {
 
 DECODER_FUNC(jobject, flacDecodeMetadata, jlong jContext) {
   Context *context = reinterpret_cast<Context *>(jContext);
-  context->source->setFlacDecoderJni(env, thiz);
+  context->javaSource->setFlacDecoderJni(env, thiz);
   if (!context->parser->decodeMetadata()) {
     return NULL;
   }
 
-  jclass arrayListClass = env->FindClass("java/util/ArrayList");
-  jmethodID arrayListConstructor =
-      env->GetMethodID(arrayListClass, "<init>", "()V");
   jobject commentList = env->NewObject(arrayListClass, arrayListConstructor);
-  jmethodID arrayListAddMethod =
-      env->GetMethodID(arrayListClass, "add", "(Ljava/lang/Object;)Z");
 
   if (context->parser->areVorbisCommentsValid()) {
     std::vector<std::string> vorbisComments =
@@ -123,11 +339,6 @@ DECODER_FUNC(jobject, flacDecodeMetadata, jlong jContext) {
   bool picturesValid = context->parser->arePicturesValid();
   if (picturesValid) {
     std::vector<FlacPicture> pictures = context->parser->getPictures();
-    jclass pictureFrameClass =
-        env->FindClass("androidx/media3/extractor/metadata/flac/PictureFrame");
-    jmethodID pictureFrameConstructor =
-        env->GetMethodID(pictureFrameClass, "<init>",
-                         "(ILjava/lang/String;Ljava/lang/String;IIII[B)V");
     for (std::vector<FlacPicture>::const_iterator picture = pictures.begin();
          picture != pictures.end(); ++picture) {
       jstring mimeType = env->NewStringUTF(picture->mimeType.c_str());
@@ -148,14 +359,6 @@ DECODER_FUNC(jobject, flacDecodeMetadata, jlong jContext) {
 
   const FLAC__StreamMetadata_StreamInfo &streamInfo =
       context->parser->getStreamInfo();
-
-  jclass flacStreamMetadataClass = env->FindClass(
-      "androidx/media3/extractor/"
-      "FlacStreamMetadata");
-  jmethodID flacStreamMetadataConstructor =
-      env->GetMethodID(flacStreamMetadataClass, "<init>",
-                       "(IIIIIIIJLjava/util/ArrayList;Ljava/util/ArrayList;)V");
-
   return env->NewObject(flacStreamMetadataClass, flacStreamMetadataConstructor,
                         streamInfo.min_blocksize, streamInfo.max_blocksize,
                         streamInfo.min_framesize, streamInfo.max_framesize,
@@ -166,7 +369,7 @@ DECODER_FUNC(jobject, flacDecodeMetadata, jlong jContext) {
 
 DECODER_FUNC(jint, flacDecodeToBuffer, jlong jContext, jobject jOutputBuffer) {
   Context *context = reinterpret_cast<Context *>(jContext);
-  context->source->setFlacDecoderJni(env, thiz);
+  context->javaSource->setFlacDecoderJni(env, thiz);
   void *outputBuffer = env->GetDirectBufferAddress(jOutputBuffer);
   jint outputSize = env->GetDirectBufferCapacity(jOutputBuffer);
   return context->parser->readBuffer(outputBuffer, outputSize);
@@ -174,7 +377,7 @@ DECODER_FUNC(jint, flacDecodeToBuffer, jlong jContext, jobject jOutputBuffer) {
 
 DECODER_FUNC(jint, flacDecodeToArray, jlong jContext, jbyteArray jOutputArray) {
   Context *context = reinterpret_cast<Context *>(jContext);
-  context->source->setFlacDecoderJni(env, thiz);
+  context->javaSource->setFlacDecoderJni(env, thiz);
   jbyte *outputBuffer = env->GetByteArrayElements(jOutputArray, NULL);
   jint outputSize = env->GetArrayLength(jOutputArray);
   int count = context->parser->readBuffer(outputBuffer, outputSize);
@@ -182,6 +385,53 @@ DECODER_FUNC(jint, flacDecodeToArray, jlong jContext, jbyteArray jOutputArray) {
   return count;
 }
 
+// Decodes up to frameFirstSampleIndices.length - 1 frames. On success, stores
+// the first sample index of each decoded frame followed by the first sample
+// index of the next frame in frameFirstSampleIndices and returns the number of
+// decoded frames.
+static jint decodeFrames(JNIEnv *env, Context *context, void *outputBuffer,
+                         size_t outputSize,
+                         jlongArray jFrameFirstSampleIndices) {
+  jsize length = env->GetArrayLength(jFrameFirstSampleIndices);
+  if (length < 2) {
+    return -1;
+  }
+  jlong *frameFirstSampleIndices =
+      env->GetLongArrayElements(jFrameFirstSampleIndices, NULL);
+  int count = context->parser->readBuffers(
+      outputBuffer, outputSize,
+      reinterpret_cast<int64_t *>(frameFirstSampleIndices), length - 1);
+  if (count > 0) {
+    frameFirstSampleIndices[count] =
+        context->parser->getNextFrameFirstSampleIndex();
+  }
+  env->ReleaseLongArrayElements(jFrameFirstSampleIndices,
+                                frameFirstSampleIndices, 0);
+  return count;
+}
+
+DECODER_FUNC(jint, flacDecodeFramesToBuffer, jlong jContext,
+             jobject jOutputBuffer, jlongArray jFrameFirstSampleIndices) {
+  Context *context = reinterpret_cast<Context *>(jContext);
+  context->javaSource->setFlacDecoderJni(env, thiz);
+  void *outputBuffer = env->GetDirectBufferAddress(jOutputBuffer);
+  jint outputSize = env->GetDirectBufferCapacity(jOutputBuffer);
+  return decodeFrames(env, context, outputBuffer, outputSize,
+                      jFrameFirstSampleIndices);
+}
+
+DECODER_FUNC(jint, flacDecodeFramesToArray, jlong jContext,
+             jbyteArray jOutputArray, jlongArray jFrameFirstSampleIndices) {
+  Context *context = reinterpret_cast<Context *>(jContext);
+  context->javaSource->setFlacDecoderJni(env, thiz);
+  jbyte *outputBuffer = env->GetByteArrayElements(jOutputArray, NULL);
+  jint outputSize = env->GetArrayLength(jOutputArray);
+  int count = decodeFrames(env, context, outputBuffer, outputSize,
+                           jFrameFirstSampleIndices);
+  env->ReleaseByteArrayElements(jOutputArray, outputBuffer, 0);
+  return count;
+}
+
 DECODER_FUNC(jlong, flacGetDecodePosition, jlong jContext) {
   Context *context = reinterpret_cast<Context *>(jContext);
   return context->parser->getDecodePosition();
@@ -213,6 +463,56 @@ DECODER_FUNC(jboolean, flacGetSeekPoints, jlong jContext, jlong timeUs,
   return success;
 }
 
+DECODER_FUNC(jboolean, flacGetSeekIndexBounds, jlong jContext,
+             jlong sampleNumber, jlongArray outBounds) {
+  Context *context = reinterpret_cast<Context *>(jContext);
+  std::array<int64_t, 4> result;
+  bool success = context->parser->getSeekIndexBounds(sampleNumber, result);
+  if (success) {
+    env->SetLongArrayRegion(outBounds, 0, result.size(), result.data());
+  }
+  return success;
+}
+
+DECODER_FUNC(jbyteArray, flacGetSeekIndex, jlong jContext) {
+  Context *context = reinterpret_cast<Context *>(jContext);
+  std::vector<uint8_t> data;
+  context->parser->getSeekIndex().serialize(&data);
+  jbyteArray seekIndex = env->NewByteArray(data.size());
+  if (seekIndex != NULL) {
+    env->SetByteArrayRegion(seekIndex, 0, data.size(),
+                            reinterpret_cast<const jbyte *>(data.data()));
+  }
+  return seekIndex;
+}
+
+DECODER_FUNC(jboolean, flacSetSeekIndex, jlong jContext,
+             jbyteArray jSeekIndex) {
+  Context *context = reinterpret_cast<Context *>(jContext);
+  jsize size = env->GetArrayLength(jSeekIndex);
+  jbyte *seekIndex = env->GetByteArrayElements(jSeekIndex, NULL);
+  bool success = context->parser->getSeekIndex().deserialize(
+      reinterpret_cast<const uint8_t *>(seekIndex), size);
+  env->ReleaseByteArrayElements(jSeekIndex, seekIndex, JNI_ABORT);
+  return success;
+}
+
+DECODER_FUNC(jboolean, flacScanSeekIndex, jlong jContext) {
+  Context *context = reinterpret_cast<Context *>(jContext);
+  FLACParser *parser = context->parser;
+  SeekIndex &seekIndex = parser->getSeekIndex();
+  // Only a file descriptor can be read at any offset, and the scan starts
+  // after the metadata.
+  if (!context->fileSource->isOpen() || parser->getFirstFrameOffset() == 0) {
+    return false;
+  }
+  if (!seekIndex.isComplete()) {
+    seekIndex.scan(context->fileSource, parser->getFirstFrameOffset(),
+                   context->fileSource->getLength());
+  }
+  return seekIndex.isComplete();
+}
+
 DECODER_FUNC(jstring, flacGetStateString, jlong jContext) {
   Context *context = reinterpret_cast<Context *>(jContext);
   const char *str = context->parser->getDecoderStateString();
@@ -224,17 +524,143 @@ DECODER_FUNC(jboolean, flacIsDecoderAtEndOfStream, jlong jContext) {
   return context->parser->isDecoderAtEndOfStream();
 }
 
+DECODER_FUNC(jboolean, flacSetFileDescriptor, jlong jContext, jint fd,
+             jlong offset, jlong length) {
+  Context *context = reinterpret_cast<Context *>(jContext);
+  context->source->clear();
+  if (fd < 0) {
+    context->fileSource->close();
+    context->parser->setDataSource(context->source);
+    return true;
+  }
+  if (!context->fileSource->open(fd, offset, length)) {
+    context->parser->setDataSource(context->source);
+    return false;
+  }
+  context->parser->setDataSource(context->fileSource);
+  return true;
+}
+
+DECODER_FUNC(jboolean, flacSetOutputMode, jlong jContext, jint encoding,
+             jboolean downmixToStereo) {
+  Context *context = reinterpret_cast<Context *>(jContext);
+  return context->parser->setOutputMode(
+      static_cast<PcmOutputEncoding>(encoding), downmixToStereo);
+}
+
+DECODER_FUNC(jboolean, flacHasBufferedData, jlong jContext) {
+  Context *context = reinterpret_cast<Context *>(jContext);
+  return context->source->hasBufferedData();
+}
+
 DECODER_FUNC(void, flacFlush, jlong jContext) {
   Context *context = reinterpret_cast<Context *>(jContext);
+  // The data read ahead belongs to the input before the flush.
+  context->source->clear();
   context->parser->flush();
 }
 
 DECODER_FUNC(void, flacReset, jlong jContext, jlong newPosition) {
   Context *context = reinterpret_cast<Context *>(jContext);
+  context->source->clear();
   context->parser->reset(newPosition);
 }
 
 DECODER_FUNC(void, flacRelease, jlong jContext) {
   Context *context = reinterpret_cast<Context *>(jContext);
+  context->javaSource->release(env);
   delete context;
 }
+
+PROBE_FUNC(jobject, flacProbe, jint fd, jlong offset, jlong length,
+           jobjectArray jVorbisCommentKeys) {
+  FileDataSource source;
+  if (!source.open(fd, offset, length)) {
+    return NULL;
+  }
+  FlacProbe probe(&source);
+  if (jVorbisCommentKeys != NULL) {
+    std::vector<std::string> keys;
+    jsize keyCount = env->GetArrayLength(jVorbisCommentKeys);
+    for (jsize i = 0; i < keyCount; i++) {
+      jstring jKey = static_cast<jstring>(
+          env->GetObjectArrayElement(jVorbisCommentKeys, i));
+      const char *key = env->GetStringUTFChars(jKey, NULL);
+      keys.push_back(key);
+      env->ReleaseStringUTFChars(jKey, key);
+      env->DeleteLocalRef(jKey);
+    }
+    probe.setVorbisCommentKeys(keys);
+  }
+  if (!probe.probe()) {
+    return NULL;
+  }
+
+  jobject commentList = env->NewObject(arrayListClass, arrayListConstructor);
+  const std::vector<std::string> &vorbisComments = probe.getVorbisComments();
+  for (std::vector<std::string>::const_iterator vorbisComment =
+           vorbisComments.begin();
+       vorbisComment != vorbisComments.end(); ++vorbisComment) {
+    jstring commentString = env->NewStringUTF(vorbisComment->c_str());
+    env->CallBooleanMethod(commentList, arrayListAddMethod, commentString);
+    env->DeleteLocalRef(commentString);
+  }
+
+  jobject pictures = env->NewObject(arrayListClass, arrayListConstructor);
+  const std::vector<FlacProbePicture> &probePictures = probe.getPictures();
+  for (std::vector<FlacProbePicture>::const_iterator picture =
+           probePictures.begin();
+       picture != probePictures.end(); ++picture) {
+    jstring mimeType = env->NewStringUTF(picture->mimeType.c_str());
+    jstring description = env->NewStringUTF(picture->description.c_str());
+    jobject pictureObject = env->NewObject(
+        probePictureClass, probePictureConstructor, picture->type, mimeType,
+        description, picture->width, picture->height, picture->depth,
+        picture->colors, static_cast<jlong>(picture->dataOffset),
+        static_cast<jint>(picture->dataLength));
+    env->CallBooleanMethod(pictures, arrayListAddMethod, pictureObject);
+    env->DeleteLocalRef(mimeType);
+    env->DeleteLocalRef(description);
+    env->DeleteLocalRef(pictureObject);
+  }
+
+  // The pictures aren't part of the stream metadata, as their data isn't read.
+  const FLAC__StreamMetadata_StreamInfo &streamInfo = probe.getStreamInfo();
+  jobject pictureFrames = env->NewObject(arrayListClass, arrayListConstructor);
+  jobject streamMetadata = env->NewObject(
+      flacStreamMetadataClass, flacStreamMetadataConstructor,
+      streamInfo.min_blocksize, streamInfo.max_blocksize,
+      streamInfo.min_framesize, streamInfo.max_framesize,
+      streamInfo.sample_rate, streamInfo.channels, streamInfo.bits_per_sample,
+      streamInfo.total_samples, commentList, pictureFrames);
+  return env->NewObject(probeClass, probeConstructor, streamMetadata, pictures,
+                        static_cast<jlong>(probe.getFirstFrameOffset()),
+                        offset);
+}
+
+PROBE_FUNC(jbyteArray, flacReadPictureData, jint fd, jlong position,
+           jint length) {
+  jbyteArray pictureData = env->NewByteArray(length);
+  if (pictureData == NULL) {
+    return NULL;
+  }
+  jbyte *data = env->GetByteArrayElements(pictureData, NULL);
+  jint bytesRead = 0;
+  while (bytesRead < length) {
+    ssize_t result =
+        pread64(fd, data + bytesRead, length - bytesRead, position + bytesRead);
+    if (result < 0 && errno == EINTR) {
+      continue;
+    }
+    if (result <= 0) {
+      break;
+    }
+    bytesRead += result;
+  }
+  env->ReleaseByteArrayElements(pictureData, data, 0);
+  if (bytesRead < length) {
+    env->DeleteLocalRef(pictureData);
+    return NULL;
+  }
+  return pictureData;
+}
@@ -138,10 +138,21 @@ FLAC__StreamDecoderTellStatus FLACParser::tellCallback(
 
 FLAC__StreamDecoderLengthStatus FLACParser::lengthCallback(
     FLAC__uint64 *stream_length) {
-  return FLAC__STREAM_DECODER_LENGTH_STATUS_UNSUPPORTED;
+  off64_t length = mDataSource->getLength();
+  if (length < 0) {
+    return FLAC__STREAM_DECODER_LENGTH_STATUS_UNSUPPORTED;
+  }
+  *stream_length = length;
+  return FLAC__STREAM_DECODER_LENGTH_STATUS_OK;
 }
 
-FLAC__bool FLACParser::eofCallback() { return mEOF; }
+FLAC__bool FLACParser::eofCallback() {
+  if (mEOF) {
+    return true;
+  }
+  off64_t length = mDataSource->getLength();
+  return length >= 0 && mCurrentPos >= length;
+}
 
 FLAC__StreamDecoderWriteStatus FLACParser::writeCallback(
     const FLAC__Frame *frame, const FLAC__int32 *const buffer[]) {
@@ -164,6 +175,7 @@ void FLACParser::metadataCallback(const FLAC__StreamMetadata *metadata) {
       if (!mStreamInfoValid) {
         mStreamInfo = metadata->data.stream_info;
         mStreamInfoValid = true;
+        mSeekIndex.setStreamInfo(mStreamInfo);
       } else {
         ALOGE("FLACParser::metadataCallback unexpected STREAMINFO");
       }
@@ -219,42 +231,10 @@ void FLACParser::errorCallback(FLAC__StreamDecoderErrorStatus status) {
   mErrorStatus = status;
 }
 
-// Copy samples from FLAC native 32-bit non-interleaved to
-// correct bit-depth (non-zero padded), interleaved.
-// These are candidates for optimization if needed.
-static void copyToByteArrayBigEndian(int8_t *dst, const int *const *src,
-                                     unsigned bytesPerSample, unsigned nSamples,
-                                     unsigned nChannels) {
-  for (unsigned i = 0; i < nSamples; ++i) {
-    for (unsigned c = 0; c < nChannels; ++c) {
-      // point to the first byte of the source address
-      // and then skip the first few bytes (most significant bytes)
-      // depending on the bit depth
-      const int8_t *byteSrc =
-          reinterpret_cast<const int8_t *>(&src[c][i]) + 4 - bytesPerSample;
-      memcpy(dst, byteSrc, bytesPerSample);
-      dst = dst + bytesPerSample;
-    }
-  }
-}
-
-static void copyToByteArrayLittleEndian(int8_t *dst, const int *const *src,
-                                        unsigned bytesPerSample,
-                                        unsigned nSamples, unsigned nChannels) {
-  for (unsigned i = 0; i < nSamples; ++i) {
-    for (unsigned c = 0; c < nChannels; ++c) {
-      // with little endian, the most significant bytes will be at the end
-      // copy the bytes in little endian will remove the most significant byte
-      // so we are good here.
-      memcpy(dst, &(src[c][i]), bytesPerSample);
-      dst = dst + bytesPerSample;
-    }
-  }
-}
-
 static void copyTrespass(int8_t * /* dst */, const int *const * /* src */,
                          unsigned /* bytesPerSample */, unsigned /* nSamples */,
-                         unsigned /* nChannels */) {
+                         unsigned /* nChannels */,
+                         uint32_t * /* ditherState */) {
   TRESPASS();
 }
 
@@ -263,6 +243,9 @@ static void copyTrespass(int8_t * /* dst */, const int *const * /* src */,
 FLACParser::FLACParser(DataSource *source)
     : mDataSource(source),
       mCopy(copyTrespass),
+      mOutputEncoding(kPcmOutputEncodingSource),
+      mDownmixToStereo(false),
+      mDitherState(1),
       mDecoder(NULL),
       mCurrentPos(0LL),
       mEOF(false),
@@ -330,6 +313,7 @@ bool FLACParser::decodeMetadata() {
   }
   // store first frame offset
   FLAC__stream_decoder_get_decode_position(mDecoder, &firstFrameOffset);
+  mSeekIndex.add(0, firstFrameOffset);
 
   if (mStreamInfoValid) {
     // check channel count
@@ -348,11 +332,8 @@ bool FLACParser::decodeMetadata() {
         ALOGE("unsupported bits per sample %u", getBitsPerSample());
         return false;
     }
-    // configure the appropriate copy function based on device endianness.
-    if (isBigEndian()) {
-      mCopy = copyToByteArrayBigEndian;
-    } else {
-      mCopy = copyToByteArrayLittleEndian;
+    if (!selectCopyFunction()) {
+      return false;
     }
   } else {
     ALOGE("missing STREAMINFO");
@@ -361,19 +342,48 @@ bool FLACParser::decodeMetadata() {
   return true;
 }
 
-size_t FLACParser::readBuffer(void *output, size_t output_size) {
+bool FLACParser::setOutputMode(PcmOutputEncoding encoding,
+                               bool downmixToStereo) {
+  mOutputEncoding = encoding;
+  mDownmixToStereo = downmixToStereo;
+  return !mStreamInfoValid || selectCopyFunction();
+}
+
+bool FLACParser::selectCopyFunction() {
+  // configure the appropriate copy function based on device endianness,
+  // specialized for the stream's sample size and channel count.
+  if (isBigEndian()) {
+    if (mOutputEncoding != kPcmOutputEncodingSource || mDownmixToStereo) {
+      ALOGE("output conversion is only supported on little endian devices");
+      return false;
+    }
+    mCopy = getBigEndianPcmCopyFunction();
+  } else {
+    mCopy = getLittleEndianPcmCopyFunction(mOutputEncoding, mDownmixToStereo,
+                                           getBitsPerSample() >> 3,
+                                           getChannels());
+    if (mCopy == NULL) {
+      ALOGE("unsupported output encoding %d for %u channels",
+            mOutputEncoding, getChannels());
+      return false;
+    }
+  }
+  return true;
+}
+
+size_t FLACParser::decodeFrame() {
   mWriteRequested = true;
   mWriteCompleted = false;
 
   if (!FLAC__stream_decoder_process_single(mDecoder)) {
-    ALOGE("FLACParser::readBuffer process_single failed. Status: %s",
+    ALOGE("FLACParser::decodeFrame process_single failed. Status: %s",
           getDecoderStateString());
     return -1;
   }
   if (!mWriteCompleted) {
     if (FLAC__stream_decoder_get_state(mDecoder) !=
         FLAC__STREAM_DECODER_END_OF_STREAM) {
-      ALOGE("FLACParser::readBuffer write did not complete. Status: %s",
+      ALOGE("FLACParser::decodeFrame write did not complete. Status: %s",
             getDecoderStateString());
     }
     return -1;
@@ -382,23 +392,39 @@ size_t FLACParser::readBuffer(void *output, size_t output_size) {
   // verify that block header keeps the promises made by STREAMINFO
   unsigned blocksize = mWriteHeader.blocksize;
   if (blocksize == 0 || blocksize > getMaxBlockSize()) {
-    ALOGE("FLACParser::readBuffer write invalid blocksize %u", blocksize);
+    ALOGE("FLACParser::decodeFrame write invalid blocksize %u", blocksize);
     return -1;
   }
   if (mWriteHeader.sample_rate != getSampleRate() ||
       mWriteHeader.channels != getChannels() ||
       mWriteHeader.bits_per_sample != getBitsPerSample()) {
     ALOGE(
-        "FLACParser::readBuffer write changed parameters mid-stream: %d/%d/%d "
-        "-> %d/%d/%d",
+        "FLACParser::decodeFrame write changed parameters mid-stream: "
+        "%d/%d/%d -> %d/%d/%d",
         getSampleRate(), getChannels(), getBitsPerSample(),
         mWriteHeader.sample_rate, mWriteHeader.channels,
         mWriteHeader.bits_per_sample);
     return -1;
   }
 
-  unsigned bytesPerSample = getBitsPerSample() >> 3;
-  size_t bufferSize = blocksize * getChannels() * bytesPerSample;
+  // fill in buffer metadata
+  CHECK(mWriteHeader.number_type == FLAC__FRAME_NUMBER_TYPE_SAMPLE_NUMBER);
+
+  // the decode position is now that of the next frame, wherever decoding
+  // started from
+  uint64_t nextFrameOffset;
+  if (FLAC__stream_decoder_get_decode_position(mDecoder, &nextFrameOffset)) {
+    mSeekIndex.add(getNextFrameFirstSampleIndex(), nextFrameOffset);
+  }
+
+  return blocksize * getOutputChannels() * getOutputBytesPerSample();
+}
+
+size_t FLACParser::readBuffer(void *output, size_t output_size) {
+  size_t bufferSize = decodeFrame();
+  if (bufferSize == static_cast<size_t>(-1)) {
+    return -1;
+  }
   if (bufferSize > output_size) {
     ALOGE(
         "FLACParser::readBuffer not enough space in output buffer "
@@ -408,19 +434,46 @@ size_t FLACParser::readBuffer(void *output, size_t output_size) {
   }
 
   // copy PCM from FLAC write buffer to our media buffer, with interleaving.
-  (*mCopy)(reinterpret_cast<int8_t *>(output), mWriteBuffer, bytesPerSample,
-           blocksize, getChannels());
-
-  // fill in buffer metadata
-  CHECK(mWriteHeader.number_type == FLAC__FRAME_NUMBER_TYPE_SAMPLE_NUMBER);
+  (*mCopy)(reinterpret_cast<int8_t *>(output), mWriteBuffer,
+           getBitsPerSample() >> 3, mWriteHeader.blocksize, getChannels(),
+           &mDitherState);
 
   return bufferSize;
 }
 
+size_t FLACParser::readBuffers(void *output, size_t output_size,
+                               int64_t *frameFirstSampleIndices,
+                               size_t maxFrames) {
+  // A frame is only decoded if a frame of the maximum size would fit, as it
+  // can't be put back once decoded.
+  size_t maxFrameSize =
+      getMaxBlockSize() * getOutputChannels() * getOutputBytesPerSample();
+  int8_t *dst = reinterpret_cast<int8_t *>(output);
+  size_t frames = 0;
+  while (frames < maxFrames) {
+    if (frames > 0 && output_size < maxFrameSize) {
+      break;
+    }
+    size_t bufferSize = readBuffer(dst, output_size);
+    if (bufferSize == static_cast<size_t>(-1)) {
+      // frames decoded before the end of the stream are returned, but an error
+      // fails the whole batch so that the caller can retry it.
+      if (frames > 0 && isDecoderAtEndOfStream()) {
+        break;
+      }
+      return -1;
+    }
+    frameFirstSampleIndices[frames++] = getLastFrameFirstSampleIndex();
+    dst += bufferSize;
+    output_size -= bufferSize;
+  }
+  return frames;
+}
+
 bool FLACParser::getSeekPositions(int64_t timeUs,
                                   std::array<int64_t, 4> &result) {
   if (!mSeekTable) {
-    return false;
+    return getSeekIndexPositions(timeUs, result);
   }
 
   unsigned sampleRate = getSampleRate();
@@ -459,3 +512,48 @@ bool FLACParser::getSeekPositions(int64_t timeUs,
   result[3] = firstFrameOffset;
   return true;
 }
+
+bool FLACParser::getSeekIndexPositions(int64_t timeUs,
+                                       std::array<int64_t, 4> &result) {
+  // a partial index can't tell whether a better seek point exists
+  if (!mSeekIndex.isComplete()) {
+    return false;
+  }
+  unsigned sampleRate = getSampleRate();
+  int64_t totalSamples = getTotalSamples();
+  int64_t targetSampleNumber = (timeUs * sampleRate) / 1000000LL;
+  if (targetSampleNumber >= totalSamples) {
+    targetSampleNumber = totalSamples - 1;
+  }
+  SeekIndex::Point floor;
+  SeekIndex::Point ceiling;
+  if (!mSeekIndex.find(targetSampleNumber, &floor, &ceiling)) {
+    floor.sampleNumber = 0;
+    floor.offset = firstFrameOffset;
+    ceiling = floor;
+  }
+  result[0] = (floor.sampleNumber * 1000000LL) / sampleRate;
+  result[1] = floor.offset;
+  result[2] = (ceiling.sampleNumber * 1000000LL) / sampleRate;
+  result[3] = ceiling.offset;
+  return true;
+}
+
+bool FLACParser::getSeekIndexBounds(int64_t sampleNumber,
+                                    std::array<int64_t, 4> &result) {
+  SeekIndex::Point floor;
+  SeekIndex::Point ceiling;
+  if (!mSeekIndex.find(sampleNumber, &floor, &ceiling)) {
+    return false;
+  }
+  if (ceiling.sampleNumber == floor.sampleNumber &&
+      floor.sampleNumber != sampleNumber) {
+    ceiling.sampleNumber = -1;
+    ceiling.offset = -1;
+  }
+  result[0] = floor.sampleNumber;
+  result[1] = floor.offset;
+  result[2] = ceiling.sampleNumber;
+  result[3] = ceiling.offset;
+  return true;
+}
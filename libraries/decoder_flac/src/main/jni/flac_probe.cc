@@ -0,0 +1,278 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "include/flac_probe.h"
+
+#include <android/log.h>
+#include <strings.h>
+
+#include <cstring>
+
+#define LOG_TAG "FlacProbe"
+#define ALOGE(...) \
+  ((void)__android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__))
+
+namespace {
+
+const size_t kMetadataBlockHeaderSize = 4;
+const size_t kStreamInfoSize = 34;
+const size_t kId3HeaderSize = 10;
+// the fixed size fields of a PICTURE block, besides the two strings
+const int64_t kPictureFieldsSize = 32;
+
+uint32_t readBigEndian32(const uint8_t *data) {
+  return (static_cast<uint32_t>(data[0]) << 24) |
+         (static_cast<uint32_t>(data[1]) << 16) |
+         (static_cast<uint32_t>(data[2]) << 8) | data[3];
+}
+
+uint32_t readLittleEndian32(const uint8_t *data) {
+  return (static_cast<uint32_t>(data[3]) << 24) |
+         (static_cast<uint32_t>(data[2]) << 16) |
+         (static_cast<uint32_t>(data[1]) << 8) | data[0];
+}
+
+}  // namespace
+
+FlacProbe::FlacProbe(DataSource *source)
+    : mSource(source), mFilterVorbisComments(false), mFirstFrameOffset(0) {
+  memset(&mStreamInfo, 0, sizeof(mStreamInfo));
+}
+
+void FlacProbe::setVorbisCommentKeys(const std::vector<std::string> &keys) {
+  mFilterVorbisComments = true;
+  mVorbisCommentKeys = keys;
+}
+
+bool FlacProbe::probe() {
+  int64_t offset = 0;
+  if (!skipId3Tags(&offset)) {
+    return false;
+  }
+  uint8_t marker[4];
+  if (!readFully(offset, marker, sizeof(marker)) ||
+      memcmp(marker, "fLaC", sizeof(marker)) != 0) {
+    return false;
+  }
+  offset += sizeof(marker);
+
+  bool streamInfoRead = false;
+  bool vorbisCommentsRead = false;
+  bool isLastBlock = false;
+  while (!isLastBlock) {
+    uint8_t header[kMetadataBlockHeaderSize];
+    if (!readFully(offset, header, sizeof(header))) {
+      return false;
+    }
+    isLastBlock = header[0] & 0x80;
+    unsigned type = header[0] & 0x7f;
+    uint32_t length = readBigEndian32(header) & 0xffffff;
+    offset += sizeof(header);
+    // STREAMINFO has to be the first block
+    if (!streamInfoRead && type != FLAC__METADATA_TYPE_STREAMINFO) {
+      return false;
+    }
+    switch (type) {
+      case FLAC__METADATA_TYPE_STREAMINFO:
+        if (streamInfoRead || !parseStreamInfo(offset, length)) {
+          return false;
+        }
+        streamInfoRead = true;
+        break;
+      case FLAC__METADATA_TYPE_VORBIS_COMMENT:
+        // like FLACParser, only the first block is used
+        if (!vorbisCommentsRead) {
+          if (!parseVorbisComments(offset, length)) {
+            return false;
+          }
+          vorbisCommentsRead = true;
+        }
+        break;
+      case FLAC__METADATA_TYPE_PICTURE:
+        if (!parsePicture(offset, length)) {
+          return false;
+        }
+        break;
+      default:
+        break;
+    }
+    offset += length;
+  }
+  mFirstFrameOffset = offset;
+  return true;
+}
+
+bool FlacProbe::readFully(int64_t offset, void *data, size_t size) {
+  uint8_t *target = static_cast<uint8_t *>(data);
+  while (size > 0) {
+    ssize_t result = mSource->readAt(offset, target, size);
+    if (result <= 0) {
+      return false;
+    }
+    target += result;
+    offset += result;
+    size -= result;
+  }
+  return true;
+}
+
+bool FlacProbe::skipId3Tags(int64_t *offset) {
+  // libFLAC skips ID3v2 tags before the stream marker, so the probe does too
+  while (true) {
+    uint8_t header[kId3HeaderSize];
+    if (!readFully(*offset, header, sizeof(header))) {
+      return false;
+    }
+    if (memcmp(header, "ID3", 3) != 0) {
+      return true;
+    }
+    // the size is a 28-bit synchsafe integer, excluding the header and footer
+    int64_t size = ((header[6] & 0x7f) << 21) | ((header[7] & 0x7f) << 14) |
+                   ((header[8] & 0x7f) << 7) | (header[9] & 0x7f);
+    bool hasFooter = header[5] & 0x10;
+    *offset += kId3HeaderSize + size + (hasFooter ? kId3HeaderSize : 0);
+  }
+}
+
+bool FlacProbe::parseStreamInfo(int64_t offset, uint32_t length) {
+  uint8_t data[kStreamInfoSize];
+  if (length != kStreamInfoSize || !readFully(offset, data, sizeof(data))) {
+    return false;
+  }
+  mStreamInfo.min_blocksize = (data[0] << 8) | data[1];
+  mStreamInfo.max_blocksize = (data[2] << 8) | data[3];
+  mStreamInfo.min_framesize = (data[4] << 16) | (data[5] << 8) | data[6];
+  mStreamInfo.max_framesize = (data[7] << 16) | (data[8] << 8) | data[9];
+  mStreamInfo.sample_rate =
+      (data[10] << 12) | (data[11] << 4) | (data[12] >> 4);
+  mStreamInfo.channels = ((data[12] >> 1) & 0x07) + 1;
+  mStreamInfo.bits_per_sample =
+      (((data[12] & 0x01) << 4) | (data[13] >> 4)) + 1;
+  mStreamInfo.total_samples =
+      (static_cast<FLAC__uint64>(data[13] & 0x0f) << 32) |
+      readBigEndian32(data + 14);
+  memcpy(mStreamInfo.md5sum, data + 18, sizeof(mStreamInfo.md5sum));
+  return mStreamInfo.sample_rate != 0;
+}
+
+bool FlacProbe::parseVorbisComments(int64_t offset, uint32_t length) {
+  if (mFilterVorbisComments && mVorbisCommentKeys.empty()) {
+    return true;
+  }
+  std::vector<uint8_t> block(length);
+  if (length < 8 || !readFully(offset, block.data(), length)) {
+    return false;
+  }
+  const uint8_t *data = block.data();
+  const uint8_t *end = data + length;
+  uint32_t vendorLength = readLittleEndian32(data);
+  if (vendorLength > length - 8) {
+    return false;
+  }
+  data += 4 + vendorLength;
+  uint32_t count = readLittleEndian32(data);
+  data += 4;
+  for (uint32_t i = 0; i < count; i++) {
+    if (end - data < 4) {
+      return false;
+    }
+    uint32_t commentLength = readLittleEndian32(data);
+    data += 4;
+    if (commentLength > static_cast<size_t>(end - data)) {
+      return false;
+    }
+    std::string comment(reinterpret_cast<const char *>(data), commentLength);
+    if (isVorbisCommentKept(comment)) {
+      mVorbisComments.push_back(comment);
+    }
+    data += commentLength;
+  }
+  return true;
+}
+
+bool FlacProbe::parsePicture(int64_t offset, uint32_t length) {
+  const int64_t end = offset + length;
+  uint8_t fields[20];
+  FlacProbePicture picture;
+
+  // type and MIME type
+  if (length < kPictureFieldsSize || !readFully(offset, fields, 8)) {
+    return false;
+  }
+  picture.type = readBigEndian32(fields);
+  uint32_t stringLength = readBigEndian32(fields + 4);
+  offset += 8;
+  if (stringLength > end - offset - (kPictureFieldsSize - 8)) {
+    return false;
+  }
+  picture.mimeType.resize(stringLength);
+  if (!readFully(offset, &picture.mimeType[0], stringLength)) {
+    return false;
+  }
+  offset += stringLength;
+
+  // description
+  if (!readFully(offset, fields, 4)) {
+    return false;
+  }
+  stringLength = readBigEndian32(fields);
+  offset += 4;
+  if (stringLength > end - offset - (kPictureFieldsSize - 12)) {
+    return false;
+  }
+  picture.description.resize(stringLength);
+  if (!readFully(offset, &picture.description[0], stringLength)) {
+    return false;
+  }
+  offset += stringLength;
+
+  // dimensions and data length
+  if (!readFully(offset, fields, sizeof(fields))) {
+    return false;
+  }
+  picture.width = readBigEndian32(fields);
+  picture.height = readBigEndian32(fields + 4);
+  picture.depth = readBigEndian32(fields + 8);
+  picture.colors = readBigEndian32(fields + 12);
+  picture.dataLength = readBigEndian32(fields + 16);
+  offset += sizeof(fields);
+  if (picture.dataLength > end - offset) {
+    ALOGE("FlacProbe::parsePicture invalid data length");
+    return false;
+  }
+  picture.dataOffset = offset;
+  mPictures.push_back(picture);
+  return true;
+}
+
+bool FlacProbe::isVorbisCommentKept(const std::string &comment) const {
+  if (!mFilterVorbisComments) {
+    return true;
+  }
+  size_t separator = comment.find('=');
+  if (separator == std::string::npos) {
+    return false;
+  }
+  for (std::vector<std::string>::const_iterator key =
+           mVorbisCommentKeys.begin();
+       key != mVorbisCommentKeys.end(); ++key) {
+    if (key->size() == separator &&
+        strncasecmp(key->c_str(), comment.c_str(), separator) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
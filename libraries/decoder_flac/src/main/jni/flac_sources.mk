@@ -15,8 +15,12 @@
 #
 
 FLAC_SOURCES = \
+  buffered_data_source.cc                        \
   flac_jni.cc                                    \
   flac_parser.cc                                 \
+  flac_probe.cc                                  \
+  pcm_copy.cc                                    \
+  seek_index.cc                                  \
   flac/src/libFLAC/bitmath.c                     \
   flac/src/libFLAC/bitreader.c                   \
   flac/src/libFLAC/bitwriter.c                   \
@@ -0,0 +1,70 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef INCLUDE_BUFFERED_DATA_SOURCE_H_
+#define INCLUDE_BUFFERED_DATA_SOURCE_H_
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#include <vector>
+
+#include "include/data_source.h"
+
+// A DataSource that reads ahead from another, sequential DataSource in large
+// chunks and serves the small reads of libFLAC from native memory, so that
+// reading from a JavaDataSource only crosses JNI once per chunk.
+class BufferedDataSource : public DataSource {
+ public:
+  static const size_t kDefaultCapacity = 64 * 1024;
+
+  // |source| must outlive this instance.
+  BufferedDataSource(DataSource *source, size_t capacity = kDefaultCapacity);
+
+  // Reads from the buffered data, refilling the buffer with a single read from
+  // the underlying source if it's empty. Reads at an offset other than that of
+  // the buffered data discard it. Reads of at least the buffer capacity bypass
+  // the buffer.
+  ssize_t readAt(off64_t offset, void *const data, size_t size);
+
+  off64_t getLength() { return mSource->getLength(); }
+
+  // Discards the buffered data, e.g. after the underlying source was
+  // repositioned.
+  void clear() { mStart = mEnd = 0; }
+
+  // Returns whether there's buffered data that hasn't been read yet.
+  bool hasBufferedData() const { return mStart < mEnd; }
+
+  // The memory the underlying source is read into. It doesn't move, so that
+  // the underlying source can wrap it once (e.g. in a direct ByteBuffer).
+  void *getBuffer() { return mBuffer.data(); }
+  size_t getCapacity() const { return mBuffer.size(); }
+
+ private:
+  DataSource *mSource;
+  std::vector<uint8_t> mBuffer;
+  // The buffered data is mBuffer[mStart, mEnd), at mOffset in the source.
+  size_t mStart;
+  size_t mEnd;
+  off64_t mOffset;
+
+  // no copy constructor or assignment
+  BufferedDataSource(const BufferedDataSource &);
+  BufferedDataSource &operator=(const BufferedDataSource &);
+};
+
+#endif  // INCLUDE_BUFFERED_DATA_SOURCE_H_
@@ -28,6 +28,8 @@
 #include "FLAC/stream_decoder.h"
 
 #include "include/data_source.h"
+#include "include/pcm_copy.h"
+#include "include/seek_index.h"
 
 typedef int status_t;
 
@@ -49,6 +51,10 @@ class FLACParser {
 
   bool init();
 
+  // Replaces the source of the data to parse. Takes effect with the next read,
+  // so it's typically followed by reset().
+  void setDataSource(DataSource *source) { mDataSource = source; }
+
   // stream properties
   unsigned getMaxBlockSize() const { return mStreamInfo.max_blocksize; }
   unsigned getSampleRate() const { return mStreamInfo.sample_rate; }
@@ -56,6 +62,20 @@ class FLACParser {
   unsigned getBitsPerSample() const { return mStreamInfo.bits_per_sample; }
   FLAC__uint64 getTotalSamples() const { return mStreamInfo.total_samples; }
 
+  // Sets the format of the PCM output, which defaults to integer samples with
+  // the stream's bit depth and channel count. Returns false if the stream can't
+  // be output in this format.
+  bool setOutputMode(PcmOutputEncoding encoding, bool downmixToStereo);
+
+  // output properties
+  unsigned getOutputChannels() const {
+    return getPcmOutputChannels(mDownmixToStereo, getChannels());
+  }
+  unsigned getOutputBytesPerSample() const {
+    return getPcmOutputBytesPerSample(mOutputEncoding,
+                                      getBitsPerSample() >> 3);
+  }
+
   const FLAC__StreamMetadata_StreamInfo& getStreamInfo() const {
     return mStreamInfo;
   }
@@ -85,8 +105,29 @@ class FLACParser {
   bool decodeMetadata();
   size_t readBuffer(void *output, size_t output_size);
 
+  // Decodes up to maxFrames whole frames into output, one after the other,
+  // stopping early when the next frame might not fit or at the end of the
+  // stream. Stores the first sample index of each decoded frame in
+  // frameFirstSampleIndices. Returns the number of decoded frames, or -1 on
+  // error or if no frame could be decoded.
+  size_t readBuffers(void *output, size_t output_size,
+                     int64_t *frameFirstSampleIndices, size_t maxFrames);
+
   bool getSeekPositions(int64_t timeUs, std::array<int64_t, 4> &result);
 
+  // Returns the sample numbers and byte offsets of the indexed frames around
+  // sampleNumber, as {floorSample, floorOffset, ceilingSample, ceilingOffset}.
+  // The ceiling is -1 if no frame after sampleNumber is indexed. Returns false
+  // if no frame at or before sampleNumber is indexed.
+  bool getSeekIndexBounds(int64_t sampleNumber,
+                          std::array<int64_t, 4> &result);
+
+  // The index of the frames of the stream, used for seeking if there's no
+  // SEEKTABLE once it's complete.
+  SeekIndex &getSeekIndex() { return mSeekIndex; }
+
+  int64_t getFirstFrameOffset() const { return firstFrameOffset; }
+
   void flush() {
     reset(mCurrentPos);
   }
@@ -129,8 +170,10 @@ class FLACParser {
  private:
   DataSource *mDataSource;
 
-  void (*mCopy)(int8_t *dst, const int *const *src, unsigned bytesPerSample,
-                unsigned nSamples, unsigned nChannels);
+  PcmCopyFunction mCopy;
+  PcmOutputEncoding mOutputEncoding;
+  bool mDownmixToStereo;
+  uint32_t mDitherState;
 
   // handle to underlying libFLAC parser
   FLAC__StreamDecoder *mDecoder;
@@ -146,6 +189,9 @@ class FLACParser {
   const FLAC__StreamMetadata_SeekTable *mSeekTable;
   uint64_t firstFrameOffset;
 
+  // built as frames are decoded
+  SeekIndex mSeekIndex;
+
   // cached when the VORBIS_COMMENT metadata is parsed by libFLAC
   std::vector<std::string> mVorbisComments;
   bool mVorbisCommentsValid;
@@ -167,6 +213,15 @@ class FLACParser {
   FLACParser(const FLACParser &);
   FLACParser &operator=(const FLACParser &);
 
+  bool getSeekIndexPositions(int64_t timeUs, std::array<int64_t, 4> &result);
+
+  // selects mCopy for the stream and output mode
+  bool selectCopyFunction();
+
+  // decodes the next frame into mWriteBuffer, returning its size once
+  // interleaved, or -1 on error or at the end of the stream
+  size_t decodeFrame();
+
   // FLAC parser callbacks as C++ instance methods
   FLAC__StreamDecoderReadStatus readCallback(FLAC__byte buffer[],
                                              size_t *bytes);
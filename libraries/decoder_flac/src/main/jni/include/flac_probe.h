@@ -0,0 +1,98 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef INCLUDE_FLAC_PROBE_H_
+#define INCLUDE_FLAC_PROBE_H_
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include "FLAC/format.h"
+#include "include/data_source.h"
+
+// A picture found by FlacProbe. The picture data isn't read, only its position
+// in the source, so that it can be read later if needed.
+struct FlacProbePicture {
+  int type;
+  std::string mimeType;
+  std::string description;
+  FLAC__uint32 width;
+  FLAC__uint32 height;
+  FLAC__uint32 depth;
+  FLAC__uint32 colors;
+  int64_t dataOffset;
+  FLAC__uint32 dataLength;
+};
+
+// Reads the metadata blocks of a FLAC stream without creating a libFLAC
+// decoder, e.g. to scan the files of a media library. Only the blocks that are
+// needed are read, and the source is read at explicit offsets, so the probe
+// never reads audio data.
+//
+// Instances aren't shared, so probes of different sources can run
+// concurrently.
+class FlacProbe {
+ public:
+  explicit FlacProbe(DataSource *source);
+
+  // Limits the Vorbis comments that are kept to the ones whose field name
+  // matches one of keys, ignoring case. All comments are kept by default.
+  void setVorbisCommentKeys(const std::vector<std::string> &keys);
+
+  // Reads the metadata blocks. Returns false if the source isn't a FLAC stream
+  // or can't be read.
+  bool probe();
+
+  const FLAC__StreamMetadata_StreamInfo &getStreamInfo() const {
+    return mStreamInfo;
+  }
+
+  const std::vector<std::string> &getVorbisComments() const {
+    return mVorbisComments;
+  }
+
+  const std::vector<FlacProbePicture> &getPictures() const {
+    return mPictures;
+  }
+
+  // The offset of the first frame, after the metadata blocks.
+  int64_t getFirstFrameOffset() const { return mFirstFrameOffset; }
+
+ private:
+  DataSource *mSource;
+  bool mFilterVorbisComments;
+  std::vector<std::string> mVorbisCommentKeys;
+
+  FLAC__StreamMetadata_StreamInfo mStreamInfo;
+  std::vector<std::string> mVorbisComments;
+  std::vector<FlacProbePicture> mPictures;
+  int64_t mFirstFrameOffset;
+
+  bool readFully(int64_t offset, void *data, size_t size);
+  bool skipId3Tags(int64_t *offset);
+  bool parseStreamInfo(int64_t offset, uint32_t length);
+  bool parseVorbisComments(int64_t offset, uint32_t length);
+  bool parsePicture(int64_t offset, uint32_t length);
+  bool isVorbisCommentKept(const std::string &comment) const;
+
+  // no copy constructor or assignment
+  FlacProbe(const FlacProbe &);
+  FlacProbe &operator=(const FlacProbe &);
+};
+
+#endif  // INCLUDE_FLAC_PROBE_H_
@@ -0,0 +1,63 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef INCLUDE_PCM_COPY_H_
+#define INCLUDE_PCM_COPY_H_
+
+#include <stdint.h>
+
+// The encodings a PcmCopyFunction can write.
+enum PcmOutputEncoding {
+  // integer samples of the source size
+  kPcmOutputEncodingSource = 0,
+  // 32-bit float samples in [-1, 1]
+  kPcmOutputEncodingFloat = 1,
+  // 16-bit integer samples, with triangular dither if the source is larger
+  kPcmOutputEncoding16Bit = 2,
+};
+
+// Copies |nSamples| samples of each of the |nChannels| planar 32-bit channels
+// in |src|, holding samples of |bytesPerSample| bytes, to |dst| as interleaved
+// PCM. |ditherState| holds the state of the dither noise generator, if any.
+typedef void (*PcmCopyFunction)(int8_t *dst, const int *const *src,
+                                unsigned bytesPerSample, unsigned nSamples,
+                                unsigned nChannels, uint32_t *ditherState);
+
+// Returns the number of channels written by a copy function.
+unsigned getPcmOutputChannels(bool downmixToStereo, unsigned nChannels);
+
+// Returns the size of the samples written by a copy function.
+unsigned getPcmOutputBytesPerSample(PcmOutputEncoding encoding,
+                                    unsigned bytesPerSample);
+
+// Returns a copy function writing little endian samples with the given
+// encoding, specialized for the given sample size (1 to 4 bytes) and channel
+// count (1 to 8). If |downmixToStereo| is set, streams of more than 2 channels
+// are downmixed to stereo in the same pass. Returns NULL if there's no
+// specialization.
+//
+// The stereo and 5.1 cases of the 16, 24 and 32-bit sample sizes, and stereo
+// float output, are vectorized with NEON or SSE where available.
+PcmCopyFunction getLittleEndianPcmCopyFunction(PcmOutputEncoding encoding,
+                                               bool downmixToStereo,
+                                               unsigned bytesPerSample,
+                                               unsigned nChannels);
+
+// Returns a generic copy function writing big endian samples of the source
+// size.
+PcmCopyFunction getBigEndianPcmCopyFunction();
+
+#endif  // INCLUDE_PCM_COPY_H_
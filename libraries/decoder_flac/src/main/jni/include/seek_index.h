@@ -0,0 +1,111 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef INCLUDE_SEEK_INDEX_H_
+#define INCLUDE_SEEK_INDEX_H_
+
+#include <stdint.h>
+
+#include <mutex>
+#include <vector>
+
+#include "FLAC/format.h"
+#include "include/data_source.h"
+
+// An index of the byte offsets of the frames of a FLAC stream, for seeking in
+// streams without a SEEKTABLE. Points are recorded as frames are decoded, and
+// can be added by scanning the frame headers. At most one point is kept per
+// kMinPointSpacingUs of the stream, so the index stays small.
+//
+// The index is thread-safe, so that it can be serialized while the stream is
+// decoded.
+class SeekIndex {
+ public:
+  static const int64_t kMinPointSpacingUs = 500000;
+
+  struct Point {
+    int64_t sampleNumber;
+    int64_t offset;
+  };
+
+  SeekIndex();
+
+  // Sets the stream the index belongs to. The index is cleared if it was built
+  // or deserialized for another stream.
+  void setStreamInfo(const FLAC__StreamMetadata_StreamInfo &streamInfo);
+
+  // Records that a frame starting at sampleNumber is at offset. Points
+  // contradicting existing ones are ignored.
+  void add(int64_t sampleNumber, int64_t offset);
+
+  // Finds the last point at or before sampleNumber and the point after it. If
+  // there's no point after it, ceiling is set to floor. Returns false if there
+  // is no point at or before sampleNumber.
+  bool find(int64_t sampleNumber, Point *floor, Point *ceiling) const;
+
+  // Whether the whole stream has been indexed, by a scan or in the
+  // deserialized index, so that the index can be used like a SEEKTABLE.
+  bool isComplete() const;
+
+  size_t size() const;
+
+  void clear();
+
+  // Scans the frame headers of the stream in [start, end) of source, where
+  // start is the offset of the first frame, adding a point every
+  // kMinPointSpacingUs of the stream, and marks the index complete. Returns
+  // early, with the index incomplete, if reading fails. setStreamInfo must have
+  // been called.
+  void scan(DataSource *source, int64_t start, int64_t end);
+
+  // Appends the index to data, in a versioned format that deserialize
+  // accepts.
+  void serialize(std::vector<uint8_t> *data) const;
+
+  // Replaces the index with a serialized one. Returns false if data isn't a
+  // valid index. The index is checked against the stream when the stream info
+  // is set.
+  bool deserialize(const uint8_t *data, size_t size);
+
+  // identifies the stream an index belongs to
+  struct StreamKey {
+    uint8_t md5sum[16];
+    uint64_t totalSamples;
+    uint32_t sampleRate;
+    uint32_t channels;
+    uint32_t bitsPerSample;
+    uint32_t minBlockSize;
+    uint32_t maxBlockSize;
+  };
+
+ private:
+  mutable std::mutex mMutex;
+  std::vector<Point> mPoints;
+  bool mComplete;
+  StreamKey mStreamKey;
+  bool mStreamKeyValid;
+  int64_t mMinPointSpacing;
+
+  void addLocked(int64_t sampleNumber, int64_t offset);
+  static StreamKey createStreamKey(
+      const FLAC__StreamMetadata_StreamInfo &streamInfo);
+
+  // no copy constructor or assignment
+  SeekIndex(const SeekIndex &);
+  SeekIndex &operator=(const SeekIndex &);
+};
+
+#endif  // INCLUDE_SEEK_INDEX_H_
@@ -0,0 +1,760 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "include/pcm_copy.h"
+
+#include <cmath>
+#include <cstring>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define PCM_COPY_NEON 1
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define PCM_COPY_SSE2 1
+#if defined(__SSSE3__)
+#include <tmmintrin.h>
+#define PCM_COPY_SSSE3 1
+#endif
+#endif
+
+namespace {
+
+// Scalar copy.
+
+template <unsigned kBytes>
+inline void storeSample(int8_t *dst, int value) {
+  if (kBytes == 1) {
+    *dst = static_cast<int8_t>(value);
+  } else if (kBytes == 2) {
+    const int16_t sample = static_cast<int16_t>(value);
+    memcpy(dst, &sample, sizeof(sample));
+  } else if (kBytes == 3) {
+    dst[0] = static_cast<int8_t>(value);
+    dst[1] = static_cast<int8_t>(value >> 8);
+    dst[2] = static_cast<int8_t>(value >> 16);
+  } else {
+    memcpy(dst, &value, sizeof(value));
+  }
+}
+
+// Copies samples [first, end) of each channel, starting at sample |first| of
+// |dst|.
+template <unsigned kBytes, unsigned kChannels>
+void copyScalar(int8_t *dst, const int *const *src, unsigned first,
+                unsigned end) {
+  const int *channels[kChannels];
+  for (unsigned c = 0; c < kChannels; ++c) {
+    channels[c] = src[c];
+  }
+  dst += first * kBytes * kChannels;
+  for (unsigned i = first; i < end; ++i) {
+    for (unsigned c = 0; c < kChannels; ++c) {
+      storeSample<kBytes>(dst, channels[c][i]);
+      dst += kBytes;
+    }
+  }
+}
+
+// Vectorized copy of a prefix of the samples. Returns the number of samples
+// copied, which the scalar copy completes. Only the specializations below are
+// vectorized.
+template <unsigned kBytes, unsigned kChannels>
+unsigned copyVector(int8_t * /* dst */, const int *const * /* src */,
+                    unsigned /* nSamples */) {
+  return 0;
+}
+
+#if PCM_COPY_NEON
+
+template <>
+unsigned copyVector<2, 2>(int8_t *dst, const int *const *src,
+                          unsigned nSamples) {
+  const int *const l = src[0];
+  const int *const r = src[1];
+  int16_t *out = reinterpret_cast<int16_t *>(dst);
+  unsigned i = 0;
+  for (; i + 8 <= nSamples; i += 8) {
+    int16x8x2_t v;
+    v.val[0] = vcombine_s16(vmovn_s32(vld1q_s32(l + i)),
+                            vmovn_s32(vld1q_s32(l + i + 4)));
+    v.val[1] = vcombine_s16(vmovn_s32(vld1q_s32(r + i)),
+                            vmovn_s32(vld1q_s32(r + i + 4)));
+    vst2q_s16(out + 2 * i, v);
+  }
+  return i;
+}
+
+// Returns the 16-bit samples i to i + 3 of channels a and b, interleaved.
+inline uint32x4_t interleavePair16(const int *a, const int *b, unsigned i) {
+  const int16x4x2_t v =
+      vzip_s16(vmovn_s32(vld1q_s32(a + i)), vmovn_s32(vld1q_s32(b + i)));
+  return vreinterpretq_u32_s16(vcombine_s16(v.val[0], v.val[1]));
+}
+
+template <>
+unsigned copyVector<2, 6>(int8_t *dst, const int *const *src,
+                          unsigned nSamples) {
+  uint32_t *out = reinterpret_cast<uint32_t *>(dst);
+  unsigned i = 0;
+  for (; i + 4 <= nSamples; i += 4) {
+    // Each 32-bit lane holds a pair of channels of one sample.
+    uint32x4x3_t v;
+    v.val[0] = interleavePair16(src[0], src[1], i);
+    v.val[1] = interleavePair16(src[2], src[3], i);
+    v.val[2] = interleavePair16(src[4], src[5], i);
+    vst3q_u32(out + 3 * i, v);
+  }
+  return i;
+}
+
+template <>
+unsigned copyVector<4, 2>(int8_t *dst, const int *const *src,
+                          unsigned nSamples) {
+  int32_t *out = reinterpret_cast<int32_t *>(dst);
+  unsigned i = 0;
+  for (; i + 4 <= nSamples; i += 4) {
+    int32x4x2_t v;
+    v.val[0] = vld1q_s32(src[0] + i);
+    v.val[1] = vld1q_s32(src[1] + i);
+    vst2q_s32(out + 2 * i, v);
+  }
+  return i;
+}
+
+template <>
+unsigned copyVector<4, 6>(int8_t *dst, const int *const *src,
+                          unsigned nSamples) {
+  int32_t *out = reinterpret_cast<int32_t *>(dst);
+  unsigned i = 0;
+  for (; i + 4 <= nSamples; i += 4) {
+    // The 64-bit halves hold a pair of channels of one sample.
+    const int32x4x2_t p01 = vzipq_s32(vld1q_s32(src[0] + i),
+                                      vld1q_s32(src[1] + i));
+    const int32x4x2_t p23 = vzipq_s32(vld1q_s32(src[2] + i),
+                                      vld1q_s32(src[3] + i));
+    const int32x4x2_t p45 = vzipq_s32(vld1q_s32(src[4] + i),
+                                      vld1q_s32(src[5] + i));
+    int32_t *const o = out + 6 * i;
+    for (int j = 0; j < 2; ++j) {
+      // Samples i + 2 * j and i + 2 * j + 1.
+      vst1q_s32(o + 12 * j, vcombine_s32(vget_low_s32(p01.val[j]),
+                                         vget_low_s32(p23.val[j])));
+      vst1q_s32(o + 12 * j + 4, vcombine_s32(vget_low_s32(p45.val[j]),
+                                             vget_high_s32(p01.val[j])));
+      vst1q_s32(o + 12 * j + 8, vcombine_s32(vget_high_s32(p23.val[j]),
+                                             vget_high_s32(p45.val[j])));
+    }
+  }
+  return i;
+}
+
+#define PCM_COPY_PACK_24 1
+
+// Packs |count| interleaved 32-bit samples to 24 bits. |count| must be a
+// multiple of 16.
+void pack24(int8_t *dst, const int32_t *src, unsigned count) {
+  uint8_t *out = reinterpret_cast<uint8_t *>(dst);
+  const uint32_t *in = reinterpret_cast<const uint32_t *>(src);
+  for (unsigned i = 0; i < count; i += 16) {
+    const uint32x4_t v0 = vld1q_u32(in + i);
+    const uint32x4_t v1 = vld1q_u32(in + i + 4);
+    const uint32x4_t v2 = vld1q_u32(in + i + 8);
+    const uint32x4_t v3 = vld1q_u32(in + i + 12);
+    uint8x16x3_t bytes;
+    bytes.val[0] = vcombine_u8(
+        vmovn_u16(vcombine_u16(vmovn_u32(v0), vmovn_u32(v1))),
+        vmovn_u16(vcombine_u16(vmovn_u32(v2), vmovn_u32(v3))));
+    bytes.val[1] = vcombine_u8(
+        vmovn_u16(vcombine_u16(vshrn_n_u32(v0, 8), vshrn_n_u32(v1, 8))),
+        vmovn_u16(vcombine_u16(vshrn_n_u32(v2, 8), vshrn_n_u32(v3, 8))));
+    bytes.val[2] = vcombine_u8(
+        vmovn_u16(vcombine_u16(vshrn_n_u32(v0, 16), vshrn_n_u32(v1, 16))),
+        vmovn_u16(vcombine_u16(vshrn_n_u32(v2, 16), vshrn_n_u32(v3, 16))));
+    vst3q_u8(out + 3 * i, bytes);
+  }
+}
+
+#elif PCM_COPY_SSE2
+
+inline __m128i load(const int *src) {
+  return _mm_loadu_si128(reinterpret_cast<const __m128i *>(src));
+}
+
+inline void store(void *dst, __m128i v) {
+  _mm_storeu_si128(reinterpret_cast<__m128i *>(dst), v);
+}
+
+// Returns the 16-bit samples i to i + 7 of |src|. Values are in range, so the
+// saturation of packs is a no-op.
+inline __m128i load16(const int *src, unsigned i) {
+  return _mm_packs_epi32(load(src + i), load(src + i + 4));
+}
+
+// Interleaves the 32-bit lanes of a, b and c into 3 vectors, a0 b0 c0 a1 ...
+inline void store3x32(void *dst, __m128i a, __m128i b, __m128i c) {
+  const __m128 fa = _mm_castsi128_ps(a);
+  const __m128 fb = _mm_castsi128_ps(b);
+  const __m128 fc = _mm_castsi128_ps(c);
+  // a0 b0 c0 a1
+  const __m128 ab01 = _mm_unpacklo_ps(fa, fb);
+  const __m128 c0a1 = _mm_shuffle_ps(fc, fa, _MM_SHUFFLE(1, 1, 0, 0));
+  const __m128 v0 = _mm_shuffle_ps(ab01, c0a1, _MM_SHUFFLE(2, 0, 1, 0));
+  // b1 c1 a2 b2
+  const __m128 b1c1 = _mm_shuffle_ps(fb, fc, _MM_SHUFFLE(1, 1, 1, 1));
+  const __m128 a2b2 = _mm_shuffle_ps(fa, fb, _MM_SHUFFLE(2, 2, 2, 2));
+  const __m128 v1 = _mm_shuffle_ps(b1c1, a2b2, _MM_SHUFFLE(2, 0, 2, 0));
+  // c2 a3 b3 c3
+  const __m128 c2a3 = _mm_shuffle_ps(fc, fa, _MM_SHUFFLE(3, 3, 2, 2));
+  const __m128 b3c3 = _mm_shuffle_ps(fb, fc, _MM_SHUFFLE(3, 3, 3, 3));
+  const __m128 v2 = _mm_shuffle_ps(c2a3, b3c3, _MM_SHUFFLE(2, 0, 2, 0));
+  __m128i *const out = reinterpret_cast<__m128i *>(dst);
+  _mm_storeu_si128(out, _mm_castps_si128(v0));
+  _mm_storeu_si128(out + 1, _mm_castps_si128(v1));
+  _mm_storeu_si128(out + 2, _mm_castps_si128(v2));
+}
+
+template <>
+unsigned copyVector<2, 2>(int8_t *dst, const int *const *src,
+                          unsigned nSamples) {
+  unsigned i = 0;
+  for (; i + 8 <= nSamples; i += 8) {
+    const __m128i l = load16(src[0], i);
+    const __m128i r = load16(src[1], i);
+    store(dst + 4 * i, _mm_unpacklo_epi16(l, r));
+    store(dst + 4 * i + 16, _mm_unpackhi_epi16(l, r));
+  }
+  return i;
+}
+
+template <>
+unsigned copyVector<2, 6>(int8_t *dst, const int *const *src,
+                          unsigned nSamples) {
+  unsigned i = 0;
+  for (; i + 8 <= nSamples; i += 8) {
+    // Each 32-bit lane holds a pair of channels of one sample.
+    const __m128i c0 = load16(src[0], i);
+    const __m128i c1 = load16(src[1], i);
+    const __m128i c2 = load16(src[2], i);
+    const __m128i c3 = load16(src[3], i);
+    const __m128i c4 = load16(src[4], i);
+    const __m128i c5 = load16(src[5], i);
+    store3x32(dst + 12 * i, _mm_unpacklo_epi16(c0, c1),
+              _mm_unpacklo_epi16(c2, c3), _mm_unpacklo_epi16(c4, c5));
+    store3x32(dst + 12 * i + 48, _mm_unpackhi_epi16(c0, c1),
+              _mm_unpackhi_epi16(c2, c3), _mm_unpackhi_epi16(c4, c5));
+  }
+  return i;
+}
+
+template <>
+unsigned copyVector<4, 2>(int8_t *dst, const int *const *src,
+                          unsigned nSamples) {
+  unsigned i = 0;
+  for (; i + 4 <= nSamples; i += 4) {
+    const __m128i l = load(src[0] + i);
+    const __m128i r = load(src[1] + i);
+    store(dst + 8 * i, _mm_unpacklo_epi32(l, r));
+    store(dst + 8 * i + 16, _mm_unpackhi_epi32(l, r));
+  }
+  return i;
+}
+
+// Interleaves the 64-bit lanes of a, b and c into 3 vectors, a0 b0 c0 a1 b1 c1.
+inline void store3x64(void *dst, __m128i a, __m128i b, __m128i c) {
+  __m128i *const out = reinterpret_cast<__m128i *>(dst);
+  _mm_storeu_si128(out, _mm_unpacklo_epi64(a, b));
+  _mm_storeu_si128(out + 1, _mm_castpd_si128(_mm_shuffle_pd(
+                                _mm_castsi128_pd(c), _mm_castsi128_pd(a), 2)));
+  _mm_storeu_si128(out + 2, _mm_unpackhi_epi64(b, c));
+}
+
+template <>
+unsigned copyVector<4, 6>(int8_t *dst, const int *const *src,
+                          unsigned nSamples) {
+  unsigned i = 0;
+  for (; i + 4 <= nSamples; i += 4) {
+    const __m128i c0 = load(src[0] + i);
+    const __m128i c1 = load(src[1] + i);
+    const __m128i c2 = load(src[2] + i);
+    const __m128i c3 = load(src[3] + i);
+    const __m128i c4 = load(src[4] + i);
+    const __m128i c5 = load(src[5] + i);
+    // Each 64-bit lane holds a pair of channels of one sample.
+    store3x64(dst + 24 * i, _mm_unpacklo_epi32(c0, c1),
+              _mm_unpacklo_epi32(c2, c3), _mm_unpacklo_epi32(c4, c5));
+    store3x64(dst + 24 * i + 48, _mm_unpackhi_epi32(c0, c1),
+              _mm_unpackhi_epi32(c2, c3), _mm_unpackhi_epi32(c4, c5));
+  }
+  return i;
+}
+
+#if PCM_COPY_SSSE3
+
+#define PCM_COPY_PACK_24 1
+
+// Packs |count| interleaved 32-bit samples to 24 bits. |count| must be a
+// multiple of 16.
+void pack24(int8_t *dst, const int32_t *src, unsigned count) {
+  // Moves the low 3 bytes of each lane to the low 12 bytes.
+  const __m128i mask =
+      _mm_setr_epi8(0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+  for (unsigned i = 0; i < count; i += 16) {
+    const __m128i v0 = _mm_shuffle_epi8(load(src + i), mask);
+    const __m128i v1 = _mm_shuffle_epi8(load(src + i + 4), mask);
+    const __m128i v2 = _mm_shuffle_epi8(load(src + i + 8), mask);
+    const __m128i v3 = _mm_shuffle_epi8(load(src + i + 12), mask);
+    int8_t *const out = dst + 3 * i;
+    store(out, _mm_or_si128(v0, _mm_slli_si128(v1, 12)));
+    store(out + 16, _mm_or_si128(_mm_srli_si128(v1, 4), _mm_slli_si128(v2, 8)));
+    store(out + 32, _mm_or_si128(_mm_srli_si128(v2, 8), _mm_slli_si128(v3, 4)));
+  }
+}
+
+#endif  // PCM_COPY_SSSE3
+
+#endif  // PCM_COPY_NEON
+
+#if PCM_COPY_PACK_24
+
+// The number of samples per channel 24-bit samples are interleaved at 32 bits
+// before being packed, so that the intermediate data stays in the L1 cache.
+const unsigned kPack24BlockSize = 32;
+
+// Interleaves blocks at 32 bits with the vectorized 32-bit copy, then packs
+// them.
+template <unsigned kChannels>
+unsigned copyVector24(int8_t *dst, const int *const *src, unsigned nSamples) {
+  int32_t block[kPack24BlockSize * kChannels];
+  const int *blockSrc[kChannels];
+  unsigned i = 0;
+  for (; i + kPack24BlockSize <= nSamples; i += kPack24BlockSize) {
+    for (unsigned c = 0; c < kChannels; ++c) {
+      blockSrc[c] = src[c] + i;
+    }
+    copyVector<4, kChannels>(reinterpret_cast<int8_t *>(block), blockSrc,
+                             kPack24BlockSize);
+    pack24(dst + 3 * kChannels * i, block, kPack24BlockSize * kChannels);
+  }
+  return i;
+}
+
+template <>
+unsigned copyVector<3, 2>(int8_t *dst, const int *const *src,
+                          unsigned nSamples) {
+  return copyVector24<2>(dst, src, nSamples);
+}
+
+template <>
+unsigned copyVector<3, 6>(int8_t *dst, const int *const *src,
+                          unsigned nSamples) {
+  return copyVector24<6>(dst, src, nSamples);
+}
+
+#endif  // PCM_COPY_PACK_24
+
+// Converting copy. The output classes store one sample, and are created for
+// each call so that the compiler can keep their state in registers.
+
+// Returns the next value of a linear congruential generator.
+inline uint32_t nextRandom(uint32_t *state) {
+  *state = *state * 1664525u + 1013904223u;
+  return *state;
+}
+
+// Stores samples as 32-bit floats in [-1, 1].
+class FloatOutput {
+ public:
+  static const unsigned kBytes = 4;
+
+  FloatOutput(unsigned bytesPerSample, uint32_t * /* ditherState */)
+      : mScale(1.0f / static_cast<float>(1u << (8 * bytesPerSample - 1))) {}
+
+  float getScale() const { return mScale; }
+
+  void store(int8_t *dst, int value) { storeFloat(dst, value * mScale); }
+
+  void storeFloat(int8_t *dst, float value) {
+    memcpy(dst, &value, sizeof(value));
+  }
+
+ private:
+  const float mScale;
+};
+
+// Stores samples as 16-bit integers, adding triangular dither when the source
+// samples are larger.
+class DitheredInt16Output {
+ public:
+  static const unsigned kBytes = 2;
+
+  DitheredInt16Output(unsigned bytesPerSample, uint32_t *ditherState)
+      : mShift(8 * static_cast<int>(bytesPerSample) - 16),
+        mMask(mShift > 0 ? (1 << mShift) - 1 : 0),
+        mScale(1.0f / static_cast<float>(1u << (8 * bytesPerSample - 1))),
+        mDitherState(ditherState),
+        mRandom(*ditherState) {}
+
+  ~DitheredInt16Output() { *mDitherState = mRandom; }
+
+  float getScale() const { return mScale; }
+
+  void store(int8_t *dst, int value) {
+    if (mShift <= 0) {
+      storeClamped(dst, static_cast<int64_t>(value) << -mShift);
+      return;
+    }
+    // the dither is in (-1, 1) output LSB. It takes the top bits of the
+    // generator, as its low bits have short periods.
+    int64_t dither =
+        static_cast<int64_t>(nextRandom(&mRandom) >> (32 - mShift)) +
+        (nextRandom(&mRandom) >> (32 - mShift)) - mMask;
+    int64_t sample =
+        (value + dither + (static_cast<int64_t>(1) << (mShift - 1))) >> mShift;
+    storeClamped(dst, sample);
+  }
+
+  void storeFloat(int8_t *dst, float value) {
+    float dither = (static_cast<float>(nextRandom(&mRandom) >> 8) -
+                    static_cast<float>(nextRandom(&mRandom) >> 8)) *
+                   (1.0f / (1 << 24));
+    storeClamped(dst,
+                 static_cast<int64_t>(floorf(value * 32768.0f + dither + 0.5f)));
+  }
+
+ private:
+  const int mShift;
+  const int64_t mMask;
+  const float mScale;
+  uint32_t *const mDitherState;
+  uint32_t mRandom;
+
+  static void storeClamped(int8_t *dst, int64_t value) {
+    const int16_t sample = static_cast<int16_t>(
+        value < -32768 ? -32768 : (value > 32767 ? 32767 : value));
+    memcpy(dst, &sample, sizeof(sample));
+  }
+};
+
+// Stores samples as integers of the source size. Only used to store downmixed
+// samples, as copyLittleEndian is faster otherwise.
+template <unsigned kSize>
+class IntOutput {
+ public:
+  static const unsigned kBytes = kSize;
+
+  IntOutput(unsigned /* bytesPerSample */, uint32_t * /* ditherState */) {}
+
+  float getScale() const { return 1.0f / static_cast<float>(kMax); }
+
+  void store(int8_t *dst, int value) { storeSample<kSize>(dst, value); }
+
+  void storeFloat(int8_t *dst, float value) {
+    int64_t sample = static_cast<int64_t>(floorf(value * kMax + 0.5f));
+    storeSample<kSize>(
+        dst, static_cast<int>(sample < -kMax ? -kMax
+                                             : (sample >= kMax ? kMax - 1
+                                                               : sample)));
+  }
+
+ private:
+  static const int64_t kMax = static_cast<int64_t>(1) << (8 * kSize - 1);
+};
+
+// Vectorized prefix of copyConverted, as for copyVector.
+template <class Output, unsigned kChannels>
+unsigned convertVector(int8_t * /* dst */, const int *const * /* src */,
+                       unsigned /* nSamples */, Output * /* output */) {
+  return 0;
+}
+
+#if PCM_COPY_NEON
+
+template <>
+unsigned convertVector<FloatOutput, 2>(int8_t *dst, const int *const *src,
+                                       unsigned nSamples, FloatOutput *output) {
+  float *out = reinterpret_cast<float *>(dst);
+  const float scale = output->getScale();
+  unsigned i = 0;
+  for (; i + 4 <= nSamples; i += 4) {
+    float32x4x2_t v;
+    v.val[0] = vmulq_n_f32(vcvtq_f32_s32(vld1q_s32(src[0] + i)), scale);
+    v.val[1] = vmulq_n_f32(vcvtq_f32_s32(vld1q_s32(src[1] + i)), scale);
+    vst2q_f32(out + 2 * i, v);
+  }
+  return i;
+}
+
+#elif PCM_COPY_SSE2
+
+template <>
+unsigned convertVector<FloatOutput, 2>(int8_t *dst, const int *const *src,
+                                       unsigned nSamples, FloatOutput *output) {
+  float *out = reinterpret_cast<float *>(dst);
+  const __m128 scale = _mm_set1_ps(output->getScale());
+  unsigned i = 0;
+  for (; i + 4 <= nSamples; i += 4) {
+    const __m128 l = _mm_mul_ps(_mm_cvtepi32_ps(load(src[0] + i)), scale);
+    const __m128 r = _mm_mul_ps(_mm_cvtepi32_ps(load(src[1] + i)), scale);
+    _mm_storeu_ps(out + 2 * i, _mm_unpacklo_ps(l, r));
+    _mm_storeu_ps(out + 2 * i + 4, _mm_unpackhi_ps(l, r));
+  }
+  return i;
+}
+
+#endif  // PCM_COPY_NEON
+
+template <class Output, unsigned kChannels>
+void copyConverted(int8_t *dst, const int *const *src, unsigned bytesPerSample,
+                   unsigned nSamples, unsigned /* nChannels */,
+                   uint32_t *ditherState) {
+  Output output(bytesPerSample, ditherState);
+  const unsigned converted =
+      convertVector<Output, kChannels>(dst, src, nSamples, &output);
+  dst += converted * Output::kBytes * kChannels;
+  for (unsigned i = converted; i < nSamples; ++i) {
+    for (unsigned c = 0; c < kChannels; ++c) {
+      output.store(dst, src[c][i]);
+      dst += Output::kBytes;
+    }
+  }
+}
+
+// Stereo downmix coefficients for each FLAC channel layout. The LFE channel is
+// dropped.
+const float kMinus3Db = 0.70710678f;
+const float kDownmixLeft[9][8] = {
+    {},
+    {},
+    {},
+    // L R C
+    {1.0f, 0.0f, kMinus3Db},
+    // L R BL BR
+    {1.0f, 0.0f, kMinus3Db, 0.0f},
+    // L R C BL BR
+    {1.0f, 0.0f, kMinus3Db, kMinus3Db, 0.0f},
+    // L R C LFE BL BR
+    {1.0f, 0.0f, kMinus3Db, 0.0f, kMinus3Db, 0.0f},
+    // L R C LFE BC SL SR
+    {1.0f, 0.0f, kMinus3Db, 0.0f, 0.5f, kMinus3Db, 0.0f},
+    // L R C LFE BL BR SL SR
+    {1.0f, 0.0f, kMinus3Db, 0.0f, kMinus3Db, 0.0f, kMinus3Db, 0.0f},
+};
+const float kDownmixRight[9][8] = {
+    {},
+    {},
+    {},
+    {0.0f, 1.0f, kMinus3Db},
+    {0.0f, 1.0f, 0.0f, kMinus3Db},
+    {0.0f, 1.0f, kMinus3Db, 0.0f, kMinus3Db},
+    {0.0f, 1.0f, kMinus3Db, 0.0f, 0.0f, kMinus3Db},
+    {0.0f, 1.0f, kMinus3Db, 0.0f, 0.5f, 0.0f, kMinus3Db},
+    {0.0f, 1.0f, kMinus3Db, 0.0f, 0.0f, kMinus3Db, 0.0f, kMinus3Db},
+};
+
+template <class Output, unsigned kChannels>
+void copyDownmixed(int8_t *dst, const int *const *src, unsigned bytesPerSample,
+                   unsigned nSamples, unsigned /* nChannels */,
+                   uint32_t *ditherState) {
+  Output output(bytesPerSample, ditherState);
+  // scale the coefficients so that the output can't clip, and so that they
+  // also convert the samples to [-1, 1].
+  float sum = 0.0f;
+  for (unsigned c = 0; c < kChannels; ++c) {
+    sum += kDownmixLeft[kChannels][c];
+  }
+  const float scale = output.getScale() / sum;
+  float left[kChannels];
+  float right[kChannels];
+  for (unsigned c = 0; c < kChannels; ++c) {
+    left[c] = kDownmixLeft[kChannels][c] * scale;
+    right[c] = kDownmixRight[kChannels][c] * scale;
+  }
+  for (unsigned i = 0; i < nSamples; ++i) {
+    float l = 0.0f;
+    float r = 0.0f;
+    for (unsigned c = 0; c < kChannels; ++c) {
+      const float sample = static_cast<float>(src[c][i]);
+      l += left[c] * sample;
+      r += right[c] * sample;
+    }
+    output.storeFloat(dst, l);
+    output.storeFloat(dst + Output::kBytes, r);
+    dst += 2 * Output::kBytes;
+  }
+}
+
+template <class Output>
+PcmCopyFunction getConvertingPcmCopyFunction(bool downmixToStereo,
+                                             unsigned nChannels) {
+  if (downmixToStereo && nChannels > 2) {
+    switch (nChannels) {
+      case 3:
+        return copyDownmixed<Output, 3>;
+      case 4:
+        return copyDownmixed<Output, 4>;
+      case 5:
+        return copyDownmixed<Output, 5>;
+      case 6:
+        return copyDownmixed<Output, 6>;
+      case 7:
+        return copyDownmixed<Output, 7>;
+      case 8:
+        return copyDownmixed<Output, 8>;
+      default:
+        return NULL;
+    }
+  }
+  switch (nChannels) {
+    case 1:
+      return copyConverted<Output, 1>;
+    case 2:
+      return copyConverted<Output, 2>;
+    case 3:
+      return copyConverted<Output, 3>;
+    case 4:
+      return copyConverted<Output, 4>;
+    case 5:
+      return copyConverted<Output, 5>;
+    case 6:
+      return copyConverted<Output, 6>;
+    case 7:
+      return copyConverted<Output, 7>;
+    case 8:
+      return copyConverted<Output, 8>;
+    default:
+      return NULL;
+  }
+}
+
+template <unsigned kBytes, unsigned kChannels>
+void copyLittleEndian(int8_t *dst, const int *const *src,
+                      unsigned /* bytesPerSample */, unsigned nSamples,
+                      unsigned /* nChannels */, uint32_t * /* ditherState */) {
+  const unsigned copied = copyVector<kBytes, kChannels>(dst, src, nSamples);
+  copyScalar<kBytes, kChannels>(dst, src, copied, nSamples);
+}
+
+template <unsigned kBytes>
+PcmCopyFunction getSourcePcmCopyFunction(unsigned nChannels) {
+  switch (nChannels) {
+    case 1:
+      return copyLittleEndian<kBytes, 1>;
+    case 2:
+      return copyLittleEndian<kBytes, 2>;
+    case 3:
+      return copyLittleEndian<kBytes, 3>;
+    case 4:
+      return copyLittleEndian<kBytes, 4>;
+    case 5:
+      return copyLittleEndian<kBytes, 5>;
+    case 6:
+      return copyLittleEndian<kBytes, 6>;
+    case 7:
+      return copyLittleEndian<kBytes, 7>;
+    case 8:
+      return copyLittleEndian<kBytes, 8>;
+    default:
+      return NULL;
+  }
+}
+
+PcmCopyFunction getSourcePcmCopyFunction(unsigned bytesPerSample,
+                                         unsigned nChannels) {
+  switch (bytesPerSample) {
+    case 1:
+      return getSourcePcmCopyFunction<1>(nChannels);
+    case 2:
+      return getSourcePcmCopyFunction<2>(nChannels);
+    case 3:
+      return getSourcePcmCopyFunction<3>(nChannels);
+    case 4:
+      return getSourcePcmCopyFunction<4>(nChannels);
+    default:
+      return NULL;
+  }
+}
+
+void copyBigEndian(int8_t *dst, const int *const *src, unsigned bytesPerSample,
+                   unsigned nSamples, unsigned nChannels,
+                   uint32_t * /* ditherState */) {
+  for (unsigned i = 0; i < nSamples; ++i) {
+    for (unsigned c = 0; c < nChannels; ++c) {
+      // point to the first byte of the source address
+      // and then skip the first few bytes (most significant bytes)
+      // depending on the bit depth
+      const int8_t *byteSrc =
+          reinterpret_cast<const int8_t *>(&src[c][i]) + 4 - bytesPerSample;
+      memcpy(dst, byteSrc, bytesPerSample);
+      dst = dst + bytesPerSample;
+    }
+  }
+}
+
+}  // namespace
+
+PcmCopyFunction getBigEndianPcmCopyFunction() { return copyBigEndian; }
+
+unsigned getPcmOutputChannels(bool downmixToStereo, unsigned nChannels) {
+  return downmixToStereo && nChannels > 2 ? 2 : nChannels;
+}
+
+unsigned getPcmOutputBytesPerSample(PcmOutputEncoding encoding,
+                                    unsigned bytesPerSample) {
+  switch (encoding) {
+    case kPcmOutputEncodingFloat:
+      return 4;
+    case kPcmOutputEncoding16Bit:
+      return 2;
+    default:
+      return bytesPerSample;
+  }
+}
+
+PcmCopyFunction getLittleEndianPcmCopyFunction(PcmOutputEncoding encoding,
+                                               bool downmixToStereo,
+                                               unsigned bytesPerSample,
+                                               unsigned nChannels) {
+  if (bytesPerSample < 1 || bytesPerSample > 4) {
+    return NULL;
+  }
+  const bool downmix = downmixToStereo && nChannels > 2;
+  switch (encoding) {
+    case kPcmOutputEncodingFloat:
+      return getConvertingPcmCopyFunction<FloatOutput>(downmix, nChannels);
+    case kPcmOutputEncoding16Bit:
+      if (bytesPerSample != 2 || downmix) {
+        return getConvertingPcmCopyFunction<DitheredInt16Output>(downmix,
+                                                                 nChannels);
+      }
+      break;
+    default:
+      break;
+  }
+  if (!downmix) {
+    return getSourcePcmCopyFunction(bytesPerSample, nChannels);
+  }
+  switch (bytesPerSample) {
+    case 1:
+      return getConvertingPcmCopyFunction<IntOutput<1> >(downmix, nChannels);
+    case 2:
+      return getConvertingPcmCopyFunction<IntOutput<2> >(downmix, nChannels);
+    case 3:
+      return getConvertingPcmCopyFunction<IntOutput<3> >(downmix, nChannels);
+    default:
+      return getConvertingPcmCopyFunction<IntOutput<4> >(downmix, nChannels);
+  }
+}
@@ -0,0 +1,441 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "include/seek_index.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+const uint8_t kMagic[4] = {'F', 'L', 'S', 'I'};
+const uint32_t kVersion = 1;
+
+// The size of the reads of a scan.
+const size_t kScanChunkSize = 4096;
+// The longest possible frame header, including the CRC-8.
+const size_t kMaxFrameHeaderSize = 16;
+
+uint8_t crc8(const uint8_t *data, size_t size) {
+  uint8_t crc = 0;
+  for (size_t i = 0; i < size; ++i) {
+    crc ^= data[i];
+    for (int bit = 0; bit < 8; ++bit) {
+      crc = (crc & 0x80) ? (crc << 1) ^ 0x07 : crc << 1;
+    }
+  }
+  return crc;
+}
+
+// Parses the frame header at data, returning the number of its first sample,
+// or -1 if it's not a valid frame header of the stream. The number of samples
+// of the frame is stored in blockSize.
+int64_t parseFrameHeader(const uint8_t *data, size_t size,
+                         const FLAC__StreamMetadata_StreamInfo &streamInfo,
+                         uint32_t *blockSize) {
+  if (size < 6 || data[0] != 0xFF || (data[1] & 0xFE) != 0xF8) {
+    return -1;
+  }
+  const bool variableBlockSize = data[1] & 1;
+  const unsigned blockSizeCode = data[2] >> 4;
+  const unsigned sampleRateCode = data[2] & 0x0F;
+  const unsigned channelAssignment = data[3] >> 4;
+  const unsigned sampleSizeCode = (data[3] >> 1) & 0x07;
+  if (blockSizeCode == 0 || sampleRateCode == 15 || channelAssignment > 10 ||
+      sampleSizeCode == 3 || (data[3] & 1)) {
+    return -1;
+  }
+  const unsigned channels = channelAssignment < 8 ? channelAssignment + 1 : 2;
+  if (channels != streamInfo.channels) {
+    return -1;
+  }
+  static const unsigned kSampleSizes[8] = {0, 8, 12, 0, 16, 20, 24, 32};
+  if (sampleSizeCode != 0 &&
+      kSampleSizes[sampleSizeCode] != streamInfo.bits_per_sample) {
+    return -1;
+  }
+
+  // the UTF-8 like coded frame or sample number
+  size_t position = 4;
+  uint64_t number = data[position++];
+  unsigned extraBytes = 0;
+  if (number >= 0xFE) {
+    extraBytes = 6;
+    number = 0;
+  } else if (number >= 0xFC) {
+    extraBytes = 5;
+    number &= 0x01;
+  } else if (number >= 0xF8) {
+    extraBytes = 4;
+    number &= 0x03;
+  } else if (number >= 0xF0) {
+    extraBytes = 3;
+    number &= 0x07;
+  } else if (number >= 0xE0) {
+    extraBytes = 2;
+    number &= 0x0F;
+  } else if (number >= 0xC0) {
+    extraBytes = 1;
+    number &= 0x1F;
+  } else if (number >= 0x80) {
+    return -1;
+  }
+  if ((!variableBlockSize && extraBytes > 5) ||
+      position + extraBytes + 3 > size) {
+    return -1;
+  }
+  for (unsigned i = 0; i < extraBytes; ++i) {
+    const uint8_t byte = data[position++];
+    if ((byte & 0xC0) != 0x80) {
+      return -1;
+    }
+    number = (number << 6) | (byte & 0x3F);
+  }
+
+  if (blockSizeCode == 1) {
+    *blockSize = 192;
+  } else if (blockSizeCode <= 5) {
+    *blockSize = 576 << (blockSizeCode - 2);
+  } else if (blockSizeCode == 6) {
+    *blockSize = data[position] + 1;
+    position += 1;
+  } else if (blockSizeCode == 7) {
+    *blockSize = ((data[position] << 8) | data[position + 1]) + 1;
+    position += 2;
+  } else {
+    *blockSize = 256 << (blockSizeCode - 8);
+  }
+  if (sampleRateCode == 12) {
+    position += 1;
+  } else if (sampleRateCode == 13 || sampleRateCode == 14) {
+    position += 2;
+  }
+  if (position >= size || crc8(data, position) != data[position]) {
+    return -1;
+  }
+  if (variableBlockSize) {
+    return number;
+  }
+  // fixed block size streams are numbered by frame
+  if (streamInfo.min_blocksize != streamInfo.max_blocksize) {
+    return -1;
+  }
+  return number * streamInfo.max_blocksize;
+}
+
+struct FrameHeader {
+  // The offset of the header in the source, or -1 if none was found.
+  int64_t offset;
+  int64_t sampleNumber;
+  uint32_t blockSize;
+};
+
+// Finds the first frame header in [position, end) of source. Returns false if
+// reading fails.
+bool findFrameHeader(DataSource *source, int64_t position, int64_t end,
+                     const FLAC__StreamMetadata_StreamInfo &streamInfo,
+                     std::vector<uint8_t> *buffer, FrameHeader *header) {
+  header->offset = -1;
+  while (position < end) {
+    const size_t size = static_cast<size_t>(
+        std::min<int64_t>(buffer->size(), end - position));
+    ssize_t bytesRead = source->readAt(position, buffer->data(), size);
+    if (bytesRead <= 0) {
+      return false;
+    }
+    const size_t available = static_cast<size_t>(bytesRead);
+    for (size_t i = 0; i < available; ++i) {
+      if ((*buffer)[i] != 0xFF) {
+        continue;
+      }
+      header->sampleNumber = parseFrameHeader(
+          &(*buffer)[i], available - i, streamInfo, &header->blockSize);
+      if (header->sampleNumber >= 0) {
+        header->offset = position + i;
+        return true;
+      }
+    }
+    if (available < size ||
+        position + static_cast<int64_t>(available) >= end) {
+      return true;
+    }
+    // a header may straddle the end of the chunk
+    position += available - kMaxFrameHeaderSize + 1;
+  }
+  return true;
+}
+
+void appendUint32(std::vector<uint8_t> *data, uint32_t value) {
+  for (int i = 0; i < 4; ++i) {
+    data->push_back(static_cast<uint8_t>(value >> (8 * i)));
+  }
+}
+
+void appendUint64(std::vector<uint8_t> *data, uint64_t value) {
+  appendUint32(data, static_cast<uint32_t>(value));
+  appendUint32(data, static_cast<uint32_t>(value >> 32));
+}
+
+uint32_t readUint32(const uint8_t *data) {
+  return data[0] | (data[1] << 8) | (data[2] << 16) |
+         (static_cast<uint32_t>(data[3]) << 24);
+}
+
+uint64_t readUint64(const uint8_t *data) {
+  return readUint32(data) | (static_cast<uint64_t>(readUint32(data + 4)) << 32);
+}
+
+bool equals(const SeekIndex::StreamKey &a, const SeekIndex::StreamKey &b) {
+  return memcmp(a.md5sum, b.md5sum, sizeof(a.md5sum)) == 0 &&
+         a.totalSamples == b.totalSamples && a.sampleRate == b.sampleRate &&
+         a.channels == b.channels && a.bitsPerSample == b.bitsPerSample &&
+         a.minBlockSize == b.minBlockSize && a.maxBlockSize == b.maxBlockSize;
+}
+
+bool comparePoints(const SeekIndex::Point &a, const SeekIndex::Point &b) {
+  return a.sampleNumber < b.sampleNumber;
+}
+
+}  // namespace
+
+SeekIndex::SeekIndex()
+    : mComplete(false), mStreamKeyValid(false), mMinPointSpacing(0) {
+  memset(&mStreamKey, 0, sizeof(mStreamKey));
+}
+
+SeekIndex::StreamKey SeekIndex::createStreamKey(
+    const FLAC__StreamMetadata_StreamInfo &streamInfo) {
+  StreamKey key;
+  memset(&key, 0, sizeof(key));
+  memcpy(key.md5sum, streamInfo.md5sum, sizeof(key.md5sum));
+  key.totalSamples = streamInfo.total_samples;
+  key.sampleRate = streamInfo.sample_rate;
+  key.channels = streamInfo.channels;
+  key.bitsPerSample = streamInfo.bits_per_sample;
+  key.minBlockSize = streamInfo.min_blocksize;
+  key.maxBlockSize = streamInfo.max_blocksize;
+  return key;
+}
+
+void SeekIndex::setStreamInfo(
+    const FLAC__StreamMetadata_StreamInfo &streamInfo) {
+  std::lock_guard<std::mutex> lock(mMutex);
+  StreamKey key = createStreamKey(streamInfo);
+  if (mStreamKeyValid && !equals(key, mStreamKey)) {
+    mPoints.clear();
+    mComplete = false;
+  }
+  mStreamKey = key;
+  mStreamKeyValid = true;
+  mMinPointSpacing = kMinPointSpacingUs * streamInfo.sample_rate / 1000000;
+}
+
+void SeekIndex::add(int64_t sampleNumber, int64_t offset) {
+  std::lock_guard<std::mutex> lock(mMutex);
+  addLocked(sampleNumber, offset);
+}
+
+void SeekIndex::addLocked(int64_t sampleNumber, int64_t offset) {
+  if (sampleNumber < 0 || offset < 0 ||
+      (mStreamKey.totalSamples > 0 &&
+       static_cast<uint64_t>(sampleNumber) > mStreamKey.totalSamples)) {
+    return;
+  }
+  Point point = {sampleNumber, offset};
+  std::vector<Point>::iterator next =
+      std::lower_bound(mPoints.begin(), mPoints.end(), point, comparePoints);
+  if (next != mPoints.end() && (next->sampleNumber - sampleNumber <
+                                    mMinPointSpacing ||
+                                next->offset <= offset)) {
+    // too close to the next point, or contradicting it
+    return;
+  }
+  if (next != mPoints.begin()) {
+    std::vector<Point>::iterator previous = next - 1;
+    if (sampleNumber - previous->sampleNumber < mMinPointSpacing ||
+        previous->offset >= offset) {
+      return;
+    }
+  }
+  mPoints.insert(next, point);
+}
+
+bool SeekIndex::find(int64_t sampleNumber, Point *floor,
+                     Point *ceiling) const {
+  std::lock_guard<std::mutex> lock(mMutex);
+  Point point = {sampleNumber, 0};
+  std::vector<Point>::const_iterator next =
+      std::upper_bound(mPoints.begin(), mPoints.end(), point, comparePoints);
+  if (next == mPoints.begin()) {
+    return false;
+  }
+  *floor = *(next - 1);
+  *ceiling = next == mPoints.end() || floor->sampleNumber == sampleNumber
+                 ? *floor
+                 : *next;
+  return true;
+}
+
+bool SeekIndex::isComplete() const {
+  std::lock_guard<std::mutex> lock(mMutex);
+  return mComplete;
+}
+
+size_t SeekIndex::size() const {
+  std::lock_guard<std::mutex> lock(mMutex);
+  return mPoints.size();
+}
+
+void SeekIndex::clear() {
+  std::lock_guard<std::mutex> lock(mMutex);
+  mPoints.clear();
+  mComplete = false;
+}
+
+void SeekIndex::scan(DataSource *source, int64_t start, int64_t end) {
+  FLAC__StreamMetadata_StreamInfo streamInfo;
+  memset(&streamInfo, 0, sizeof(streamInfo));
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    if (!mStreamKeyValid) {
+      return;
+    }
+    streamInfo.min_blocksize = mStreamKey.minBlockSize;
+    streamInfo.max_blocksize = mStreamKey.maxBlockSize;
+    streamInfo.sample_rate = mStreamKey.sampleRate;
+    streamInfo.channels = mStreamKey.channels;
+    streamInfo.bits_per_sample = mStreamKey.bitsPerSample;
+    streamInfo.total_samples = mStreamKey.totalSamples;
+  }
+  if (streamInfo.total_samples == 0 || end <= start) {
+    return;
+  }
+  // probe the stream at the byte interval that corresponds to the point
+  // spacing at the average bitrate
+  const int64_t durationUs =
+      streamInfo.total_samples * 1000000 / streamInfo.sample_rate;
+  const int64_t interval = std::max<int64_t>(
+      kScanChunkSize, (end - start) * kMinPointSpacingUs / durationUs);
+
+  std::vector<uint8_t> buffer(kScanChunkSize);
+  int64_t position = start;
+  int64_t target = start;
+  while (position < end) {
+    FrameHeader header;
+    if (!findFrameHeader(source, position, end, streamInfo, &buffer,
+                         &header)) {
+      return;
+    }
+    if (header.offset < 0) {
+      break;
+    }
+    // Audio data can mimic a frame header, CRC-8 included. Points are only
+    // added for headers followed by the header of the next frame, or by the
+    // end of the stream, as a false point would make the genuine points after
+    // it look contradicting.
+    FrameHeader nextHeader;
+    if (!findFrameHeader(source, header.offset + 1, end, streamInfo, &buffer,
+                         &nextHeader)) {
+      return;
+    }
+    const int64_t nextSampleNumber = header.sampleNumber + header.blockSize;
+    if (nextHeader.offset < 0) {
+      if (static_cast<uint64_t>(nextSampleNumber) ==
+          streamInfo.total_samples) {
+        add(header.sampleNumber, header.offset);
+      }
+      break;
+    }
+    if (nextHeader.sampleNumber == nextSampleNumber) {
+      add(header.sampleNumber, header.offset);
+      target += interval;
+      position = std::max(target, nextHeader.offset);
+    } else {
+      // Either header may be the false one, so continue from the second.
+      position = nextHeader.offset;
+    }
+  }
+  std::lock_guard<std::mutex> lock(mMutex);
+  mComplete = true;
+}
+
+void SeekIndex::serialize(std::vector<uint8_t> *data) const {
+  std::lock_guard<std::mutex> lock(mMutex);
+  data->insert(data->end(), kMagic, kMagic + sizeof(kMagic));
+  appendUint32(data, kVersion);
+  data->insert(data->end(), mStreamKey.md5sum,
+               mStreamKey.md5sum + sizeof(mStreamKey.md5sum));
+  appendUint64(data, mStreamKey.totalSamples);
+  appendUint32(data, mStreamKey.sampleRate);
+  appendUint32(data, mStreamKey.channels);
+  appendUint32(data, mStreamKey.bitsPerSample);
+  appendUint32(data, mStreamKey.minBlockSize);
+  appendUint32(data, mStreamKey.maxBlockSize);
+  appendUint32(data, mComplete ? 1 : 0);
+  appendUint32(data, mPoints.size());
+  for (size_t i = 0; i < mPoints.size(); ++i) {
+    appendUint64(data, mPoints[i].sampleNumber);
+    appendUint64(data, mPoints[i].offset);
+  }
+}
+
+bool SeekIndex::deserialize(const uint8_t *data, size_t size) {
+  const size_t headerSize = 4 + 4 + 16 + 8 + 6 * 4 + 4;
+  if (size < headerSize || memcmp(data, kMagic, sizeof(kMagic)) != 0 ||
+      readUint32(data + 4) != kVersion) {
+    return false;
+  }
+  const uint8_t *position = data + 8;
+  StreamKey key;
+  memset(&key, 0, sizeof(key));
+  memcpy(key.md5sum, position, sizeof(key.md5sum));
+  position += sizeof(key.md5sum);
+  key.totalSamples = readUint64(position);
+  key.sampleRate = readUint32(position + 8);
+  key.channels = readUint32(position + 12);
+  key.bitsPerSample = readUint32(position + 16);
+  key.minBlockSize = readUint32(position + 20);
+  key.maxBlockSize = readUint32(position + 24);
+  const bool complete = readUint32(position + 28) != 0;
+  const uint32_t count = readUint32(position + 32);
+  position += 36;
+  if ((size - headerSize) / 16 < count) {
+    return false;
+  }
+  std::vector<Point> points(count);
+  for (uint32_t i = 0; i < count; ++i) {
+    points[i].sampleNumber = static_cast<int64_t>(readUint64(position));
+    points[i].offset = static_cast<int64_t>(readUint64(position + 8));
+    position += 16;
+    if (points[i].sampleNumber < 0 || points[i].offset < 0 ||
+        (i > 0 && (points[i].sampleNumber <= points[i - 1].sampleNumber ||
+                   points[i].offset <= points[i - 1].offset))) {
+      return false;
+    }
+  }
+
+  std::lock_guard<std::mutex> lock(mMutex);
+  if (mStreamKeyValid && !equals(key, mStreamKey)) {
+    return false;
+  }
+  mPoints.swap(points);
+  mComplete = complete;
+  if (!mStreamKeyValid) {
+    mStreamKey = key;
+    mStreamKeyValid = true;
+  }
+  return true;
+}
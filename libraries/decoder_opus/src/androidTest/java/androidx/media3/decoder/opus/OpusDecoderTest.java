@@ -0,0 +1,149 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package androidx.media3.decoder.opus;
+
+import static com.google.common.truth.Truth.assertThat;
+import static java.lang.Math.max;
+import static java.lang.Math.min;
+import static org.junit.Assert.fail;
+
+import android.content.Context;
+import androidx.media3.common.Format;
+import androidx.media3.extractor.mkv.MatroskaExtractor;
+import androidx.media3.test.utils.FakeExtractorOutput;
+import androidx.media3.test.utils.FakeTrackOutput;
+import androidx.media3.test.utils.TestUtil;
+import androidx.test.core.app.ApplicationProvider;
+import androidx.test.ext.junit.runners.AndroidJUnit4;
+import java.io.ByteArrayOutputStream;
+import java.nio.ByteBuffer;
+import java.util.Arrays;
+import org.junit.Before;
+import org.junit.Test;
+import org.junit.runner.RunWith;
+
+/** Tests for {@link OpusDecoder}. */
+@RunWith(AndroidJUnit4.class)
+public final class OpusDecoderTest {
+
+  private static final String BEAR_OPUS_PATH = "media/mka/bear-opus.mka";
+
+  @Before
+  public void setUp() {
+    if (!OpusLibrary.isAvailable()) {
+      fail("Opus library not available.");
+    }
+  }
+
+  @Test
+  public void decodePackets_outputsSamePacketsAsSinglePacketCalls() throws Exception {
+    Context context = ApplicationProvider.getApplicationContext();
+    FakeExtractorOutput extractorOutput =
+        TestUtil.extractAllSamplesFromFile(new MatroskaExtractor(), context, BEAR_OPUS_PATH);
+    FakeTrackOutput trackOutput = extractorOutput.trackOutputs.valueAt(0);
+    Format format = trackOutput.lastFormat;
+    int packetCount = trackOutput.getSampleCount();
+    int[] packetSizes = new int[packetCount];
+    ByteArrayOutputStream packets = new ByteArrayOutputStream();
+    for (int i = 0; i < packetCount; i++) {
+      byte[] sampleData = trackOutput.getSampleData(i);
+      packetSizes[i] = sampleData.length;
+      packets.write(sampleData);
+    }
+    byte[] inputData = packets.toByteArray();
+
+    int[] expectedPacketOutputSizes = new int[packetCount];
+    byte[] expectedOutput =
+        decodeAllPackets(
+            format,
+            inputData,
+            packetSizes,
+            /* maxPacketsPerCall= */ 1,
+            /* outputBufferSize= */ 1 << 16,
+            expectedPacketOutputSizes);
+    int maxPacketOutputSize = 0;
+    for (int packetOutputSize : expectedPacketOutputSizes) {
+      maxPacketOutputSize = max(maxPacketOutputSize, packetOutputSize);
+    }
+    // The output buffer only fits a few packets, so that most calls stop before the last packet.
+    int[] packetOutputSizes = new int[packetCount];
+    byte[] output =
+        decodeAllPackets(
+            format,
+            inputData,
+            packetSizes,
+            /* maxPacketsPerCall= */ packetCount,
+            /* outputBufferSize= */ 5 * maxPacketOutputSize / 2,
+            packetOutputSizes);
+
+    assertThat(expectedOutput.length).isGreaterThan(0);
+    assertThat(packetOutputSizes).isEqualTo(expectedPacketOutputSizes);
+    assertThat(output).isEqualTo(expectedOutput);
+  }
+
+  /**
+   * Decodes all the packets with {@link OpusDecoder#decodePackets}, and returns the concatenated
+   * output. The output size of each packet is written to {@code packetOutputSizes}.
+   */
+  private static byte[] decodeAllPackets(
+      Format format,
+      byte[] inputData,
+      int[] packetSizes,
+      int maxPacketsPerCall,
+      int outputBufferSize,
+      int[] packetOutputSizes)
+      throws Exception {
+    OpusDecoder decoder =
+        new OpusDecoder(
+            /* numInputBuffers= */ 1,
+            /* numOutputBuffers= */ 1,
+            /* initialInputBufferSize= */ inputData.length,
+            format.initializationData,
+            /* cryptoConfig= */ null,
+            /* outputFloat= */ false);
+    ByteBuffer input = ByteBuffer.allocateDirect(inputData.length);
+    input.put(inputData);
+    input.flip();
+    // The offsets are relative to the start of the output buffer, not to its position.
+    int outputPosition = 16;
+    ByteBuffer outputData = ByteBuffer.allocateDirect(outputPosition + outputBufferSize);
+    outputData.position(outputPosition);
+    ByteArrayOutputStream output = new ByteArrayOutputStream();
+    int packetIndex = 0;
+    while (packetIndex < packetSizes.length) {
+      int[] remainingPacketSizes =
+          Arrays.copyOfRange(
+              packetSizes, packetIndex, min(packetSizes.length, packetIndex + maxPacketsPerCall));
+      int[] outputOffsets = new int[remainingPacketSizes.length + 1];
+      int decodedPacketCount =
+          decoder.decodePackets(
+              input, remainingPacketSizes, remainingPacketSizes.length, outputData, outputOffsets);
+      assertThat(decodedPacketCount).isGreaterThan(0);
+      assertThat(outputOffsets[0]).isEqualTo(outputPosition);
+      assertThat(outputData.position()).isEqualTo(outputPosition);
+      for (int i = 0; i < decodedPacketCount; i++) {
+        packetOutputSizes[packetIndex + i] = outputOffsets[i + 1] - outputOffsets[i];
+        input.position(input.position() + remainingPacketSizes[i]);
+      }
+      byte[] outputBytes = new byte[outputOffsets[decodedPacketCount] - outputPosition];
+      outputData.duplicate().get(outputBytes);
+      output.write(outputBytes);
+      packetIndex += decodedPacketCount;
+    }
+    decoder.release();
+    return output.toByteArray();
+  }
+}
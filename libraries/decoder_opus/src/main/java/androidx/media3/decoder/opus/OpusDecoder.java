@@ -142,7 +142,7 @@ public final class OpusDecoder
 
     this.outputFloat = outputFloat;
     if (outputFloat) {
-      opusSetFloatOutput();
+      opusSetFloatOutput(nativeDecoderContext);
     }
   }
 
@@ -217,7 +217,8 @@ public final class OpusDecoder
             new CryptoException(opusGetErrorCode(nativeDecoderContext), message);
         return new OpusDecoderException(message, cause);
       } else {
-        return new OpusDecoderException("Decode error: " + opusGetErrorMessage(result));
+        return new OpusDecoderException(
+            "Decode error: " + opusGetErrorMessage(nativeDecoderContext));
       }
     }
 
@@ -247,6 +248,56 @@ public final class OpusDecoder
     return null;
   }
 
+  /**
+   * Decodes several packets in a single native call, into one contiguous buffer. This is intended
+   * for decoding a stream offline, e.g. for transcoding, without queueing each packet through
+   * {@link #queueInputBuffer}. It must not be called while input buffers are queued.
+   *
+   * <p>The packets are decoded as they are: samples aren't skipped for the pre-skip, seek pre-roll
+   * or discard padding.
+   *
+   * <p>Decoding stops early if the next packet doesn't fit in the output buffer, in which case the
+   * remaining packets should be passed to the next call. Decoding also stops early if a packet
+   * can't be decoded after others were, in which case the packets decoded before it are returned,
+   * and the next call, starting at that packet, throws.
+   *
+   * @param inputData A direct buffer holding the packets back to back, from its position.
+   * @param packetSizes The sizes of the packets, in bytes.
+   * @param packetCount The number of packets.
+   * @param outputData A direct buffer to decode into, from its position to its capacity. Its
+   *     position and limit aren't changed.
+   * @param outputOffsets Receives the offsets in {@code outputData} at which the decoded packets
+   *     start, followed by the offset at which the last decoded packet ends. Must have at least
+   *     {@code packetCount + 1} elements.
+   * @return The number of packets decoded.
+   * @throws OpusDecoderException If the first packet can't be decoded.
+   */
+  public int decodePackets(
+      ByteBuffer inputData,
+      int[] packetSizes,
+      int packetCount,
+      ByteBuffer outputData,
+      int[] outputOffsets)
+      throws OpusDecoderException {
+    Assertions.checkArgument(inputData.isDirect() && outputData.isDirect());
+    Assertions.checkArgument(packetCount >= 0 && packetCount <= packetSizes.length);
+    Assertions.checkArgument(packetCount < outputOffsets.length);
+    int result =
+        opusDecodePackets(
+            nativeDecoderContext,
+            inputData,
+            inputData.position(),
+            packetSizes,
+            packetCount,
+            outputData,
+            outputData.position(),
+            outputOffsets);
+    if (result < 0) {
+      throw new OpusDecoderException("Decode error: " + opusGetErrorMessage(nativeDecoderContext));
+    }
+    return result;
+  }
+
   @Override
   public void release() {
     super.release();
@@ -341,6 +392,16 @@ public final class OpusDecoder
       int inputSize,
       SimpleDecoderOutputBuffer outputBuffer);
 
+  private native int opusDecodePackets(
+      long decoder,
+      ByteBuffer inputBuffer,
+      int inputOffset,
+      int[] packetSizes,
+      int packetCount,
+      ByteBuffer outputBuffer,
+      int outputOffset,
+      int[] outputOffsets);
+
   private native int opusSecureDecode(
       long decoder,
       long timeUs,
@@ -364,5 +425,5 @@ public final class OpusDecoder
 
   private native String opusGetErrorMessage(long decoder);
 
-  private native void opusSetFloatOutput();
+  private native void opusSetFloatOutput(long decoder);
 }
@@ -21,6 +21,7 @@
 
 #include <cstdint>
 #include <cstdlib>
+#include <vector>
 
 #include "opus.h"              // NOLINT
 #include "opus_multistream.h"  // NOLINT
@@ -51,99 +52,213 @@
   JNIEXPORT RETURN_TYPE Java_androidx_media3_decoder_opus_OpusLibrary_##NAME( \
       JNIEnv* env, jobject thiz, ##__VA_ARGS__)
 
-// JNI references for SimpleOutputBuffer class.
-static jmethodID outputBufferInit;
+// JNI references for the SimpleDecoderOutputBuffer class, resolved in
+// JNI_OnLoad and shared by all decoders.
+static jclass output_buffer_class;
+static jmethodID output_buffer_init;
 
 jint JNI_OnLoad(JavaVM* vm, void* reserved) {
   JNIEnv* env;
   if (vm->GetEnv(reinterpret_cast<void**>(&env), JNI_VERSION_1_6) != JNI_OK) {
     return -1;
   }
+
+  // Populate JNI References once, rather than for each decoder.
+  const jclass local_output_buffer_class =
+      env->FindClass("androidx/media3/decoder/SimpleDecoderOutputBuffer");
+  if (!local_output_buffer_class) {
+    return -1;
+  }
+  output_buffer_class =
+      static_cast<jclass>(env->NewGlobalRef(local_output_buffer_class));
+  env->DeleteLocalRef(local_output_buffer_class);
+  output_buffer_init = env->GetMethodID(output_buffer_class, "init",
+                                        "(JI)Ljava/nio/ByteBuffer;");
+  if (!output_buffer_init) {
+    return -1;
+  }
   return JNI_VERSION_1_6;
 }
 
 static const int kBytesPerIntPcmSample = 2;
 static const int kBytesPerFloatSample = 4;
 static const int kMaxOpusOutputPacketSizeSamples = 960 * 6;
-static int channelCount;
-static int errorCode;
-static bool outputFloat = false;
+
+// The state of a decoder. Each OpusDecoder has its own, so that decoders can
+// be used concurrently on different threads.
+struct JniContext {
+  ~JniContext() {
+    if (decoder) {
+      opus_multistream_decoder_destroy(decoder);
+    }
+  }
+
+  OpusMSDecoder* decoder = NULL;
+  int sample_rate = 0;
+  int channel_count = 0;
+  int error_code = 0;
+  bool output_float = false;
+};
 
 DECODER_FUNC(jlong, opusInit, jint sampleRate, jint channelCount,
              jint numStreams, jint numCoupled, jint gain,
              jbyteArray jStreamMap) {
+  JniContext* context = new JniContext();
+  context->sample_rate = sampleRate;
+  context->channel_count = channelCount;
   int status = OPUS_INVALID_STATE;
-  ::channelCount = channelCount;
-  errorCode = 0;
   jbyte* streamMapBytes = env->GetByteArrayElements(jStreamMap, 0);
   uint8_t* streamMap = reinterpret_cast<uint8_t*>(streamMapBytes);
-  OpusMSDecoder* decoder = opus_multistream_decoder_create(
+  context->decoder = opus_multistream_decoder_create(
       sampleRate, channelCount, numStreams, numCoupled, streamMap, &status);
   env->ReleaseByteArrayElements(jStreamMap, streamMapBytes, 0);
-  if (!decoder || status != OPUS_OK) {
+  if (!context->decoder || status != OPUS_OK) {
     LOGE("Failed to create Opus Decoder; status=%s", opus_strerror(status));
+    delete context;
     return 0;
   }
-  status = opus_multistream_decoder_ctl(decoder, OPUS_SET_GAIN(gain));
+  status = opus_multistream_decoder_ctl(context->decoder, OPUS_SET_GAIN(gain));
   if (status != OPUS_OK) {
     LOGE("Failed to set Opus header gain; status=%s", opus_strerror(status));
+    delete context;
     return 0;
   }
 
-  // Populate JNI References.
-  const jclass outputBufferClass =
-      env->FindClass("androidx/media3/decoder/SimpleDecoderOutputBuffer");
-  outputBufferInit =
-      env->GetMethodID(outputBufferClass, "init", "(JI)Ljava/nio/ByteBuffer;");
-
-  return reinterpret_cast<intptr_t>(decoder);
+  return reinterpret_cast<intptr_t>(context);
 }
 
-DECODER_FUNC(jint, opusDecode, jlong jDecoder, jlong jTimeUs,
+DECODER_FUNC(jint, opusDecode, jlong jContext, jlong jTimeUs,
              jobject jInputBuffer, jint inputSize, jobject jOutputBuffer) {
-  OpusMSDecoder* decoder = reinterpret_cast<OpusMSDecoder*>(jDecoder);
+  JniContext* const context = reinterpret_cast<JniContext*>(jContext);
   const uint8_t* inputBuffer = reinterpret_cast<const uint8_t*>(
       env->GetDirectBufferAddress(jInputBuffer));
 
+  // Size the output buffer for the packet rather than for the longest possible
+  // packet. All the streams of a multistream packet have the same duration, so
+  // the table of contents of the first stream is enough. An empty packet is
+  // decoded as a lost packet, for which libopus conceals up to the buffer size.
+  const int packetSampleCount =
+      inputSize > 0 ? opus_packet_get_nb_samples(inputBuffer, inputSize,
+                                                 context->sample_rate)
+                    : kMaxOpusOutputPacketSizeSamples;
+  if (packetSampleCount < 0) {
+    context->error_code = packetSampleCount;
+    return packetSampleCount;
+  }
   const int byteSizePerSample =
-      outputFloat ? kBytesPerFloatSample : kBytesPerIntPcmSample;
+      context->output_float ? kBytesPerFloatSample : kBytesPerIntPcmSample;
   const jint outputSize =
-      kMaxOpusOutputPacketSizeSamples * byteSizePerSample * channelCount;
+      packetSampleCount * byteSizePerSample * context->channel_count;
 
-  env->CallObjectMethod(jOutputBuffer, outputBufferInit, jTimeUs, outputSize);
-  if (env->ExceptionCheck()) {
-    // Exception is thrown in Java when returning from the native call.
-    return -1;
-  }
   const jobject jOutputBufferData = env->CallObjectMethod(
-      jOutputBuffer, outputBufferInit, jTimeUs, outputSize);
+      jOutputBuffer, output_buffer_init, jTimeUs, outputSize);
   if (env->ExceptionCheck()) {
     // Exception is thrown in Java when returning from the native call.
     return -1;
   }
 
   int sampleCount;
-  if (outputFloat) {
+  if (context->output_float) {
     float* outputBufferData = reinterpret_cast<float*>(
         env->GetDirectBufferAddress(jOutputBufferData));
     sampleCount = opus_multistream_decode_float(
-        decoder, inputBuffer, inputSize, outputBufferData,
-        kMaxOpusOutputPacketSizeSamples, 0);
+        context->decoder, inputBuffer, inputSize, outputBufferData,
+        packetSampleCount, 0);
   } else {
     int16_t* outputBufferData = reinterpret_cast<int16_t*>(
         env->GetDirectBufferAddress(jOutputBufferData));
-    sampleCount = opus_multistream_decode(decoder, inputBuffer, inputSize,
-                                          outputBufferData,
-                                          kMaxOpusOutputPacketSizeSamples, 0);
+    sampleCount = opus_multistream_decode(context->decoder, inputBuffer,
+                                          inputSize, outputBufferData,
+                                          packetSampleCount, 0);
   }
 
   // record error code
-  errorCode = (sampleCount < 0) ? sampleCount : 0;
-  return (sampleCount < 0) ? sampleCount
-                           : sampleCount * byteSizePerSample * channelCount;
+  context->error_code = (sampleCount < 0) ? sampleCount : 0;
+  return (sampleCount < 0)
+             ? sampleCount
+             : sampleCount * byteSizePerSample * context->channel_count;
+}
+
+DECODER_FUNC(jint, opusDecodePackets, jlong jContext, jobject jInputBuffer,
+             jint inputOffset, jintArray jPacketSizes, jint packetCount,
+             jobject jOutputBuffer, jint outputOffset,
+             jintArray jOutputOffsets) {
+  JniContext* const context = reinterpret_cast<JniContext*>(jContext);
+  const uint8_t* inputBuffer = reinterpret_cast<const uint8_t*>(
+      env->GetDirectBufferAddress(jInputBuffer));
+  const jlong inputCapacity = env->GetDirectBufferCapacity(jInputBuffer);
+  uint8_t* outputBuffer =
+      reinterpret_cast<uint8_t*>(env->GetDirectBufferAddress(jOutputBuffer));
+  const jlong outputCapacity = env->GetDirectBufferCapacity(jOutputBuffer);
+  if (!inputBuffer || !outputBuffer || packetCount < 0 ||
+      packetCount > env->GetArrayLength(jPacketSizes) ||
+      packetCount >= env->GetArrayLength(jOutputOffsets)) {
+    context->error_code = OPUS_BAD_ARG;
+    return OPUS_BAD_ARG;
+  }
+
+  std::vector<jint> packetSizes(packetCount);
+  env->GetIntArrayRegion(jPacketSizes, 0, packetCount, packetSizes.data());
+  std::vector<jint> outputOffsets(packetCount + 1);
+
+  const int bytesPerSampleFrame =
+      (context->output_float ? kBytesPerFloatSample : kBytesPerIntPcmSample) *
+      context->channel_count;
+  jlong inputPosition = inputOffset;
+  jlong outputPosition = outputOffset;
+  outputOffsets[0] = outputOffset;
+  int decodedPacketCount = 0;
+  context->error_code = 0;
+  for (; decodedPacketCount < packetCount; decodedPacketCount++) {
+    const jint packetSize = packetSizes[decodedPacketCount];
+    if (packetSize <= 0 || packetSize > inputCapacity - inputPosition) {
+      context->error_code = OPUS_BAD_ARG;
+      break;
+    }
+    const uint8_t* packet = inputBuffer + inputPosition;
+    const int packetSampleCount =
+        opus_packet_get_nb_samples(packet, packetSize, context->sample_rate);
+    if (packetSampleCount < 0) {
+      context->error_code = packetSampleCount;
+      break;
+    }
+    if (static_cast<jlong>(packetSampleCount) * bytesPerSampleFrame >
+        outputCapacity - outputPosition) {
+      // The remaining packets are left for the next call.
+      break;
+    }
+    int sampleCount;
+    if (context->output_float) {
+      sampleCount = opus_multistream_decode_float(
+          context->decoder, packet, packetSize,
+          reinterpret_cast<float*>(outputBuffer + outputPosition),
+          packetSampleCount, 0);
+    } else {
+      sampleCount = opus_multistream_decode(
+          context->decoder, packet, packetSize,
+          reinterpret_cast<int16_t*>(outputBuffer + outputPosition),
+          packetSampleCount, 0);
+    }
+    if (sampleCount < 0) {
+      context->error_code = sampleCount;
+      break;
+    }
+    inputPosition += packetSize;
+    outputPosition += sampleCount * bytesPerSampleFrame;
+    outputOffsets[decodedPacketCount + 1] = outputPosition;
+  }
+
+  // The decoder state has advanced past the packets decoded before an error,
+  // so they're returned, and the error is reported by the next call.
+  if (context->error_code != 0 && decodedPacketCount == 0) {
+    return context->error_code;
+  }
+  env->SetIntArrayRegion(jOutputOffsets, 0, decodedPacketCount + 1,
+                         outputOffsets.data());
+  return decodedPacketCount;
 }
 
-DECODER_FUNC(jint, opusSecureDecode, jlong jDecoder, jlong jTimeUs,
+DECODER_FUNC(jint, opusSecureDecode, jlong jContext, jlong jTimeUs,
              jobject jInputBuffer, jint inputSize, jobject jOutputBuffer,
              jint sampleRate, jobject mediaCrypto, jint inputMode,
              jbyteArray key, jbyteArray javaIv, jint inputNumSubSamples,
@@ -155,23 +270,30 @@ DECODER_FUNC(jint, opusSecureDecode, jlong jDecoder, jlong jTimeUs,
   return -2;
 }
 
-DECODER_FUNC(void, opusClose, jlong jDecoder) {
-  OpusMSDecoder* decoder = reinterpret_cast<OpusMSDecoder*>(jDecoder);
-  opus_multistream_decoder_destroy(decoder);
+DECODER_FUNC(void, opusClose, jlong jContext) {
+  JniContext* const context = reinterpret_cast<JniContext*>(jContext);
+  delete context;
 }
 
-DECODER_FUNC(void, opusReset, jlong jDecoder) {
-  OpusMSDecoder* decoder = reinterpret_cast<OpusMSDecoder*>(jDecoder);
-  opus_multistream_decoder_ctl(decoder, OPUS_RESET_STATE);
+DECODER_FUNC(void, opusReset, jlong jContext) {
+  JniContext* const context = reinterpret_cast<JniContext*>(jContext);
+  opus_multistream_decoder_ctl(context->decoder, OPUS_RESET_STATE);
 }
 
 DECODER_FUNC(jstring, opusGetErrorMessage, jlong jContext) {
-  return env->NewStringUTF(opus_strerror(errorCode));
+  JniContext* const context = reinterpret_cast<JniContext*>(jContext);
+  return env->NewStringUTF(opus_strerror(context->error_code));
 }
 
-DECODER_FUNC(jint, opusGetErrorCode, jlong jContext) { return errorCode; }
+DECODER_FUNC(jint, opusGetErrorCode, jlong jContext) {
+  JniContext* const context = reinterpret_cast<JniContext*>(jContext);
+  return context->error_code;
+}
 
-DECODER_FUNC(void, opusSetFloatOutput) { outputFloat = true; }
+DECODER_FUNC(void, opusSetFloatOutput, jlong jContext) {
+  JniContext* const context = reinterpret_cast<JniContext*>(jContext);
+  context->output_float = true;
+}
 
 LIBRARY_FUNC(jstring, opusIsSecureDecodeSupported) {
   // Doesn't support
@@ -0,0 +1,100 @@
+/*
+ * Copyright 2026 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+package androidx.media3.decoder.vp9;
+
+import static com.google.common.truth.Truth.assertThat;
+import static org.junit.Assert.fail;
+
+import android.content.Context;
+import androidx.annotation.Nullable;
+import androidx.media3.common.C;
+import androidx.media3.decoder.DecoderInputBuffer;
+import androidx.media3.decoder.VideoDecoderOutputBuffer;
+import androidx.media3.extractor.mkv.MatroskaExtractor;
+import androidx.media3.test.utils.FakeExtractorOutput;
+import androidx.media3.test.utils.FakeTrackOutput;
+import androidx.media3.test.utils.TestUtil;
+import androidx.test.core.app.ApplicationProvider;
+import androidx.test.ext.junit.runners.AndroidJUnit4;
+import java.nio.ByteBuffer;
+import org.junit.Before;
+import org.junit.Test;
+import org.junit.runner.RunWith;
+
+/** Tests for {@link VpxDecoder}. */
+@RunWith(AndroidJUnit4.class)
+public final class VpxDecoderTest {
+
+  private static final String BEAR_PATH = "media/vp9/bear-vp9.webm";
+
+  @Before
+  public void setUp() {
+    if (!VpxLibrary.isAvailable()) {
+      fail("Vpx library not available.");
+    }
+  }
+
+  @Test
+  public void release_whileHoldingZeroCopyOutputBuffer_keepsFrameUntilBufferReleased()
+      throws Exception {
+    Context context = ApplicationProvider.getApplicationContext();
+    FakeExtractorOutput extractorOutput =
+        TestUtil.extractAllSamplesFromFile(new MatroskaExtractor(), context, BEAR_PATH);
+    FakeTrackOutput trackOutput = extractorOutput.trackOutputs.valueAt(0);
+    byte[] sampleData = trackOutput.getSampleData(0);
+    VpxDecoder decoder =
+        new VpxDecoder(
+            /* numInputBuffers= */ 1,
+            /* numOutputBuffers= */ 1,
+            /* initialInputBufferSize= */ sampleData.length,
+            /* cryptoConfig= */ null,
+            /* threads= */ 1);
+    decoder.setOutputMode(C.VIDEO_OUTPUT_MODE_YUV);
+    decoder.experimentalSetZeroCopyYuvOutputEnabled(true);
+    DecoderInputBuffer inputBuffer = decoder.dequeueInputBuffer();
+    inputBuffer.ensureSpaceForWrite(sampleData.length);
+    inputBuffer.data.put(sampleData);
+    inputBuffer.flip();
+    inputBuffer.timeUs = trackOutput.getSampleTimeUs(0);
+    decoder.queueInputBuffer(inputBuffer);
+    @Nullable VideoDecoderOutputBuffer outputBuffer = null;
+    while (outputBuffer == null) {
+      outputBuffer = decoder.dequeueOutputBuffer();
+    }
+    ByteBuffer[] yuvPlanes = outputBuffer.yuvPlanes;
+    byte[][] planeData = new byte[yuvPlanes.length][];
+    for (int i = 0; i < yuvPlanes.length; i++) {
+      planeData[i] = getBytes(yuvPlanes[i]);
+    }
+
+    decoder.release();
+
+    // The planes reference the decoder's frame buffer, which stays valid until the output buffer
+    // is released, e.g. for a view that redraws the last frame.
+    for (int i = 0; i < yuvPlanes.length; i++) {
+      assertThat(getBytes(yuvPlanes[i])).isEqualTo(planeData[i]);
+    }
+    outputBuffer.release();
+  }
+
+  private static byte[] getBytes(ByteBuffer buffer) {
+    ByteBuffer duplicate = buffer.duplicate();
+    duplicate.clear();
+    byte[] bytes = new byte[duplicate.remaining()];
+    duplicate.get(bytes);
+    return bytes;
+  }
+}
@@ -37,6 +37,16 @@ import androidx.media3.exoplayer.video.VideoRendererEventListener;
 @UnstableApi
 public class LibvpxVideoRenderer extends DecoderVideoRenderer {
 
+  /**
+   * Attempts to use one thread per 640x360 pixels of the largest frames of the video, but no more
+   * threads than performance processors available on the device. If the maximum size of the video
+   * is unknown, one thread per performance processor is used. If the number of performance
+   * processors cannot be detected, the number of available processors is used.
+   *
+   * <p>The value is negative, because a thread count of 0 is passed to libvpx as is.
+   */
+  public static final int THREAD_COUNT_AUTODETECT = -1;
+
   private static final String TAG = "LibvpxVideoRenderer";
 
   /** The number of input buffers. */
@@ -54,6 +64,7 @@ public class LibvpxVideoRenderer extends DecoderVideoRenderer {
 
   private final int threads;
 
+  private boolean performanceCoreAffinityEnabled;
   @Nullable private VpxDecoder decoder;
 
   /**
@@ -102,7 +113,9 @@ public class LibvpxVideoRenderer extends DecoderVideoRenderer {
    * @param eventListener A listener of events. May be null if delivery of events is not required.
    * @param maxDroppedFramesToNotify The maximum number of frames that can be dropped between
    *     invocations of {@link VideoRendererEventListener#onDroppedFrames(int, long)}.
-   * @param threads Number of threads libvpx will use to decode.
+   * @param threads Number of threads libvpx will use to decode. If {@link
+   *     #THREAD_COUNT_AUTODETECT} is passed, then the number of threads to use is autodetected
+   *     based on CPU capabilities and the video size.
    * @param numInputBuffers Number of input buffers.
    * @param numOutputBuffers Number of output buffers.
    */
@@ -120,6 +133,23 @@ public class LibvpxVideoRenderer extends DecoderVideoRenderer {
     this.numOutputBuffers = numOutputBuffers;
   }
 
+  /**
+   * Sets whether to restrict the decoder threads to the performance cores on devices with
+   * heterogeneous cores (e.g. big.LITTLE), so that frames aren't delayed by threads scheduled on
+   * efficiency cores. Disabled by default.
+   *
+   * <p>Takes effect the next time a decoder is created.
+   *
+   * <p>This method is experimental, and will be renamed or removed in a future release.
+   *
+   * @param performanceCoreAffinityEnabled Whether to restrict the decoder threads to the
+   *     performance cores.
+   */
+  public void experimentalSetPerformanceCoreAffinityEnabled(
+      boolean performanceCoreAffinityEnabled) {
+    this.performanceCoreAffinityEnabled = performanceCoreAffinityEnabled;
+  }
+
   @Override
   public String getName() {
     return TAG;
@@ -146,7 +176,16 @@ public class LibvpxVideoRenderer extends DecoderVideoRenderer {
         format.maxInputSize != Format.NO_VALUE ? format.maxInputSize : DEFAULT_INPUT_BUFFER_SIZE;
     VpxDecoder decoder =
         new VpxDecoder(
-            numInputBuffers, numOutputBuffers, initialInputBufferSize, cryptoConfig, threads);
+            numInputBuffers,
+            numOutputBuffers,
+            initialInputBufferSize,
+            cryptoConfig,
+            threads,
+            // The decoder is reused when the size changes, so the thread count is sized for the
+            // largest frames. If their size is unknown, all the performance cores are used.
+            format.maxWidth,
+            format.maxHeight,
+            performanceCoreAffinityEnabled);
     this.decoder = decoder;
     TraceUtil.endSection();
     return decoder;
@@ -16,11 +16,13 @@
 package androidx.media3.decoder.vp9;
 
 import static androidx.annotation.VisibleForTesting.PACKAGE_PRIVATE;
+import static java.lang.Runtime.getRuntime;
 
 import android.view.Surface;
 import androidx.annotation.Nullable;
 import androidx.annotation.VisibleForTesting;
 import androidx.media3.common.C;
+import androidx.media3.common.Format;
 import androidx.media3.common.util.Assertions;
 import androidx.media3.common.util.UnstableApi;
 import androidx.media3.common.util.Util;
@@ -30,6 +32,7 @@ import androidx.media3.decoder.CryptoInfo;
 import androidx.media3.decoder.DecoderInputBuffer;
 import androidx.media3.decoder.SimpleDecoder;
 import androidx.media3.decoder.VideoDecoderOutputBuffer;
+import androidx.media3.decoder.VideoDecoderStats;
 import java.nio.ByteBuffer;
 
 /** Vpx decoder. */
@@ -50,6 +53,7 @@ public final class VpxDecoder
   @Nullable private ByteBuffer lastSupplementalData;
 
   private volatile @C.VideoOutputMode int outputMode;
+  private boolean zeroCopyYuvOutputEnabled;
 
   /**
    * Creates a VP9 decoder.
@@ -59,7 +63,9 @@ public final class VpxDecoder
    * @param initialInputBufferSize The initial size of each input buffer.
    * @param cryptoConfig The {@link CryptoConfig} object required for decoding encrypted content.
    *     May be null and can be ignored if decoder does not handle encrypted content.
-   * @param threads Number of threads libvpx will use to decode.
+   * @param threads Number of threads libvpx will use to decode. If {@link
+   *     LibvpxVideoRenderer#THREAD_COUNT_AUTODETECT} is passed, then this class will auto detect
+   *     the number of threads to be used.
    * @throws VpxDecoderException Thrown if an exception occurs when initializing the decoder.
    */
   public VpxDecoder(
@@ -69,6 +75,46 @@ public final class VpxDecoder
       @Nullable CryptoConfig cryptoConfig,
       int threads)
       throws VpxDecoderException {
+    this(
+        numInputBuffers,
+        numOutputBuffers,
+        initialInputBufferSize,
+        cryptoConfig,
+        threads,
+        /* width= */ Format.NO_VALUE,
+        /* height= */ Format.NO_VALUE,
+        /* performanceCoreAffinityEnabled= */ false);
+  }
+
+  /**
+   * Creates a VP9 decoder.
+   *
+   * @param numInputBuffers The number of input buffers.
+   * @param numOutputBuffers The number of output buffers.
+   * @param initialInputBufferSize The initial size of each input buffer.
+   * @param cryptoConfig The {@link CryptoConfig} object required for decoding encrypted content.
+   *     May be null and can be ignored if decoder does not handle encrypted content.
+   * @param threads Number of threads libvpx will use to decode. If {@link
+   *     LibvpxVideoRenderer#THREAD_COUNT_AUTODETECT} is passed, then this class will auto detect
+   *     the number of threads to be used.
+   * @param maxWidth The maximum width of the video in pixels, or {@link Format#NO_VALUE} if
+   *     unknown. Used to auto detect the number of threads.
+   * @param maxHeight The maximum height of the video in pixels, or {@link Format#NO_VALUE} if
+   *     unknown. Used to auto detect the number of threads.
+   * @param performanceCoreAffinityEnabled Whether to restrict the decoder threads to the
+   *     performance cores on devices with heterogeneous cores (e.g. big.LITTLE).
+   * @throws VpxDecoderException Thrown if an exception occurs when initializing the decoder.
+   */
+  public VpxDecoder(
+      int numInputBuffers,
+      int numOutputBuffers,
+      int initialInputBufferSize,
+      @Nullable CryptoConfig cryptoConfig,
+      int threads,
+      int maxWidth,
+      int maxHeight,
+      boolean performanceCoreAffinityEnabled)
+      throws VpxDecoderException {
     super(new DecoderInputBuffer[numInputBuffers], new VideoDecoderOutputBuffer[numOutputBuffers]);
     if (!VpxLibrary.isAvailable()) {
       throw new VpxDecoderException("Failed to load decoder native libraries.");
@@ -77,8 +123,20 @@ public final class VpxDecoder
     if (cryptoConfig != null && !VpxLibrary.vpxIsSecureDecodeSupported()) {
       throw new VpxDecoderException("Vpx decoder does not support secure decode.");
     }
+    if (threads == LibvpxVideoRenderer.THREAD_COUNT_AUTODETECT) {
+      // Try to get the optimal number of threads from the heuristic shared with AV1.
+      threads = vpxGetThreads(maxWidth, maxHeight);
+      if (threads <= 0) {
+        // If that is not available, default to the number of available processors.
+        threads = getRuntime().availableProcessors();
+      }
+    }
     vpxDecContext =
-        vpxInit(/* disableLoopFilter= */ false, /* enableRowMultiThreadMode= */ false, threads);
+        vpxInit(
+            /* disableLoopFilter= */ false,
+            /* enableRowMultiThreadMode= */ false,
+            threads,
+            performanceCoreAffinityEnabled);
     if (vpxDecContext == 0) {
       throw new VpxDecoderException("Failed to initialize decoder");
     }
@@ -104,7 +162,8 @@ public final class VpxDecoder
   protected void releaseOutputBuffer(VideoDecoderOutputBuffer buffer) {
     // Decode only frames do not acquire a reference on the internal decoder buffer and thus do not
     // require a call to vpxReleaseFrame.
-    if (outputMode == C.VIDEO_OUTPUT_MODE_SURFACE_YUV && !buffer.isDecodeOnly()) {
+    if ((outputMode == C.VIDEO_OUTPUT_MODE_SURFACE_YUV || zeroCopyYuvOutputEnabled)
+        && !buffer.isDecodeOnly()) {
       vpxReleaseFrame(vpxDecContext, buffer);
     }
     super.releaseOutputBuffer(buffer);
@@ -181,6 +240,9 @@ public final class VpxDecoder
   @Override
   public void release() {
     super.release();
+    // Release the frames that were decoded but not dequeued, so that they don't keep the native
+    // frame buffers alive.
+    flush();
     lastSupplementalData = null;
     vpxClose(vpxDecContext);
   }
@@ -194,17 +256,62 @@ public final class VpxDecoder
     this.outputMode = outputMode;
   }
 
-  /** Renders the outputBuffer to the surface. Used with OUTPUT_MODE_SURFACE_YUV only. */
+  /**
+   * Sets whether frames output in {@link C#VIDEO_OUTPUT_MODE_YUV} expose the decoder's frame
+   * buffers directly instead of copying them into {@link VideoDecoderOutputBuffer#data}. When
+   * enabled, {@link VideoDecoderOutputBuffer#yuvPlanes} reference native memory that is only valid
+   * until the output buffer is released, which may happen after the decoder is released. High bit
+   * depth frames are always converted and copied.
+   *
+   * <p>Must be called before the first call to {@link #decode}.
+   *
+   * <p>This method is experimental, and will be renamed or removed in a future release.
+   */
+  public void experimentalSetZeroCopyYuvOutputEnabled(boolean enabled) {
+    zeroCopyYuvOutputEnabled = enabled;
+    vpxSetZeroCopyYuvOutput(vpxDecContext, enabled);
+  }
+
+  /**
+   * Returns the performance counters of the decoder since it was created.
+   *
+   * <p>May be called from any thread, but not after {@link #release()}.
+   *
+   * <p>This method is experimental, and will be renamed or removed in a future release.
+   */
+  public VideoDecoderStats experimentalGetStats() {
+    long[] values = new long[VideoDecoderStats.VALUE_COUNT];
+    vpxGetStats(vpxDecContext, values);
+    return new VideoDecoderStats(values);
+  }
+
+  /**
+   * Renders the outputBuffer to the surface. Used with OUTPUT_MODE_SURFACE_YUV only.
+   *
+   * <p>High bit depth frames are rendered as 10-bit P010 buffers, with a data space derived from
+   * the color info of the output buffer's format. If the device doesn't report the layout of P010
+   * buffers (before API level 29), or the surface rejects them, 10-bit frames are converted to 8
+   * bits instead.
+   */
   public void renderToSurface(VideoDecoderOutputBuffer outputBuffer, Surface surface)
       throws VpxDecoderException {
-    int getFrameResult = vpxRenderFrame(vpxDecContext, surface, outputBuffer);
+    @Nullable Format format = outputBuffer.format;
+    @C.ColorTransfer
+    int colorTransfer =
+        format != null && format.colorInfo != null
+            ? format.colorInfo.colorTransfer
+            : Format.NO_VALUE;
+    int getFrameResult = vpxRenderFrame(vpxDecContext, surface, outputBuffer, colorTransfer);
     if (getFrameResult == -1) {
       throw new VpxDecoderException("Buffer render failed.");
     }
   }
 
   private native long vpxInit(
-      boolean disableLoopFilter, boolean enableRowMultiThreadMode, int threads);
+      boolean disableLoopFilter,
+      boolean enableRowMultiThreadMode,
+      int threads,
+      boolean performanceCoreAffinity);
 
   private native long vpxClose(long context);
 
@@ -226,10 +333,14 @@ public final class VpxDecoder
 
   /**
    * Renders the frame to the surface. Used with OUTPUT_MODE_SURFACE_YUV only. Must only be called
-   * if {@link #vpxInit} was called with {@code enableBufferManager = true}.
+   * if {@link #vpxInit} was called with {@code enableBufferManager = true}. {@code colorTransfer}
+   * is only used for high bit depth frames, as VP9 doesn't signal the transfer function.
    */
   private native int vpxRenderFrame(
-      long context, Surface surface, VideoDecoderOutputBuffer outputBuffer);
+      long context,
+      Surface surface,
+      VideoDecoderOutputBuffer outputBuffer,
+      @C.ColorTransfer int colorTransfer);
 
   /**
    * Releases the frame. Used with OUTPUT_MODE_SURFACE_YUV only. Must only be called if {@link
@@ -237,7 +348,22 @@ public final class VpxDecoder
    */
   private native int vpxReleaseFrame(long context, VideoDecoderOutputBuffer outputBuffer);
 
+  /**
+   * Sets whether YUV frames reference the decoder's frame buffers instead of being copied. Frames
+   * output this way must be released with {@link #vpxReleaseFrame}.
+   */
+  private native void vpxSetZeroCopyYuvOutput(long context, boolean enabled);
+
+  /** Writes {@link VideoDecoderStats#VALUE_COUNT} stats values to {@code values}. */
+  private native void vpxGetStats(long context, long[] values);
+
   private native int vpxGetErrorCode(long context);
 
   private native String vpxGetErrorMessage(long context);
+
+  /**
+   * Returns the optimal number of threads to decode video of the given size with, or 0 if it
+   * cannot be determined. {@code width} and {@code height} may be {@link Format#NO_VALUE}.
+   */
+  private native int vpxGetThreads(int width, int height);
 }
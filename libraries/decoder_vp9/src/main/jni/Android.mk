@@ -17,11 +17,16 @@
 WORKING_DIR := $(call my-dir)
 include $(CLEAR_VARS)
 LIBVPX_ROOT := $(WORKING_DIR)/libvpx
+# Native code shared between the decoder modules.
+DECODER_JNI_ROOT := $(WORKING_DIR)/../../../../decoder/src/main/jni
 
 # build libvpx.so
 LOCAL_PATH := $(WORKING_DIR)
 include libvpx.mk
 
+# build the shared decoder JNI library
+include $(DECODER_JNI_ROOT)/decoder_jni.mk
+
 # build libvpxV2JNI.so
 include $(CLEAR_VARS)
 LOCAL_PATH := $(WORKING_DIR)
@@ -31,7 +36,5 @@ LOCAL_CPP_EXTENSION := .cc
 LOCAL_SRC_FILES := vpx_jni.cc
 LOCAL_LDLIBS := -llog -lz -lm -landroid
 LOCAL_SHARED_LIBRARIES := libvpx
-LOCAL_STATIC_LIBRARIES := cpufeatures
+LOCAL_STATIC_LIBRARIES := decoder_jni
 include $(BUILD_SHARED_LIBRARY)
-
-$(call import-module,android/cpufeatures)
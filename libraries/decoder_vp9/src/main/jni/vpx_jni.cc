@@ -14,17 +14,13 @@
  * limitations under the License.
  */
 
-#include <cpu-features.h>
-#ifdef __ARM_NEON__
-#include <arm_neon.h>
-#endif
 #include <android/log.h>
 #include <android/native_window.h>
 #include <android/native_window_jni.h>
 #include <jni.h>
-#include <pthread.h>
 
 #include <algorithm>
+#include <atomic>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
@@ -34,6 +30,13 @@
 #include "vpx/vp8dx.h"
 #include "vpx/vpx_decoder.h"
 
+#include "bit_depth_converter.h"  // NOLINT
+#include "decoder_stats.h"        // NOLINT
+#include "frame_pool.h"           // NOLINT
+#include "p010_surface.h"         // NOLINT
+#include "plane_copy.h"           // NOLINT
+#include "thread_scheduling.h"    // NOLINT
+
 #define LOG_TAG "vpx_jni"
 #define LOGE(...) \
   ((void)__android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__))
@@ -54,8 +57,10 @@
   JNIEXPORT RETURN_TYPE Java_androidx_media3_decoder_vp9_VpxLibrary_##NAME( \
       JNIEnv* env, jobject thiz, ##__VA_ARGS__)
 
-// JNI references for VideoDecoderOutputBuffer class.
+// JNI references for VideoDecoderOutputBuffer class, resolved in JNI_OnLoad.
+static jclass outputBufferClass;
 static jmethodID initForYuvFrame;
+static jmethodID initForExternalYuvFrame;
 static jmethodID initForPrivateFrame;
 static jfieldID dataField;
 static jfieldID outputModeField;
@@ -73,323 +78,189 @@ jint JNI_OnLoad(JavaVM* vm, void* reserved) {
   if (vm->GetEnv(reinterpret_cast<void**>(&env), JNI_VERSION_1_6) != JNI_OK) {
     return -1;
   }
-  return JNI_VERSION_1_6;
-}
-
-#ifdef __ARM_NEON__
-static int convert_16_to_8_neon(const vpx_image_t* const img, jbyte* const data,
-                                const int32_t uvHeight, const int32_t yLength,
-                                const int32_t uvLength) {
-  if (!(android_getCpuFeatures() & ANDROID_CPU_ARM_FEATURE_NEON)) return 0;
-  uint32x2_t lcg_val = vdup_n_u32(random());
-  lcg_val = vset_lane_u32(random(), lcg_val, 1);
-  // LCG values recommended in good ol' "Numerical Recipes"
-  const uint32x2_t LCG_MULT = vdup_n_u32(1664525);
-  const uint32x2_t LCG_INCR = vdup_n_u32(1013904223);
-
-  const uint16_t* srcBase =
-      reinterpret_cast<uint16_t*>(img->planes[VPX_PLANE_Y]);
-  uint8_t* dstBase = reinterpret_cast<uint8_t*>(data);
-  // In units of uint16_t, so /2 from raw stride
-  const int srcStride = img->stride[VPX_PLANE_Y] / 2;
-  const int dstStride = img->stride[VPX_PLANE_Y];
-
-  for (int y = 0; y < img->d_h; y++) {
-    const uint16_t* src = srcBase;
-    uint8_t* dst = dstBase;
-
-    // Each read consumes 4 2-byte samples, but to reduce branches and
-    // random steps we unroll to four rounds, so each loop consumes 16
-    // samples.
-    const int imax = img->d_w & ~15;
-    int i;
-    for (i = 0; i < imax; i += 16) {
-      // Run a round of the RNG.
-      lcg_val = vmla_u32(LCG_INCR, lcg_val, LCG_MULT);
-
-      // The lower two bits of this LCG parameterization are garbage,
-      // leaving streaks on the image. We access the upper bits of each
-      // 16-bit lane by shifting. (We use this both as an 8- and 16-bit
-      // vector, so the choice of which one to keep it as is arbitrary.)
-      uint8x8_t randvec =
-          vreinterpret_u8_u16(vshr_n_u16(vreinterpret_u16_u32(lcg_val), 8));
-
-      // We retrieve the values and shift them so that the bits we'll
-      // shift out (after biasing) are in the upper 8 bits of each 16-bit
-      // lane.
-      uint16x4_t values = vshl_n_u16(vld1_u16(src), 6);
-      src += 4;
-
-      // We add the bias bits in the lower 8 to the shifted values to get
-      // the final values in the upper 8 bits.
-      uint16x4_t added1 = vqadd_u16(values, vreinterpret_u16_u8(randvec));
-
-      // Shifting the randvec bits left by 2 bits, as an 8-bit vector,
-      // should leave us with enough bias to get the needed rounding
-      // operation.
-      randvec = vshl_n_u8(randvec, 2);
-
-      // Retrieve and sum the next 4 pixels.
-      values = vshl_n_u16(vld1_u16(src), 6);
-      src += 4;
-      uint16x4_t added2 = vqadd_u16(values, vreinterpret_u16_u8(randvec));
-
-      // Reinterpret the two added vectors as 8x8, zip them together, and
-      // discard the lower portions.
-      uint8x8_t zipped =
-          vuzp_u8(vreinterpret_u8_u16(added1), vreinterpret_u8_u16(added2))
-              .val[1];
-      vst1_u8(dst, zipped);
-      dst += 8;
-
-      // Run it again with the next two rounds using the remaining
-      // entropy in randvec.
-      randvec = vshl_n_u8(randvec, 2);
-      values = vshl_n_u16(vld1_u16(src), 6);
-      src += 4;
-      added1 = vqadd_u16(values, vreinterpret_u16_u8(randvec));
-      randvec = vshl_n_u8(randvec, 2);
-      values = vshl_n_u16(vld1_u16(src), 6);
-      src += 4;
-      added2 = vqadd_u16(values, vreinterpret_u16_u8(randvec));
-      zipped = vuzp_u8(vreinterpret_u8_u16(added1), vreinterpret_u8_u16(added2))
-                   .val[1];
-      vst1_u8(dst, zipped);
-      dst += 8;
-    }
-
-    uint32_t randval = 0;
-    // For the remaining pixels in each row - usually none, as most
-    // standard sizes are divisible by 32 - convert them "by hand".
-    while (i < img->d_w) {
-      if (!randval) randval = random();
-      dstBase[i] = (srcBase[i] + (randval & 3)) >> 2;
-      i++;
-      randval >>= 2;
-    }
-
-    srcBase += srcStride;
-    dstBase += dstStride;
-  }
-
-  const uint16_t* srcUBase =
-      reinterpret_cast<uint16_t*>(img->planes[VPX_PLANE_U]);
-  const uint16_t* srcVBase =
-      reinterpret_cast<uint16_t*>(img->planes[VPX_PLANE_V]);
-  const int32_t uvWidth = (img->d_w + 1) / 2;
-  uint8_t* dstUBase = reinterpret_cast<uint8_t*>(data + yLength);
-  uint8_t* dstVBase = reinterpret_cast<uint8_t*>(data + yLength + uvLength);
-  const int srcUVStride = img->stride[VPX_PLANE_V] / 2;
-  const int dstUVStride = img->stride[VPX_PLANE_V];
-
-  for (int y = 0; y < uvHeight; y++) {
-    const uint16_t* srcU = srcUBase;
-    const uint16_t* srcV = srcVBase;
-    uint8_t* dstU = dstUBase;
-    uint8_t* dstV = dstVBase;
-
-    // As before, each i++ consumes 4 samples (8 bytes). For simplicity we
-    // don't unroll these loops more than we have to, which is 8 samples.
-    const int imax = uvWidth & ~7;
-    int i;
-    for (i = 0; i < imax; i += 8) {
-      lcg_val = vmla_u32(LCG_INCR, lcg_val, LCG_MULT);
-      uint8x8_t randvec =
-          vreinterpret_u8_u16(vshr_n_u16(vreinterpret_u16_u32(lcg_val), 8));
-      uint16x4_t uVal1 = vqadd_u16(vshl_n_u16(vld1_u16(srcU), 6),
-                                   vreinterpret_u16_u8(randvec));
-      srcU += 4;
-      randvec = vshl_n_u8(randvec, 2);
-      uint16x4_t vVal1 = vqadd_u16(vshl_n_u16(vld1_u16(srcV), 6),
-                                   vreinterpret_u16_u8(randvec));
-      srcV += 4;
-      randvec = vshl_n_u8(randvec, 2);
-      uint16x4_t uVal2 = vqadd_u16(vshl_n_u16(vld1_u16(srcU), 6),
-                                   vreinterpret_u16_u8(randvec));
-      srcU += 4;
-      randvec = vshl_n_u8(randvec, 2);
-      uint16x4_t vVal2 = vqadd_u16(vshl_n_u16(vld1_u16(srcV), 6),
-                                   vreinterpret_u16_u8(randvec));
-      srcV += 4;
-      vst1_u8(dstU,
-              vuzp_u8(vreinterpret_u8_u16(uVal1), vreinterpret_u8_u16(uVal2))
-                  .val[1]);
-      dstU += 8;
-      vst1_u8(dstV,
-              vuzp_u8(vreinterpret_u8_u16(vVal1), vreinterpret_u8_u16(vVal2))
-                  .val[1]);
-      dstV += 8;
-    }
-
-    uint32_t randval = 0;
-    while (i < uvWidth) {
-      if (!randval) randval = random();
-      dstUBase[i] = (srcUBase[i] + (randval & 3)) >> 2;
-      randval >>= 2;
-      dstVBase[i] = (srcVBase[i] + (randval & 3)) >> 2;
-      randval >>= 2;
-      i++;
-    }
-
-    srcUBase += srcUVStride;
-    srcVBase += srcUVStride;
-    dstUBase += dstUVStride;
-    dstVBase += dstUVStride;
-  }
-
-  return 1;
-}
-
-#endif  // __ARM_NEON__
 
-static void convert_16_to_8_standard(const vpx_image_t* const img,
-                                     jbyte* const data, const int32_t uvHeight,
-                                     const int32_t yLength,
-                                     const int32_t uvLength) {
-  // Y
-  int sampleY = 0;
-  for (int y = 0; y < img->d_h; y++) {
-    const uint16_t* srcBase = reinterpret_cast<uint16_t*>(
-        img->planes[VPX_PLANE_Y] + img->stride[VPX_PLANE_Y] * y);
-    int8_t* destBase = data + img->stride[VPX_PLANE_Y] * y;
-    for (int x = 0; x < img->d_w; x++) {
-      // Lightweight dither. Carryover the remainder of each 10->8 bit
-      // conversion to the next pixel.
-      sampleY += *srcBase++;
-      *destBase++ = sampleY >> 2;
-      sampleY = sampleY & 3;  // Remainder.
-    }
+  // Populate JNI References once, rather than for each decoder.
+  const jclass localOutputBufferClass =
+      env->FindClass("androidx/media3/decoder/VideoDecoderOutputBuffer");
+  if (!localOutputBufferClass) {
+    return -1;
   }
-  // UV
-  int sampleU = 0;
-  int sampleV = 0;
-  const int32_t uvWidth = (img->d_w + 1) / 2;
-  for (int y = 0; y < uvHeight; y++) {
-    const uint16_t* srcUBase = reinterpret_cast<uint16_t*>(
-        img->planes[VPX_PLANE_U] + img->stride[VPX_PLANE_U] * y);
-    const uint16_t* srcVBase = reinterpret_cast<uint16_t*>(
-        img->planes[VPX_PLANE_V] + img->stride[VPX_PLANE_V] * y);
-    int8_t* destUBase = data + yLength + img->stride[VPX_PLANE_U] * y;
-    int8_t* destVBase =
-        data + yLength + uvLength + img->stride[VPX_PLANE_V] * y;
-    for (int x = 0; x < uvWidth; x++) {
-      // Lightweight dither. Carryover the remainder of each 10->8 bit
-      // conversion to the next pixel.
-      sampleU += *srcUBase++;
-      *destUBase++ = sampleU >> 2;
-      sampleU = sampleU & 3;  // Remainder.
-      sampleV += *srcVBase++;
-      *destVBase++ = sampleV >> 2;
-      sampleV = sampleV & 3;  // Remainder.
-    }
+  outputBufferClass =
+      static_cast<jclass>(env->NewGlobalRef(localOutputBufferClass));
+  env->DeleteLocalRef(localOutputBufferClass);
+  initForYuvFrame =
+      env->GetMethodID(outputBufferClass, "initForYuvFrame", "(IIIII)Z");
+  initForExternalYuvFrame = env->GetMethodID(
+      outputBufferClass, "initForExternalYuvFrame",
+      "(IIIIILjava/nio/ByteBuffer;Ljava/nio/ByteBuffer;Ljava/nio/ByteBuffer;)"
+      "V");
+  initForPrivateFrame =
+      env->GetMethodID(outputBufferClass, "initForPrivateFrame", "(II)V");
+  dataField =
+      env->GetFieldID(outputBufferClass, "data", "Ljava/nio/ByteBuffer;");
+  outputModeField = env->GetFieldID(outputBufferClass, "mode", "I");
+  decoderPrivateField =
+      env->GetFieldID(outputBufferClass, "decoderPrivate", "I");
+  if (!initForYuvFrame || !initForExternalYuvFrame || !initForPrivateFrame ||
+      !dataField || !outputModeField || !decoderPrivateField) {
+    return -1;
   }
+  return JNI_VERSION_1_6;
 }
 
 struct JniFrameBuffer {
   friend class JniBufferManager;
 
+  explicit JniFrameBuffer(int id) : id(id) {
+    vpx_fb.data = NULL;
+    vpx_fb.size = 0;
+    vpx_fb.priv = &this->id;
+  }
+
+  ~JniFrameBuffer() { free(vpx_fb.data); }
+
   int stride[4];
   uint8_t* planes[4];
   int d_w;
   int d_h;
+  unsigned int bit_depth;
+  vpx_color_space_t cs;
+  vpx_color_range_t range;
+
+  // Direct ByteBuffers (global references) wrapping the Y, U and V planes of
+  // this buffer, used for zero-copy YUV output. Only accessed on the thread
+  // calling vpxGetFrame and vpxClose.
+  jobject java_planes[3] = {};
+  uint8_t* java_plane_data[3] = {};
+  size_t java_plane_size[3] = {};
 
  private:
   int id;
-  int ref_count;
   vpx_codec_frame_buffer_t vpx_fb;
 };
 
+// Hands out frame buffers to libvpx and tracks the references held by libvpx
+// and by Java output buffers. All methods are lock-free and may be called
+// concurrently from libvpx worker threads and the playback thread.
+//
+// Buffers are allocated in size classes spaced a quarter octave apart, and
+// released buffers are kept per size class. This lets libvpx reuse buffers
+// across resolution switches (e.g. during adaptive playback) instead of
+// reallocating them whenever the requested size changes.
 class JniBufferManager {
-  static const int MAX_FRAMES = 32;
-
-  JniFrameBuffer* all_buffers[MAX_FRAMES];
-  int all_buffer_count = 0;
-
-  JniFrameBuffer* free_buffers[MAX_FRAMES];
-  int free_buffer_count = 0;
-
-  pthread_mutex_t mutex;
-
- public:
-  JniBufferManager() { pthread_mutex_init(&mutex, NULL); }
-
-  ~JniBufferManager() {
-    while (all_buffer_count--) {
-      free(all_buffers[all_buffer_count]->vpx_fb.data);
+  // Sizes up to 64 KiB share the smallest size class. Above that each octave
+  // up to 2 GiB is split into four classes.
+  static const int kMinSizeClassLog2 = 16;
+  static const int kNumSizeClasses = 4 * (31 - kMinSizeClassLog2) + 1;
+
+  decoder_jni::FramePool<JniFrameBuffer, kNumSizeClasses> pool;
+  decoder_jni::DecoderStats* const stats;
+
+  // Returns the smallest size class holding |size| bytes and sets |class_size|
+  // to the size of buffers allocated for it.
+  static int get_size_class(size_t size, size_t* class_size) {
+    if (size <= (static_cast<size_t>(1) << kMinSizeClassLog2)) {
+      *class_size = static_cast<size_t>(1) << kMinSizeClassLog2;
+      return 0;
     }
+    const uint64_t n = static_cast<uint64_t>(size) - 1;
+    const int log2 = 63 - __builtin_clzll(n);
+    const int quarter = static_cast<int>(n >> (log2 - 2)) & 3;
+    *class_size = static_cast<size_t>(
+        static_cast<uint64_t>(4 + quarter + 1) << (log2 - 2));
+    return 4 * (log2 - kMinSizeClassLog2) + quarter + 1;
   }
 
+ public:
+  // Counts frame buffer allocations in |stats|.
+  explicit JniBufferManager(decoder_jni::DecoderStats* stats) : stats(stats) {}
+
   int get_buffer(size_t min_size, vpx_codec_frame_buffer_t* fb) {
-    pthread_mutex_lock(&mutex);
-    JniFrameBuffer* out_buffer;
-    if (free_buffer_count) {
-      out_buffer = free_buffers[--free_buffer_count];
-      if (out_buffer->vpx_fb.size < min_size) {
-        free(out_buffer->vpx_fb.data);
-        out_buffer->vpx_fb.data = (uint8_t*)malloc(min_size);
-        out_buffer->vpx_fb.size = min_size;
-      }
-    } else {
-      out_buffer = new JniFrameBuffer();
-      out_buffer->id = all_buffer_count;
-      all_buffers[all_buffer_count++] = out_buffer;
-      out_buffer->vpx_fb.data = (uint8_t*)malloc(min_size);
-      out_buffer->vpx_fb.size = min_size;
-      out_buffer->vpx_fb.priv = &out_buffer->id;
+    if (min_size > (static_cast<size_t>(1) << 31)) {
+      LOGE("JniBufferManager get_buffer size %zu too large.", min_size);
+      return -1;
     }
-    *fb = out_buffer->vpx_fb;
-    int retVal = 0;
-    if (!out_buffer->vpx_fb.data || all_buffer_count >= MAX_FRAMES) {
+    size_t class_size;
+    const int size_class = get_size_class(min_size, &class_size);
+    int id;
+    JniFrameBuffer* out_buffer = NULL;
+    // Prefer the smallest released buffer that already fits.
+    for (int i = size_class; i < kNumSizeClasses && !out_buffer; i++) {
+      out_buffer = pool.AcquireReleased(i, &id);
+    }
+    // Otherwise grow a smaller released buffer rather than the pool.
+    for (int i = size_class - 1; i >= 0 && !out_buffer; i--) {
+      out_buffer = pool.AcquireReleased(i, &id);
+    }
+    if (!out_buffer) {
+      out_buffer = pool.AcquireNew(size_class, &id);
+    }
+    if (!out_buffer) {
       LOGE("JniBufferManager get_buffer OOM.");
-      retVal = -1;
-    } else {
-      memset(fb->data, 0, fb->size);
+      return -1;
+    }
+    if (out_buffer->vpx_fb.size < min_size) {
+      free(out_buffer->vpx_fb.data);
+      // libvpx requires new frame buffers to be zeroed. Like libvpx's internal
+      // frame buffer list, reused buffers aren't cleared again.
+      out_buffer->vpx_fb.data = (uint8_t*)calloc(class_size, 1);
+      out_buffer->vpx_fb.size = out_buffer->vpx_fb.data ? class_size : 0;
+      pool.SetSizeClass(id, size_class);
+      stats->AddBufferAllocation();
+    }
+    if (!out_buffer->vpx_fb.data) {
+      LOGE("JniBufferManager get_buffer OOM.");
+      pool.Release(id);
+      return -1;
     }
-    out_buffer->ref_count = 1;
-    pthread_mutex_unlock(&mutex);
-    return retVal;
+    *fb = out_buffer->vpx_fb;
+    return 0;
+  }
+
+  // Deletes the global references to the Java plane buffers. Must be called
+  // before the buffer manager is destroyed.
+  void release_java_planes(JNIEnv* env) {
+    pool.ForEach([env](JniFrameBuffer* buffer) {
+      for (int plane = 0; plane < 3; plane++) {
+        if (buffer->java_planes[plane]) {
+          env->DeleteGlobalRef(buffer->java_planes[plane]);
+          buffer->java_planes[plane] = NULL;
+        }
+      }
+    });
   }
 
   JniFrameBuffer* get_buffer(int id) const {
-    if (id < 0 || id >= all_buffer_count) {
+    JniFrameBuffer* buffer = pool.Get(id);
+    if (!buffer) {
       LOGE("JniBufferManager get_buffer invalid id %d.", id);
-      return NULL;
     }
-    return all_buffers[id];
+    return buffer;
+  }
+
+  // Writes the values of the decoder stats, including the buffer counts.
+  void get_stats_values(int64_t* values) const {
+    stats->GetValues(pool, values);
   }
 
   void add_ref(int id) {
-    if (id < 0 || id >= all_buffer_count) {
+    if (!pool.AddReference(id)) {
       LOGE("JniBufferManager add_ref invalid id %d.", id);
-      return;
     }
-    pthread_mutex_lock(&mutex);
-    all_buffers[id]->ref_count++;
-    pthread_mutex_unlock(&mutex);
   }
 
   int release(int id) {
-    if (id < 0 || id >= all_buffer_count) {
-      LOGE("JniBufferManager release invalid id %d.", id);
-      return -1;
-    }
-    pthread_mutex_lock(&mutex);
-    JniFrameBuffer* buffer = all_buffers[id];
-    if (!buffer->ref_count) {
-      LOGE("JniBufferManager release, buffer already released.");
-      pthread_mutex_unlock(&mutex);
+    if (!pool.Release(id)) {
+      LOGE("JniBufferManager release invalid id %d or buffer already released.",
+           id);
       return -1;
     }
-    if (!--buffer->ref_count) {
-      free_buffers[free_buffer_count++] = buffer;
-    }
-    pthread_mutex_unlock(&mutex);
     return 0;
   }
 };
 
 struct JniCtx {
-  JniCtx() { buffer_manager = new JniBufferManager(); }
+  JniCtx() { buffer_manager = new JniBufferManager(&stats); }
 
   ~JniCtx() {
     if (native_window) {
@@ -398,6 +269,7 @@ struct JniCtx {
     if (buffer_manager) {
       delete buffer_manager;
     }
+    delete bit_depth_converter;
   }
 
   void acquire_native_window(JNIEnv* env, jobject new_surface) {
@@ -408,17 +280,107 @@ struct JniCtx {
       native_window = ANativeWindow_fromSurface(env, new_surface);
       surface = new_surface;
       width = 0;
+      data_space = 0;
     }
   }
 
+  decoder_jni::DecoderStats stats;
+  // One reference held by the decoder, until vpxClose, and one per output
+  // buffer holding a frame buffer reference, until vpxReleaseFrame. Output
+  // buffers may outlive the decoder, e.g. when a view keeps drawing the last
+  // frame, so the frame buffers are only freed with the last reference.
+  std::atomic<int> references{1};
   JniBufferManager* buffer_manager = NULL;
+  // Created for the first high bit depth frame converted to 8 bits.
+  decoder_jni::BitDepthConverter* bit_depth_converter = NULL;
   vpx_codec_ctx_t* decoder = NULL;
+  bool zero_copy_yuv_output = false;
   ANativeWindow* native_window = NULL;
   jobject surface = NULL;
   int width = 0;
   int height = 0;
+  int format = 0;
+  int32_t data_space = 0;
+  // The layout of P010 window buffers, for rendering high bit depth frames.
+  decoder_jni::P010LayoutCache p010_layouts;
+  const decoder_jni::PlaneCopier plane_copier;
+  // The topology the decoder threads are restricted to the performance cores
+  // of, if performance_core_affinity is true.
+  decoder_jni::CpuTopology cpu_topology;
+  bool performance_core_affinity = false;
+  bool decode_thread_pinned = false;
 };
 
+// Returns a direct ByteBuffer wrapping |size| bytes at |data| for the given
+// plane of |jfb|. The buffer is cached in |jfb| and only recreated when the
+// plane moves, so steady-state playback doesn't allocate Java objects.
+static jobject get_java_plane(JNIEnv* env, JniFrameBuffer* jfb, int plane,
+                              uint8_t* data, size_t size) {
+  if (jfb->java_planes[plane] && jfb->java_plane_data[plane] == data &&
+      jfb->java_plane_size[plane] == size) {
+    return jfb->java_planes[plane];
+  }
+  if (jfb->java_planes[plane]) {
+    env->DeleteGlobalRef(jfb->java_planes[plane]);
+    jfb->java_planes[plane] = NULL;
+  }
+  jobject local_plane = env->NewDirectByteBuffer(data, size);
+  if (local_plane == NULL) {
+    return NULL;
+  }
+  jfb->java_planes[plane] = env->NewGlobalRef(local_plane);
+  env->DeleteLocalRef(local_plane);
+  jfb->java_plane_data[plane] = data;
+  jfb->java_plane_size[plane] = size;
+  return jfb->java_planes[plane];
+}
+
+// Drops a reference to |context|, deleting it with the last reference.
+static void release_context(JNIEnv* env, JniCtx* context) {
+  if (context->references.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+    context->buffer_manager->release_java_planes(env);
+    delete context;
+  }
+}
+
+// Returns the bit depth converter of |context|, creating it if needed, or NULL
+// if it can't be allocated.
+static decoder_jni::BitDepthConverter* get_bit_depth_converter(
+    JniCtx* context) {
+  if (!context->bit_depth_converter) {
+    context->bit_depth_converter =
+        new (std::nothrow) decoder_jni::BitDepthConverter();
+    if (!context->bit_depth_converter) {
+      LOGE("Failed to allocate the bit depth converter.");
+      return NULL;
+    }
+    context->stats.SetConversionThreadCount(
+        context->bit_depth_converter->num_threads());
+  }
+  return context->bit_depth_converter;
+}
+
+// Sets the geometry of the native window of |context| if needed, and locks its
+// next buffer. Returns false on failure.
+static bool lock_native_window(JniCtx* context, int width, int height,
+                               int format, ANativeWindow_Buffer* buffer) {
+  if (context->width != width || context->height != height ||
+      context->format != format) {
+    if (ANativeWindow_setBuffersGeometry(context->native_window, width, height,
+                                         format)) {
+      LOGE("Failed to set buffers geometry with format %d.", format);
+      // Set the geometry again for the next frame.
+      context->width = 0;
+      return false;
+    }
+    context->width = width;
+    context->height = height;
+    context->format = format;
+  }
+  return !ANativeWindow_lock(context->native_window, buffer, NULL) &&
+         buffer->bits != NULL;
+}
+
 int vpx_get_frame_buffer(void* priv, size_t min_size,
                          vpx_codec_frame_buffer_t* fb) {
   JniBufferManager* const buffer_manager =
@@ -433,11 +395,16 @@ int vpx_release_frame_buffer(void* priv, vpx_codec_frame_buffer_t* fb) {
 }
 
 DECODER_FUNC(jlong, vpxInit, jboolean disableLoopFilter,
-             jboolean enableRowMultiThreadMode, jint threads) {
+             jboolean enableRowMultiThreadMode, jint threads,
+             jboolean performanceCoreAffinity) {
   JniCtx* context = new JniCtx();
+  context->performance_core_affinity =
+      performanceCoreAffinity &&
+      decoder_jni::GetCpuTopology(&context->cpu_topology);
   context->decoder = new vpx_codec_ctx_t();
   vpx_codec_dec_cfg_t cfg = {0, 0, 0};
   cfg.threads = threads;
+  context->stats.SetDecoderThreadCount(threads);
   errorCode = 0;
   vpx_codec_err_t err =
       vpx_codec_dec_init(context->decoder, &vpx_codec_vp9_dx_algo, &cfg, 0);
@@ -472,28 +439,26 @@ DECODER_FUNC(jlong, vpxInit, jboolean disableLoopFilter,
   if (err) {
     LOGE("Failed to set libvpx frame buffer functions, error = %d.", err);
   }
-
-  // Populate JNI References.
-  const jclass outputBufferClass =
-      env->FindClass("androidx/media3/decoder/VideoDecoderOutputBuffer");
-  initForYuvFrame =
-      env->GetMethodID(outputBufferClass, "initForYuvFrame", "(IIIII)Z");
-  initForPrivateFrame =
-      env->GetMethodID(outputBufferClass, "initForPrivateFrame", "(II)V");
-  dataField =
-      env->GetFieldID(outputBufferClass, "data", "Ljava/nio/ByteBuffer;");
-  outputModeField = env->GetFieldID(outputBufferClass, "mode", "I");
-  decoderPrivateField =
-      env->GetFieldID(outputBufferClass, "decoderPrivate", "I");
   return reinterpret_cast<intptr_t>(context);
 }
 
 DECODER_FUNC(jlong, vpxDecode, jlong jContext, jobject encoded, jint len) {
   JniCtx* const context = reinterpret_cast<JniCtx*>(jContext);
+  if (context->performance_core_affinity && !context->decode_thread_pinned) {
+    // libvpx creates its worker threads in the first vpx_codec_decode() call,
+    // and they inherit the affinity of the decode thread, which is owned by
+    // the Java decoder.
+    decoder_jni::SetPerformanceCoreAffinity(context->cpu_topology);
+    context->decode_thread_pinned = true;
+  }
   const uint8_t* const buffer =
       reinterpret_cast<const uint8_t*>(env->GetDirectBufferAddress(encoded));
-  const vpx_codec_err_t status =
-      vpx_codec_decode(context->decoder, buffer, len, NULL, 0);
+  vpx_codec_err_t status;
+  {
+    const decoder_jni::ScopedStageTimer timer(
+        &context->stats, decoder_jni::DecoderStats::kStageDecode, "vpxDecode");
+    status = vpx_codec_decode(context->decoder, buffer, len, NULL, 0);
+  }
   errorCode = 0;
   if (status != VPX_CODEC_OK) {
     LOGE("vpx_codec_decode() failed, status= %d", status);
@@ -517,7 +482,12 @@ DECODER_FUNC(jlong, vpxSecureDecode, jlong jContext, jobject encoded, jint len,
 DECODER_FUNC(jlong, vpxClose, jlong jContext) {
   JniCtx* const context = reinterpret_cast<JniCtx*>(jContext);
   vpx_codec_destroy(context->decoder);
-  delete context;
+  if (context->native_window) {
+    ANativeWindow_release(context->native_window);
+    context->native_window = NULL;
+  }
+  // The frame buffers of output buffers that aren't released yet stay valid.
+  release_context(env, context);
   return 0;
 }
 
@@ -555,6 +525,41 @@ DECODER_FUNC(jint, vpxGetFrame, jlong jContext, jobject jOutputBuffer) {
         break;
     }
 
+    const int32_t uvHeight = (img->d_h + 1) / 2;
+    if (context->zero_copy_yuv_output &&
+        !(img->fmt & VPX_IMG_FMT_HIGHBITDEPTH) && img->fb_priv) {
+      // Expose the frame buffer libvpx decoded into directly. The reference
+      // taken here is released through vpxReleaseFrame.
+      const int id = *(int*)img->fb_priv;
+      JniFrameBuffer* jfb = context->buffer_manager->get_buffer(id);
+      if (!jfb) {
+        return -1;
+      }
+      jobject planes[3];
+      for (int i = 0; i < 3; i++) {
+        const int32_t planeHeight = i == VPX_PLANE_Y ? img->d_h : uvHeight;
+        planes[i] = get_java_plane(env, jfb, i, img->planes[i],
+                                   (size_t)img->stride[i] * planeHeight);
+        if (!planes[i]) {
+          return -1;
+        }
+      }
+      context->buffer_manager->add_ref(id);
+      context->references.fetch_add(1, std::memory_order_relaxed);
+      env->CallVoidMethod(jOutputBuffer, initForExternalYuvFrame, img->d_w,
+                          img->d_h, img->stride[VPX_PLANE_Y],
+                          img->stride[VPX_PLANE_U], colorspace, planes[0],
+                          planes[1], planes[2]);
+      if (env->ExceptionCheck()) {
+        context->buffer_manager->release(id);
+        context->references.fetch_sub(1, std::memory_order_relaxed);
+        return -1;
+      }
+      env->SetIntField(jOutputBuffer, decoderPrivateField,
+                       id + kDecoderPrivateBase);
+      return 0;
+    }
+
     // resize buffer if required.
     jboolean initResult = env->CallBooleanMethod(
         jOutputBuffer, initForYuvFrame, img->d_w, img->d_h,
@@ -568,30 +573,42 @@ DECODER_FUNC(jint, vpxGetFrame, jlong jContext, jobject jOutputBuffer) {
     jbyte* const data =
         reinterpret_cast<jbyte*>(env->GetDirectBufferAddress(dataObject));
 
-    const int32_t uvHeight = (img->d_h + 1) / 2;
+    const decoder_jni::ScopedStageTimer timer(
+        &context->stats, decoder_jni::DecoderStats::kStageConvert,
+        "vpxCopyFrame");
+
     const uint64_t yLength = img->stride[VPX_PLANE_Y] * img->d_h;
     const uint64_t uvLength = img->stride[VPX_PLANE_U] * uvHeight;
     if (img->fmt == VPX_IMG_FMT_I42016) {  // HBD planar 420.
       // Note: The stride for BT2020 is twice of what we use so this is wasting
       // memory. The long term goal however is to upload half-float/short so
       // it's not important to optimize the stride at this time.
-      int converted = 0;
-#ifdef __ARM_NEON__
-      converted = convert_16_to_8_neon(img, data, uvHeight, yLength, uvLength);
-#endif  // __ARM_NEON__
-      if (!converted) {
-        convert_16_to_8_standard(img, data, uvHeight, yLength, uvLength);
+      if (!get_bit_depth_converter(context)) {
+        return -1;
       }
+      uint8_t* const dest = reinterpret_cast<uint8_t*>(data);
+      const int32_t uvWidth = (img->d_w + 1) / 2;
+      const decoder_jni::BitDepthConverter::Plane planes[3] = {
+          {img->planes[VPX_PLANE_Y], img->stride[VPX_PLANE_Y], dest,
+           img->stride[VPX_PLANE_Y], (int)img->d_w, (int)img->d_h},
+          {img->planes[VPX_PLANE_U], img->stride[VPX_PLANE_U], dest + yLength,
+           img->stride[VPX_PLANE_U], uvWidth, uvHeight},
+          {img->planes[VPX_PLANE_V], img->stride[VPX_PLANE_V],
+           dest + yLength + uvLength, img->stride[VPX_PLANE_V], uvWidth,
+           uvHeight}};
+      context->bit_depth_converter->Convert10BitTo8Bit(planes, 3);
     } else {
-      // TODO: This copy can be eliminated by using external frame
-      // buffers. This is insignificant for smaller videos but takes ~1.5ms
-      // for 1080p clips. So this should eventually be gotten rid of.
+      // This copy takes ~1.5ms for 1080p clips. It's avoided when zero-copy
+      // YUV output is enabled (see vpxSetZeroCopyYuvOutput).
       memcpy(data, img->planes[VPX_PLANE_Y], yLength);
       memcpy(data + yLength, img->planes[VPX_PLANE_U], uvLength);
       memcpy(data + yLength + uvLength, img->planes[VPX_PLANE_V], uvLength);
     }
   } else if (outputMode == kOutputModeSurfaceYuv) {
-    if (img->fmt & VPX_IMG_FMT_HIGHBITDEPTH) {
+    // High bit depth 4:2:0 frames are rendered as P010, or converted to 8 bits
+    // (see vpxRenderFrame).
+    if ((img->fmt & VPX_IMG_FMT_HIGHBITDEPTH) &&
+        img->fmt != VPX_IMG_FMT_I42016) {
       LOGE(
           "High bit depth output format %d not supported in surface YUV output "
           "mode",
@@ -600,6 +617,7 @@ DECODER_FUNC(jint, vpxGetFrame, jlong jContext, jobject jOutputBuffer) {
     }
     int id = *(int*)img->fb_priv;
     context->buffer_manager->add_ref(id);
+    context->references.fetch_add(1, std::memory_order_relaxed);
     JniFrameBuffer* jfb = context->buffer_manager->get_buffer(id);
     for (int i = 2; i >= 0; i--) {
       jfb->stride[i] = img->stride[i];
@@ -607,6 +625,9 @@ DECODER_FUNC(jint, vpxGetFrame, jlong jContext, jobject jOutputBuffer) {
     }
     jfb->d_w = img->d_w;
     jfb->d_h = img->d_h;
+    jfb->bit_depth = (img->fmt & VPX_IMG_FMT_HIGHBITDEPTH) ? img->bit_depth : 8;
+    jfb->cs = img->cs;
+    jfb->range = img->range;
     env->CallVoidMethod(jOutputBuffer, initForPrivateFrame, img->d_w, img->d_h);
     if (env->ExceptionCheck()) {
       return -1;
@@ -618,8 +639,11 @@ DECODER_FUNC(jint, vpxGetFrame, jlong jContext, jobject jOutputBuffer) {
 }
 
 DECODER_FUNC(jint, vpxRenderFrame, jlong jContext, jobject jSurface,
-             jobject jOutputBuffer) {
+             jobject jOutputBuffer, jint colorTransfer) {
   JniCtx* const context = reinterpret_cast<JniCtx*>(jContext);
+  const decoder_jni::ScopedStageTimer timer(
+      &context->stats, decoder_jni::DecoderStats::kStageRender,
+      "vpxRenderFrame");
   const int id = env->GetIntField(jOutputBuffer, decoderPrivateField) -
                  kDecoderPrivateBase;
   JniFrameBuffer* srcBuffer = context->buffer_manager->get_buffer(id);
@@ -627,49 +651,90 @@ DECODER_FUNC(jint, vpxRenderFrame, jlong jContext, jobject jSurface,
   if (context->native_window == NULL || !srcBuffer) {
     return 1;
   }
-  if (context->width != srcBuffer->d_w || context->height != srcBuffer->d_h) {
-    ANativeWindow_setBuffersGeometry(context->native_window, srcBuffer->d_w,
-                                     srcBuffer->d_h, kImageFormatYV12);
-    context->width = srcBuffer->d_w;
-    context->height = srcBuffer->d_h;
-  }
+  const bool high_bit_depth = srcBuffer->bit_depth > 8;
+  // High bit depth frames are rendered as P010 if the layout of P010 buffers is
+  // known, and converted to 8 bits otherwise.
+  const decoder_jni::P010Layout* p010_layout =
+      high_bit_depth
+          ? context->p010_layouts.Get(srcBuffer->d_w, srcBuffer->d_h)
+          : NULL;
   ANativeWindow_Buffer buffer;
-  int result = ANativeWindow_lock(context->native_window, &buffer, NULL);
-  if (buffer.bits == NULL || result) {
+  if (p010_layout &&
+      !lock_native_window(context, srcBuffer->d_w, srcBuffer->d_h,
+                          decoder_jni::kImageFormatYCbCrP010, &buffer)) {
+    LOGE("Failed to render P010 buffers. Converting to 8 bits instead.");
+    context->p010_layouts.Disable();
+    p010_layout = NULL;
+  }
+  decoder_jni::BitDepthConverter* bit_depth_converter = NULL;
+  if (high_bit_depth && !p010_layout) {
+    bit_depth_converter =
+        srcBuffer->bit_depth == 10 ? get_bit_depth_converter(context) : NULL;
+    if (!bit_depth_converter) {
+      LOGE("Can't render %d-bit frames to this surface.",
+           srcBuffer->bit_depth);
+      return -1;
+    }
+  }
+  if (!p010_layout &&
+      !lock_native_window(context, srcBuffer->d_w, srcBuffer->d_h,
+                          kImageFormatYV12, &buffer)) {
     return -1;
   }
+  if (high_bit_depth) {
+    const uint8_t* const planes[3] = {srcBuffer->planes[VPX_PLANE_Y],
+                                      srcBuffer->planes[VPX_PLANE_U],
+                                      srcBuffer->planes[VPX_PLANE_V]};
+    const int strides[3] = {srcBuffer->stride[VPX_PLANE_Y],
+                            srcBuffer->stride[VPX_PLANE_U],
+                            srcBuffer->stride[VPX_PLANE_V]};
+    // VP9 doesn't signal the transfer function, so it's taken from the format.
+    // Converted frames are output with the default data space.
+    const int32_t data_space =
+        p010_layout ? decoder_jni::GetHighBitDepthDataSpace(
+                          srcBuffer->cs == VPX_CS_BT_2020, colorTransfer,
+                          srcBuffer->range == VPX_CR_FULL_RANGE)
+                    : 0;
+    if (data_space != context->data_space &&
+        decoder_jni::SetNativeWindowDataSpace(context->native_window,
+                                              data_space)) {
+      context->data_space = data_space;
+    }
+    if (p010_layout) {
+      if (!decoder_jni::CopyFrameToP010Buffer(
+              context->plane_copier, planes, strides, srcBuffer->d_w,
+              srcBuffer->d_h, srcBuffer->bit_depth, *p010_layout, buffer)) {
+        // The UV plane can't be located, so later frames are converted.
+        LOGE("Unexpected P010 buffer stride %d. Converting to 8 bits instead.",
+             buffer.stride);
+        context->p010_layouts.Disable();
+      }
+      return ANativeWindow_unlockAndPost(context->native_window);
+    }
+    decoder_jni::ConvertFrameToYv12Buffer(bit_depth_converter, planes,
+                                          strides, srcBuffer->d_w,
+                                          srcBuffer->d_h, buffer);
+    return ANativeWindow_unlockAndPost(context->native_window);
+  }
   // Y
-  const size_t src_y_stride = srcBuffer->stride[VPX_PLANE_Y];
-  int stride = srcBuffer->d_w;
-  const uint8_t* src_base =
-      reinterpret_cast<uint8_t*>(srcBuffer->planes[VPX_PLANE_Y]);
   uint8_t* dest_base = (uint8_t*)buffer.bits;
-  for (int y = 0; y < srcBuffer->d_h; y++) {
-    memcpy(dest_base, src_base, stride);
-    src_base += src_y_stride;
-    dest_base += buffer.stride;
-  }
+  context->plane_copier.CopyPlane(srcBuffer->planes[VPX_PLANE_Y],
+                                  srcBuffer->stride[VPX_PLANE_Y], dest_base,
+                                  buffer.stride, srcBuffer->d_w,
+                                  srcBuffer->d_h);
   // UV
-  const int src_uv_stride = srcBuffer->stride[VPX_PLANE_U];
   const int dest_uv_stride = (buffer.stride / 2 + 15) & (~15);
   const int32_t buffer_uv_height = (buffer.height + 1) / 2;
   const int32_t height =
       std::min((int32_t)(srcBuffer->d_h + 1) / 2, buffer_uv_height);
-  stride = (srcBuffer->d_w + 1) / 2;
-  src_base = reinterpret_cast<uint8_t*>(srcBuffer->planes[VPX_PLANE_U]);
-  const uint8_t* src_v_base =
-      reinterpret_cast<uint8_t*>(srcBuffer->planes[VPX_PLANE_V]);
   uint8_t* dest_v_base =
       ((uint8_t*)buffer.bits) + buffer.stride * buffer.height;
-  dest_base = dest_v_base + buffer_uv_height * dest_uv_stride;
-  for (int y = 0; y < height; y++) {
-    memcpy(dest_base, src_base, stride);
-    memcpy(dest_v_base, src_v_base, stride);
-    src_base += src_uv_stride;
-    src_v_base += src_uv_stride;
-    dest_base += dest_uv_stride;
-    dest_v_base += dest_uv_stride;
-  }
+  uint8_t* dest_u_base = dest_v_base + buffer_uv_height * dest_uv_stride;
+  context->plane_copier.CopyChromaPlanes(
+      srcBuffer->planes[VPX_PLANE_U], srcBuffer->stride[VPX_PLANE_U],
+      srcBuffer->planes[VPX_PLANE_V], srcBuffer->stride[VPX_PLANE_U],
+      dest_u_base, dest_v_base, dest_uv_stride, (srcBuffer->d_w + 1) / 2,
+      height);
   return ANativeWindow_unlockAndPost(context->native_window);
 }
 
@@ -677,8 +742,20 @@ DECODER_FUNC(void, vpxReleaseFrame, jlong jContext, jobject jOutputBuffer) {
   JniCtx* const context = reinterpret_cast<JniCtx*>(jContext);
   const int id = env->GetIntField(jOutputBuffer, decoderPrivateField) -
                  kDecoderPrivateBase;
+  if (id < 0) {
+    // The output buffer doesn't hold a frame buffer reference (e.g. a high bit
+    // depth frame converted in zero-copy YUV output mode).
+    return;
+  }
   env->SetIntField(jOutputBuffer, decoderPrivateField, -1);
   context->buffer_manager->release(id);
+  // May be called after vpxClose.
+  release_context(env, context);
+}
+
+DECODER_FUNC(void, vpxSetZeroCopyYuvOutput, jlong jContext, jboolean enabled) {
+  JniCtx* const context = reinterpret_cast<JniCtx*>(jContext);
+  context->zero_copy_yuv_output = enabled;
 }
 
 DECODER_FUNC(jstring, vpxGetErrorMessage, jlong jContext) {
@@ -688,6 +765,25 @@ DECODER_FUNC(jstring, vpxGetErrorMessage, jlong jContext) {
 
 DECODER_FUNC(jint, vpxGetErrorCode, jlong jContext) { return errorCode; }
 
+DECODER_FUNC(void, vpxGetStats, jlong jContext, jlongArray jValues) {
+  JniCtx* const context = reinterpret_cast<JniCtx*>(jContext);
+  if (env->GetArrayLength(jValues) < decoder_jni::DecoderStats::kNumValues) {
+    return;
+  }
+  int64_t values[decoder_jni::DecoderStats::kNumValues];
+  context->buffer_manager->get_stats_values(values);
+  env->SetLongArrayRegion(jValues, 0, decoder_jni::DecoderStats::kNumValues,
+                          reinterpret_cast<const jlong*>(values));
+}
+
+DECODER_FUNC(jint, vpxGetThreads, jint width, jint height) {
+  decoder_jni::CpuTopology topology;
+  if (!decoder_jni::GetCpuTopology(&topology)) {
+    return 0;
+  }
+  return decoder_jni::GetDecoderThreadCount(topology, width, height);
+}
+
 LIBRARY_FUNC(jstring, vpxIsSecureDecodeSupported) {
   // Doesn't support
   return 0;
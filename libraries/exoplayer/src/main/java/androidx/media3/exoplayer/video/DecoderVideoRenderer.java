@@ -357,7 +357,11 @@ public abstract class DecoderVideoRenderer extends BaseRenderer {
   @CallSuper
   protected void releaseDecoder() {
     inputBuffer = null;
-    outputBuffer = null;
+    if (outputBuffer != null) {
+      // Release the buffer before the decoder, as it may hold decoder resources.
+      outputBuffer.release();
+      outputBuffer = null;
+    }
     decoderReinitializationState = REINITIALIZATION_STATE_NONE;
     decoderReceivedBuffers = false;
     buffersInCodecCount = 0;